@@ -62,6 +62,15 @@ class ThreadPoolExecutor : public NonBlockingExecutor
 public:
     void spawn(std::function<void()>&& work) override;
 
+    /**
+     * Execute \a work on a thread of its own, rather than one shared with other work
+     *
+     * The ThreadPoolExecutor has a fixed number of threads, so work that runs indefinitely
+     * (such as a compositing loop) should use this rather than occupying one of them.
+     * Such work is otherwise treated the same as work from \ref spawn.
+     */
+    static void spawn_on_dedicated_thread(std::function<void()>&& work);
+
     /**
      * Set a handler to be called should an unhandled exception occur on the ThreadPoolExecutor
      *
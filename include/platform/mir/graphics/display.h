@@ -22,6 +22,7 @@
 #include <memory>
 #include <functional>
 #include <chrono>
+#include <optional>
 
 namespace mir
 {
@@ -75,6 +76,34 @@ public:
      */
     virtual std::chrono::milliseconds recommended_sleep() const = 0;
 
+    /**
+     * When the display is next expected to refresh with a new post(), going
+     * by the most recent page flip. That is the refresh after next if the
+     * previous post() is still waiting to be shown at the next one. A
+     * compositor measuring how long its frames take can use this to start
+     * each one just in time, instead of relying on recommended_sleep().
+     *
+     * \returns std::nullopt if the platform can't tell, for example because
+     *          the group drives displays that aren't in sync.
+     */
+    virtual auto next_vblank() const -> std::optional<Frame::Timestamp>
+    {
+        return std::nullopt;
+    }
+
+    /**
+     * Call \a handler once the content of the most recent post() has been
+     * shown: straight away if it already has, otherwise from whichever thread
+     * sees the display finish showing it.
+     *
+     * \returns false if the platform can't tell when the content is shown, in
+     *          which case \a handler is never called.
+     */
+    virtual auto when_presented(std::function<void(Presentation const&)> const& /*handler*/) -> bool
+    {
+        return false;
+    }
+
     virtual ~DisplaySyncGroup() = default;
 protected:
     DisplaySyncGroup() = default;
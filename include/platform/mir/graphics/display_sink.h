@@ -47,6 +47,10 @@ struct DisplayElement
      */
     geometry::RectangleF source_position;
     std::shared_ptr<Framebuffer> buffer;
+    /// Opacity to show the whole element with, on top of any alpha channel buffer has
+    float alpha{1.0f};
+    /// Transformation of the element about its centre, as Renderable::transformation()
+    glm::mat4 transformation{1};
 };
 /**
  * Interface to an output sink.
@@ -74,6 +78,32 @@ public:
     **/
     virtual bool overlay(std::vector<DisplayElement> const& renderlist) = 0;
 
+    /** Show as many of the topmost elements of renderlist as the hardware can
+     *  above the content of the next set_next_image(), when overlay() can't
+     *  show the whole list.
+     *  \param [in] renderlist
+     *      The topmost elements of the frame, bottom to top.
+     *  \returns
+     *      The number of elements, counted back from the end of renderlist,
+     *      that the hardware will show. The caller should render the rest of
+     *      the frame, without those, and pass it to set_next_image() as usual.
+     *      The default is for the hardware to show none of them.
+    **/
+    virtual auto overlay_topmost(std::vector<DisplayElement> const& /*renderlist*/) -> size_t
+    {
+        return 0;
+    }
+
+    /** Whether overlay() or overlay_topmost() could show anything at present.
+     *  \returns
+     *      False if the caller needn't prepare framebuffers for them. The
+     *      default is to assume they could.
+    **/
+    virtual auto can_overlay() const -> bool
+    {
+        return true;
+    }
+
     /**
      * Set the content for the next submission of this display
      *
@@ -63,6 +63,38 @@ public:
 
     virtual auto size() const -> geometry::Size = 0;
 };
+
+/**
+ * A client buffer the display can show without the renderer reading it
+ *
+ * Such a buffer needs telling, as texturing from it would, that it is about to
+ * be shown.
+ */
+class DirectScanoutBuffer
+{
+public:
+    virtual ~DirectScanoutBuffer() = default;
+
+    /**
+     * Whether the buffer's content is ready to be shown
+     *
+     * \returns false if the client's drawing has yet to complete, in which
+     *          case the buffer should be rendered instead.
+     */
+    virtual auto ready_for_scanout() const -> bool = 0;
+
+    /**
+     * Claim the buffer for showing on the display
+     *
+     * Only call this once the display is committed to showing the buffer.
+     */
+    virtual void claim_for_scanout() = 0;
+
+protected:
+    DirectScanoutBuffer() = default;
+    DirectScanoutBuffer(DirectScanoutBuffer const&) = delete;
+    DirectScanoutBuffer& operator=(DirectScanoutBuffer const&) = delete;
+};
 }
 }
 
@@ -0,0 +1,122 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_GRAPHICS_DRM_SYNCOBJ_H_
+#define MIR_GRAPHICS_DRM_SYNCOBJ_H_
+
+#include "mir/fd.h"
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+
+namespace mir
+{
+namespace graphics
+{
+/**
+ * A DRM timeline syncobj shared with us by a client
+ *
+ * Each point on the timeline is signalled by a fence; the client's GPU work
+ * signals the points we wait on, and we signal the points it waits on.
+ */
+class DRMTimeline
+{
+public:
+    /**
+     * Import a timeline syncobj into a DRM device
+     *
+     * \throws std::system_error if syncobj is not a DRM syncobj
+     */
+    DRMTimeline(mir::Fd drm_fd, mir::Fd const& syncobj);
+    ~DRMTimeline();
+
+    DRMTimeline(DRMTimeline const&) = delete;
+    DRMTimeline& operator=(DRMTimeline const&) = delete;
+
+    /// Whether the work that signals point has been submitted, so point has a fence
+    auto has_fence_for(uint64_t point) const -> bool;
+
+    /**
+     * An eventfd that becomes readable once point has a fence
+     *
+     * A client may commit before it submits the work that signals point; this
+     * lets the commit be held back until then without blocking.
+     */
+    auto eventfd_for_fence(uint64_t point) const -> mir::Fd;
+
+    /**
+     * A sync_file for the fence that signals point
+     *
+     * This doesn't wait for the fence to be submitted.
+     *
+     * \throws std::system_error if point doesn't have a fence yet
+     */
+    auto sync_file_for(uint64_t point) const -> mir::Fd;
+
+    /// Signal point once the fence of sync_file has signalled
+    void signal_after(uint64_t point, mir::Fd const& sync_file);
+
+    /// Signal point now
+    void signal(uint64_t point);
+
+    /**
+     * Signal point once fence has signalled, or now if there is no fence
+     *
+     * Where fence can't be attached to point, point is signalled now instead:
+     * a client overwriting a buffer early beats one waiting on it forever.
+     * Failures are logged rather than thrown.
+     */
+    void release(uint64_t point, std::optional<mir::Fd> const& fence) noexcept;
+
+private:
+    mir::Fd const drm_fd;
+    uint32_t const handle;
+};
+
+/// A point on a DRMTimeline
+struct DRMTimelinePoint
+{
+    std::shared_ptr<DRMTimeline> timeline;
+    uint64_t point;
+};
+
+/**
+ * A client buffer that can be synchronised through DRM timeline points,
+ * rather than through the implicit fences of its dma-bufs
+ */
+class ExplicitSyncBuffer
+{
+public:
+    virtual ~ExplicitSyncBuffer() = default;
+
+    /**
+     * \param acquire   Signalled once the client's drawing to the buffer is
+     *                  complete; our reads wait for it.
+     * \param release   For us to signal once we have finished reading from
+     *                  the buffer.
+     */
+    virtual void set_sync_points(DRMTimelinePoint acquire, DRMTimelinePoint release) = 0;
+
+protected:
+    ExplicitSyncBuffer() = default;
+    ExplicitSyncBuffer(ExplicitSyncBuffer const&) = delete;
+    ExplicitSyncBuffer& operator=(ExplicitSyncBuffer const&) = delete;
+};
+}
+}
+
+#endif /* MIR_GRAPHICS_DRM_SYNCOBJ_H_ */
@@ -326,6 +326,30 @@ struct EGLExtensions
         PFNEGLEXPORTDMABUFIMAGEMESAPROC const eglExportDMABUFImageMESA;
         PFNEGLEXPORTDMABUFIMAGEQUERYMESAPROC const eglExportDMABUFImageQueryMESA;
     };
+
+    struct FenceSyncKHR
+    {
+        FenceSyncKHR(EGLDisplay dpy);
+
+        static auto extension_if_supported(EGLDisplay dpy) -> std::optional<FenceSyncKHR>;
+
+        PFNEGLCREATESYNCKHRPROC const eglCreateSyncKHR;
+        PFNEGLDESTROYSYNCKHRPROC const eglDestroySyncKHR;
+        PFNEGLCLIENTWAITSYNCKHRPROC const eglClientWaitSyncKHR;
+    };
+
+    /// Syncs backed by sync_file fds, which the GPU (rather than the CPU) can wait on
+    struct NativeFenceSyncANDROID
+    {
+        NativeFenceSyncANDROID(EGLDisplay dpy);
+
+        static auto extension_if_supported(EGLDisplay dpy) -> std::optional<NativeFenceSyncANDROID>;
+
+        PFNEGLCREATESYNCKHRPROC const eglCreateSyncKHR;
+        PFNEGLDESTROYSYNCKHRPROC const eglDestroySyncKHR;
+        PFNEGLWAITSYNCKHRPROC const eglWaitSyncKHR;
+        PFNEGLDUPNATIVEFENCEFDANDROIDPROC const eglDupNativeFenceFDANDROID;
+    };
 };
 }
 }
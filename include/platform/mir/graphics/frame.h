@@ -18,6 +18,7 @@
 #define MIR_GRAPHICS_FRAME_H_
 
 #include "mir/time/posix_timestamp.h"
+#include <chrono>
 #include <cstdint>
 
 namespace mir { namespace graphics {
@@ -40,6 +41,19 @@ struct Frame
     Timestamp ust;     /**< Unadjusted System Time */
 };
 
+/**
+ * When, and how precisely, a frame was shown on an output
+ */
+struct Presentation
+{
+    Frame frame;
+    /// Time between refreshes of the output, or zero if it isn't known
+    std::chrono::nanoseconds refresh_interval{0};
+    /// Whether frame is the vblank the display hardware reported showing the frame at,
+    /// rather than an estimate made after the fact
+    bool from_hardware{false};
+};
+
 }} // namespace mir::graphics
 
 #endif // MIR_GRAPHICS_FRAME_H_
@@ -18,10 +18,13 @@
 #define MIR_GRAPHICS_GRAPHIC_BUFFER_ALLOCATOR_H_
 
 #include "mir/graphics/buffer.h"
+#include "mir/geometry/rectangles.h"
+#include "mir/fd.h"
 
 #include <vector>
 #include <memory>
 #include <functional>
+#include <optional>
 
 struct wl_display;
 struct wl_resource;
@@ -37,6 +40,7 @@ class RWMappableBuffer;
 
 namespace graphics
 {
+class ScanoutFeedback;
 
 /**
  * Interface to graphic buffer allocation.
@@ -86,11 +90,50 @@ public:
         std::function<void()>&& on_consumed,
         std::function<void()>&& on_release) = 0;
 
+    /**
+     * Create a buffer from a client's shared-memory pixels
+     *
+     * Successive buffers of a stream may share GPU resources, so that only what
+     * has changed between them needs uploading.
+     *
+     * \param shm_data [in]    The pixels
+     * \param previous [in]    The previous buffer of the same stream, or nullptr
+     * \param damage [in]      The area, in buffer coordinates, in which shm_data differs
+     *                         from previous; std::nullopt if unknown
+     */
     virtual auto buffer_from_shm(
         std::shared_ptr<renderer::software::RWMappableBuffer> shm_data,
+        std::shared_ptr<Buffer> const& previous,
+        std::optional<geometry::Rectangles> const& damage,
         std::function<void()>&& on_consumed,
         std::function<void()>&& on_release) -> std::shared_ptr<Buffer> = 0;
 
+    /**
+     * The DRM device in which to import clients' timeline syncobjs
+     *
+     * \returns std::nullopt if the buffers from buffer_from_resource() can't be
+     *          explicitly synchronised (see ExplicitSyncBuffer)
+     */
+    virtual auto explicit_sync_device() const -> std::optional<mir::Fd>
+    {
+        return std::nullopt;
+    }
+
+    /**
+     * The scanout feedback a client has asked for on a surface
+     *
+     * Buffers committed to surface should carry this (see ScanoutFeedbackBuffer)
+     * so the display can tell the client what it could scan out.
+     *
+     * Must be called on the Wayland thread.
+     *
+     * \returns nullptr if the client hasn't asked for feedback on surface
+     */
+    virtual auto scanout_feedback_for(wl_resource* /*surface*/) -> std::shared_ptr<ScanoutFeedback>
+    {
+        return nullptr;
+    }
+
 protected:
     GraphicBufferAllocator() = default;
     GraphicBufferAllocator(const GraphicBufferAllocator&) = delete;
@@ -22,7 +22,9 @@
 
 #include <EGL/egl.h>
 #include <memory>
+#include <optional>
 #include <span>
+#include <sys/types.h>
 
 #include "mir/graphics/buffer.h"
 #include "mir/graphics/drm_formats.h"
@@ -30,6 +32,8 @@
 
 namespace mir
 {
+class Executor;
+
 namespace renderer
 {
 namespace gl
@@ -52,6 +56,7 @@ class EGLContextExecutor;
 
 class DmaBufFormatDescriptors;
 class DMABufBuffer;
+class ScanoutFeedback;
 class EGLBufferCopier;
 
 class DMABufEGLProvider : public std::enable_shared_from_this<DMABufEGLProvider>
@@ -87,10 +92,18 @@ public:
         -> std::shared_ptr<gl::Texture>;
 
      auto supported_formats() const -> DmaBufFormatDescriptors const&;
+
+    /**
+     * The DRM device that imported buffers are rendered by
+     *
+     * \returns std::nullopt if EGL can't tell us the device
+     */
+    auto main_device() const -> std::optional<dev_t>;
 private:
     EGLDisplay const dpy;
     std::shared_ptr<EGLExtensions> const egl_extensions;
     std::optional<EGLExtensions::MESADmaBufExport> const dmabuf_export_ext;
+    std::optional<EGLExtensions::NativeFenceSyncANDROID> const native_fence_ext;
     std::unique_ptr<DmaBufFormatDescriptors> const formats;
     std::shared_ptr<common::EGLContextExecutor> const egl_delegate;
     EGLImageAllocator allocate_importable_image;
@@ -102,7 +115,8 @@ class LinuxDmaBufUnstable : public mir::wayland::LinuxDmabufV1::Global
 public:
     LinuxDmaBufUnstable(
         wl_display* display,
-        std::shared_ptr<DMABufEGLProvider> provider);
+        std::shared_ptr<DMABufEGLProvider> provider,
+        std::shared_ptr<Executor> wayland_executor);
 
     auto buffer_from_resource(
         wl_resource* buffer,
@@ -110,11 +124,29 @@ public:
         std::function<void()>&& on_release,
         std::shared_ptr<common::EGLContextExecutor> egl_delegate)
         -> std::shared_ptr<Buffer>;
+
+    /**
+     * The feedback a client has asked for on surface
+     *
+     * Must be called on the Wayland thread.
+     *
+     * \returns nullptr if the client hasn't asked for feedback on surface
+     */
+    auto scanout_feedback_for(wl_resource* surface) -> std::shared_ptr<ScanoutFeedback>;
 private:
     class Instance;
+    class FeedbackSources;
+
+    LinuxDmaBufUnstable(
+        wl_display* display,
+        std::shared_ptr<DMABufEGLProvider> provider,
+        std::optional<dev_t> main_device,
+        std::shared_ptr<Executor> wayland_executor);
+
     void bind(wl_resource* new_resource) override;
 
     std::shared_ptr<DMABufEGLProvider> const provider;
+    std::shared_ptr<FeedbackSources> const feedback_sources;
 };
 
 }
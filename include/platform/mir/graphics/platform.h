@@ -23,6 +23,7 @@
 #include <gbm.h>
 
 #include "mir/graphics/drm_formats.h"
+#include "mir/graphics/scanout_feedback.h"
 #include "mir/module_properties.h"
 #include "mir/module_deleter.h"
 #include "mir/renderer/sw/pixel_source.h"
@@ -129,6 +130,18 @@ public:
          */
         virtual auto buffer_to_framebuffer(std::shared_ptr<Buffer> buffer)
             -> std::unique_ptr<Framebuffer> = 0;
+
+        /**
+         * Note the buffer that fills the display, and so could be scanned out directly
+         *
+         * Called once per frame, whether or not buffer_to_framebuffer() accepts the
+         * buffer, so that its client can be told what would let it be scanned out.
+         *
+         * \param buffer  The buffer filling the display, or nullptr if there is none
+         */
+        virtual void scanout_candidate(std::shared_ptr<Buffer> const& /*buffer*/)
+        {
+        }
     };
 
     /**
@@ -308,6 +321,18 @@ public:
         virtual ~MappableFB() override = default;
 
         using renderer::software::WriteMappableBuffer::size;
+
+        /**
+         * Age of the content of this buffer
+         *
+         * This follows the semantics of EGL_EXT_buffer_age, counting calls
+         * of alloc_fb(): 0 means the content is undefined, N means the buffer
+         * holds what was written to the buffer allocated N calls ago.
+         */
+        virtual auto buffer_age() const -> unsigned
+        {
+            return 0;
+        }
     };
 
     virtual auto supported_formats() const
@@ -362,6 +387,16 @@ public:
      */
     virtual auto modifiers_for_format(DRMFormat format) const -> std::vector<uint64_t> = 0;
 
+    /**
+     * What a client buffer needs to be to be scanned out on this display
+     *
+     * \returns std::nullopt if client buffers can't be scanned out
+     */
+    virtual auto scanout_tranche() const -> std::optional<ScanoutTranche>
+    {
+        return std::nullopt;
+    }
+
     class GBMSurface
     {
     public:
@@ -387,8 +422,6 @@ public:
     virtual auto make_surface(DRMFormat format, std::span<uint64_t> modifiers) -> std::unique_ptr<GBMSurface> = 0;
 };
 
-class DmaBufBuffer;
-
 class DmaBufDisplayAllocator : public DisplayAllocator
 {
 public:
@@ -396,7 +429,15 @@ public:
     {
     };
 
-    virtual auto framebuffer_for(std::shared_ptr<DmaBufBuffer> buffer)
+    /**
+     * Import a client's dma-buf backed buffer as a Framebuffer the display can show directly
+     *
+     * The Framebuffer keeps buffer alive for as long as the display might show it.
+     *
+     * \returns nullptr if buffer isn't backed by dma-bufs, the display can't import it,
+     *          or it isn't ready to be shown yet.
+     */
+    virtual auto framebuffer_for(std::shared_ptr<Buffer> buffer)
         -> std::unique_ptr<Framebuffer> = 0;
 };
 
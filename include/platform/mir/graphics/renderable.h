@@ -19,6 +19,7 @@
 
 #include <optional>
 #include <mir/geometry/rectangle.h>
+#include <mir/geometry/rectangles.h>
 #include <glm/glm.hpp>
 #include <memory>
 #include <vector>
@@ -80,6 +81,29 @@ public:
 
     virtual bool shaped() const = 0;  // meaning the pixel format has alpha
 
+    /**
+     * The area of the renderable whose content has changed since the compositor
+     * last rendered it, in screen coordinates.
+     *
+     * An empty region means the content is unchanged; std::nullopt means the
+     * whole renderable should be considered changed.
+     *
+     * \note   Changes to the renderable's position, size, alpha or transformation
+     *         are not included; the consumer is expected to track those itself.
+     */
+    virtual auto damage() const -> std::optional<geometry::Rectangles> = 0;
+
+    /**
+     * The parts of a shaped() renderable that are known to be fully opaque,
+     * in screen coordinates.
+     *
+     * This is a hint allowing the compositor to treat the interior of, say, a
+     * window with translucent rounded corners as opaque. It may be empty, and
+     * is meaningless for renderables that aren't shaped() (which are opaque
+     * everywhere).
+     */
+    virtual auto opaque_region() const -> geometry::Rectangles = 0;
+
     virtual auto surface_if_any() const
         -> std::optional<mir::scene::Surface const*> = 0;
 protected:
@@ -0,0 +1,85 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_GRAPHICS_SCANOUT_FEEDBACK_H_
+#define MIR_GRAPHICS_SCANOUT_FEEDBACK_H_
+
+#include <sys/types.h>
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace mir
+{
+namespace graphics
+{
+/// What a client buffer needs to be to be scanned out by a display plane
+struct ScanoutTranche
+{
+    /// The DRM device driving the plane
+    dev_t device;
+    /// The DRM format and modifier pairs the plane can scan out
+    std::vector<std::pair<uint32_t, uint64_t>> formats;
+
+    auto operator==(ScanoutTranche const&) const -> bool = default;
+};
+
+/**
+ * Tells the client of a surface whether its buffers could be scanned out
+ *
+ * Threadsafety: may be called from any thread
+ */
+class ScanoutFeedback
+{
+public:
+    virtual ~ScanoutFeedback() = default;
+
+    /**
+     * \param tranche   What the surface's buffers need to be to be scanned out,
+     *                  or std::nullopt if the surface is no longer in a position
+     *                  to be.
+     */
+    virtual void scanout_tranche_changed(std::optional<ScanoutTranche> const& tranche) = 0;
+
+protected:
+    ScanoutFeedback() = default;
+    ScanoutFeedback(ScanoutFeedback const&) = delete;
+    ScanoutFeedback& operator=(ScanoutFeedback const&) = delete;
+};
+
+/// A client buffer carrying the ScanoutFeedback of the surface it was committed to
+class ScanoutFeedbackBuffer
+{
+public:
+    virtual ~ScanoutFeedbackBuffer() = default;
+
+    virtual void set_scanout_feedback(std::shared_ptr<ScanoutFeedback> feedback) = 0;
+
+    /// \returns nullptr if the surface's client hasn't asked for feedback
+    virtual auto scanout_feedback() const -> std::shared_ptr<ScanoutFeedback> = 0;
+
+protected:
+    ScanoutFeedbackBuffer() = default;
+    ScanoutFeedbackBuffer(ScanoutFeedbackBuffer const&) = delete;
+    ScanoutFeedbackBuffer& operator=(ScanoutFeedbackBuffer const&) = delete;
+};
+}
+}
+
+#endif /* MIR_GRAPHICS_SCANOUT_FEEDBACK_H_ */
@@ -18,7 +18,9 @@
 #define MIR_RENDERER_GL_SURFACE_H_
 
 #include "mir/geometry/size.h"
+#include "mir/geometry/rectangles.h"
 #include <memory>
+#include <optional>
 
 namespace mir
 {
@@ -51,6 +53,34 @@ public:
         GL = BottomRowFirst     //< GL texture layout is in decreasing-y order.
     };
     virtual auto layout() const -> Layout = 0;
+
+    /**
+     * Age of the buffer that will be rendered to after the next bind()
+     *
+     * This follows the semantics of EGL_EXT_buffer_age: 0 means the contents
+     * of the buffer are undefined, N means the buffer holds the frame that
+     * was committed N commits ago.
+     *
+     * Surfaces that cannot track this return std::nullopt, and the renderer
+     * will repaint the whole surface each frame.
+     */
+    virtual auto buffer_age() const -> std::optional<unsigned>
+    {
+        return std::nullopt;
+    }
+
+    /**
+     * Hint which parts of the surface the next commit() has changed
+     *
+     * This is only a hint, and applies only to the next commit(). Without it
+     * the whole surface is assumed to have changed.
+     *
+     * \param damage    The changed areas, in GL window coordinates (as for
+     *                  glScissor()), relative to the frame last committed.
+     */
+    virtual void set_damage_hint(geometry::Rectangles const& /*damage*/)
+    {
+    }
 };
 }
 }
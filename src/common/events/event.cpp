@@ -26,6 +26,7 @@
 #include "mir/events/window_output_event.h"
 #include "mir/events/input_device_state_event.h"
 #include "mir/events/window_placement_event.h"
+#include "mir/events/event_pool.h"
 
 
 MirEvent::MirEvent(MirEventType type) :
@@ -35,6 +36,16 @@ MirEvent::MirEvent(MirEventType type) :
 
 MirEvent::MirEvent(MirEvent const& e) = default;
 
+auto MirEvent::operator new(std::size_t size) -> void*
+{
+    return mir::events::pool_allocate(size);
+}
+
+void MirEvent::operator delete(void* block, std::size_t size) noexcept
+{
+    mir::events::pool_deallocate(block, size);
+}
+
 MirEventType MirEvent::type() const
 {
     return type_;
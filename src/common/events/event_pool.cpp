@@ -0,0 +1,121 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/events/event_pool.h"
+
+#include <array>
+#include <mutex>
+#include <new>
+
+namespace mev = mir::events;
+
+namespace
+{
+std::size_t const smallest_block = 64;
+/// 64, 128, ..., 1024 bytes, which covers every event and control block
+int const size_classes = 5;
+/// Blocks taken from the heap at once when a size class runs out
+int const blocks_per_refill = 16;
+
+struct FreeBlock
+{
+    FreeBlock* next;
+};
+
+struct SizeClass
+{
+    std::mutex mutex;
+    FreeBlock* free{nullptr};
+};
+
+auto size_class_of(std::size_t size) -> int
+{
+    auto size_class = 0;
+    for (auto block_size = smallest_block; block_size < size; block_size *= 2)
+    {
+        ++size_class;
+    }
+    return size_class;
+}
+
+auto pool() -> std::array<SizeClass, size_classes>&
+{
+    // Never destroyed: events may be dropped during static destruction
+    static auto* const classes = new std::array<SizeClass, size_classes>;
+    return *classes;
+}
+}
+
+auto mev::pool_allocate(std::size_t size) -> void*
+{
+    auto const size_class = size_class_of(size);
+    if (size_class >= size_classes)
+    {
+        return ::operator new(size);
+    }
+
+    auto& pool = ::pool()[size_class];
+    {
+        std::lock_guard lock{pool.mutex};
+        if (auto const block = pool.free)
+        {
+            pool.free = block->next;
+            return block;
+        }
+    }
+
+    // Keep the first block of a new chunk, and make the rest available. Chunks are never returned to the heap, so
+    // the pool stays at the size of the most events ever in flight at once.
+    auto const block_size = smallest_block << size_class;
+    auto const chunk = static_cast<char*>(::operator new(block_size * blocks_per_refill));
+
+    FreeBlock* const last = new (chunk + block_size * (blocks_per_refill - 1)) FreeBlock{nullptr};
+    FreeBlock* first = last;
+    for (auto i = blocks_per_refill - 2; i > 0; --i)
+    {
+        first = new (chunk + block_size * i) FreeBlock{first};
+    }
+
+    std::lock_guard lock{pool.mutex};
+    last->next = pool.free;
+    pool.free = first;
+    return chunk;
+}
+
+void mev::pool_deallocate(void* block, std::size_t size) noexcept
+{
+    auto const size_class = size_class_of(size);
+    if (size_class >= size_classes)
+    {
+        ::operator delete(block);
+        return;
+    }
+
+    auto& pool = ::pool()[size_class];
+    std::lock_guard lock{pool.mutex};
+    pool.free = new (block) FreeBlock{pool.free};
+}
+
+auto mev::share(EventUPtr&& event) -> std::shared_ptr<MirEvent>
+{
+    if (!event)
+    {
+        return nullptr;
+    }
+
+    auto const deleter = event.get_deleter();
+    return std::shared_ptr<MirEvent>{event.release(), deleter, PoolAllocator<MirEvent>{}};
+}
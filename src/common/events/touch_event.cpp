@@ -30,7 +30,7 @@ MirTouchEvent::MirTouchEvent(MirInputDeviceId id,
                              MirInputEventModifiers modifiers,
                              std::vector<mir::events::TouchContact> const& contacts)
     : MirInputEvent(mir_input_event_type_touch, id, timestamp, modifiers),
-      contacts{contacts}
+      contacts(begin(contacts), end(contacts))
 {
 }
 
@@ -15,253 +15,402 @@
  */
 
 #include "mir/executor.h"
-#include "mir/signal.h"
 
 #include "mir/thread_name.h"
 
-#include <thread>
-#include <memory>
+#include <algorithm>
 #include <atomic>
-#include <list>
-#include <future>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include <pthread.h>
+#include <time.h>
 
 namespace
 {
-constexpr int const min_threadpool_threads = 4;
+constexpr unsigned const min_threadpool_threads = 4;
+
+/// How long queued work may wait, with every thread busy and none starting new work,
+/// before we assume the threads are blocked and add another.
+constexpr auto const starvation_timeout = std::chrono::milliseconds{2};
+
+/// How long an extra thread added to relieve starvation stays around without work.
+constexpr auto const extra_thread_linger = std::chrono::seconds{5};
+
+/// How much of each hardware thread's time during starvation_timeout the pool must use
+/// for the CPU to count as saturated, rather than the busy threads being blocked.
+constexpr auto const saturation_threshold = starvation_timeout / 2;
 
 /* We use an atomic void(*)() rather than a std::function to avoid needing to take a mutex
  * in exception context, as taking a mutex can itself throw an exception!
  */
 std::atomic<void(*)()> exception_handler{[] { std::rethrow_exception(std::current_exception()); }};
 
-class Worker
+void execute(std::function<void()>& work)
 {
-public:
-    Worker()
-        : work{[](){}}
+    try
     {
-        std::promise<std::atomic<bool>*> shutdown_channel;
-        auto resolved_shutdown_location = shutdown_channel.get_future();
+        work();
+    }
+    catch (...)
+    {
+        (*exception_handler)();
+    }
+}
 
-        thread = std::thread{
-            &work_loop,
-            this,
-            std::move(shutdown_channel)};
+/**
+ * A fixed-size, work-stealing ThreadPool
+ *
+ * Theory of operation:
+ * The ThreadPool starts one worker thread per hardware thread (but at least
+ * min_threadpool_threads) the first time work is spawned, and each worker owns a queue.
+ * Work spawned on a worker goes on that worker's queue; work spawned from elsewhere is
+ * dealt round the queues. Workers take work from the front of their own queue and, when
+ * that's empty, steal from the back of the others'. Workers with nothing to do sleep until
+ * work is spawned.
+ *
+ * Work on the pool is allowed to block, including on other work spawned to the pool. So
+ * that this can't deadlock, a monitor thread watches for work left queued while every
+ * thread is busy and none has started anything for starvation_timeout. When that happens
+ * it adds an extra thread, which steals work like the workers do and exits after
+ * extra_thread_linger without any.
+ *
+ * Extra threads only help when the busy threads are blocked. So that a stream of CPU-bound
+ * work can't grow the pool, the monitor samples the CPU time of the pool threads, and
+ * while they're keeping every hardware thread busy the work stays queued.
+ *
+ * Work that runs indefinitely should use spawn_on_dedicated_thread() instead, which runs
+ * it on a thread of its own.
+ */
+class ThreadPool : public mir::NonBlockingExecutor
+{
+public:
+    ThreadPool() noexcept
+        : queues(std::max(std::thread::hardware_concurrency(), min_threadpool_threads))
+    {
+    }
 
-        shutdown = resolved_shutdown_location.get();
+    ~ThreadPool() noexcept
+    {
+        quiesce();
     }
 
-    ~Worker() noexcept
+    void spawn(std::function<void()>&& work) override
     {
-        if (thread.joinable())
+        ensure_started();
+
+        auto& queue = local_queue ? *local_queue : queues[next_queue++ % queues.size()];
         {
-            /* Safety: stop() is the only other callsite of signal_work_thread_to_halt()
-             * If stop() has been called then it has already called thread.join(), so
-             * thread.joinable() will be false and we can't get here.
-             */
-            signal_work_thread_to_halt();
-            if (thread.get_id() == std::this_thread::get_id())
-            {
-                /* We're being destroyed from our own work thread.
-                 * This can only happen when destroying the work functor at me->work = [](){}
-                 * in work_loop results in destroying the last shared pointer to *this.
-                 *
-                 * At this point, work_loop will exit without touching anything
-                 */
-                thread.detach();
-            }
-            else
-            {
-                thread.join();
-            }
+            std::lock_guard lock{queue.mutex};
+            queue.work.push_back(std::move(work));
+        }
+        ++queued;
+
+        if (sleeping > 0)
+        {
+            std::lock_guard lock{mutex};
+            work_available.notify_one();
+        }
+        // Even if a sleeping thread takes this work, it may block before the rest is taken
+        if (!monitor_armed.exchange(true))
+        {
+            std::lock_guard lock{mutex};
+            monitor_wakeup.notify_one();
         }
     }
 
-    void set_work(std::function<void()>&& to_do)
+    void spawn_on_dedicated_thread(std::function<void()>&& work)
     {
-        // Precondition: this Worker is idle (work_available is unraised, work = [](){})
-        work = std::move(to_do);
-        work_available.raise();
+        std::lock_guard lock{mutex};
+        ++busy;
+        start_thread(
+            [this, work = std::move(work)]() mutable
+            {
+                execute(work);
+                work = nullptr;
+                finished_work();
+            });
     }
 
     /**
-     * Halt the worker, dropping any work scheduled but not yet executing, and wait for completion.
+     * Wait for all work to finish, then stop all the threads.
+     *
+     * The threads are started again by the next spawn().
      */
-    void stop()
+    void quiesce()
     {
-        signal_work_thread_to_halt();
-        thread.join();
+        std::unique_lock lock{mutex};
+        if (live_threads == 0)
+        {
+            return;
+        }
+
+        quiescing = true;
+        state_changed.wait(lock, [this] { return queued <= 0 && busy == 0; });
+
+        stopping = true;
+        work_available.notify_all();
+        monitor_wakeup.notify_all();
+        state_changed.wait(lock, [this] { return live_threads == 0; });
+
+        stopping = false;
+        quiescing = false;
+        monitor_armed = false;
+        started = false;
     }
+
 private:
-    void signal_work_thread_to_halt()
+    struct WorkQueue
     {
-        /* Precondition: *shutdown == false
-         * If *shutdown has become true, then we are unsynchronised with the termination of
-         * the worker thread, and so we can not guarantee that shutdown points to valid memory.
-         *
-         * This implies that signal_work_thread_to_halt() must be called exactly once.
-         */
-        *shutdown = true;
-        /* We need to release the workloop thread by raising the signal.
-         */
-        work_available.raise();
-    }
+        std::mutex mutex;
+        std::deque<std::function<void()>> work;
+    };
 
-    static void work_loop(Worker* me, std::promise<std::atomic<bool>*>&& shutdown_channel)
+    void ensure_started()
     {
-        mir::set_thread_name("Mir/Workqueue");
-
-        std::atomic<bool> shutdown{false};
-        shutdown_channel.set_value(&shutdown);
+        if (started)
+        {
+            return;
+        }
 
-        while (!shutdown)
+        std::lock_guard lock{mutex};
+        if (!started)
         {
-            me->work_available.wait();
-            auto work = std::move(me->work);
-            me->work = [](){};
-            work();
+            for (auto& queue : queues)
+            {
+                start_thread([this, queue = &queue] { work_loop(queue); });
+            }
+            start_thread([this] { monitor_loop(); });
+            started = true;
         }
     }
 
-    std::function<void()> work;
-    /**
-     * Pointer to an atomic<bool> on the thread's stack (in work_loop).
-     *
-     * Being on the thread's stack means that the thread is allowed to outlive the Worker
-     * (as long as the thread does not access anything from the Worker), but also means that
-     * after setting *shutdown to true it is no longer safe to access.
-     */
-    std::atomic<bool>* shutdown;
-    mir::Signal work_available;
-    std::thread thread;
-};
-
-/**
- * A self-managing ThreadPool
- *
- * Theory of operation:
- * The ThreadPool executes each item of work on an independent thread; each call to spawn() is
- * guaranteed to be on a different thread to the caller.
- *
- * To reduce the overhead of spawning threads, the ThreadPool attempts to maintain
- * min_threadpool_threads of free worker threads.
- *
- * The ThreadPool maintains two linked-lists of Worker threads; a list of all Workers, and a list of
- * (Worker, position-in-all-workers-list) containing idle Worker threads.
- *
- * When a work item is received through spawn() the ThreadPool first checks to see if there's a
- * free Worker thread in the idle list; if so, it takes it off the free list and dispatches the work.
- * If there are no free Workers, it creates a new Worker, adds it to the all-workers list, and dispatches
- * the work to the new Worker.
- *
- * When a Worker finishes an item of work, it calls recycle(). If there are fewer than
- * min_threadpool_threads in the free list, the Worker is added to the free list. Otherwise, the
- * Worker is removed from the all-workers list and is destroyed.
- */
-class ThreadPool : public mir::NonBlockingExecutor
-{
-public:
-    ThreadPool() noexcept
+    // Must be called with mutex held
+    void start_thread(std::function<void()>&& thread_main)
     {
-    }
+        ++live_threads;
+        std::thread{
+            [this, thread_main = std::move(thread_main)]
+            {
+                mir::set_thread_name("Mir/Workqueue");
+                thread_main();
 
-    ~ThreadPool() noexcept
-    {
-        wait_for_idle();
+                std::lock_guard lock{mutex};
+                --live_threads;
+                state_changed.notify_all();
+            }}.detach();
     }
 
-    void quiesce()
+    /// Runs work from \a own_queue, or stolen from the other queues, until stopped
+    /// (or, for extra threads without a queue, until there's been no work for a while)
+    void work_loop(WorkQueue* own_queue)
     {
-        wait_for_idle();
-        std::lock_guard lock{workers_mutex};
-        free_workers.clear();
-        workers.clear();
-        num_workers_free = 0;
+        local_queue = own_queue;
+
+        clockid_t cpu_clock;
+        bool const have_cpu_clock = pthread_getcpuclockid(pthread_self(), &cpu_clock) == 0;
+        if (have_cpu_clock)
+        {
+            std::lock_guard lock{mutex};
+            cpu_clocks.push_back(cpu_clock);
+        }
+
+        while (true)
+        {
+            if (auto work = take_work(own_queue))
+            {
+                ++started_work;
+                execute(*work);
+                work.reset();
+                finished_work();
+                continue;
+            }
+
+            std::unique_lock lock{mutex};
+            ++sleeping;
+            auto const woken = [this] { return stopping || queued > 0; };
+            bool have_work = true;
+            if (own_queue)
+            {
+                work_available.wait(lock, woken);
+            }
+            else
+            {
+                have_work = work_available.wait_for(lock, extra_thread_linger, woken);
+            }
+            --sleeping;
+
+            if (stopping || !have_work)
+            {
+                break;
+            }
+        }
+
+        if (have_cpu_clock)
+        {
+            std::lock_guard lock{mutex};
+            std::erase(cpu_clocks, cpu_clock);
+        }
+        local_queue = nullptr;
     }
 
-    void spawn(std::function<void()>&& work)
+    /// The oldest work from \a own_queue if there is any, otherwise the newest from another queue
+    auto take_work(WorkQueue* own_queue) -> std::optional<std::function<void()>>
     {
-        WorkerHandle worker;
+        std::optional<std::function<void()>> work;
+
+        if (own_queue)
         {
-            std::lock_guard lock{workers_mutex};
-            if (num_workers_free > 0)
+            std::lock_guard lock{own_queue->mutex};
+            if (!own_queue->work.empty())
             {
-                worker = free_workers.front();
-                free_workers.pop_front();
-                num_workers_free--;
+                work = std::move(own_queue->work.front());
+                own_queue->work.pop_front();
             }
-            else
+        }
+
+        for (auto queue = queues.begin(); !work && queued > 0 && queue != queues.end(); ++queue)
+        {
+            if (&*queue != own_queue)
             {
-                worker.worker = std::make_shared<Worker>();
-                worker.pos = workers.insert(workers.cend(), worker.worker);
+                std::lock_guard lock{queue->mutex};
+                if (!queue->work.empty())
+                {
+                    work = std::move(queue->work.back());
+                    queue->work.pop_back();
+                }
             }
         }
-        worker.worker->set_work(
-            [this, worker, work = std::move(work)]() mutable
+
+        if (work)
+        {
+            // Count the work as busy before it stops counting as queued, so quiesce() can't miss it
+            ++busy;
+            --queued;
+        }
+        return work;
+    }
+
+    void finished_work()
+    {
+        if (--busy == 0 && quiescing)
+        {
+            std::lock_guard lock{mutex};
+            state_changed.notify_all();
+        }
+    }
+
+    void monitor_loop()
+    {
+        std::unique_lock lock{mutex};
+        while (!stopping)
+        {
+            monitor_wakeup.wait(lock, [this] { return stopping || monitor_armed; });
+
+            auto const started_before = started_work.load();
+            auto const cpu_before = cpu_times();
+            if (monitor_wakeup.wait_for(lock, starvation_timeout, [this] { return stopping.load(); }))
+            {
+                break;
+            }
+
+            if (queued > 0)
             {
-                try
+                if (sleeping == 0 && started_work == started_before && !cpu_saturated_since(cpu_before))
                 {
-                    work();
+                    start_thread([this] { work_loop(nullptr); });
                 }
-                catch (...)
+            }
+            else
+            {
+                monitor_armed = false;
+                // Work may have been queued after we checked, but before we disarmed
+                if (queued > 0)
                 {
-                    (*exception_handler)();
+                    monitor_armed = true;
                 }
-                recycle(std::move(worker));
-            });
+            }
+        }
     }
-private:
-    struct WorkerHandle
-    {
-        std::list<std::shared_ptr<Worker>>::const_iterator pos;
-        std::shared_ptr<Worker> worker;
-    };
 
-    void wait_for_idle()
+    using CPUTimes = std::vector<std::pair<clockid_t, std::chrono::nanoseconds>>;
+
+    // Must be called with mutex held
+    auto cpu_times() const -> CPUTimes
     {
-        std::unique_lock lock{workers_mutex};
-        // We need to wait for any active workers to finish.
-        bool idle = workers.size() == free_workers.size();
-        while (!idle)
+        CPUTimes times;
+        for (auto const clock : cpu_clocks)
         {
-            workers_changed.wait(lock);
-
-            /* When a worker finishes it either adds itself to the free_workers list
-             * or removes itself from the workers list.
-             *
-             * This means that we're idle once all the workers are free_workers
-             * - that is, the free_workers list is the same size as workers.
-             */
-            idle = workers.size() == free_workers.size();
+            if (auto const time = cpu_time(clock))
+            {
+                times.emplace_back(clock, *time);
+            }
         }
+        return times;
     }
 
-    void recycle(WorkerHandle&& worker)
+    /// Whether the pool threads have been keeping every hardware thread busy since \a before
+    // Must be called with mutex held
+    auto cpu_saturated_since(CPUTimes const& before) const -> bool
     {
+        std::chrono::nanoseconds used{0};
+        for (auto const& [clock, then] : before)
         {
-            std::lock_guard lock{workers_mutex};
-            if (num_workers_free < min_threadpool_threads)
+            // Threads that have exited since (and their clocks) no longer count
+            if (std::find(cpu_clocks.begin(), cpu_clocks.end(), clock) == cpu_clocks.end())
             {
-                // If we're below our free-thread minimum, recycle this thread back into the pool…
-                free_workers.emplace_front(std::move(worker));
-                num_workers_free++;
+                continue;
             }
-            else
+            if (auto const now = cpu_time(clock))
             {
-                // …otherwise, let it die.
-                workers.erase(worker.pos);
+                used += *now - then;
             }
         }
-        workers_changed.notify_all();
+        return used >= std::max(std::thread::hardware_concurrency(), 1u) * saturation_threshold;
+    }
+
+    static auto cpu_time(clockid_t clock) -> std::optional<std::chrono::nanoseconds>
+    {
+        timespec time;
+        if (clock_gettime(clock, &time) != 0)
+        {
+            return std::nullopt;
+        }
+        return std::chrono::seconds{time.tv_sec} + std::chrono::nanoseconds{time.tv_nsec};
     }
 
-    std::mutex workers_mutex;
-    std::condition_variable workers_changed;
-    int num_workers_free{0};
-    std::list<WorkerHandle> free_workers;
-    std::list<std::shared_ptr<Worker>> workers;
+    static thread_local WorkQueue* local_queue;
+
+    std::vector<WorkQueue> queues;
+    std::atomic<unsigned> next_queue{0};
+
+    std::mutex mutex;
+    std::condition_variable work_available;
+    std::condition_variable monitor_wakeup;
+    std::condition_variable state_changed;
+    /// The CPU-time clocks of the worker and extra threads
+    std::vector<clockid_t> cpu_clocks;
+
+    std::atomic<bool> started{false};
+    std::atomic<bool> stopping{false};
+    std::atomic<bool> quiescing{false};
+    std::atomic<bool> monitor_armed{false};
+    /// Work in the queues; can briefly go negative as work is taken before it's counted
+    std::atomic<long> queued{0};
+    std::atomic<int> busy{0};
+    std::atomic<int> sleeping{0};
+    std::atomic<unsigned long> started_work{0};
+    int live_threads{0};
 };
 
+thread_local ThreadPool::WorkQueue* ThreadPool::local_queue{nullptr};
+
 ThreadPool thread_pool;
 
 }
@@ -273,6 +422,11 @@ void mir::ThreadPoolExecutor::spawn(std::function<void()>&& work)
     thread_pool.spawn(std::move(work));
 }
 
+void mir::ThreadPoolExecutor::spawn_on_dedicated_thread(std::function<void()>&& work)
+{
+    thread_pool.spawn_on_dedicated_thread(std::move(work));
+}
+
 void mir::ThreadPoolExecutor::set_unhandled_exception_handler(void (*handler)())
 {
     exception_handler = handler;
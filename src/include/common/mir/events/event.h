@@ -20,6 +20,7 @@
 #include "mir_toolkit/event.h"
 #include "mir/events/event_builders.h"
 
+#include <cstddef>
 #include <cstring>
 
 struct MirEvent
@@ -27,6 +28,12 @@ struct MirEvent
     virtual auto clone() const -> MirEvent* = 0;
     virtual ~MirEvent() = default;
 
+    /// Events of every type are allocated from the event pool (see mir/events/event_pool.h)
+    ///@{
+    static auto operator new(std::size_t size) -> void*;
+    static void operator delete(void* block, std::size_t size) noexcept;
+    ///@}
+
     MirEventType type() const;
 
     MirInputEvent* to_input();
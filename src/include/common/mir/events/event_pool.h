@@ -0,0 +1,82 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_COMMON_EVENT_POOL_H_
+#define MIR_COMMON_EVENT_POOL_H_
+
+#include "mir/events/event_builders.h"
+
+#include <cstddef>
+#include <memory>
+
+namespace mir
+{
+namespace events
+{
+/**
+ * Storage for events, and the control blocks of the shared_ptrs that own them.
+ *
+ * Input produces and drops events at a steady rate, so blocks are recycled
+ * through free lists (one for each size class) instead of being returned to the
+ * heap. Sizes larger than the largest class go to the heap.
+ *
+ * Threadsafety: may be called from any thread
+ */
+auto pool_allocate(std::size_t size) -> void*;
+void pool_deallocate(void* block, std::size_t size) noexcept;
+
+/// An allocator using pool_allocate(), for containers and control blocks
+template<typename T>
+struct PoolAllocator
+{
+    using value_type = T;
+
+    PoolAllocator() = default;
+
+    template<typename U>
+    PoolAllocator(PoolAllocator<U> const&) noexcept
+    {
+    }
+
+    auto allocate(std::size_t n) -> T*
+    {
+        static_assert(alignof(T) <= alignof(std::max_align_t), "Pool blocks are only aligned for fundamental types");
+        return static_cast<T*>(pool_allocate(n * sizeof(T)));
+    }
+
+    void deallocate(T* block, std::size_t n) noexcept
+    {
+        pool_deallocate(block, n * sizeof(T));
+    }
+
+    template<typename U>
+    auto operator==(PoolAllocator<U> const&) const noexcept -> bool
+    {
+        return true;
+    }
+};
+
+/**
+ * Share ownership of an event
+ *
+ * Unlike converting the EventUPtr to a shared_ptr, the control block comes from
+ * the pool rather than the heap.
+ */
+auto share(EventUPtr&& event) -> std::shared_ptr<MirEvent>;
+}
+}
+
+#endif /* MIR_COMMON_EVENT_POOL_H_ */
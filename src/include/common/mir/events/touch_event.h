@@ -22,6 +22,8 @@
 
 #include "mir/events/input_event.h"
 
+#include <boost/container/small_vector.hpp>
+
 struct MirTouchEvent : MirInputEvent
 {
     MirTouchEvent();
@@ -62,7 +64,8 @@ struct MirTouchEvent : MirInputEvent
     void set_action(size_t index, MirTouchAction action);
 
 private:
-    std::vector<mir::events::TouchContact> contacts;
+    /// Enough for all the fingers of two hands without touching the heap
+    boost::container::small_vector<mir::events::TouchContact, 10> contacts;
     void throw_if_out_of_bounds(size_t index) const;
 };
 
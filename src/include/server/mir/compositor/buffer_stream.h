@@ -19,18 +19,21 @@
 
 #include "mir/geometry/size.h"
 #include "mir/geometry/rectangle.h"
+#include "mir/geometry/rectangles.h"
 #include "mir/frontend/buffer_stream.h"
 #include "mir/graphics/drm_formats.h"
 #include "mir_toolkit/common.h"
 #include "mir/graphics/buffer_id.h"
 
 #include <memory>
+#include <optional>
 
 namespace mir
 {
 namespace graphics
 {
 class Buffer;
+struct Presentation;
 }
 
 namespace compositor
@@ -45,6 +48,17 @@ public:
 
     virtual auto next_submission_for_compositor(void const* user_id) -> std::shared_ptr<Submission> = 0;
     virtual auto has_submitted_buffer() const -> bool = 0;
+    /**
+     * Logical size of the most recently submitted buffer
+     */
+    virtual auto stream_size() const -> geometry::Size = 0;
+    /**
+     * Note the buffer user_id last took from this stream, for reporting once
+     * the frame it was composited into is shown
+     *
+     * \returns The function to call with the presentation of that frame
+     */
+    virtual auto presenter(void const* user_id) -> std::function<void(graphics::Presentation const&)> = 0;
 
     class Submission
     {
@@ -69,6 +83,16 @@ public:
          * Pixel format
          */
         virtual auto pixel_format() const -> graphics::DRMFormat = 0;
+
+        /**
+         * Region of the buffer that has changed since the requesting compositor last claimed
+         * a buffer from this stream, in logical coordinates relative to the top-left of the
+         * stream's destination (see size()).
+         *
+         * An empty region means the content is unchanged; std::nullopt means the change is
+         * unknown and the whole stream should be considered damaged.
+         */
+        virtual auto damage() const -> std::optional<geometry::Rectangles> = 0;
     };
 };
 
@@ -19,8 +19,14 @@
 
 #include "mir/graphics/renderable.h"
 
+#include <chrono>
+
 namespace mir
 {
+namespace graphics
+{
+struct Presentation;
+}
 namespace compositor
 {
 
@@ -33,6 +39,13 @@ public:
     virtual void renderables_in_frame(SubCompositorId id, graphics::RenderableList const& renderables) = 0;
     virtual void rendered_frame(SubCompositorId id) = 0;
     virtual void finished_frame(SubCompositorId id) = 0;
+    /// The oldest frame finished by \a id and not yet presented has been shown, as described by \a presentation
+    virtual void presented_frame(SubCompositorId id, graphics::Presentation const& presentation) = 0;
+    /// The next frame of \a id is expected to take \a predicted_render_time, so will start after \a delay
+    virtual void scheduled_next_frame(
+        SubCompositorId id,
+        std::chrono::nanoseconds predicted_render_time,
+        std::chrono::nanoseconds delay) = 0;
     virtual void started() = 0;
     virtual void stopped() = 0;
     virtual void scheduled() = 0;
@@ -0,0 +1,145 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_COMPOSITOR_FRAME_TIMINGS_H_
+#define MIR_COMPOSITOR_FRAME_TIMINGS_H_
+
+#include "mir/compositor/compositor_report.h"
+#include "mir/graphics/frame.h"
+#include "mir/time/types.h"
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+
+namespace mir
+{
+namespace compositor
+{
+/**
+ * A histogram of durations, with buckets whose width grows with the duration
+ *
+ * Like an HDR histogram, every bucket is within about 3% of the durations it counts,
+ * from a microsecond to hours, in a fixed amount of memory.
+ */
+class LatencyHistogram
+{
+public:
+    void record(std::chrono::microseconds duration);
+    void clear();
+
+    auto count() const -> std::uint64_t;
+    auto max() const -> std::chrono::microseconds;
+    /// The duration \a fraction (0 to 1) of the recorded durations are no longer than
+    auto percentile(double fraction) const -> std::chrono::microseconds;
+
+private:
+    static int constexpr sub_buckets = 32;
+    static int constexpr max_shift = 32;
+    static int constexpr bucket_count = (max_shift + 1) * sub_buckets;
+
+    std::array<std::uint64_t, bucket_count> buckets{};
+    std::uint64_t total{0};
+    std::chrono::microseconds longest{0};
+};
+
+struct LatencySummary
+{
+    std::chrono::microseconds p50{0};
+    std::chrono::microseconds p90{0};
+    std::chrono::microseconds p99{0};
+    std::chrono::microseconds max{0};
+    std::uint64_t samples{0};
+};
+
+struct FrameTimingStats
+{
+    /// From starting a frame to finishing rendering it (frames that are bypassed aren't rendered)
+    LatencySummary render_time;
+    /// From compositing being scheduled to starting the frame
+    LatencySummary schedule_latency;
+    /// From starting a frame (taking it from the scene) to the display showing it
+    LatencySummary present_latency;
+    std::uint64_t frames{0};
+    /// Vblanks the display flipped past between frames that were composited back to back
+    std::uint64_t missed_vblanks{0};
+};
+
+/**
+ * Collects the timing of each display's frames, as seen by a CompositorReport
+ *
+ * Vblanks are counted as missed from the flips the display hardware reports: where a
+ * frame was scheduled before the previous one was shown (so was composited back to back
+ * with it) but was shown more than one vblank after it.
+ */
+class FrameTimings
+{
+public:
+    using DisplayId = CompositorReport::SubCompositorId;
+
+    void scheduled(time::Timestamp when);
+    void began_frame(DisplayId id, time::Timestamp when);
+    void rendered_frame(DisplayId id, time::Timestamp when);
+    void finished_frame(DisplayId id, time::Timestamp when);
+    /// The oldest frame finished by \a id and not yet presented was shown at \a when
+    void presented_frame(DisplayId id, time::Timestamp when, graphics::Presentation const& presentation);
+    void clear();
+
+    /// When \a presentation was shown, on a clock that reads \a now at this moment
+    static auto time_of(graphics::Presentation const& presentation, time::Timestamp now) -> time::Timestamp;
+
+    auto stats() const -> std::unordered_map<DisplayId, FrameTimingStats>;
+    auto stats_for(DisplayId id) const -> std::optional<FrameTimingStats>;
+
+private:
+    struct Display
+    {
+        LatencyHistogram render_time;
+        LatencyHistogram schedule_latency;
+        LatencyHistogram present_latency;
+        std::uint64_t frames{0};
+        std::uint64_t missed_vblanks{0};
+
+        struct Frame
+        {
+            time::Timestamp began;
+            /// When compositing the frame was scheduled
+            std::optional<time::Timestamp> scheduled;
+        };
+
+        /// The earliest time compositing was scheduled since the last frame started
+        std::optional<time::Timestamp> pending_since;
+        Frame frame_in_progress;
+        /// Frames finished but not yet shown, oldest first
+        std::deque<Frame> awaiting_presentation;
+        std::optional<time::Timestamp> last_presented;
+        /// The vblank the last frame was shown at, if the display hardware reported it
+        std::optional<std::int64_t> last_msc;
+
+        auto summarise() const -> FrameTimingStats;
+    };
+
+    std::mutex mutable mutex;
+    std::unordered_map<DisplayId, Display> displays;
+};
+}
+}
+
+#endif // MIR_COMPOSITOR_FRAME_TIMINGS_H_
@@ -18,12 +18,18 @@
 #define MIR_COMPOSITOR_SCENE_H_
 
 #include "compositor_id.h"
+#include "mir/geometry/rectangle.h"
 
+#include <functional>
 #include <memory>
 #include <vector>
 
 namespace mir
 {
+namespace graphics
+{
+struct Presentation;
+}
 namespace scene
 {
 class Observer;
@@ -47,10 +53,21 @@ public:
      *                     a new (different) sequence to that user each time. For
      *                     consistency, all callers need to determine their id
      *                     in the same way (e.g. always use "this" pointer).
+     * \param [in] view_area The area of the scene the compositor will show.
+     *                     Surfaces that can't appear in it are left out, and
+     *                     their buffers are not consumed on behalf of \a id.
      * \returns a sequence of SceneElements for the compositor id. The
      *          sequence is in stacking order from back to front.
      */
-    virtual SceneElementSequence scene_elements_for(CompositorID id) = 0;
+    virtual SceneElementSequence scene_elements_for(CompositorID id, geometry::Rectangle const& view_area) = 0;
+
+    /**
+     * Note what compositor id last composited from this scene, for reporting
+     * once that frame is shown
+     *
+     * \returns The function to call with the presentation of that frame
+     */
+    virtual auto frame_presenter(CompositorID id) -> std::function<void(graphics::Presentation const&)> = 0;
 
     virtual void register_compositor(CompositorID id) = 0;
     virtual void unregister_compositor(CompositorID id) = 0;
@@ -24,7 +24,7 @@
 
 #include <atomic>
 #include <memory>
-#include <atomic>
+#include <optional>
 
 namespace mir
 {
@@ -41,17 +41,32 @@ public:
     void submit_buffer(
         std::shared_ptr<graphics::Buffer> const& buffer,
         geometry::Size dest_size,
-        geometry::RectangleD src_bounds) override;
+        geometry::RectangleD src_bounds,
+        std::optional<geometry::Rectangles> const& damage) override;
     void set_frame_posted_callback(
-        std::function<void(geometry::Size const&)> const& callback) override;
+        std::function<void(geometry::Rectangle const&)> const& callback) override;
+    void set_frame_presented_callback(
+        std::function<void(graphics::BufferID, graphics::Presentation const&)> const& callback) override;
     auto next_submission_for_compositor(void const* user_id) -> std::shared_ptr<Submission> override;
     bool has_submitted_buffer() const override;
+    auto stream_size() const -> geometry::Size override;
+    auto presenter(void const* user_id) -> std::function<void(graphics::Presentation const&)> override;
 private:
     std::shared_ptr<MultiMonitorArbiter> const arbiter;
 
     std::atomic<bool> first_frame_posted;
+    Synchronised<geometry::Size> latest_size;
+
+    Synchronised<std::function<void(geometry::Rectangle const&)>> frame_callback;
 
-    Synchronised<std::function<void(geometry::Size const&)>> frame_callback;
+    struct PresentedState
+    {
+        std::function<void(graphics::BufferID, graphics::Presentation const&)> callback;
+        /// Only the first output to show a buffer reports it
+        std::optional<graphics::BufferID> last_presented;
+    };
+    /// Shared with the presenters, which can outlive the stream while their frame is waiting to be shown
+    std::shared_ptr<Synchronised<PresentedState>> const presented_state;
 };
 }
 }
@@ -19,7 +19,10 @@
 
 #include <mir_toolkit/common.h>
 #include "mir/geometry/size.h"
+#include "mir/geometry/rectangles.h"
+#include "mir/graphics/buffer_id.h"
 #include <functional>
+#include <optional>
 #include <memory>
 
 namespace mir
@@ -28,6 +31,7 @@ namespace graphics
 {
 class Buffer;
 struct BufferProperties;
+struct Presentation;
 }
 
 namespace frontend
@@ -38,13 +42,38 @@ class BufferStream
 public:
     virtual ~BufferStream() = default;
 
+    /**
+     * Submit a new frame of content to the stream
+     *
+     * \param [in] buffer      The new content
+     * \param [in] dest_size   The logical size the content should be displayed at
+     * \param [in] src_bounds  The region of \p buffer that should be sampled from
+     * \param [in] damage      The region of \p buffer (in buffer coordinates) that has changed
+     *                         since the previous submission, or std::nullopt if the whole
+     *                         buffer should be considered changed
+     */
     virtual void submit_buffer(
         std::shared_ptr<graphics::Buffer> const& buffer,
         geometry::Size dest_size,
-        geometry::RectangleD src_bounds) = 0;
+        geometry::RectangleD src_bounds,
+        std::optional<geometry::Rectangles> const& damage) = 0;
 
+    /**
+     * Set the callback invoked whenever a frame is submitted
+     *
+     * The callback receives the area of the stream that changed, in stream-local logical coordinates.
+     */
     virtual void set_frame_posted_callback(
-        std::function<void(geometry::Size const&)> const& callback) = 0;
+        std::function<void(geometry::Rectangle const&)> const& callback) = 0;
+
+    /**
+     * Set the callback invoked when a submitted buffer is first shown on an output
+     *
+     * The callback receives the id of the buffer and when it was shown. Buffers that
+     * were replaced before any output showed them are never reported.
+     */
+    virtual void set_frame_presented_callback(
+        std::function<void(graphics::BufferID, graphics::Presentation const&)> const& callback) = 0;
 protected:
     BufferStream() = default;
     BufferStream(BufferStream const&) = delete;
@@ -25,12 +25,13 @@
 #include "mir/observer_registrar.h"
 #include "surface_state_tracker.h"
 
+#include <functional>
 #include <vector>
 #include <list>
 
 namespace mir
 {
-namespace graphics { class CursorImage; }
+namespace graphics { class CursorImage; struct Presentation; }
 namespace compositor { class BufferStream; }
 namespace scene
 {
@@ -38,6 +39,8 @@ struct StreamInfo
 {
     std::shared_ptr<compositor::BufferStream> stream;
     geometry::Displacement displacement;
+    /// Parts of the stream's content known to be opaque, relative to the stream's top left
+    std::vector<geometry::Rectangle> opaque_region{};
 };
 
 class SurfaceObserver;
@@ -63,6 +66,13 @@ public:
     virtual geometry::Size window_size() const = 0;
 
     virtual graphics::RenderableList generate_renderables(compositor::CompositorID id) const = 0; 
+    /// As generate_renderables(id), but leaving out streams that can't appear in \a view_area.
+    /// No submission is taken from the streams left out.
+    virtual graphics::RenderableList generate_renderables(
+        compositor::CompositorID id,
+        geometry::Rectangle const& view_area) const = 0;
+    /// What compositor \a id last composited from this surface's streams, to report once that frame is shown
+    virtual auto frame_presenter(compositor::CompositorID id) const -> std::function<void(graphics::Presentation const&)> = 0;
 
     virtual MirWindowType type() const = 0;
     virtual MirWindowState state() const = 0;
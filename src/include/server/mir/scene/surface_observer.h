@@ -65,6 +65,8 @@ public:
     virtual void entered_output(Surface const* surf, graphics::DisplayConfigurationOutputId const& id) = 0;
     virtual void left_output(Surface const* surf, graphics::DisplayConfigurationOutputId const& id) = 0;
     virtual void rescale_output(Surface const* surf, graphics::DisplayConfigurationOutputId const& id) = 0;
+    /// region is given in surface-local logical coordinates, and is empty if the whole surface takes input
+    virtual void input_region_set_to(Surface const* surf, std::vector<geometry::Rectangle> const& region) = 0;
 
 protected:
     SurfaceObserver() = default;
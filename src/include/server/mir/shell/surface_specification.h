@@ -27,6 +27,7 @@
 
 #include <string>
 #include <memory>
+#include <vector>
 
 namespace mir
 {
@@ -47,6 +48,8 @@ struct StreamSpecification
 {
     std::weak_ptr<frontend::BufferStream> stream;
     geometry::Displacement displacement;
+    /// Parts of the stream's content the client promises are opaque, relative to the stream's top left
+    std::vector<geometry::Rectangle> opaque_region{};
 };
 auto operator==(StreamSpecification const& lhs, StreamSpecification const& rhs) -> bool;
 
@@ -60,6 +60,7 @@ public:
   void entered_output(mir::scene::Surface const* surf, mir::graphics::DisplayConfigurationOutputId const& id) override;
   void left_output(mir::scene::Surface const* surf, mir::graphics::DisplayConfigurationOutputId const& id) override;
   void rescale_output(mir::scene::Surface const* surf, mir::graphics::DisplayConfigurationOutputId const& id) override;
+  void input_region_set_to(mir::scene::Surface const* surf, std::vector<mir::geometry::Rectangle> const& region) override;
 
 private:
   std::shared_ptr<miroil::SurfaceObserver> listener;
@@ -178,6 +179,12 @@ void miroil::SurfaceObserverImpl::rescale_output(
 {
 }
 
+void miroil::SurfaceObserverImpl::input_region_set_to(
+    mir::scene::Surface const* /*surf*/,
+    std::vector<mir::geometry::Rectangle> const& /*region*/)
+{
+}
+
 miroil::Surface::Surface(std::shared_ptr<mir::scene::Surface> wrapped) :
      wrapped(wrapped)
 {
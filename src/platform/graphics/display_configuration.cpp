@@ -117,6 +117,7 @@ std::ostream& mg::operator<<(std::ostream& out, mg::DisplayConfigurationOutput c
 
     out << "\tscale: " << val.scale << std::endl;
     out << "\tform factor: " << as_string(val.form_factor) << std::endl;
+    out << "\tvrr capable: " << (val.vrr_capable ? "true" : "false") << std::endl;
 
     out << "\tcustom logical size: ";
     if (val.custom_logical_size.is_set())
@@ -324,7 +325,8 @@ mg::UserDisplayConfigurationOutput::UserDisplayConfigurationOutput(
         edid(*reinterpret_cast<std::vector<uint8_t const>*>(&main.edid)),
         custom_logical_size(main.custom_logical_size),
         name(main.name),
-        custom_attribute{main.custom_attribute}
+        custom_attribute{main.custom_attribute},
+        vrr_capable(main.vrr_capable)
 {
 }
 
@@ -0,0 +1,173 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/graphics/drm_syncobj.h"
+#include "mir/log.h"
+
+#include <boost/throw_exception.hpp>
+#include <xf86drm.h>
+#include <sys/eventfd.h>
+
+#include <system_error>
+
+namespace mg = mir::graphics;
+
+namespace
+{
+auto import_syncobj(int drm_fd, int syncobj) -> uint32_t
+{
+    uint32_t handle;
+    if (drmSyncobjFDToHandle(drm_fd, syncobj, &handle) != 0)
+    {
+        BOOST_THROW_EXCEPTION((std::system_error{errno, std::system_category(), "Failed to import DRM syncobj"}));
+    }
+    return handle;
+}
+
+/// A binary syncobj, to move a single fence between a timeline and a sync_file
+class BinarySyncobj
+{
+public:
+    explicit BinarySyncobj(int drm_fd)
+        : drm_fd{drm_fd}
+    {
+        if (drmSyncobjCreate(drm_fd, 0, &handle) != 0)
+        {
+            BOOST_THROW_EXCEPTION((std::system_error{errno, std::system_category(), "Failed to create DRM syncobj"}));
+        }
+    }
+
+    ~BinarySyncobj()
+    {
+        drmSyncobjDestroy(drm_fd, handle);
+    }
+
+    BinarySyncobj(BinarySyncobj const&) = delete;
+    BinarySyncobj& operator=(BinarySyncobj const&) = delete;
+
+    int const drm_fd;
+    uint32_t handle;
+};
+}
+
+mg::DRMTimeline::DRMTimeline(mir::Fd drm_fd, mir::Fd const& syncobj)
+    : drm_fd{std::move(drm_fd)},
+      handle{import_syncobj(this->drm_fd, syncobj)}
+{
+}
+
+mg::DRMTimeline::~DRMTimeline()
+{
+    drmSyncobjDestroy(drm_fd, handle);
+}
+
+auto mg::DRMTimeline::has_fence_for(uint64_t point) const -> bool
+{
+    auto handle = this->handle;
+    // A deadline in the past doesn't wait at all
+    if (drmSyncobjTimelineWait(drm_fd, &handle, &point, 1, 0, DRM_SYNCOBJ_WAIT_FLAGS_WAIT_AVAILABLE, nullptr) != 0)
+    {
+        if (errno == ETIME)
+        {
+            return false;
+        }
+        BOOST_THROW_EXCEPTION((std::system_error{errno, std::system_category(), "Failed to query DRM timeline point"}));
+    }
+    return true;
+}
+
+auto mg::DRMTimeline::eventfd_for_fence(uint64_t point) const -> mir::Fd
+{
+    mir::Fd const notify{eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)};
+    if (notify == mir::Fd::invalid)
+    {
+        BOOST_THROW_EXCEPTION((std::system_error{errno, std::system_category(), "Failed to create eventfd"}));
+    }
+    if (drmSyncobjEventfd(drm_fd, handle, point, notify, DRM_SYNCOBJ_WAIT_FLAGS_WAIT_AVAILABLE) != 0)
+    {
+        BOOST_THROW_EXCEPTION((std::system_error{errno, std::system_category(), "Failed to watch DRM timeline point"}));
+    }
+    return notify;
+}
+
+auto mg::DRMTimeline::sync_file_for(uint64_t point) const -> mir::Fd
+{
+    if (!has_fence_for(point))
+    {
+        BOOST_THROW_EXCEPTION((std::system_error{ETIME, std::system_category(), "No fence for DRM timeline point"}));
+    }
+
+    // sync_files can only be exported from binary syncobjs
+    BinarySyncobj const binary{drm_fd};
+    if (drmSyncobjTransfer(drm_fd, binary.handle, 0, this->handle, point, 0) != 0)
+    {
+        BOOST_THROW_EXCEPTION((std::system_error{errno, std::system_category(), "Failed to transfer DRM timeline point"}));
+    }
+
+    int sync_file;
+    if (drmSyncobjExportSyncFile(drm_fd, binary.handle, &sync_file) != 0)
+    {
+        BOOST_THROW_EXCEPTION((std::system_error{errno, std::system_category(), "Failed to export sync_file"}));
+    }
+    return mir::Fd{sync_file};
+}
+
+void mg::DRMTimeline::signal_after(uint64_t point, mir::Fd const& sync_file)
+{
+    BinarySyncobj const binary{drm_fd};
+    if (drmSyncobjImportSyncFile(drm_fd, binary.handle, sync_file) != 0)
+    {
+        BOOST_THROW_EXCEPTION((std::system_error{errno, std::system_category(), "Failed to import sync_file"}));
+    }
+    if (drmSyncobjTransfer(drm_fd, handle, point, binary.handle, 0, 0) != 0)
+    {
+        BOOST_THROW_EXCEPTION((std::system_error{errno, std::system_category(), "Failed to transfer to DRM timeline point"}));
+    }
+}
+
+void mg::DRMTimeline::signal(uint64_t point)
+{
+    auto handle = this->handle;
+    if (drmSyncobjTimelineSignal(drm_fd, &handle, &point, 1) != 0)
+    {
+        BOOST_THROW_EXCEPTION((std::system_error{errno, std::system_category(), "Failed to signal DRM timeline point"}));
+    }
+}
+
+void mg::DRMTimeline::release(uint64_t point, std::optional<mir::Fd> const& fence) noexcept
+{
+    if (fence)
+    {
+        try
+        {
+            signal_after(point, *fence);
+            return;
+        }
+        catch (std::exception const& error)
+        {
+            mir::log_warning("Failed to fence client buffer release point: %s", error.what());
+        }
+    }
+
+    try
+    {
+        signal(point);
+    }
+    catch (std::exception const& error)
+    {
+        mir::log_warning("Failed to signal client buffer release point: %s", error.what());
+    }
+}
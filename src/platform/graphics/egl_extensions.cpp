@@ -253,3 +253,77 @@ auto mg::EGLExtensions::MESADmaBufExport::extension_if_supported(EGLDisplay dpy)
     }
 }
 
+mg::EGLExtensions::FenceSyncKHR::FenceSyncKHR(EGLDisplay dpy)
+    : eglCreateSyncKHR{
+          reinterpret_cast<PFNEGLCREATESYNCKHRPROC>(
+              eglGetProcAddress("eglCreateSyncKHR"))},
+      eglDestroySyncKHR{
+          reinterpret_cast<PFNEGLDESTROYSYNCKHRPROC>(
+              eglGetProcAddress("eglDestroySyncKHR"))},
+      eglClientWaitSyncKHR{
+          reinterpret_cast<PFNEGLCLIENTWAITSYNCKHRPROC>(
+              eglGetProcAddress("eglClientWaitSyncKHR"))}
+{
+    auto const egl_extensions = eglQueryString(dpy, EGL_EXTENSIONS);
+    if (!egl_extensions ||
+        !strstr(egl_extensions, "EGL_KHR_fence_sync") ||
+        !eglCreateSyncKHR ||
+        !eglDestroySyncKHR ||
+        !eglClientWaitSyncKHR)
+    {
+        BOOST_THROW_EXCEPTION((std::runtime_error{"Missing required EGL_KHR_fence_sync extension"}));
+    }
+}
+
+auto mg::EGLExtensions::FenceSyncKHR::extension_if_supported(EGLDisplay dpy) -> std::optional<FenceSyncKHR>
+{
+    try
+    {
+        return FenceSyncKHR{dpy};
+    }
+    catch (std::runtime_error const&)
+    {
+        return std::nullopt;
+    }
+}
+
+mg::EGLExtensions::NativeFenceSyncANDROID::NativeFenceSyncANDROID(EGLDisplay dpy)
+    : eglCreateSyncKHR{
+          reinterpret_cast<PFNEGLCREATESYNCKHRPROC>(
+              eglGetProcAddress("eglCreateSyncKHR"))},
+      eglDestroySyncKHR{
+          reinterpret_cast<PFNEGLDESTROYSYNCKHRPROC>(
+              eglGetProcAddress("eglDestroySyncKHR"))},
+      eglWaitSyncKHR{
+          reinterpret_cast<PFNEGLWAITSYNCKHRPROC>(
+              eglGetProcAddress("eglWaitSyncKHR"))},
+      eglDupNativeFenceFDANDROID{
+          reinterpret_cast<PFNEGLDUPNATIVEFENCEFDANDROIDPROC>(
+              eglGetProcAddress("eglDupNativeFenceFDANDROID"))}
+{
+    auto const egl_extensions = eglQueryString(dpy, EGL_EXTENSIONS);
+    if (!egl_extensions ||
+        !strstr(egl_extensions, "EGL_ANDROID_native_fence_sync") ||
+        !strstr(egl_extensions, "EGL_KHR_wait_sync") ||
+        !eglCreateSyncKHR ||
+        !eglDestroySyncKHR ||
+        !eglWaitSyncKHR ||
+        !eglDupNativeFenceFDANDROID)
+    {
+        BOOST_THROW_EXCEPTION((std::runtime_error{"Missing required EGL_ANDROID_native_fence_sync extension"}));
+    }
+}
+
+auto mg::EGLExtensions::NativeFenceSyncANDROID::extension_if_supported(EGLDisplay dpy)
+    -> std::optional<NativeFenceSyncANDROID>
+{
+    try
+    {
+        return NativeFenceSyncANDROID{dpy};
+    }
+    catch (std::runtime_error const&)
+    {
+        return std::nullopt;
+    }
+}
+
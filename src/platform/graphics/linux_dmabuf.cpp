@@ -29,12 +29,29 @@
 #include "mir/graphics/buffer.h"
 #include "mir/graphics/buffer_basic.h"
 #include "mir/graphics/dmabuf_buffer.h"
+#include "mir/graphics/drm_syncobj.h"
 #include "mir/graphics/egl_context_executor.h"
+#include "mir/graphics/scanout_feedback.h"
+#include "mir/executor.h"
 
 #include <EGL/egl.h>
+#include <cerrno>
 #include <cstdint>
 #include <cstring>
 #include <stdexcept>
+#include <fcntl.h>
+#include <numeric>
+#include <limits>
+#include <linux/sync_file.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <system_error>
+#include <unistd.h>
+#include <unordered_map>
+#include <map>
+#include <atomic>
 
 #define MIR_LOG_COMPONENT "linux-dmabuf-import"
 #include "mir/log.h"
@@ -47,6 +64,10 @@
 #include <drm_fourcc.h>
 #include <wayland-server.h>
 
+#ifndef EGL_DRM_RENDER_NODE_FILE_EXT
+#define EGL_DRM_RENDER_NODE_FILE_EXT 0x3377
+#endif
+
 namespace mg = mir::graphics;
 namespace mgc = mg::common;
 namespace mw = mir::wayland;
@@ -608,7 +629,7 @@ public:
     LinuxDmaBufParams(
         wl_resource* new_resource,
         std::shared_ptr<mg::DMABufEGLProvider> provider)
-        : mir::wayland::LinuxBufferParamsV1(new_resource, Version<3>{}),
+        : mir::wayland::LinuxBufferParamsV1(new_resource, Version<4>{}),
           consumed{false},
           provider{std::move(provider)}
     {
@@ -863,6 +884,19 @@ GLuint get_tex_id()
     return tex;
 }
 
+/// A sync_file that signals once both a and b have
+auto merge_sync_files(mir::Fd const& a, mir::Fd const& b) -> mir::Fd
+{
+    sync_merge_data merge{};
+    strncpy(merge.name, "mir-reads", sizeof merge.name - 1);
+    merge.fd2 = b;
+    if (ioctl(a, SYNC_IOC_MERGE, &merge) < 0)
+    {
+        BOOST_THROW_EXCEPTION((std::system_error{errno, std::system_category(), "Failed to merge sync_files"}));
+    }
+    return mir::Fd{static_cast<int>(merge.fence)};
+}
+
 class DMABufTex : public mg::gl::Texture
 {
 public:
@@ -871,11 +905,14 @@ public:
         mg::EGLExtensions const& extensions,
         mg::DMABufBuffer const& dma_buf,
         BufferGLDescription const& descriptor,
-        std::shared_ptr<mgc::EGLContextExecutor> egl_delegate)
-        : tex{get_tex_id()},
+        std::shared_ptr<mgc::EGLContextExecutor> egl_delegate,
+        mg::EGLExtensions::NativeFenceSyncANDROID const* native_fence = nullptr)
+        : dpy{dpy},
+          tex{get_tex_id()},
           desc{descriptor},
           layout_{dma_buf.layout()},
-          egl_delegate{std::move(egl_delegate)}
+          egl_delegate{std::move(egl_delegate)},
+          native_fence{native_fence}
     {
         eglBindAPI(EGL_OPENGL_ES_API);
 
@@ -905,6 +942,10 @@ public:
 
     ~DMABufTex() override
     {
+        for (auto const& [context, last_read] : last_reads)
+        {
+            native_fence->eglDestroySyncKHR(dpy, last_read);
+        }
         egl_delegate->spawn(
             [tex = tex]()
             {
@@ -936,12 +977,113 @@ public:
 
     void add_syncpoint() override
     {
+        if (!tracking_reads || !native_fence)
+        {
+            return;
+        }
+
+        auto const read = native_fence->eglCreateSyncKHR(dpy, EGL_SYNC_NATIVE_FENCE_ANDROID, nullptr);
+        if (read == EGL_NO_SYNC_KHR)
+        {
+            return;
+        }
+
+        // Each output's renderer has its own context (and thread), and a context's reads complete in order:
+        // only the most recent read from each context matters
+        std::lock_guard lock{reads_mutex};
+        auto const [last_read, first_read] = last_reads.try_emplace(eglGetCurrentContext(), read);
+        if (!first_read)
+        {
+            native_fence->eglDestroySyncKHR(dpy, last_read->second);
+            last_read->second = read;
+        }
+    }
+
+    /// Have add_syncpoint() fence the renderer's reads, for last_read_fence()
+    void track_reads()
+    {
+        tracking_reads = true;
+    }
+
+    /**
+     * A sync_file that signals once the renderers' reads have completed
+     *
+     * \returns std::nullopt if the reads weren't tracked, or there were none
+     * \throws std::system_error if the reads of several renderers can't be combined into one fence
+     */
+    auto last_read_fence() const -> std::optional<mir::Fd>
+    {
+        std::lock_guard lock{reads_mutex};
+
+        std::optional<mir::Fd> all_reads;
+        for (auto const& [context, last_read] : last_reads)
+        {
+            // The fence is only exported once the commands before it are flushed, as they are by the time we post
+            auto const fd = native_fence->eglDupNativeFenceFDANDROID(dpy, last_read);
+            if (fd == EGL_NO_NATIVE_FENCE_FD_ANDROID)
+            {
+                continue;
+            }
+
+            mir::Fd read{fd};
+            all_reads = all_reads ? merge_sync_files(*all_reads, read) : std::move(read);
+        }
+        return all_reads;
+    }
+
+    /**
+     * Have subsequent reads from the current context wait until acquire has signalled
+     *
+     * The wait is queued on the GPU, so this never blocks. The frontend only
+     * applies a commit once its acquire point has a fence to wait on.
+     *
+     * \throws std::system_error if acquire has no fence, or it hasn't yet
+     *         signalled and the GPU can't wait for it.
+     */
+    void wait_for(mg::DRMTimelinePoint const& acquire)
+    {
+        auto const fence = acquire.timeline->sync_file_for(acquire.point);
+
+        if (native_fence)
+        {
+            // EGL takes ownership of the fd only if it successfully creates the sync
+            auto const fd = dup(fence);
+            EGLint const attribs[] = {EGL_SYNC_NATIVE_FENCE_FD_ANDROID, fd, EGL_NONE};
+            auto const sync = native_fence->eglCreateSyncKHR(dpy, EGL_SYNC_NATIVE_FENCE_ANDROID, attribs);
+            if (sync != EGL_NO_SYNC_KHR)
+            {
+                auto const waiting = native_fence->eglWaitSyncKHR(dpy, sync, 0);
+                native_fence->eglDestroySyncKHR(dpy, sync);
+                if (waiting == EGL_TRUE)
+                {
+                    return;
+                }
+            }
+            else if (fd >= 0)
+            {
+                close(fd);
+            }
+        }
+
+        // A sync_file is readable once its fence has signalled
+        pollfd readable{fence, POLLIN, 0};
+        if (poll(&readable, 1, 0) != 1)
+        {
+            BOOST_THROW_EXCEPTION((std::system_error{ETIME, std::system_category(), "Client drawing not complete"}));
+        }
     }
 private:
+    EGLDisplay const dpy;
     GLuint const tex;
     BufferGLDescription const& desc;
     Layout const layout_;
     std::shared_ptr<mgc::EGLContextExecutor> const egl_delegate;
+    mg::EGLExtensions::NativeFenceSyncANDROID const* const native_fence;
+
+    std::atomic<bool> tracking_reads{false};
+    std::mutex mutable reads_mutex;
+    /// The fence of the most recent read in each renderer's context
+    std::map<EGLContext, EGLSyncKHR> last_reads;
 };
 
 namespace
@@ -954,13 +1096,17 @@ auto format_has_known_alpha(mg::DRMFormat format) -> std::optional<bool>
 
 class DmabufTexBuffer :
     public mg::BufferBasic,
-    public mg::DMABufBuffer
+    public mg::DMABufBuffer,
+    public mg::ExplicitSyncBuffer,
+    public mg::ScanoutFeedbackBuffer,
+    public mg::DirectScanoutBuffer
 {
 public:
     // Note: Must be called with a current EGL context
     DmabufTexBuffer(
         EGLDisplay dpy,
         mg::EGLExtensions const& extensions,
+        mg::EGLExtensions::NativeFenceSyncANDROID const* native_fence,
         mg::DMABufBuffer const& dma_buf,
         BufferGLDescription const& descriptor,
         std::shared_ptr<mg::DMABufEGLProvider> provider,
@@ -968,7 +1114,7 @@ public:
         std::function<void()>&& on_consumed,
         std::function<void()>&& on_release)
         : dpy{dpy},
-          tex{dpy, extensions, dma_buf, descriptor, std::move(egl_delegate)},
+          tex{dpy, extensions, dma_buf, descriptor, std::move(egl_delegate), native_fence},
           provider_{std::move(provider)},
           on_consumed{std::move(on_consumed)},
           on_release{std::move(on_release)},
@@ -982,9 +1128,33 @@ public:
 
     ~DmabufTexBuffer() override
     {
+        if (release)
+        {
+            signal_release(*release);
+        }
         on_release();
     }
 
+    void set_scanout_feedback(std::shared_ptr<mg::ScanoutFeedback> feedback) override
+    {
+        std::lock_guard lock{consumed_mutex};
+        scanout_feedback_ = std::move(feedback);
+    }
+
+    auto scanout_feedback() const -> std::shared_ptr<mg::ScanoutFeedback> override
+    {
+        std::lock_guard lock{consumed_mutex};
+        return scanout_feedback_;
+    }
+
+    void set_sync_points(mg::DRMTimelinePoint acquire, mg::DRMTimelinePoint release) override
+    {
+        std::lock_guard lock{consumed_mutex};
+        this->acquire = std::move(acquire);
+        this->release = std::move(release);
+        tex.track_reads();
+    }
+
     auto on_same_egl_display(EGLDisplay dpy) -> bool
     {
         return this->dpy == dpy;
@@ -1027,9 +1197,52 @@ public:
         on_consumed();
         on_consumed = [](){};
 
+        if (acquire)
+        {
+            try
+            {
+                tex.wait_for(*acquire);
+            }
+            catch (std::exception const& error)
+            {
+                // Showing what may be an incomplete frame beats stalling the compositor on a client
+                mir::log_warning("Failed to wait for client buffer acquire point: %s", error.what());
+            }
+            acquire.reset();
+        }
+
         return &tex;
     }
 
+    auto ready_for_scanout() const -> bool override
+    {
+        std::lock_guard lock{consumed_mutex};
+        if (!acquire)
+        {
+            return true;
+        }
+
+        // The display can't wait for the client's drawing like the GPU can; only show finished frames
+        try
+        {
+            auto const fence = acquire->timeline->sync_file_for(acquire->point);
+            pollfd readable{fence, POLLIN, 0};
+            return poll(&readable, 1, 0) == 1;
+        }
+        catch (std::system_error const&)
+        {
+            return false;
+        }
+    }
+
+    void claim_for_scanout() override
+    {
+        std::lock_guard lock{consumed_mutex};
+        acquire.reset();
+        on_consumed();
+        on_consumed = [](){};
+    }
+
     auto format() const -> mg::DRMFormat override
     {
         return format_;
@@ -1055,14 +1268,32 @@ public:
         return provider_;
     }
 private:
+    /// Let the client reuse the buffer once our reads of it have completed
+    void signal_release(mg::DRMTimelinePoint const& release)
+    {
+        std::optional<mir::Fd> reads;
+        try
+        {
+            reads = tex.last_read_fence();
+        }
+        catch (std::exception const& error)
+        {
+            mir::log_warning("Failed to fence client buffer release point: %s", error.what());
+        }
+        release.timeline->release(release.point, reads);
+    }
+
     EGLDisplay const dpy;
     DMABufTex tex;
 
     std::shared_ptr<mg::DMABufEGLProvider> const provider_;
 
-    std::mutex consumed_mutex;
+    std::mutex mutable consumed_mutex;
     std::function<void()> on_consumed;
     std::function<void()> const on_release;
+    std::optional<mg::DRMTimelinePoint> acquire;
+    std::optional<mg::DRMTimelinePoint> release;
+    std::shared_ptr<mg::ScanoutFeedback> scanout_feedback_;
 
     geom::Size const size_;
     bool const has_alpha;
@@ -1072,18 +1303,358 @@ private:
     mg::DRMFormat const format_;
 };
 
+/**
+ * The format_table of zwp_linux_dmabuf_feedback_v1
+ *
+ * A sealed memfd of every format/modifier pair we can import, shared
+ * read-only with every client; tranches refer to pairs by their index.
+ */
+class FormatTable
+{
+public:
+    explicit FormatTable(mg::DmaBufFormatDescriptors const& formats)
+    {
+        for (auto i = 0u; i < formats.num_formats(); ++i)
+        {
+            auto [format, modifiers, external_only] = formats[i];
+            for (auto const modifier : modifiers)
+            {
+                // Tranches index the table with a uint16_t
+                if (entries.size() <= std::numeric_limits<uint16_t>::max())
+                {
+                    entries.emplace_back(static_cast<uint32_t>(format), modifier);
+                }
+            }
+        }
+
+        struct Entry
+        {
+            uint32_t format;
+            uint32_t padding;
+            uint64_t modifier;
+        };
+        static_assert(sizeof(Entry) == 16, "zwp_linux_dmabuf_feedback_v1 format table entries are 16 bytes");
+
+        std::vector<Entry> table;
+        table.reserve(entries.size());
+        for (auto const& [format, modifier] : entries)
+        {
+            table.push_back(Entry{format, 0, modifier});
+        }
+        size_ = table.size() * sizeof(Entry);
 
+        fd_ = mir::Fd{memfd_create("mir-dmabuf-format-table", MFD_CLOEXEC | MFD_ALLOW_SEALING)};
+        if (fd_ < 0)
+        {
+            BOOST_THROW_EXCEPTION((std::system_error{errno, std::system_category(), "Failed to create format table"}));
+        }
+        if (write(fd_, table.data(), size_) != static_cast<ssize_t>(size_))
+        {
+            BOOST_THROW_EXCEPTION((std::system_error{errno, std::system_category(), "Failed to write format table"}));
+        }
+        // Every client maps the same file, so no client may change it
+        if (fcntl(fd_, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL) < 0)
+        {
+            BOOST_THROW_EXCEPTION((std::system_error{errno, std::system_category(), "Failed to seal format table"}));
+        }
+    }
+
+    auto fd() const -> mir::Fd
+    {
+        return fd_;
+    }
+
+    auto size() const -> uint32_t
+    {
+        return size_;
+    }
+
+    /// The indices of every pair in formats that is in the table
+    auto indices_of(std::vector<std::pair<uint32_t, uint64_t>> const& formats) const -> std::vector<uint16_t>
+    {
+        std::vector<uint16_t> indices;
+        for (auto i = 0u; i < entries.size(); ++i)
+        {
+            if (std::find(formats.begin(), formats.end(), entries[i]) != formats.end())
+            {
+                indices.push_back(i);
+            }
+        }
+        return indices;
+    }
+
+    auto all_indices() const -> std::vector<uint16_t>
+    {
+        std::vector<uint16_t> indices(entries.size());
+        std::iota(indices.begin(), indices.end(), 0);
+        return indices;
+    }
+
+private:
+    std::vector<std::pair<uint32_t, uint64_t>> entries;
+    mir::Fd fd_;
+    size_t size_;
+};
+
+/// A wl_array holding a copy of some values, for the duration of an event
+template<typename T>
+class WlArray
+{
+public:
+    explicit WlArray(std::span<T const> values)
+    {
+        wl_array_init(&array);
+        if (!values.empty())
+        {
+            auto const data = wl_array_add(&array, values.size_bytes());
+            memcpy(data, values.data(), values.size_bytes());
+        }
+    }
+
+    ~WlArray()
+    {
+        wl_array_release(&array);
+    }
+
+    WlArray(WlArray const&) = delete;
+    WlArray& operator=(WlArray const&) = delete;
+
+    operator wl_array*()
+    {
+        return &array;
+    }
+
+private:
+    wl_array array;
+};
+
+class Feedback : public mw::LinuxDmabufFeedbackV1
+{
+public:
+    explicit Feedback(wl_resource* new_resource)
+        : LinuxDmabufFeedbackV1(new_resource, Version<4>{})
+    {
+    }
+
+    /**
+     * Send a complete set of feedback
+     *
+     * The scanout tranche, if any, comes first as the client should prefer it;
+     * the main tranche is everything we can import.
+     */
+    void send_feedback(
+        FormatTable const& table,
+        dev_t main_device,
+        std::optional<mg::ScanoutTranche> const& scanout)
+    {
+        send_format_table_event(table.fd(), table.size());
+        send_main_device_event(WlArray<dev_t>{std::span{&main_device, 1}});
+
+        if (scanout)
+        {
+            auto const indices = table.indices_of(scanout->formats);
+            if (!indices.empty())
+            {
+                send_tranche(scanout->device, TrancheFlags::scanout, indices);
+            }
+        }
+        send_tranche(main_device, 0, table.all_indices());
+
+        send_done_event();
+    }
+
+private:
+    void send_tranche(dev_t device, uint32_t flags, std::vector<uint16_t> const& indices)
+    {
+        send_tranche_target_device_event(WlArray<dev_t>{std::span{&device, 1}});
+        send_tranche_flags_event(flags);
+        send_tranche_formats_event(WlArray<uint16_t>{std::span<uint16_t const>{indices}});
+        send_tranche_done_event();
+    }
+};
+
+/**
+ * The feedback for a surface, shared by the surface's buffers
+ *
+ * Threadsafety: scanout_tranche_changed() may be called from any thread; everything
+ * else must be called on the Wayland thread.
+ */
+class SurfaceFeedback : public mg::ScanoutFeedback, public std::enable_shared_from_this<SurfaceFeedback>
+{
+public:
+    SurfaceFeedback(
+        std::shared_ptr<FormatTable const> table,
+        dev_t main_device,
+        std::shared_ptr<mir::Executor> wayland_executor)
+        : table{std::move(table)},
+          main_device{main_device},
+          wayland_executor{std::move(wayland_executor)}
+    {
+    }
+
+    void add(Feedback* feedback)
+    {
+        std::erase_if(feedbacks, [](auto const& weak) { return !weak; });
+        feedbacks.push_back(mw::make_weak(feedback));
+        feedback->send_feedback(*table, main_device, scanout);
+    }
+
+    /// Feedback objects of a destroyed surface are inert
+    void surface_destroyed()
+    {
+        feedbacks.clear();
+    }
+
+    void scanout_tranche_changed(std::optional<mg::ScanoutTranche> const& tranche) override
+    {
+        wayland_executor->spawn(
+            [weak_self = weak_from_this(), tranche]()
+            {
+                if (auto const self = weak_self.lock())
+                {
+                    self->update(tranche);
+                }
+            });
+    }
+
+private:
+    void update(std::optional<mg::ScanoutTranche> const& tranche)
+    {
+        if (tranche == scanout)
+        {
+            return;
+        }
+        scanout = tranche;
+
+        for (auto const& feedback : feedbacks)
+        {
+            if (feedback)
+            {
+                feedback.value().send_feedback(*table, main_device, scanout);
+            }
+        }
+    }
+
+    std::shared_ptr<FormatTable const> const table;
+    dev_t const main_device;
+    std::shared_ptr<mir::Executor> const wayland_executor;
+    std::vector<mw::Weak<Feedback>> feedbacks;
+    std::optional<mg::ScanoutTranche> scanout;
+};
 }
 
+/**
+ * The per-surface feedback of every surface a client has asked about
+ *
+ * Threadsafety: This must only be accessed from the Wayland thread
+ */
+class mg::LinuxDmaBufUnstable::FeedbackSources
+{
+public:
+    FeedbackSources(
+        std::shared_ptr<FormatTable const> table,
+        dev_t main_device,
+        std::shared_ptr<Executor> wayland_executor)
+        : table{std::move(table)},
+          main_device{main_device},
+          wayland_executor{std::move(wayland_executor)}
+    {
+    }
+
+    ~FeedbackSources()
+    {
+        for (auto& [surface, entry] : surfaces)
+        {
+            wl_list_remove(&entry->destruction_listener.link);
+        }
+    }
+
+    FeedbackSources(FeedbackSources const&) = delete;
+    FeedbackSources& operator=(FeedbackSources const&) = delete;
+
+    void send_default_feedback(Feedback& feedback) const
+    {
+        feedback.send_feedback(*table, main_device, std::nullopt);
+    }
+
+    auto for_surface(wl_resource* surface) -> std::shared_ptr<SurfaceFeedback>
+    {
+        if (auto const existing = existing_for(surface))
+        {
+            return existing;
+        }
+
+        auto entry = std::make_unique<SurfaceEntry>(
+            this,
+            surface,
+            std::make_shared<SurfaceFeedback>(table, main_device, wayland_executor));
+        entry->destruction_listener.notify = &on_surface_destroyed;
+        wl_resource_add_destroy_listener(surface, &entry->destruction_listener);
+
+        auto const feedback = entry->feedback;
+        surfaces.emplace(surface, std::move(entry));
+        return feedback;
+    }
+
+    /// \returns nullptr if no client has asked for feedback for surface
+    auto existing_for(wl_resource* surface) const -> std::shared_ptr<SurfaceFeedback>
+    {
+        if (auto const found = surfaces.find(surface); found != surfaces.end())
+        {
+            return found->second->feedback;
+        }
+        return nullptr;
+    }
+
+private:
+    struct SurfaceEntry
+    {
+        SurfaceEntry(FeedbackSources* owner, wl_resource* surface, std::shared_ptr<SurfaceFeedback> feedback)
+            : owner{owner},
+              surface{surface},
+              feedback{std::move(feedback)}
+        {
+        }
+
+        FeedbackSources* const owner;
+        wl_resource* const surface;
+        std::shared_ptr<SurfaceFeedback> const feedback;
+        wl_listener destruction_listener{};
+    };
+
+    static void on_surface_destroyed(wl_listener* listener, void*)
+    {
+        SurfaceEntry* entry;
+        entry = wl_container_of(listener, entry, destruction_listener);
+        // The surface's buffers may still hold its feedback, but it has nothing more to send to
+        wl_list_remove(&entry->destruction_listener.link);
+        entry->feedback->surface_destroyed();
+        entry->owner->surfaces.erase(entry->surface);
+    }
+
+    std::shared_ptr<FormatTable const> const table;
+    dev_t const main_device;
+    std::shared_ptr<Executor> const wayland_executor;
+    std::unordered_map<wl_resource*, std::unique_ptr<SurfaceEntry>> surfaces;
+};
+
 class mg::LinuxDmaBufUnstable::Instance : public mir::wayland::LinuxDmabufV1
 {
 public:
     Instance(
         wl_resource* new_resource,
-        std::shared_ptr<mg::DMABufEGLProvider> provider)
-        : mir::wayland::LinuxDmabufV1(new_resource, Version<3>{}),
-          provider{std::move(provider)}
+        std::shared_ptr<mg::DMABufEGLProvider> provider,
+        std::shared_ptr<FeedbackSources> feedback_sources)
+        : mir::wayland::LinuxDmabufV1(new_resource, Version<4>{}),
+          provider{std::move(provider)},
+          feedback_sources{std::move(feedback_sources)}
     {
+        if (wl_resource_get_version(resource) >= 4)
+        {
+            // From version 4 clients get their formats from zwp_linux_dmabuf_feedback_v1
+            return;
+        }
+
         auto const& formats = this->provider->supported_formats();
         for (auto i = 0u; i < formats.num_formats(); ++i)
         {
@@ -1106,15 +1677,48 @@ private:
         new LinuxDmaBufParams{params_id, provider};
     }
 
+    void get_default_feedback(struct wl_resource* id) override
+    {
+        feedback_sources->send_default_feedback(*new Feedback{id});
+    }
+
+    void get_surface_feedback(struct wl_resource* id, struct wl_resource* surface) override
+    {
+        feedback_sources->for_surface(surface)->add(new Feedback{id});
+    }
+
     std::shared_ptr<mg::DMABufEGLProvider> const provider;
+    std::shared_ptr<FeedbackSources> const feedback_sources;
 };
 
 mg::LinuxDmaBufUnstable::LinuxDmaBufUnstable(
     wl_display* display,
-    std::shared_ptr<mg::DMABufEGLProvider> provider)
-    : mir::wayland::LinuxDmabufV1::Global(display, Version<3>{}),
-      provider{std::move(provider)}
+    std::shared_ptr<mg::DMABufEGLProvider> provider,
+    std::shared_ptr<Executor> wayland_executor)
+    : LinuxDmaBufUnstable{display, provider, provider->main_device(), std::move(wayland_executor)}
+{
+}
+
+mg::LinuxDmaBufUnstable::LinuxDmaBufUnstable(
+    wl_display* display,
+    std::shared_ptr<mg::DMABufEGLProvider> provider,
+    std::optional<dev_t> main_device,
+    std::shared_ptr<Executor> wayland_executor)
+    // Version 4 feedback has to name a main device, so without one clients get their formats the version 3 way
+    : mir::wayland::LinuxDmabufV1::Global(display, Version<4>{}, main_device ? 4 : 3),
+      provider{std::move(provider)},
+      feedback_sources{
+          std::make_shared<FeedbackSources>(
+              std::make_shared<FormatTable>(this->provider->supported_formats()),
+              // Only version 4 clients ask for feedback, and they only can when there's a main device
+              main_device.value_or(0),
+              std::move(wayland_executor))}
+{
+}
+
+auto mg::LinuxDmaBufUnstable::scanout_feedback_for(wl_resource* surface) -> std::shared_ptr<ScanoutFeedback>
 {
+    return feedback_sources->existing_for(surface);
 }
 
 auto mg::LinuxDmaBufUnstable::buffer_from_resource(
@@ -1136,7 +1740,7 @@ auto mg::LinuxDmaBufUnstable::buffer_from_resource(
 
 void mg::LinuxDmaBufUnstable::bind(wl_resource* new_resource)
 {
-    new LinuxDmaBufUnstable::Instance{new_resource, provider};
+    new LinuxDmaBufUnstable::Instance{new_resource, provider, feedback_sources};
 }
 
 mg::DMABufEGLProvider::DMABufEGLProvider(
@@ -1148,6 +1752,7 @@ mg::DMABufEGLProvider::DMABufEGLProvider(
     : dpy{dpy},
       egl_extensions{std::move(egl_extensions)},
       dmabuf_export_ext{mg::EGLExtensions::MESADmaBufExport::extension_if_supported(dpy)},
+      native_fence_ext{mg::EGLExtensions::NativeFenceSyncANDROID::extension_if_supported(dpy)},
       formats{std::make_unique<DmaBufFormatDescriptors>(dpy, dmabuf_ext)},
       egl_delegate{std::move(egl_delegate)},
       allocate_importable_image{std::move(allocate_importable_image)},
@@ -1162,6 +1767,56 @@ auto mg::DMABufEGLProvider::supported_formats() const -> mg::DmaBufFormatDescrip
     return *formats;
 }
 
+auto mg::DMABufEGLProvider::main_device() const -> std::optional<dev_t>
+{
+    auto const client_extensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    auto const query_display_attrib = reinterpret_cast<PFNEGLQUERYDISPLAYATTRIBEXTPROC>(
+        eglGetProcAddress("eglQueryDisplayAttribEXT"));
+    auto const query_device_string = reinterpret_cast<PFNEGLQUERYDEVICESTRINGEXTPROC>(
+        eglGetProcAddress("eglQueryDeviceStringEXT"));
+    if (!client_extensions ||
+        !(strstr(client_extensions, "EGL_EXT_device_query") || strstr(client_extensions, "EGL_EXT_device_base")) ||
+        !query_display_attrib ||
+        !query_device_string)
+    {
+        mir::log_warning("EGL_EXT_device_query unsupported; cannot tell dma-buf clients which device we use");
+        return std::nullopt;
+    }
+
+    EGLAttrib device_attrib;
+    if (query_display_attrib(dpy, EGL_DEVICE_EXT, &device_attrib) != EGL_TRUE)
+    {
+        mir::log_warning("Failed to query EGLDevice: %s", mg::egl_category().message(eglGetError()).c_str());
+        return std::nullopt;
+    }
+    auto const device = reinterpret_cast<EGLDeviceEXT>(device_attrib);
+
+    // Prefer the render node, as that's what clients render with
+    auto const device_extensions = query_device_string(device, EGL_EXTENSIONS);
+    char const* path{nullptr};
+    if (device_extensions && strstr(device_extensions, "EGL_EXT_device_drm_render_node"))
+    {
+        path = query_device_string(device, EGL_DRM_RENDER_NODE_FILE_EXT);
+    }
+    if (!path && device_extensions && strstr(device_extensions, "EGL_EXT_device_drm"))
+    {
+        path = query_device_string(device, EGL_DRM_DEVICE_FILE_EXT);
+    }
+    if (!path)
+    {
+        mir::log_warning("EGLDevice has no DRM device; cannot tell dma-buf clients which device we use");
+        return std::nullopt;
+    }
+
+    struct stat info;
+    if (stat(path, &info) != 0)
+    {
+        mir::log_warning("Failed to stat %s: %s", path, strerror(errno));
+        return std::nullopt;
+    }
+    return info.st_rdev;
+}
+
 auto mg::DMABufEGLProvider::import_dma_buf(
     mg::DMABufBuffer const& dma_buf,
     std::function<void()>&& on_consumed,
@@ -1175,6 +1830,7 @@ auto mg::DMABufEGLProvider::import_dma_buf(
     return std::make_shared<DmabufTexBuffer>(
         dpy,
         *egl_extensions,
+        native_fence_ext ? &*native_fence_ext : nullptr,
         dma_buf,
         *descriptor,
         shared_from_this(),
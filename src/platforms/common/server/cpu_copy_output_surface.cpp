@@ -16,6 +16,7 @@
 
 #include <GLES2/gl2.h>
 #include <GLES2/gl2ext.h>
+#include <GLES3/gl3.h>
 
 #include <EGL/egl.h>
 #include <EGL/eglext.h>
@@ -23,14 +24,22 @@
 #include <drm_fourcc.h>
 
 #include "mir/graphics/egl_error.h"
+#include "mir/graphics/egl_extensions.h"
 #include "mir/graphics/platform.h"
 #include "mir/graphics/gl_config.h"
 #include "mir/log.h"
 
 #include "cpu_copy_output_surface.h"
 
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+
 namespace mg = mir::graphics;
 namespace mgc = mg::common;
+namespace mrs = mir::renderer::software;
 namespace geom = mir::geometry;
 
 namespace
@@ -70,15 +79,11 @@ private:
 
 using RenderbufferHandle = GLHandle<&glGenRenderbuffers, &glDeleteRenderbuffers>;
 using FramebufferHandle = GLHandle<&glGenFramebuffers, &glDeleteFramebuffers>;
+using BufferHandle = GLHandle<&glGenBuffers, &glDeleteBuffers>;
 
 auto create_current_context(EGLDisplay dpy, EGLContext share_ctx)
     -> EGLContext
 {
-    static const EGLint context_attr[] = {
-        EGL_CONTEXT_CLIENT_VERSION, 2,
-        EGL_NONE
-    };
-
     auto egl_extensions = eglQueryString(dpy, EGL_EXTENSIONS);
     if (strstr(egl_extensions, "EGL_KHR_no_config_context") == nullptr)
     {
@@ -87,7 +92,22 @@ auto create_current_context(EGLDisplay dpy, EGLContext share_ctx)
     }
 
     eglBindAPI(EGL_OPENGL_ES_API);
-    auto ctx = eglCreateContext(dpy, EGL_NO_CONFIG_KHR, share_ctx, context_attr);
+
+    // GLES 3 gets us pixel-pack buffers for asynchronous readback, but GLES 2 will do
+    EGLContext ctx = EGL_NO_CONTEXT;
+    for (EGLint const version : {3, 2})
+    {
+        EGLint const context_attr[] = {
+            EGL_CONTEXT_CLIENT_VERSION, version,
+            EGL_NONE
+        };
+
+        ctx = eglCreateContext(dpy, EGL_NO_CONFIG_KHR, share_ctx, context_attr);
+        if (ctx != EGL_NO_CONTEXT)
+        {
+            break;
+        }
+    }
 
     if (eglMakeCurrent(dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, ctx) != EGL_TRUE)
     {
@@ -120,6 +140,193 @@ auto select_format_from(mg::CPUAddressableDisplayAllocator const& provider) -> m
     }
     BOOST_THROW_EXCEPTION((std::runtime_error{"Non-?RGB8888 formats not yet supported for display"}));
 }
+
+auto gl_major_version() -> int
+{
+    auto const version = reinterpret_cast<char const*>(glGetString(GL_VERSION));
+    char const prefix[] = "OpenGL ES ";
+    if (!version || strncmp(version, prefix, sizeof(prefix) - 1) != 0)
+    {
+        return 0;
+    }
+    return atoi(version + sizeof(prefix) - 1);
+}
+
+/// Rows [top, bottom) of the framebuffer, in GL window coordinates
+struct RowSpan
+{
+    int top;
+    int bottom;
+};
+
+/// The rows covered by damage, in order, with overlapping and adjacent runs merged
+auto rows_covered_by(std::vector<geom::Rectangle> const& damage, int height) -> std::vector<RowSpan>
+{
+    std::vector<RowSpan> spans;
+    for (auto const& rect : damage)
+    {
+        auto const top = std::max(rect.top_left.y.as_int(), 0);
+        auto const bottom = std::min(rect.bottom().as_int(), height);
+        if (top < bottom)
+        {
+            spans.push_back({top, bottom});
+        }
+    }
+
+    std::sort(spans.begin(), spans.end(), [](auto const& a, auto const& b) { return a.top < b.top; });
+
+    std::vector<RowSpan> merged;
+    for (auto const& span : spans)
+    {
+        if (!merged.empty() && span.top <= merged.back().bottom)
+        {
+            merged.back().bottom = std::max(merged.back().bottom, span.bottom);
+        }
+        else
+        {
+            merged.push_back(span);
+        }
+    }
+    return merged;
+}
+
+/**
+ * Reads the framebuffer back through a ring of pixel-pack buffers
+ *
+ * The rows to read are split into bands, each read into its own buffer and
+ * fenced. Rather than glReadPixels() blocking until everything rendered so
+ * far is done and copied, the GPU can be copying out one band while the CPU
+ * copies the previous one into the output.
+ */
+class PixelPackPipeline
+{
+public:
+    PixelPackPipeline(EGLDisplay dpy, mg::EGLExtensions::FenceSyncKHR fence_sync, geom::Size size)
+        : dpy{dpy},
+          fence_sync{fence_sync},
+          width{size.width.as_int()},
+          row_bytes{static_cast<size_t>(width) * 4}
+    {
+        for (auto& band : bands)
+        {
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, band.pbo);
+            glBufferData(GL_PIXEL_PACK_BUFFER, rows_per_band * row_bytes, nullptr, GL_STREAM_READ);
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    }
+
+    ~PixelPackPipeline()
+    {
+        for (auto& band : bands)
+        {
+            if (band.fence != EGL_NO_SYNC_KHR)
+            {
+                fence_sync.eglDestroySyncKHR(dpy, band.fence);
+            }
+        }
+    }
+
+    void read(std::vector<RowSpan> const& spans, GLenum pixel_layout, mrs::Mapping<unsigned char>& into)
+    {
+        size_t next{0};
+        for (auto const& span : spans)
+        {
+            for (auto top = span.top; top < span.bottom; top += rows_per_band)
+            {
+                auto& band = bands[next++ % bands.size()];
+                if (band.fence != EGL_NO_SYNC_KHR)
+                {
+                    finish(band, into);
+                }
+                start(band, {top, std::min(top + rows_per_band, span.bottom)}, pixel_layout);
+            }
+        }
+
+        // Drain the ring, oldest band first
+        for (size_t i = 0; i != bands.size(); ++i)
+        {
+            auto& band = bands[(next + i) % bands.size()];
+            if (band.fence != EGL_NO_SYNC_KHR)
+            {
+                finish(band, into);
+            }
+        }
+    }
+
+private:
+    static int constexpr rows_per_band{128};
+
+    struct Band
+    {
+        BufferHandle pbo;
+        EGLSyncKHR fence{EGL_NO_SYNC_KHR};
+        RowSpan rows{0, 0};
+    };
+
+    void start(Band& band, RowSpan rows, GLenum pixel_layout)
+    {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, band.pbo);
+        glReadPixels(0, rows.top, width, rows.bottom - rows.top, pixel_layout, GL_UNSIGNED_BYTE, nullptr);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+        band.fence = fence_sync.eglCreateSyncKHR(dpy, EGL_SYNC_FENCE_KHR, nullptr);
+        if (band.fence == EGL_NO_SYNC_KHR)
+        {
+            BOOST_THROW_EXCEPTION((mg::egl_error("Failed to create fence for pixel readback")));
+        }
+        band.rows = rows;
+
+        // Get the GPU started on this band while we copy out the last one
+        glFlush();
+    }
+
+    void finish(Band& band, mrs::Mapping<unsigned char>& into)
+    {
+        fence_sync.eglClientWaitSyncKHR(dpy, band.fence, EGL_SYNC_FLUSH_COMMANDS_BIT_KHR, EGL_FOREVER_KHR);
+        fence_sync.eglDestroySyncKHR(dpy, band.fence);
+        band.fence = EGL_NO_SYNC_KHR;
+
+        auto const rows = static_cast<size_t>(band.rows.bottom - band.rows.top);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, band.pbo);
+        auto const pixels = static_cast<unsigned char const*>(
+            glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, rows * row_bytes, GL_MAP_READ_BIT));
+        if (!pixels)
+        {
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+            BOOST_THROW_EXCEPTION((mg::gl_error("Failed to map pixel readback buffer")));
+        }
+
+        auto const stride = into.stride().as_uint32_t();
+        for (size_t row = 0; row != rows; ++row)
+        {
+            memcpy(into.data() + (band.rows.top + row) * stride, pixels + row * row_bytes, row_bytes);
+        }
+
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    }
+
+    EGLDisplay const dpy;
+    mg::EGLExtensions::FenceSyncKHR const fence_sync;
+    int const width;
+    size_t const row_bytes;
+    std::array<Band, 3> bands;
+};
+
+auto create_pixel_pack_pipeline(EGLDisplay dpy, geom::Size size) -> std::unique_ptr<PixelPackPipeline>
+{
+    if (gl_major_version() < 3)
+    {
+        mir::log_debug("GLES 3 unavailable; reading back rendered frames synchronously");
+        return nullptr;
+    }
+    if (auto fence_sync = mg::EGLExtensions::FenceSyncKHR::extension_if_supported(dpy))
+    {
+        return std::make_unique<PixelPackPipeline>(dpy, *fence_sync, size);
+    }
+    mir::log_debug("EGL_KHR_fence_sync unavailable; reading back rendered frames synchronously");
+    return nullptr;
+}
 }
 
 class mgc::CPUCopyOutputSurface::Impl
@@ -140,8 +347,13 @@ public:
 
     auto size() const -> geom::Size;
     auto layout() const -> Layout;
+    auto buffer_age() const -> std::optional<unsigned>;
+    void set_damage_hint(geom::Rectangles const& damage);
 
 private:
+    /// The rows to copy into a buffer of the given age, or nullopt for all of them
+    auto rows_to_copy(unsigned age) const -> std::optional<std::vector<RowSpan>>;
+
     mg::CPUAddressableDisplayAllocator& allocator;
     EGLDisplay const dpy;
     EGLContext const ctx;
@@ -149,6 +361,14 @@ private:
     RenderbufferHandle const colour_buffer;
     std::shared_ptr<RenderbufferHandle> depth_stencil_buffer;
     FramebufferHandle const fbo;
+    bool committed{false};
+    /// Null if the GL implementation can only read back synchronously
+    std::unique_ptr<PixelPackPipeline> const pixel_pack;
+
+    std::optional<std::vector<geom::Rectangle>> damage_hint;
+    static size_t constexpr max_damage_history{4};
+    /// The rows changed by each of the most recent commits, newest first; nullopt for all of them
+    std::deque<std::optional<std::vector<RowSpan>>> damage_history;
 };
 
 mgc::CPUCopyOutputSurface::CPUCopyOutputSurface(
@@ -192,6 +412,16 @@ auto mgc::CPUCopyOutputSurface::layout() const -> Layout
     return impl->layout();
 }
 
+auto mgc::CPUCopyOutputSurface::buffer_age() const -> std::optional<unsigned>
+{
+    return impl->buffer_age();
+}
+
+void mgc::CPUCopyOutputSurface::set_damage_hint(geom::Rectangles const& damage)
+{
+    impl->set_damage_hint(damage);
+}
+
 mgc::CPUCopyOutputSurface::Impl::Impl(
     EGLDisplay dpy,
     EGLContext share_ctx,
@@ -200,7 +430,8 @@ mgc::CPUCopyOutputSurface::Impl::Impl(
     : allocator{allocator},
       dpy{dpy},
       ctx{create_current_context(dpy, share_ctx)},
-      format{select_format_from(allocator)}
+      format{select_format_from(allocator)},
+      pixel_pack{create_pixel_pack_pipeline(dpy, size())}
 {
     glBindRenderbuffer(GL_RENDERBUFFER, colour_buffer);
     glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8_OES, size().width.as_int(), size().height.as_int());
@@ -276,6 +507,17 @@ void mgc::CPUCopyOutputSurface::Impl::release_current()
 
 auto mgc::CPUCopyOutputSurface::Impl::commit() -> std::unique_ptr<mg::Framebuffer>
 {
+    auto const height = size().height.as_int();
+
+    damage_history.push_front(
+        damage_hint ? std::make_optional(rows_covered_by(*damage_hint, height)) : std::nullopt);
+    damage_hint.reset();
+    // Enough to cover the buffers the display allocator can recycle
+    while (damage_history.size() > max_damage_history)
+    {
+        damage_history.pop_back();
+    }
+
     auto fb = allocator.alloc_fb(format);
     glBindFramebuffer(GL_FRAMEBUFFER, fbo);
     {
@@ -290,19 +532,32 @@ auto mgc::CPUCopyOutputSurface::Impl::commit() -> std::unique_ptr<mg::Framebuffe
             pixel_layout = GL_RGBA;
         }
         auto mapping = fb->map_writeable();
-        /*
-         * TODO: This introduces a pipeline stall; GL must wait for all previous rendering commands
-         * to complete before glReadPixels returns. We could instead do something fancy with
-         * pixel buffer objects to defer this cost.
-         */
-        /*
-         * TODO: We are assuming that the framebuffer pixel format is RGBX
-         */
-        glReadPixels(
-            0, 0,
-            fb->size().width.as_uint32_t(), fb->size().height.as_uint32_t(),
-            pixel_layout, GL_UNSIGNED_BYTE, mapping->data());
+        auto const rows = rows_to_copy(fb->buffer_age()).value_or(std::vector<RowSpan>{{0, height}});
+
+        if (pixel_pack)
+        {
+            pixel_pack->read(rows, pixel_layout, *mapping);
+        }
+        else
+        {
+            /*
+             * This introduces a pipeline stall; GL must wait for all previous rendering commands
+             * to complete before glReadPixels returns.
+             */
+            /*
+             * TODO: We are assuming that the framebuffer pixel format is RGBX
+             */
+            auto const stride = mapping->stride().as_uint32_t();
+            for (auto const& span : rows)
+            {
+                glReadPixels(
+                    0, span.top,
+                    fb->size().width.as_uint32_t(), span.bottom - span.top,
+                    pixel_layout, GL_UNSIGNED_BYTE, mapping->data() + span.top * stride);
+            }
+        }
     }
+    committed = true;
     return fb;
 }
 
@@ -315,3 +570,38 @@ auto mgc::CPUCopyOutputSurface::Impl::layout() const -> Layout
 {
     return Layout::TopRowFirst;
 }
+
+auto mgc::CPUCopyOutputSurface::Impl::buffer_age() const -> std::optional<unsigned>
+{
+    // We render into the same renderbuffer every frame, so once it has been
+    // committed it always holds the previous frame.
+    return committed ? 1 : 0;
+}
+
+void mgc::CPUCopyOutputSurface::Impl::set_damage_hint(geom::Rectangles const& damage)
+{
+    damage_hint.emplace(damage.begin(), damage.end());
+}
+
+auto mgc::CPUCopyOutputSurface::Impl::rows_to_copy(unsigned age) const -> std::optional<std::vector<RowSpan>>
+{
+    // The buffer holds what we copied age commits ago, so needs everything changed since
+    if (age == 0 || age > damage_history.size())
+    {
+        return std::nullopt;
+    }
+
+    std::vector<geom::Rectangle> changed;
+    for (auto i = 0u; i != age; ++i)
+    {
+        if (!damage_history[i])
+        {
+            return std::nullopt;
+        }
+        for (auto const& span : *damage_history[i])
+        {
+            changed.push_back({{0, span.top}, {1, span.bottom - span.top}});
+        }
+    }
+    return rows_covered_by(changed, size().height.as_int());
+}
@@ -51,6 +51,10 @@ public:
 
     auto layout() const -> Layout override;
 
+    auto buffer_age() const -> std::optional<unsigned> override;
+
+    void set_damage_hint(geometry::Rectangles const& damage) override;
+
 private:
     class Impl;
     std::unique_ptr<Impl> const impl;
@@ -16,9 +16,16 @@
 
 #include "kms_cpu_addressable_display_provider.h"
 #include "cpu_addressable_fb.h"
+#include "kms_framebuffer.h"
 #include <drm_fourcc.h>
 #include <xf86drm.h>
 
+#include <algorithm>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <vector>
+
 namespace
 {
 auto drm_get_cap_checked(mir::Fd const& drm_fd, uint64_t cap) -> uint64_t
@@ -37,12 +44,215 @@ auto drm_get_cap_checked(mir::Fd const& drm_fd, uint64_t cap) -> uint64_t
 }
 
 namespace mg = mir::graphics;
+namespace mrs = mir::renderer::software;
 namespace geom = mir::geometry;
 
-mg::kms::CPUAddressableDisplayAllocator::CPUAddressableDisplayAllocator(mir::Fd drm_fd, geom::Size size)
+class mg::kms::CPUAddressableDisplayAllocator::BufferRing : public std::enable_shared_from_this<BufferRing>
+{
+public:
+    explicit BufferRing(size_t capacity)
+        : capacity{capacity}
+    {
+    }
+
+    /// A dumb buffer, and the mapping it keeps for its whole life
+    struct Slot
+    {
+        Slot(DRMFormat format, std::unique_ptr<CPUAddressableFB> fb)
+            : format{format},
+              fb{std::move(fb)},
+              mapping{this->fb->map_writeable()}
+        {
+        }
+
+        DRMFormat const format;
+        std::unique_ptr<CPUAddressableFB> const fb;
+        std::unique_ptr<mrs::Mapping<unsigned char>> const mapping;
+        /// The acquire() that last handed this out, if any
+        std::optional<uint64_t> last_acquired;
+    };
+
+    /**
+     * Take a buffer of format out of the ring, creating one if there's room
+     *
+     * \return the buffer, or nullptr if every buffer the ring may hold is in use
+     */
+    auto acquire(DRMFormat format, std::function<std::unique_ptr<CPUAddressableFB>()> const& allocate)
+        -> std::unique_ptr<MappableFB>;
+
+private:
+    class RecycledFB;
+
+    void release(std::unique_ptr<Slot> slot);
+
+    size_t const capacity;
+
+    std::mutex mutex;
+    std::vector<std::unique_ptr<Slot>> idle;
+    size_t in_use{0};
+    /// Counts calls of acquire(), to work out the age of a buffer's content
+    uint64_t acquisitions{0};
+};
+
+/// Hands a buffer from the ring out to the display, returning it to the ring when done with
+class mg::kms::CPUAddressableDisplayAllocator::BufferRing::RecycledFB : public FBHandle, public MappableFB
+{
+public:
+    RecycledFB(std::shared_ptr<BufferRing> ring, std::unique_ptr<Slot> slot, unsigned age)
+        : ring{std::move(ring)},
+          slot{std::move(slot)},
+          age{age}
+    {
+    }
+
+    ~RecycledFB() override
+    {
+        ring->release(std::move(slot));
+    }
+
+    auto map_writeable() -> std::unique_ptr<mrs::Mapping<unsigned char>> override
+    {
+        return std::make_unique<View>(*slot->mapping);
+    }
+
+    auto format() const -> MirPixelFormat override
+    {
+        return slot->fb->format();
+    }
+
+    auto stride() const -> geom::Stride override
+    {
+        return slot->fb->stride();
+    }
+
+    auto size() const -> geom::Size override
+    {
+        return slot->fb->size();
+    }
+
+    operator uint32_t() const override
+    {
+        return *slot->fb;
+    }
+
+    auto buffer_age() const -> unsigned override
+    {
+        return age;
+    }
+
+private:
+    /// Dumb buffers are coherent, so there's nothing to do when the caller is done with the mapping
+    class View : public mrs::Mapping<unsigned char>
+    {
+    public:
+        explicit View(mrs::Mapping<unsigned char>& mapping)
+            : mapping{mapping}
+        {
+        }
+
+        auto format() const -> MirPixelFormat override
+        {
+            return mapping.format();
+        }
+
+        auto stride() const -> geom::Stride override
+        {
+            return mapping.stride();
+        }
+
+        auto size() const -> geom::Size override
+        {
+            return mapping.size();
+        }
+
+        auto data() -> unsigned char* override
+        {
+            return mapping.data();
+        }
+
+        auto len() const -> size_t override
+        {
+            return mapping.len();
+        }
+
+    private:
+        mrs::Mapping<unsigned char>& mapping;
+    };
+
+    std::shared_ptr<BufferRing> const ring;
+    std::unique_ptr<Slot> slot;
+    unsigned const age;
+};
+
+auto mg::kms::CPUAddressableDisplayAllocator::BufferRing::acquire(
+    DRMFormat format,
+    std::function<std::unique_ptr<CPUAddressableFB>()> const& allocate) -> std::unique_ptr<MappableFB>
+{
+    std::unique_ptr<Slot> slot;
+    uint64_t acquisition;
+    {
+        std::lock_guard lock{mutex};
+        acquisition = ++acquisitions;
+
+        auto const match = std::find_if(
+            idle.begin(),
+            idle.end(),
+            [format](auto const& candidate)
+            {
+                return static_cast<uint32_t>(candidate->format) == static_cast<uint32_t>(format);
+            });
+
+        if (match != idle.end())
+        {
+            slot = std::move(*match);
+            idle.erase(match);
+        }
+        else if (in_use + idle.size() >= capacity)
+        {
+            if (idle.empty())
+            {
+                return nullptr;
+            }
+            // Make room by dropping a buffer of a format that's no longer wanted
+            idle.erase(idle.begin());
+        }
+        ++in_use;
+    }
+
+    if (!slot)
+    {
+        try
+        {
+            slot = std::make_unique<Slot>(format, allocate());
+        }
+        catch (...)
+        {
+            std::lock_guard lock{mutex};
+            --in_use;
+            throw;
+        }
+    }
+
+    auto const age = slot->last_acquired ? static_cast<unsigned>(acquisition - *slot->last_acquired) : 0u;
+    slot->last_acquired = acquisition;
+    return std::make_unique<RecycledFB>(shared_from_this(), std::move(slot), age);
+}
+
+void mg::kms::CPUAddressableDisplayAllocator::BufferRing::release(std::unique_ptr<Slot> slot)
+{
+    std::lock_guard lock{mutex};
+    --in_use;
+    idle.push_back(std::move(slot));
+}
+
+mg::kms::CPUAddressableDisplayAllocator::CPUAddressableDisplayAllocator(
+    mir::Fd drm_fd,
+    geom::Size size,
+    size_t buffer_count)
     : drm_fd{std::move(drm_fd)},
       supports_modifiers{drm_get_cap_checked(this->drm_fd, DRM_CAP_ADDFB2_MODIFIERS) == 1},
-      size{size}
+      size{size},
+      ring{std::make_shared<BufferRing>(buffer_count)}
 {
 }
 
@@ -55,7 +265,18 @@ auto mg::kms::CPUAddressableDisplayAllocator::supported_formats() const
 
 auto mg::kms::CPUAddressableDisplayAllocator::alloc_fb(DRMFormat format) -> std::unique_ptr<MappableFB>
 {
-    return std::make_unique<mg::CPUAddressableFB>(drm_fd, supports_modifiers, format, size);
+    auto const allocate =
+        [this, format]()
+        {
+            return std::make_unique<mg::CPUAddressableFB>(drm_fd, supports_modifiers, format, size);
+        };
+
+    if (auto recycled = ring->acquire(format, allocate))
+    {
+        return recycled;
+    }
+    // The display is holding on to every buffer in the ring; don't stall waiting for one
+    return allocate();
 }
 
 auto mg::kms::CPUAddressableDisplayAllocator::output_size() const -> geom::Size
@@ -63,12 +284,16 @@ auto mg::kms::CPUAddressableDisplayAllocator::output_size() const -> geom::Size
     return size;
 }
 
-auto mir::graphics::kms::CPUAddressableDisplayAllocator::create_if_supported(mir::Fd const& drm_fd, geom::Size size)
+auto mir::graphics::kms::CPUAddressableDisplayAllocator::create_if_supported(
+    mir::Fd const& drm_fd,
+    geom::Size size,
+    size_t buffer_count)
 -> std::shared_ptr<CPUAddressableDisplayAllocator>
 {
     if  (drm_get_cap_checked(drm_fd, DRM_CAP_DUMB_BUFFER))
     {
-        return std::shared_ptr<CPUAddressableDisplayAllocator>(new CPUAddressableDisplayAllocator{drm_fd, size});
+        return std::shared_ptr<CPUAddressableDisplayAllocator>(
+            new CPUAddressableDisplayAllocator{drm_fd, size, buffer_count});
     }
     else
     {
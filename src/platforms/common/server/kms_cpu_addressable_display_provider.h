@@ -20,18 +20,38 @@
 #include "mir/graphics/platform.h"
 #include <mir/fd.h>
 
+#include <memory>
+
 namespace mir
 {
 namespace graphics
 {
 namespace kms
 {
+/**
+ * Allocates dumb buffers for the CPU to draw a display's content into
+ *
+ * Creating, mapping and registering a dumb buffer with KMS costs several
+ * ioctls, so rather than doing that every frame the allocator keeps a ring
+ * of up to buffer_count buffers, each mapped once for its lifetime. A buffer
+ * returns to the ring when the last reference to the MappableFB handed out
+ * by alloc_fb() is dropped - that is, once the display has flipped away from it.
+ */
 class CPUAddressableDisplayAllocator : public graphics::CPUAddressableDisplayAllocator
 {
 public:
+    /// Enough for one buffer being drawn, one queued for flip, and one on screen
+    static size_t constexpr default_buffer_count{3};
+
     /// Create an CPUAddressableDisplayAllocator if and only if supported by the device
+    /// \param buffer_count    The most buffers to keep for reuse. Should every one
+    ///                         of them be in use, alloc_fb() falls back to
+    ///                         allocating a buffer for one-off use.
     /// \return the provider, or an empty pointer
-    static auto create_if_supported(mir::Fd const& drm_fd, geometry::Size size)
+    static auto create_if_supported(
+        mir::Fd const& drm_fd,
+        geometry::Size size,
+        size_t buffer_count = default_buffer_count)
         -> std::shared_ptr<CPUAddressableDisplayAllocator>;
 
     auto supported_formats() const
@@ -42,11 +62,15 @@ public:
 
     auto output_size() const -> geometry::Size override;
 private:
-    explicit CPUAddressableDisplayAllocator(mir::Fd drm_fd, geometry::Size size);
+    class BufferRing;
+
+    CPUAddressableDisplayAllocator(mir::Fd drm_fd, geometry::Size size, size_t buffer_count);
 
     mir::Fd const drm_fd;
     bool const supports_modifiers;
     geometry::Size const size;
+    /// Shared with the buffers handed out, which may outlive the allocator
+    std::shared_ptr<BufferRing> const ring;
 };
 }
 }
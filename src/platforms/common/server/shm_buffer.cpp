@@ -20,15 +20,21 @@
 #include "mir/graphics/program_factory.h"
 #include "mir/graphics/program.h"
 #include "mir/graphics/egl_context_executor.h"
+#include "mir/graphics/egl_extensions.h"
 
 #define MIR_LOG_COMPONENT "gfx-common"
 #include "mir/log.h"
 
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
 #include <GLES2/gl2.h>
 #include <GLES2/gl2ext.h>
 
 #include <boost/throw_exception.hpp>
 
+#include <algorithm>
+#include <deque>
+#include <map>
 #include <string.h>
 #include <endian.h>
 
@@ -91,13 +97,406 @@ bool mgc::ShmBuffer::supports(MirPixelFormat mir_format)
     return mg::get_gl_pixel_format(mir_format, gl_format, gl_type);
 }
 
+/*
+ * A GL texture shared by successive frames of a stream of ShmBuffers.
+ *
+ * Each ShmBuffer is a frame of the stream, numbered in order of creation,
+ * along with the damage relative to the previous frame. This lets binding
+ * a frame upload only what has changed since the frame currently in the
+ * texture, rather than the whole buffer.
+ *
+ * The compositors of different outputs may be sampling the texture while
+ * another wants to upload a newer frame. Rather than overwrite a frame that
+ * is still being read, the upload then goes to another copy of the texture
+ * (of which there are at most max_copies).
+ */
+class mgc::ShmBuffer::StreamTexture
+{
+public:
+    StreamTexture(
+        geom::Size size,
+        MirPixelFormat format,
+        std::shared_ptr<EGLContextExecutor> egl_delegate)
+        : size{size},
+          format{format},
+          egl_delegate{std::move(egl_delegate)}
+    {
+    }
+
+    ~StreamTexture() noexcept
+    {
+        if (!copies.empty())
+        {
+            egl_delegate->spawn(
+                [copies = std::move(copies),
+                 dpy = upload_display,
+                 fence_sync = fence_sync]()
+                {
+                    for (auto const& copy : copies)
+                    {
+                        if (copy.tex_id != 0)
+                        {
+                            glDeleteTextures(1, &copy.tex_id);
+                        }
+                        if (copy.upload_fence != EGL_NO_SYNC_KHR)
+                        {
+                            fence_sync->eglDestroySyncKHR(dpy, copy.upload_fence);
+                        }
+                        for (auto const& [context, read] : copy.reads)
+                        {
+                            if (read.fence != EGL_NO_SYNC_KHR)
+                            {
+                                fence_sync->eglDestroySyncKHR(dpy, read.fence);
+                            }
+                        }
+                    }
+                });
+        }
+    }
+
+    auto compatible_with(geom::Size size, MirPixelFormat format) const -> bool
+    {
+        return this->size == size && this->format == format;
+    }
+
+    /// \returns The frame number of the new frame
+    auto add_frame(std::optional<geom::Rectangles> const& damage) -> uint64_t
+    {
+        std::lock_guard lock{mutex};
+        auto const frame = next_frame++;
+        pending_damage.emplace_back(frame, damage);
+        if (pending_damage.size() > max_pending_frames)
+        {
+            // Forgetting the oldest damage just means a full upload if we ever need it
+            pending_damage.pop_front();
+        }
+        return frame;
+    }
+
+    /**
+     * Bind the texture, bringing it up to date with \a frame
+     *
+     * The current context's read from the texture is in progress until it
+     * calls fence_reads().
+     *
+     * \param [in] upload   Called to upload the given area (or everything, for
+     *                      std::nullopt) of the frame's pixels to the bound texture.
+     * \note This must be called with a current GL context
+     */
+    template<typename Upload>
+    void bind(uint64_t frame, Upload const& upload)
+    {
+        std::lock_guard lock{mutex};
+        check_fence_sync();
+        auto const context = eglGetCurrentContext();
+
+        if (auto const latest = latest_copy(); latest && frame <= latest->uploaded_frame)
+        {
+            /* Either we're up to date, or a later frame has already been uploaded
+             * (which happens when compositors for different outputs are not in step).
+             * Showing the later frame a little early is harmless.
+             */
+            bind_texture(*latest);
+            latest->reads[context].in_progress = true;
+            wait_for_upload(*latest);
+            return;
+        }
+
+        auto& copy = copy_for_upload(context);
+        bind_texture(copy);
+        wait_for_reads(copy, context);
+        upload(area_to_upload_for(copy, frame));
+        copy.uploaded_frame = frame;
+        copy.reads[context].in_progress = true;
+
+        auto const oldest_uploaded = std::ranges::min_element(copies, {}, &Copy::uploaded_frame)->uploaded_frame;
+        std::erase_if(pending_damage, [oldest_uploaded](auto const& entry) { return entry.first <= oldest_uploaded; });
+
+        fence_upload(copy);
+    }
+
+    /**
+     * Note that the current context has finished issuing reads from the texture
+     *
+     * \note This must be called with a current GL context
+     */
+    void fence_reads()
+    {
+        std::lock_guard lock{mutex};
+        auto const context = eglGetCurrentContext();
+        for (auto& copy : copies)
+        {
+            auto const read = copy.reads.find(context);
+            if (read == copy.reads.end() || !read->second.in_progress)
+            {
+                continue;
+            }
+
+            read->second.in_progress = false;
+            if (!check_fence_sync())
+            {
+                continue;
+            }
+            // Reads from one context complete in order, so only the most recent matters
+            if (read->second.fence != EGL_NO_SYNC_KHR)
+            {
+                fence_sync->eglDestroySyncKHR(upload_display, read->second.fence);
+            }
+            read->second.fence = fence_sync->eglCreateSyncKHR(upload_display, EGL_SYNC_FENCE_KHR, nullptr);
+            if (read->second.fence != EGL_NO_SYNC_KHR)
+            {
+                // As with uploads, other contexts can only wait for the fence once it has been submitted
+                glFlush();
+            }
+        }
+    }
+
+private:
+    static size_t const max_pending_frames = 16;
+    static size_t const max_copies = 3;
+
+    struct Read
+    {
+        bool in_progress{false};                ///< Bound, but not yet fenced
+        EGLSyncKHR fence{EGL_NO_SYNC_KHR};      ///< The latest fenced read
+    };
+
+    struct Copy
+    {
+        GLuint tex_id{0};
+        uint64_t uploaded_frame{0};     ///< 0 means nothing has been uploaded
+        EGLSyncKHR upload_fence{EGL_NO_SYNC_KHR};
+        EGLContext upload_context{EGL_NO_CONTEXT};
+        std::map<EGLContext, Read> reads;
+    };
+
+    /// The copy holding the most recent frame, or nullptr if nothing has been uploaded
+    auto latest_copy() -> Copy*
+    {
+        if (copies.empty())
+        {
+            return nullptr;
+        }
+        auto const latest = std::ranges::max_element(copies, {}, &Copy::uploaded_frame);
+        return latest->uploaded_frame == 0 ? nullptr : &*latest;
+    }
+
+    static auto read_in_progress_by_another(Copy const& copy, EGLContext context) -> bool
+    {
+        return std::ranges::any_of(
+            copy.reads,
+            [context](auto const& entry) { return entry.first != context && entry.second.in_progress; });
+    }
+
+    /* Prefer the latest frame's copy, as that needs the least uploading, then
+     * any other copy nobody else is reading, then a new one.
+     */
+    auto copy_for_upload(EGLContext context) -> Copy&
+    {
+        if (auto const latest = latest_copy(); latest && !read_in_progress_by_another(*latest, context))
+        {
+            return *latest;
+        }
+
+        Copy* best{nullptr};
+        for (auto& copy : copies)
+        {
+            if (!read_in_progress_by_another(copy, context) &&
+                (!best || copy.uploaded_frame > best->uploaded_frame))
+            {
+                best = &copy;
+            }
+        }
+        if (best)
+        {
+            return *best;
+        }
+        if (copies.size() < max_copies)
+        {
+            return copies.emplace_back();
+        }
+
+        /* Something has bound the texture without fencing its reads (or there are
+         * more compositors than copies), so all we can do is overwrite the latest
+         * frame once its fenced reads have completed.
+         */
+        return *latest_copy();
+    }
+
+    /// The area that differs between the frame in \a copy and \a frame, or std::nullopt for everything
+    auto area_to_upload_for(Copy const& copy, uint64_t frame) const -> std::optional<geom::Rectangles>
+    {
+        auto const first_pending = std::ranges::find_if(
+            pending_damage,
+            [&copy](auto const& entry) { return entry.first > copy.uploaded_frame; });
+        if (copy.uploaded_frame == 0 ||
+            first_pending == pending_damage.end() ||
+            first_pending->first != copy.uploaded_frame + 1)
+        {
+            return std::nullopt;
+        }
+
+        geom::Rectangles area;
+        geom::Rectangle const buffer_area{{0, 0}, size};
+        for (auto i = first_pending; i != pending_damage.end(); ++i)
+        {
+            auto const& [pending_frame, damage] = *i;
+            if (pending_frame > frame)
+            {
+                break;
+            }
+            if (!damage)
+            {
+                return std::nullopt;
+            }
+            for (auto const& rect : damage.value())
+            {
+                auto const clipped = intersection_of(rect, buffer_area);
+                if (clipped.size != geom::Size{})
+                {
+                    area.add(clipped);
+                }
+            }
+        }
+        return area;
+    }
+
+    static void bind_texture(Copy& copy)
+    {
+        bool const needs_initialisation = copy.tex_id == 0;
+        if (needs_initialisation)
+        {
+            glGenTextures(1, &copy.tex_id);
+        }
+        glBindTexture(GL_TEXTURE_2D, copy.tex_id);
+        if (needs_initialisation)
+        {
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        }
+    }
+
+    /* The texture is shared between the GL contexts of all the compositors,
+     * so rather than block until each upload completes we leave a fence for
+     * other contexts to wait on.
+     */
+    void fence_upload(Copy& copy)
+    {
+        if (!check_fence_sync())
+        {
+            glFinish();
+            return;
+        }
+
+        if (copy.upload_fence != EGL_NO_SYNC_KHR)
+        {
+            fence_sync->eglDestroySyncKHR(upload_display, copy.upload_fence);
+        }
+        copy.upload_fence = fence_sync->eglCreateSyncKHR(upload_display, EGL_SYNC_FENCE_KHR, nullptr);
+        copy.upload_context = eglGetCurrentContext();
+        if (copy.upload_fence == EGL_NO_SYNC_KHR)
+        {
+            glFinish();
+        }
+        else
+        {
+            // The fence only signals once the commands before it have been submitted
+            glFlush();
+        }
+    }
+
+    /// \returns true if fences are available to synchronise the contexts sharing the texture
+    auto check_fence_sync() -> bool
+    {
+        if (!fence_sync_checked)
+        {
+            upload_display = eglGetCurrentDisplay();
+            if (auto const ext = mg::EGLExtensions::FenceSyncKHR::extension_if_supported(upload_display))
+            {
+                fence_sync.emplace(ext.value());
+            }
+            fence_sync_checked = true;
+        }
+        return fence_sync.has_value();
+    }
+
+    /* Another output's compositor may still be sampling the frame in the copy
+     * from an earlier render, so its reads must complete before we overwrite it.
+     * Reads from this context are ordered before the upload anyway.
+     */
+    void wait_for_reads(Copy& copy, EGLContext context)
+    {
+        for (auto i = copy.reads.begin(); i != copy.reads.end();)
+        {
+            auto& [reader, read] = *i;
+            if (reader != context && read.fence != EGL_NO_SYNC_KHR)
+            {
+                fence_sync->eglClientWaitSyncKHR(upload_display, read.fence, 0, EGL_FOREVER_KHR);
+                fence_sync->eglDestroySyncKHR(upload_display, read.fence);
+                read.fence = EGL_NO_SYNC_KHR;
+            }
+            if (read.fence == EGL_NO_SYNC_KHR && !read.in_progress)
+            {
+                i = copy.reads.erase(i);
+            }
+            else
+            {
+                ++i;
+            }
+        }
+    }
+
+    void wait_for_upload(Copy const& copy) const
+    {
+        if (copy.upload_fence != EGL_NO_SYNC_KHR && eglGetCurrentContext() != copy.upload_context)
+        {
+            fence_sync->eglClientWaitSyncKHR(upload_display, copy.upload_fence, 0, EGL_FOREVER_KHR);
+        }
+    }
+
+    geom::Size const size;
+    MirPixelFormat const format;
+    std::shared_ptr<EGLContextExecutor> const egl_delegate;
+
+    std::mutex mutex;
+    uint64_t next_frame{1};
+    std::deque<std::pair<uint64_t, std::optional<geom::Rectangles>>> pending_damage;
+    std::deque<Copy> copies;        ///< A deque, so adding a copy leaves references to the others valid
+
+    bool fence_sync_checked{false};
+    std::optional<mg::EGLExtensions::FenceSyncKHR> fence_sync;
+    EGLDisplay upload_display{EGL_NO_DISPLAY};
+};
+
 mgc::ShmBuffer::ShmBuffer(
     geom::Size const& size,
     MirPixelFormat const& format,
     std::shared_ptr<EGLContextExecutor> egl_delegate)
+    : ShmBuffer(size, format, std::move(egl_delegate), nullptr, std::nullopt)
+{
+}
+
+mgc::ShmBuffer::ShmBuffer(
+    geom::Size const& size,
+    MirPixelFormat const& format,
+    std::shared_ptr<EGLContextExecutor> egl_delegate,
+    std::shared_ptr<Buffer> const& previous,
+    std::optional<geom::Rectangles> const& damage)
     : size_{size},
       pixel_format_{format},
-      egl_delegate{std::move(egl_delegate)}
+      texture{
+          [&]()
+          {
+              if (auto const previous_shm = std::dynamic_pointer_cast<ShmBuffer>(previous);
+                  previous_shm && previous_shm->texture->compatible_with(size, format))
+              {
+                  return previous_shm->texture;
+              }
+              return std::make_shared<StreamTexture>(size, format, std::move(egl_delegate));
+          }()},
+      frame{texture->add_frame(damage)}
 {
 }
 
@@ -111,17 +510,7 @@ mgc::MemoryBackedShmBuffer::MemoryBackedShmBuffer(
 {
 }
 
-mgc::ShmBuffer::~ShmBuffer() noexcept
-{
-    if (tex_id != 0)
-    {
-        egl_delegate->spawn(
-            [id = tex_id]()
-            {
-                glDeleteTextures(1, &id);
-            });
-    }
-}
+mgc::ShmBuffer::~ShmBuffer() noexcept = default;
 
 geom::Size mgc::ShmBuffer::size() const
 {
@@ -133,14 +522,17 @@ MirPixelFormat mgc::ShmBuffer::pixel_format() const
     return pixel_format_;
 }
 
-void mgc::ShmBuffer::upload_to_texture(void const* pixels, geom::Stride const& stride)
+void mgc::ShmBuffer::upload_to_texture(
+    void const* pixels,
+    geom::Stride const& stride,
+    std::optional<geom::Rectangles> const& area)
 {
     GLenum format, type;
 
     if (mg::get_gl_pixel_format(pixel_format_, format, type))
     {
-        auto const stride_in_px =
-            stride.as_int() / MIR_BYTES_PER_PIXEL(pixel_format());
+        auto const bytes_per_pixel = MIR_BYTES_PER_PIXEL(pixel_format());
+        auto const stride_in_px = stride.as_int() / bytes_per_pixel;
         /*
          * We assume (as does Weston, AFAICT) that stride is
          * a multiple of whole pixels, but it need not be.
@@ -153,20 +545,42 @@ void mgc::ShmBuffer::upload_to_texture(void const* pixels, geom::Stride const& s
         glPixelStorei(GL_UNPACK_ROW_LENGTH_EXT, stride_in_px);
         glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
 
-        glTexImage2D(
-            GL_TEXTURE_2D,
-            0,
-            format,
-            size().width.as_int(), size().height.as_int(),
-            0,
-            format,
-            type,
-            pixels);
+        if (!area)
+        {
+            glTexImage2D(
+                GL_TEXTURE_2D,
+                0,
+                format,
+                size().width.as_int(), size().height.as_int(),
+                0,
+                format,
+                type,
+                pixels);
+        }
+        else
+        {
+            // The texture already holds the rest of the buffer; we only need to update what has changed
+            for (auto const& rect : area.value())
+            {
+                auto const first_pixel =
+                    static_cast<unsigned char const*>(pixels) +
+                    rect.top().as_int() * stride.as_int() +
+                    rect.left().as_int() * bytes_per_pixel;
+
+                glTexSubImage2D(
+                    GL_TEXTURE_2D,
+                    0,
+                    rect.left().as_int(), rect.top().as_int(),
+                    rect.size.width.as_int(), rect.size.height.as_int(),
+                    format,
+                    type,
+                    first_pixel);
+            }
+        }
 
         // Be nice to other users of the GL context by reverting our changes to shared state
         glPixelStorei(GL_UNPACK_ROW_LENGTH_EXT, 0);     // 0 is default, meaning “use width”
         glPixelStorei(GL_UNPACK_ALIGNMENT, 4);          // 4 is default; word alignment.
-        glFinish();
     }
     else
     {
@@ -184,32 +598,14 @@ mg::NativeBufferBase* mgc::ShmBuffer::native_buffer_base()
 
 void mgc::ShmBuffer::bind()
 {
-    std::lock_guard lock{tex_id_mutex};
-    bool const needs_initialisation = tex_id == 0;
-    if (needs_initialisation)
-    {
-        glGenTextures(1, &tex_id);
-    }
-    glBindTexture(GL_TEXTURE_2D, tex_id);
-    if (needs_initialisation)
-    {
-        // The ShmBuffer *should* be immutable, so we can just upload once.
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    }
-}
-
-void mgc::MemoryBackedShmBuffer::bind()
-{
-    mgc::ShmBuffer::bind();
-    std::lock_guard lock{uploaded_mutex};
-    if (!uploaded)
-    {
-        upload_to_texture(pixels.get(), stride_);
-        uploaded = true;
-    }
+    // The ShmBuffer *should* be immutable, so each frame needs uploading at most once.
+    texture->bind(
+        frame,
+        [this](std::optional<geom::Rectangles> const& area)
+        {
+            auto const mapping = pixels_for_upload();
+            upload_to_texture(mapping->data(), mapping->stride(), area);
+        });
 }
 
 template<typename T>
@@ -265,6 +661,11 @@ auto mgc::MemoryBackedShmBuffer::map_rw() -> std::unique_ptr<mrs::Mapping<unsign
     return std::make_unique<Mapping<unsigned char>>(this);
 }
 
+auto mgc::MemoryBackedShmBuffer::pixels_for_upload() -> std::unique_ptr<mrs::Mapping<unsigned char const>>
+{
+    return std::make_unique<Mapping<unsigned char const>>(this);
+}
+
 mg::gl::Program const& mgc::ShmBuffer::shader(mg::gl::ProgramFactory& cache) const
 {
     static int argb_shader{0};
@@ -285,12 +686,15 @@ auto mgc::ShmBuffer::layout() const -> Layout
 
 void mgc::ShmBuffer::add_syncpoint()
 {
+    texture->fence_reads();
 }
 
 mgc::MappableBackedShmBuffer::MappableBackedShmBuffer(
     std::shared_ptr<mrs::RWMappableBuffer> data,
-    std::shared_ptr<EGLContextExecutor> egl_delegate)
-    : ShmBuffer(data->size(), data->format(), std::move(egl_delegate)),
+    std::shared_ptr<EGLContextExecutor> egl_delegate,
+    std::shared_ptr<Buffer> const& previous,
+    std::optional<geom::Rectangles> const& damage)
+    : ShmBuffer(data->size(), data->format(), std::move(egl_delegate), previous, damage),
       data{std::move(data)}
 {
 }
@@ -310,16 +714,9 @@ auto mgc::MappableBackedShmBuffer::map_rw() -> std::unique_ptr<mrs::Mapping<unsi
     return data->map_rw();
 }
 
-void mgc::MappableBackedShmBuffer::bind()
+auto mgc::MappableBackedShmBuffer::pixels_for_upload() -> std::unique_ptr<mrs::Mapping<unsigned char const>>
 {
-    mgc::ShmBuffer::bind();
-    std::lock_guard lock{uploaded_mutex};
-    if (!uploaded)
-    {
-        auto mapping = data->map_readable();
-        upload_to_texture(mapping->data(), mapping->stride());
-        uploaded = true;
-    }
+    return data->map_readable();
 }
 
 auto mgc::MappableBackedShmBuffer::format() const -> MirPixelFormat
@@ -340,9 +737,11 @@ auto mgc::MappableBackedShmBuffer::size() const -> geometry::Size
 mgc::NotifyingMappableBackedShmBuffer::NotifyingMappableBackedShmBuffer(
     std::shared_ptr<mrs::RWMappableBuffer> data,
     std::shared_ptr<mgc::EGLContextExecutor> egl_delegate,
+    std::shared_ptr<Buffer> const& previous,
+    std::optional<geom::Rectangles> const& damage,
     std::function<void()>&& on_consumed,
     std::function<void()>&& on_release)
-    :  MappableBackedShmBuffer(std::move(data), std::move(egl_delegate)),
+    :  MappableBackedShmBuffer(std::move(data), std::move(egl_delegate), previous, damage),
        on_consumed{std::move(on_consumed)},
        on_release{std::move(on_release)}
 {
@@ -19,6 +19,7 @@
 
 #include "mir/graphics/buffer_basic.h"
 #include "mir/geometry/dimensions.h"
+#include "mir/geometry/rectangles.h"
 #include "mir/geometry/size.h"
 #include "mir_toolkit/common.h"
 #include "mir_toolkit/mir_native_buffer.h"
@@ -27,7 +28,9 @@
 
 #include <GLES2/gl2.h>
 
+#include <cstdint>
 #include <mutex>
+#include <optional>
 
 namespace mir
 {
@@ -63,14 +66,39 @@ protected:
         MirPixelFormat const& format,
         std::shared_ptr<EGLContextExecutor> egl_delegate);
 
-    /// \note This must be called with a current GL context
-    void upload_to_texture(void const* pixels, geometry::Stride const& stride);
+    /**
+     * Construct a buffer that is the next frame of the same stream as \a previous
+     *
+     * If \a previous is a compatible ShmBuffer the two share a GL texture, and
+     * binding this buffer only uploads the area that has changed.
+     *
+     * \param [in] previous  The previous buffer of the stream, or nullptr
+     * \param [in] damage    The area, in buffer coordinates, in which this buffer
+     *                       differs from \a previous; std::nullopt if unknown.
+     */
+    ShmBuffer(
+        geometry::Size const& size,
+        MirPixelFormat const& format,
+        std::shared_ptr<EGLContextExecutor> egl_delegate,
+        std::shared_ptr<Buffer> const& previous,
+        std::optional<geometry::Rectangles> const& damage);
+
+    /// The pixels to upload to the texture
+    /// \note This is called with a current GL context
+    virtual auto pixels_for_upload() -> std::unique_ptr<renderer::software::Mapping<unsigned char const>> = 0;
 private:
+    class StreamTexture;
+
+    /// \note This must be called with a current GL context
+    void upload_to_texture(
+        void const* pixels,
+        geometry::Stride const& stride,
+        std::optional<geometry::Rectangles> const& area);
+
     geometry::Size const size_;
     MirPixelFormat const pixel_format_;
-    std::shared_ptr<EGLContextExecutor> const egl_delegate;
-    std::mutex tex_id_mutex;
-    GLuint tex_id{0};
+    std::shared_ptr<StreamTexture> const texture;
+    uint64_t const frame;
 };
 
 class MemoryBackedShmBuffer :
@@ -88,14 +116,14 @@ public:
 
     auto map_rw() -> std::unique_ptr<renderer::software::Mapping<unsigned char>> override;
 
-    void bind() override;
-
     auto format() const -> MirPixelFormat override { return ShmBuffer::pixel_format(); }
     auto stride() const -> geometry::Stride override { return stride_; }
     auto size() const -> geometry::Size override { return ShmBuffer::size(); }
 
     MemoryBackedShmBuffer(MemoryBackedShmBuffer const&) = delete;
     MemoryBackedShmBuffer& operator=(MemoryBackedShmBuffer const&) = delete;
+protected:
+    auto pixels_for_upload() -> std::unique_ptr<renderer::software::Mapping<unsigned char const>> override;
 private:
     template<typename T>
     class Mapping;
@@ -105,8 +133,6 @@ private:
 
     geometry::Stride const stride_;
     std::unique_ptr<unsigned char[]> const pixels;
-    std::mutex uploaded_mutex;
-    bool uploaded{false};
 };
 
 class MappableBackedShmBuffer :
@@ -116,24 +142,24 @@ class MappableBackedShmBuffer :
 public:
     MappableBackedShmBuffer(
         std::shared_ptr<renderer::software::RWMappableBuffer> data,
-        std::shared_ptr<EGLContextExecutor> egl_delegate);
+        std::shared_ptr<EGLContextExecutor> egl_delegate,
+        std::shared_ptr<Buffer> const& previous,
+        std::optional<geometry::Rectangles> const& damage);
 
     auto map_writeable() -> std::unique_ptr<renderer::software::Mapping<unsigned char>> override;
     auto map_readable() -> std::unique_ptr<renderer::software::Mapping<unsigned char const>> override;
     auto map_rw() -> std::unique_ptr<renderer::software::Mapping<unsigned char>> override;
 
-    void bind() override;
-
     auto format() const -> MirPixelFormat override;
     auto stride() const -> geometry::Stride override;
     auto size() const -> geometry::Size override;
 
     MappableBackedShmBuffer(MappableBackedShmBuffer const&) = delete;
     MappableBackedShmBuffer& operator=(MappableBackedShmBuffer const&) = delete;
+protected:
+    auto pixels_for_upload() -> std::unique_ptr<renderer::software::Mapping<unsigned char const>> override;
 private:
     std::shared_ptr<renderer::software::RWMappableBuffer> const data;
-    std::mutex uploaded_mutex;
-    bool uploaded{false};
 };
 
 class NotifyingMappableBackedShmBuffer : public MappableBackedShmBuffer
@@ -142,6 +168,8 @@ public:
     NotifyingMappableBackedShmBuffer(
         std::shared_ptr<renderer::software::RWMappableBuffer> data,
         std::shared_ptr<common::EGLContextExecutor> egl_delegate,
+        std::shared_ptr<Buffer> const& previous,
+        std::optional<geometry::Rectangles> const& damage,
         std::function<void()>&& on_consumed,
         std::function<void()>&& on_release);
 
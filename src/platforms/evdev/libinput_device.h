@@ -103,6 +103,7 @@ private:
         bool down_notified = false;
     };
     std::map<MirTouchId,ContactData> last_seen_properties;
+    std::vector<events::TouchContact> touch_frame_contacts;
 
     void update_contact_data(ContactData &data, MirTouchAction action, libinput_event_touch* touch);
 };
@@ -33,6 +33,7 @@
 #include "mir/executor.h"
 #include "mir/renderer/gl/gl_surface.h"
 #include "mir/graphics/display_sink.h"
+#include "mir/graphics/scanout_feedback.h"
 #include "kms/egl_helper.h"
 #include "mir/graphics/drm_formats.h"
 #include "mir/graphics/egl_error.h"
@@ -65,11 +66,13 @@ namespace geom = mir::geometry;
 mgg::BufferAllocator::BufferAllocator(
     std::unique_ptr<mgg::SurfacelessEGLContext> context,
     std::shared_ptr<mgc::EGLContextExecutor> egl_delegate,
-    std::shared_ptr<mg::DMABufEGLProvider> dmabuf_provider)
+    std::shared_ptr<mg::DMABufEGLProvider> dmabuf_provider,
+    std::optional<mir::Fd> explicit_sync_device)
     : ctx{std::move(context)},
       egl_delegate{std::move(egl_delegate)},
       egl_extensions(std::make_shared<mg::EGLExtensions>()),
-      dmabuf_provider{std::move(dmabuf_provider)}
+      dmabuf_provider{std::move(dmabuf_provider)},
+      explicit_sync_device_{std::move(explicit_sync_device)}
 {
 }
 
@@ -145,6 +148,7 @@ void mgg::BufferAllocator::bind_display(wl_display* display, std::shared_ptr<Exe
                     new LinuxDmaBufUnstable{
                         display,
                         dmabuf_provider,
+                        wayland_executor,
                     },
                     [wayland_executor](LinuxDmaBufUnstable* global)
                     {
@@ -221,16 +225,34 @@ std::shared_ptr<mg::Buffer> mgg::BufferAllocator::buffer_from_resource(
 
 auto mgg::BufferAllocator::buffer_from_shm(
     std::shared_ptr<renderer::software::RWMappableBuffer> data,
+    std::shared_ptr<Buffer> const& previous,
+    std::optional<geom::Rectangles> const& damage,
     std::function<void()>&& on_consumed,
     std::function<void()>&& on_release) -> std::shared_ptr<Buffer>
 {
     return std::make_shared<mgc::NotifyingMappableBackedShmBuffer>(
         std::move(data),
         egl_delegate,
+        previous,
+        damage,
         std::move(on_consumed),
         std::move(on_release));
 }
 
+auto mgg::BufferAllocator::explicit_sync_device() const -> std::optional<mir::Fd>
+{
+    return explicit_sync_device_;
+}
+
+auto mgg::BufferAllocator::scanout_feedback_for(wl_resource* surface) -> std::shared_ptr<ScanoutFeedback>
+{
+    if (dmabuf_extension)
+    {
+        return dmabuf_extension->scanout_feedback_for(surface);
+    }
+    return nullptr;
+}
+
 auto mgg::BufferAllocator::shared_egl_context() -> EGLContext
 {
     return static_cast<EGLContext>(*ctx);
@@ -324,6 +346,24 @@ public:
         return Layout::GL;
     }
 
+    auto buffer_age() const -> std::optional<unsigned> override
+    {
+        if (!supports_buffer_age)
+        {
+            return std::nullopt;
+        }
+
+        EGLint age;
+        if (eglQuerySurface(dpy, egl_surf, EGL_BUFFER_AGE_EXT, &age) != EGL_TRUE)
+        {
+            mir::log_debug(
+                "Failed to query EGL buffer age: %s",
+                mg::egl_category().message(eglGetError()).c_str());
+            return std::nullopt;
+        }
+        return static_cast<unsigned>(age);
+    }
+
 private:
     static auto get_matching_configs(EGLDisplay dpy, EGLint const attr[]) -> std::vector<EGLConfig>
     {
@@ -477,7 +517,8 @@ private:
         : surface{std::move(std::get<0>(renderables))},
           egl_surf{std::get<2>(renderables)},
           dpy{dpy},
-          ctx{std::get<1>(renderables)}
+          ctx{std::get<1>(renderables)},
+          supports_buffer_age{mg::has_egl_extension(dpy, "EGL_EXT_buffer_age")}
     {
     }
 
@@ -485,6 +526,7 @@ private:
     EGLSurface const egl_surf;
     EGLDisplay const dpy;
     EGLContext const ctx;
+    bool const supports_buffer_age;
 };
 }
 
@@ -552,21 +594,72 @@ auto mgg::GLRenderingProvider::surface_for_sink(
         config);
 }
 
-auto mgg::GLRenderingProvider::make_framebuffer_provider(DisplaySink& /*sink*/)
+auto mgg::GLRenderingProvider::make_framebuffer_provider(DisplaySink& sink)
     -> std::unique_ptr<FramebufferProvider>
 {
-    // TODO: Make this not a null implementation, so bypass/overlays can work again
-    class NullFramebufferProvider : public FramebufferProvider
+    class ScanoutFeedbackFramebufferProvider : public FramebufferProvider
     {
     public:
-        auto buffer_to_framebuffer(std::shared_ptr<Buffer>) -> std::unique_ptr<Framebuffer> override
+        ScanoutFeedbackFramebufferProvider(mg::GBMDisplayAllocator* allocator, mg::DmaBufDisplayAllocator* importer)
+            : allocator{allocator},
+              importer{importer}
+        {
+        }
+
+        auto buffer_to_framebuffer(std::shared_ptr<Buffer> buffer) -> std::unique_ptr<Framebuffer> override
         {
             // It is safe to return nullptr; this will be treated as “this buffer cannot be used as
             // a framebuffer”.
-            return {};
+            if (!importer)
+            {
+                return {};
+            }
+            return importer->framebuffer_for(std::move(buffer));
+        }
+
+        void scanout_candidate(std::shared_ptr<Buffer> const& buffer) override
+        {
+            std::shared_ptr<ScanoutFeedback> feedback;
+            if (buffer && allocator)
+            {
+                if (auto const feedback_buffer = dynamic_cast<ScanoutFeedbackBuffer*>(buffer->native_buffer_base()))
+                {
+                    feedback = feedback_buffer->scanout_feedback();
+                }
+            }
+
+            // Only tell clients when their surface comes into (or leaves) a position to be scanned out
+            if (feedback == candidate_feedback)
+            {
+                return;
+            }
+            if (candidate_feedback)
+            {
+                candidate_feedback->scanout_tranche_changed(std::nullopt);
+            }
+            candidate_feedback = std::move(feedback);
+            if (candidate_feedback)
+            {
+                // Without the importer its buffers can't be scanned out, however they're allocated
+                candidate_feedback->scanout_tranche_changed(importer ? allocator->scanout_tranche() : std::nullopt);
+            }
         }
+
+    private:
+        /// Owned by the sink, which outlives us
+        mg::GBMDisplayAllocator* const allocator;
+        mg::DmaBufDisplayAllocator* const importer;
+        std::shared_ptr<ScanoutFeedback> candidate_feedback;
     };
-    return std::make_unique<NullFramebufferProvider>();
+
+    mg::GBMDisplayAllocator* allocator{nullptr};
+    mg::DmaBufDisplayAllocator* importer{nullptr};
+    if (bound_display && bound_display->on_this_sink(sink))
+    {
+        allocator = sink.acquire_compatible_allocator<GBMDisplayAllocator>();
+        importer = sink.acquire_compatible_allocator<mg::DmaBufDisplayAllocator>();
+    }
+    return std::make_unique<ScanoutFeedbackFramebufferProvider>(allocator, importer);
 }
 
 mgg::GLRenderingProvider::GLRenderingProvider(
@@ -58,7 +58,8 @@ public:
     BufferAllocator(
         std::unique_ptr<SurfacelessEGLContext> ctx,
         std::shared_ptr<common::EGLContextExecutor> egl_delegate,
-        std::shared_ptr<DMABufEGLProvider> dmabuf_provider);
+        std::shared_ptr<DMABufEGLProvider> dmabuf_provider,
+        std::optional<mir::Fd> explicit_sync_device);
     ~BufferAllocator() override;
 
     std::shared_ptr<Buffer> alloc_software_buffer(geometry::Size size, MirPixelFormat) override;
@@ -72,8 +73,12 @@ public:
         std::function<void()>&& on_release) -> std::shared_ptr<Buffer> override;
     auto buffer_from_shm(
         std::shared_ptr<renderer::software::RWMappableBuffer> data,
+        std::shared_ptr<Buffer> const& previous,
+        std::optional<geometry::Rectangles> const& damage,
         std::function<void()>&& on_consumed,
         std::function<void()>&& on_release) -> std::shared_ptr<Buffer> override;
+    auto explicit_sync_device() const -> std::optional<mir::Fd> override;
+    auto scanout_feedback_for(wl_resource* surface) -> std::shared_ptr<ScanoutFeedback> override;
 
     auto shared_egl_context() -> EGLContext;
 private:
@@ -83,6 +88,7 @@ private:
     std::unique_ptr<LinuxDmaBufUnstable, std::function<void(LinuxDmaBufUnstable*)>> dmabuf_extension;
     std::shared_ptr<EGLExtensions> const egl_extensions;
     std::shared_ptr<DMABufEGLProvider> const dmabuf_provider;
+    std::optional<mir::Fd> const explicit_sync_device_;
     bool egl_display_bound{false};
 };
 
@@ -0,0 +1,253 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "dmabuf_display_allocator.h"
+#include "kms_framebuffer.h"
+#include "mir/graphics/buffer.h"
+#include "mir/graphics/dmabuf_buffer.h"
+#include "mir/graphics/drm_formats.h"
+#include "mir/log.h"
+
+#include <drm_fourcc.h>
+#include <xf86drmMode.h>
+#include <gbm.h>
+
+#include <sys/stat.h>
+
+#include <cstring>
+#include <functional>
+
+namespace mg = mir::graphics;
+namespace mgg = mir::graphics::gbm;
+namespace geom = mir::geometry;
+
+/// A client buffer imported into GBM, with a KMS framebuffer for it
+class mgg::DmaBufDisplayAllocator::ImportedBuffer : public mg::FBHandle
+{
+public:
+    ImportedBuffer(mir::Fd drm_fd, gbm_bo* bo, uint32_t fb_id)
+        : drm_fd{std::move(drm_fd)},
+          bo{bo},
+          fb_id{fb_id}
+    {
+    }
+
+    ~ImportedBuffer()
+    {
+        drmModeRmFB(drm_fd, fb_id);
+        gbm_bo_destroy(bo);
+    }
+
+    ImportedBuffer(ImportedBuffer const&) = delete;
+    ImportedBuffer& operator=(ImportedBuffer const&) = delete;
+
+    operator uint32_t() const override
+    {
+        return fb_id;
+    }
+
+    auto size() const -> geom::Size override
+    {
+        return {gbm_bo_get_width(bo), gbm_bo_get_height(bo)};
+    }
+
+private:
+    mir::Fd const drm_fd;
+    /// Owns the GEM handles the framebuffer was made from
+    gbm_bo* const bo;
+    uint32_t const fb_id;
+};
+
+namespace
+{
+/// Keeps the client's buffer (and so its content) alive for as long as KMS might show it
+class ClientBufferFramebuffer : public mg::FBHandle
+{
+public:
+    ClientBufferFramebuffer(std::shared_ptr<mg::Buffer> buffer, std::shared_ptr<mg::FBHandle const> imported)
+        : buffer{std::move(buffer)},
+          imported{std::move(imported)}
+    {
+    }
+
+    operator uint32_t() const override
+    {
+        return *imported;
+    }
+
+    auto size() const -> geom::Size override
+    {
+        return imported->size();
+    }
+
+private:
+    std::shared_ptr<mg::Buffer> const buffer;
+    std::shared_ptr<mg::FBHandle const> const imported;
+};
+}
+
+mgg::DmaBufDisplayAllocator::DmaBufDisplayAllocator(mir::Fd drm_fd, std::shared_ptr<struct gbm_device> gbm)
+    : drm_fd{std::move(drm_fd)},
+      gbm{std::move(gbm)}
+{
+}
+
+mgg::DmaBufDisplayAllocator::~DmaBufDisplayAllocator() = default;
+
+auto mgg::DmaBufDisplayAllocator::framebuffer_for(std::shared_ptr<Buffer> buffer) -> std::unique_ptr<Framebuffer>
+{
+    if (!buffer)
+    {
+        return nullptr;
+    }
+
+    auto const dmabuf = dynamic_cast<DMABufBuffer*>(buffer->native_buffer_base());
+    if (!dmabuf)
+    {
+        return nullptr;
+    }
+
+    auto const identity = identity_of(*dmabuf);
+    if (!identity)
+    {
+        return nullptr;
+    }
+
+    auto existing = imports.find(*identity);
+    if (existing == imports.end())
+    {
+        // Imports of dma-bufs whose buffers have since gone are no longer needed
+        std::erase_if(imports, [](auto const& entry) { return entry.second.latest_buffer.expired(); });
+        existing = imports.emplace(*identity, Import{import(*dmabuf), {}}).first;
+    }
+    existing->second.latest_buffer = buffer;
+
+    auto const& import_of_buffer = existing->second.imported;
+    if (!import_of_buffer)
+    {
+        return nullptr;
+    }
+
+    if (auto const scanout = dynamic_cast<DirectScanoutBuffer*>(buffer->native_buffer_base()))
+    {
+        if (!scanout->ready_for_scanout())
+        {
+            return nullptr;
+        }
+    }
+
+    return std::make_unique<ClientBufferFramebuffer>(std::move(buffer), import_of_buffer);
+}
+
+auto mgg::DmaBufDisplayAllocator::IdentityHash::operator()(Identity const& identity) const -> size_t
+{
+    // Distinct dma-bufs have distinct inodes, so the first plane's is nearly enough
+    auto const& plane = identity.planes.front();
+    return std::hash<ino_t>{}(plane.inode) ^ (std::hash<uint32_t>{}(plane.offset) << 1);
+}
+
+auto mgg::DmaBufDisplayAllocator::identity_of(DMABufBuffer const& dmabuf) -> std::optional<Identity>
+{
+    auto const& planes = dmabuf.planes();
+    if (planes.empty() || planes.size() > 4)
+    {
+        return std::nullopt;
+    }
+
+    Identity identity{
+        dmabuf.format(),
+        dmabuf.modifier().value_or(DRM_FORMAT_MOD_INVALID),
+        dmabuf.size(),
+        {}};
+    for (auto i = 0u; i < planes.size(); ++i)
+    {
+        struct stat st;
+        if (fstat(planes[i].dma_buf, &st) != 0)
+        {
+            return std::nullopt;
+        }
+        identity.planes[i] = {st.st_dev, st.st_ino, planes[i].stride, planes[i].offset};
+    }
+    return identity;
+}
+
+auto mgg::DmaBufDisplayAllocator::import(DMABufBuffer const& dmabuf) const -> std::shared_ptr<ImportedBuffer const>
+{
+    auto const& planes = dmabuf.planes();
+    if (planes.empty() || planes.size() > 4)
+    {
+        return nullptr;
+    }
+
+    auto const size = dmabuf.size();
+    auto const modifier = dmabuf.modifier().value_or(DRM_FORMAT_MOD_INVALID);
+
+    gbm_import_fd_modifier_data import_data;
+    memset(&import_data, 0, sizeof(import_data));
+    import_data.width = size.width.as_uint32_t();
+    import_data.height = size.height.as_uint32_t();
+    import_data.format = dmabuf.format();
+    import_data.num_fds = planes.size();
+    import_data.modifier = modifier;
+    for (auto i = 0u; i < planes.size(); ++i)
+    {
+        import_data.fds[i] = planes[i].dma_buf;
+        import_data.strides[i] = planes[i].stride;
+        import_data.offsets[i] = planes[i].offset;
+    }
+
+    auto const bo = gbm_bo_import(gbm.get(), GBM_BO_IMPORT_FD_MODIFIER, &import_data, GBM_BO_USE_SCANOUT);
+    if (!bo)
+    {
+        return nullptr;
+    }
+
+    uint32_t handles[4] = {0, 0, 0, 0};
+    uint32_t strides[4] = {0, 0, 0, 0};
+    uint32_t offsets[4] = {0, 0, 0, 0};
+    uint64_t modifiers[4] = {0, 0, 0, 0};
+    for (auto i = 0u; i < planes.size(); ++i)
+    {
+        handles[i] = gbm_bo_get_handle_for_plane(bo, i).u32;
+        strides[i] = planes[i].stride;
+        offsets[i] = planes[i].offset;
+        modifiers[i] = modifier;
+    }
+
+    uint32_t fb_id{0};
+    auto const result = modifier == DRM_FORMAT_MOD_INVALID ?
+        drmModeAddFB2(
+            drm_fd,
+            import_data.width, import_data.height, import_data.format,
+            handles, strides, offsets,
+            &fb_id, 0) :
+        drmModeAddFB2WithModifiers(
+            drm_fd,
+            import_data.width, import_data.height, import_data.format,
+            handles, strides, offsets, modifiers,
+            &fb_id, DRM_MODE_FB_MODIFIERS);
+    if (result != 0)
+    {
+        mir::log_debug(
+            "Failed to make a KMS framebuffer of %s client buffer: %s",
+            dmabuf.format().name(),
+            strerror(-result));
+        gbm_bo_destroy(bo);
+        return nullptr;
+    }
+
+    return std::make_shared<ImportedBuffer>(drm_fd, bo, fb_id);
+}
@@ -0,0 +1,95 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_GRAPHICS_GBM_DMABUF_DISPLAY_ALLOCATOR_H_
+#define MIR_GRAPHICS_GBM_DMABUF_DISPLAY_ALLOCATOR_H_
+
+#include "mir/graphics/platform.h"
+#include "mir/geometry/size.h"
+#include "mir/fd.h"
+
+#include <array>
+#include <optional>
+#include <unordered_map>
+#include <sys/types.h>
+
+namespace mir::graphics
+{
+class DMABufBuffer;
+}
+
+namespace mir::graphics::gbm
+{
+/**
+ * Imports client dma-bufs into KMS framebuffers, through gbm_bo_import()
+ *
+ * Each client dma-buf is imported once, however many frames (and Buffers) show it.
+ */
+class DmaBufDisplayAllocator : public graphics::DmaBufDisplayAllocator
+{
+public:
+    DmaBufDisplayAllocator(mir::Fd drm_fd, std::shared_ptr<struct gbm_device> gbm);
+    ~DmaBufDisplayAllocator();
+
+    auto framebuffer_for(std::shared_ptr<Buffer> buffer) -> std::unique_ptr<Framebuffer> override;
+
+private:
+    class ImportedBuffer;
+
+    /// What identifies a client's dma-buf memory, however many Buffers the client makes of it
+    struct Identity
+    {
+        struct Plane
+        {
+            dev_t device{0};
+            ino_t inode{0};
+            uint32_t stride{0};
+            uint32_t offset{0};
+
+            auto operator==(Plane const&) const -> bool = default;
+        };
+
+        uint32_t format;
+        uint64_t modifier;
+        geometry::Size size;
+        std::array<Plane, 4> planes;
+
+        auto operator==(Identity const&) const -> bool = default;
+    };
+
+    struct IdentityHash
+    {
+        auto operator()(Identity const& identity) const -> size_t;
+    };
+
+    struct Import
+    {
+        std::shared_ptr<ImportedBuffer const> imported;    ///< nullptr if the display can't import the dma-buf
+        std::weak_ptr<Buffer> latest_buffer;                ///< The import is kept while this Buffer is alive
+    };
+
+    /// \returns std::nullopt if dmabuf's planes can't be identified
+    static auto identity_of(DMABufBuffer const& dmabuf) -> std::optional<Identity>;
+    auto import(DMABufBuffer const& dmabuf) const -> std::shared_ptr<ImportedBuffer const>;
+
+    mir::Fd const drm_fd;
+    std::shared_ptr<struct gbm_device> const gbm;
+    /// The dma-bufs tried for showing, including those that couldn't be imported so we don't keep trying
+    std::unordered_map<Identity, Import, IdentityHash> imports;
+};
+}
+
+#endif // MIR_GRAPHICS_GBM_DMABUF_DISPLAY_ALLOCATOR_H_
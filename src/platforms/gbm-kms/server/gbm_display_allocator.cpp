@@ -16,8 +16,10 @@
 
 #include "gbm_display_allocator.h"
 #include "kms_framebuffer.h"
+#include "kms_output.h"
 
 #include <drm_fourcc.h>
+#include <sys/stat.h>
 #include <xf86drmMode.h>
 #include <gbm.h>
 
@@ -25,10 +27,15 @@ namespace mg = mir::graphics;
 namespace mgg = mir::graphics::gbm;
 namespace geom = mir::geometry;
 
-mgg::GBMDisplayAllocator::GBMDisplayAllocator(mir::Fd drm_fd, std::shared_ptr<struct gbm_device> gbm, geom::Size size)
+mgg::GBMDisplayAllocator::GBMDisplayAllocator(
+    mir::Fd drm_fd,
+    std::shared_ptr<struct gbm_device> gbm,
+    geom::Size size,
+    std::shared_ptr<KMSOutput> scanout_output)
     : fd{std::move(drm_fd)},
       gbm{std::move(gbm)},
-      size{size}
+      size{size},
+      scanout_output{std::move(scanout_output)}
 {
 }
 
@@ -44,6 +51,27 @@ auto mgg::GBMDisplayAllocator::modifiers_for_format(DRMFormat /*format*/) const
     return {};
 }
 
+auto mgg::GBMDisplayAllocator::scanout_tranche() const -> std::optional<ScanoutTranche>
+{
+    if (!scanout_output)
+    {
+        return std::nullopt;
+    }
+
+    auto formats = scanout_output->scanout_formats();
+    if (formats.empty())
+    {
+        return std::nullopt;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0)
+    {
+        return std::nullopt;
+    }
+    return ScanoutTranche{info.st_rdev, std::move(formats)};
+}
+
 namespace
 {
 using LockedFrontBuffer = std::unique_ptr<gbm_bo, std::function<void(gbm_bo*)>>;
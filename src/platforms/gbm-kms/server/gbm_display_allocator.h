@@ -19,19 +19,32 @@
 
 namespace mir::graphics::gbm
 {
+class KMSOutput;
+
 class GBMDisplayAllocator : public graphics::GBMDisplayAllocator
 {
 public:
-    GBMDisplayAllocator(mir::Fd drm_fd, std::shared_ptr<struct gbm_device> gbm, geometry::Size size);
+    /**
+     * \param scanout_output   The single output client buffers could be scanned out on,
+     *                         or nullptr if there is none
+     */
+    GBMDisplayAllocator(
+        mir::Fd drm_fd,
+        std::shared_ptr<struct gbm_device> gbm,
+        geometry::Size size,
+        std::shared_ptr<KMSOutput> scanout_output);
 
     auto supported_formats() const -> std::vector<DRMFormat> override;
 
     auto modifiers_for_format(DRMFormat format) const -> std::vector<uint64_t> override;
 
+    auto scanout_tranche() const -> std::optional<ScanoutTranche> override;
+
     auto make_surface(DRMFormat format, std::span<uint64_t> modifier) -> std::unique_ptr<GBMSurface> override;
 private:
     mir::Fd const fd;
     std::shared_ptr<struct gbm_device> const gbm;
     geometry::Size const size;
+    std::shared_ptr<KMSOutput> const scanout_output;
 };
 }
@@ -26,6 +26,8 @@
 
 #include <boost/exception/errinfo_errno.hpp>
 
+#include <algorithm>
+#include <cmath>
 #include <stdexcept>
 #include <vector>
 
@@ -75,51 +77,130 @@ gbm_device* gbm_create_device_checked(int fd)
     }
     return device;
 }
-}
 
-mgg::Cursor::GBMBOWrapper::GBMBOWrapper(int fd, MirOrientation orientation) :
-    device{gbm_create_device_checked(fd)},
-    buffer{
-        gbm_bo_create(
-            device,
-            get_drm_cursor_width(fd),
-            get_drm_cursor_height(fd),
-            GBM_FORMAT_ARGB8888,
-            GBM_BO_USE_CURSOR | GBM_BO_USE_WRITE)},
-    current_orientation{orientation}
+gbm_bo* gbm_create_cursor_bo_checked(gbm_device* device, int fd)
 {
+    auto const buffer = gbm_bo_create(
+        device,
+        get_drm_cursor_width(fd),
+        get_drm_cursor_height(fd),
+        GBM_FORMAT_ARGB8888,
+        GBM_BO_USE_CURSOR | GBM_BO_USE_WRITE);
     if (!buffer) BOOST_THROW_EXCEPTION(std::runtime_error("failed to create gbm-kms buffer"));
+    return buffer;
 }
 
-inline mgg::Cursor::GBMBOWrapper::operator gbm_bo*()
+/// Bilinearly resample a (premultiplied) ARGB8888 image
+auto scale_argb8888(uint8_t const* src, geom::Size src_size, geom::Size dest_size) -> std::vector<uint8_t>
 {
-    return buffer;
+    auto const src_width = src_size.width.as_int();
+    auto const src_height = src_size.height.as_int();
+    auto const dest_width = dest_size.width.as_int();
+    auto const dest_height = dest_size.height.as_int();
+
+    std::vector<uint8_t> dest(dest_width * dest_height * 4);
+
+    auto const x_ratio = float(src_width) / dest_width;
+    auto const y_ratio = float(src_height) / dest_height;
+
+    for (int y = 0; y != dest_height; ++y)
+    {
+        // Sample at pixel centres
+        auto const src_y = std::clamp((y + 0.5f) * y_ratio - 0.5f, 0.0f, float(src_height - 1));
+        auto const y0 = int(src_y);
+        auto const y1 = std::min(y0 + 1, src_height - 1);
+        auto const fy = src_y - y0;
+
+        for (int x = 0; x != dest_width; ++x)
+        {
+            auto const src_x = std::clamp((x + 0.5f) * x_ratio - 0.5f, 0.0f, float(src_width - 1));
+            auto const x0 = int(src_x);
+            auto const x1 = std::min(x0 + 1, src_width - 1);
+            auto const fx = src_x - x0;
+
+            for (int channel = 0; channel != 4; ++channel)
+            {
+                auto const at = [&](int sx, int sy) { return float(src[(sy * src_width + sx) * 4 + channel]); };
+                auto const top = at(x0, y0) * (1 - fx) + at(x1, y0) * fx;
+                auto const bottom = at(x0, y1) * (1 - fx) + at(x1, y1) * fx;
+                dest[(y * dest_width + x) * 4 + channel] = uint8_t(std::lround(top * (1 - fy) + bottom * fy));
+            }
+        }
+    }
+
+    return dest;
 }
 
-inline mgg::Cursor::GBMBOWrapper::~GBMBOWrapper()
+auto scaled(geom::Size size, float scale) -> geom::Size
 {
-    if (device)
+    // Don't scale anything away entirely
+    auto const scaled_length = [scale](int length) -> int
+        {
+            return length ? std::max(1l, std::lround(length * scale)) : 0;
+        };
+    return {scaled_length(size.width.as_int()), scaled_length(size.height.as_int())};
+}
+}
+
+mgg::Cursor::OutputCursor::OutputCursor(uint32_t output_id, int drm_fd) :
+    output_id{output_id},
+    drm_fd{drm_fd},
+    device{gbm_create_device_checked(drm_fd)}
+{
+    try
+    {
+        buffers.push_back(gbm_create_cursor_bo_checked(device, drm_fd));
+    }
+    catch (...)
+    {
         gbm_device_destroy(device);
-    if (buffer)
+        throw;
+    }
+}
+
+mgg::Cursor::OutputCursor::~OutputCursor()
+{
+    for (auto const buffer : buffers)
         gbm_bo_destroy(buffer);
+    if (device)
+        gbm_device_destroy(device);
 }
 
-mgg::Cursor::GBMBOWrapper::GBMBOWrapper(GBMBOWrapper&& from)
-    : device{from.device},
-      buffer{from.buffer},
-      current_orientation{from.current_orientation}
+mgg::Cursor::OutputCursor::OutputCursor(OutputCursor&& from)
+    : output_id{from.output_id},
+      drm_fd{from.drm_fd},
+      on_screen{from.on_screen},
+      stale{from.stale},
+      orientation{from.orientation},
+      scale{from.scale},
+      image_scale{from.image_scale},
+      device{from.device},
+      buffers{std::move(from.buffers)},
+      front{from.front}
 {
-    from.buffer = nullptr;
+    from.buffers.clear();
     from.device = nullptr;
 }
 
-auto mir::graphics::gbm::Cursor::GBMBOWrapper::change_orientation(MirOrientation new_orientation) -> bool
+auto mgg::Cursor::OutputCursor::back_buffer() -> gbm_bo*
 {
-    if (current_orientation == new_orientation)
-        return false;
+    // Nothing is scanning out the front buffer, so it can be written to in place
+    if (!on_screen)
+        return buffers[front];
+
+    if (buffers.size() < 2)
+        buffers.push_back(gbm_create_cursor_bo_checked(device, drm_fd));
 
-    current_orientation = new_orientation;
-    return true;
+    return buffers[(front + 1) % buffers.size()];
+}
+
+void mgg::Cursor::OutputCursor::swap()
+{
+    if (on_screen)
+        front = (front + 1) % buffers.size();
+
+    on_screen = false;
+    stale = false;
 }
 
 mgg::Cursor::Cursor(
@@ -140,7 +221,7 @@ mgg::Cursor::Cursor(
                 [this, &kms_conf](auto const& output)
                 {
                     // I'm not sure why g++ needs the explicit "this->" but it does - alan_g
-                    this->buffer_for_output(*kms_conf.get_output_for(output.id));
+                    this->cursor_for_output(*kms_conf.get_output_for(output.id));
                 });
         });
 
@@ -168,19 +249,55 @@ void mgg::Cursor::write_buffer_data_locked(
     }
 }
 
+void mgg::Cursor::prepare_image_locked(
+    std::lock_guard<std::mutex> const& lg,
+    OutputCursor& cursor,
+    MirOrientation orientation,
+    float scale)
+{
+    bool const sideways = orientation == mir_orientation_left || orientation == mir_orientation_right;
+    auto const max_width = float(sideways ? min_buffer_height : min_buffer_width);
+    auto const max_height = float(sideways ? min_buffer_width : min_buffer_height);
+
+    // Scale the image as the output scales everything else, but shrink it rather than crop it to the buffer
+    auto const image_scale = std::min({
+        scale,
+        max_width / size.width.as_int(),
+        max_height / size.height.as_int()});
+
+    auto const buffer = cursor.back_buffer();
+    if (image_scale == 1.0f || size.width.as_int() == 0 || size.height.as_int() == 0)
+    {
+        pad_and_write_image_data_locked(lg, buffer, argb8888.data(), size, orientation);
+    }
+    else
+    {
+        auto const image_size = scaled(size, image_scale);
+        auto const image = scale_argb8888(argb8888.data(), size, image_size);
+        pad_and_write_image_data_locked(lg, buffer, image.data(), image_size, orientation);
+    }
+
+    cursor.swap();
+    cursor.orientation = orientation;
+    cursor.scale = scale;
+    cursor.image_scale = image_scale;
+}
+
 void mgg::Cursor::pad_and_write_image_data_locked(
     std::lock_guard<std::mutex> const& lg,
-    GBMBOWrapper& buffer)
+    gbm_bo* buffer,
+    uint8_t const* image,
+    geom::Size image_size,
+    MirOrientation orientation)
 {
-    auto const orientation = buffer.orientation();
     bool const sideways = orientation == mir_orientation_left || orientation == mir_orientation_right;
 
     auto const min_width  = sideways ? min_buffer_width : min_buffer_height;
     auto const min_height = sideways ? min_buffer_height : min_buffer_width;
 
-    auto const image_width = std::min(min_width, size.width.as_uint32_t());
-    auto const image_height = std::min(min_height, size.height.as_uint32_t());
-    auto const image_stride = size.width.as_uint32_t() * 4;
+    auto const image_width = std::min(min_width, image_size.width.as_uint32_t());
+    auto const image_height = std::min(min_height, image_size.height.as_uint32_t());
+    auto const image_stride = image_size.width.as_uint32_t() * 4;
 
     auto const buffer_stride = std::max(min_width*4, gbm_bo_get_stride(buffer));  // in bytes
     auto const buffer_height = std::max(min_height, gbm_bo_get_height(buffer));
@@ -190,7 +307,7 @@ void mgg::Cursor::pad_and_write_image_data_locked(
     size_t rhs_padding = buffer_stride - 4*image_width;
 
     auto const filler = 0; // 0x3f; is useful to make buffer visible for debugging
-    uint8_t const* src = argb8888.data();
+    uint8_t const* src = image;
     uint8_t* dest = &padded[0];
 
     switch (orientation)
@@ -264,15 +381,14 @@ void mgg::Cursor::show(CursorImage const& cursor_image)
 
     hotspot = cursor_image.hotspot();
     {
+        // Each output's buffers are rewritten as the cursor is placed on it
         auto locked_buffers = buffers.lock();
-        for (auto& tuple : *locked_buffers)
+        for (auto& cursor : *locked_buffers)
         {
-            pad_and_write_image_data_locked(lg, std::get<2>(tuple));
+            cursor.stale = true;
         }
     }
 
-    // Writing the data could throw an exception so let's
-    // hold off on setting visible until after we have succeeded.
     visible = true;
     place_cursor_at_locked(lg, current_position, ForceState);
 }
@@ -296,6 +412,12 @@ void mir::graphics::gbm::Cursor::clear(std::lock_guard<std::mutex> const&)
             if (!output->clear_cursor())
                 last_set_failed = true;
         });
+
+    auto locked_buffers = buffers.lock();
+    for (auto& cursor : *locked_buffers)
+    {
+        cursor.on_screen = false;
+    }
 }
 
 void mgg::Cursor::resume()
@@ -377,24 +499,35 @@ void mgg::Cursor::place_cursor_at_locked(
 
             auto const position_on_output = geom::Point{roundf(output_space_vec.x), roundf(output_space_vec.y)};
 
-            auto const hotspot_displacement = transform(geom::Rectangle{{}, size}, hotspot, orientation);
+            // Output pixels per logical pixel
+            bool const sideways = orientation == mir_orientation_left || orientation == mir_orientation_right;
+            auto const scale = output_size_vec.x /
+                (sideways ? output_rect.size.height.as_int() : output_rect.size.width.as_int());
+
+            auto& cursor = cursor_for_output(output);
+
+            auto const changed_image = cursor.stale || cursor.orientation != orientation || cursor.scale != scale;
+            if (changed_image)
+                prepare_image_locked(lg, cursor, orientation, scale);
+
+            auto const image_size = scaled(size, cursor.image_scale);
+            auto const image_hotspot = geom::Displacement{
+                std::lround(hotspot.dx.as_int() * cursor.image_scale),
+                std::lround(hotspot.dy.as_int() * cursor.image_scale)};
+            auto const hotspot_displacement = transform(geom::Rectangle{{}, image_size}, image_hotspot, orientation);
 
             // It's a little strange that we implement hotspot this way as there is
             // drmModeSetCursor2 with hotspot support. However, it appears to not actually
             // work on radeon and intel. There also seems to be precedent in weston for
             // implementing hotspot in this fashion.
             output.move_cursor(position_on_output - hotspot_displacement);
-            auto& buffer = buffer_for_output(output);
-
-            auto const changed_orientation = buffer.change_orientation(orientation);
-
-            if (changed_orientation)
-                pad_and_write_image_data_locked(lg, buffer);
 
-            if (force_state || !output.has_cursor() || changed_orientation)
+            if (force_state || !output.has_cursor() || changed_image)
             {
-                if (!output.set_cursor(buffer) || !output.has_cursor())
+                if (!output.set_cursor(cursor.front_buffer()) || !output.has_cursor())
                     set_on_all_outputs = false;
+                else
+                    cursor.on_screen = true;
             }
         }
         else
@@ -409,22 +542,23 @@ void mgg::Cursor::place_cursor_at_locked(
     last_set_failed = !set_on_all_outputs;
 }
 
-mgg::Cursor::GBMBOWrapper& mgg::Cursor::buffer_for_output(KMSOutput const& output)
+mgg::Cursor::OutputCursor& mgg::Cursor::cursor_for_output(KMSOutput const& output)
 {
     auto const drm_fd = output.drm_fd();
     auto const id = output.id();
     auto locked_buffers = buffers.lock();
 
-    for (auto& bo : *locked_buffers)
+    for (auto& cursor : *locked_buffers)
     {
         // We use both id and drm_fd as identifier as we're not sure of the uniqueness of either
-        if (std::get<0>(bo) == id && std::get<1>(bo) == drm_fd)
-            return std::get<2>(bo);
+        if (cursor.output_id == id && cursor.drm_fd == drm_fd)
+            return cursor;
     }
 
-    locked_buffers->push_back(image_buffer{id, drm_fd, GBMBOWrapper{drm_fd, mir_orientation_normal}});
+    locked_buffers->emplace_back(id, drm_fd);
 
-    GBMBOWrapper& bo = std::get<2>(locked_buffers->back());
+    auto& cursor = locked_buffers->back();
+    gbm_bo* const bo = cursor.front_buffer();
     if (gbm_bo_get_width(bo) < min_buffer_width)
     {
         min_buffer_width = gbm_bo_get_width(bo);
@@ -434,5 +568,5 @@ mgg::Cursor::GBMBOWrapper& mgg::Cursor::buffer_for_output(KMSOutput const& outpu
         min_buffer_height = gbm_bo_get_height(bo);
     }
 
-    return bo;
+    return cursor;
 }
@@ -79,7 +79,7 @@ public:
 
 private:
     enum ForceCursorState { UpdateState, ForceState };
-    struct GBMBOWrapper;
+    struct OutputCursor;
     void for_each_used_output(std::function<void(KMSOutput& output, DisplayConfigurationOutput const& conf)> const& f);
     void place_cursor_at(geometry::Point position, ForceCursorState force_state);
     void place_cursor_at_locked(std::lock_guard<std::mutex> const&, geometry::Point position, ForceCursorState force_state);
@@ -88,12 +88,21 @@ private:
         gbm_bo* buffer,
         void const* data,
         size_t count);
+    /// Write the image, scaled and rotated for the output, to a cursor buffer not being scanned out
+    void prepare_image_locked(
+        std::lock_guard<std::mutex> const&,
+        OutputCursor& cursor,
+        MirOrientation orientation,
+        float scale);
     void pad_and_write_image_data_locked(
         std::lock_guard<std::mutex> const&,
-        GBMBOWrapper& buffer);
+        gbm_bo* buffer,
+        uint8_t const* image,
+        geometry::Size image_size,
+        MirOrientation orientation);
     void clear(std::lock_guard<std::mutex> const&);
 
-    GBMBOWrapper& buffer_for_output(KMSOutput const& output);
+    OutputCursor& cursor_for_output(KMSOutput const& output);
     
     std::mutex guard;
 
@@ -106,27 +115,49 @@ private:
     bool visible;
     bool last_set_failed;
 
-    struct GBMBOWrapper
+    /**
+     * The cursor buffers of an output
+     *
+     * The image is written to whichever buffer is not being scanned out, so
+     * the buffers are created on demand and reused in turn; an image only
+     * needs rewriting when it, or the orientation or scale of the output,
+     * changes. Moving the cursor never touches them.
+     */
+    struct OutputCursor
     {
-        GBMBOWrapper(int fd, MirOrientation orientation);
-        operator gbm_bo*();
-
-        auto orientation() const -> MirOrientation { return current_orientation; }
-        auto change_orientation(MirOrientation new_orientation) -> bool;
-
-        ~GBMBOWrapper();
-
-        GBMBOWrapper(GBMBOWrapper&& from);
+        OutputCursor(uint32_t output_id, int drm_fd);
+        ~OutputCursor();
+
+        OutputCursor(OutputCursor&& from);
+
+        /// The buffer to write the next image to
+        auto back_buffer() -> gbm_bo*;
+        /// The back buffer now holds the current image
+        void swap();
+
+        uint32_t const output_id;
+        int const drm_fd;
+
+        /// The buffer holding the current image
+        auto front_buffer() const -> gbm_bo* { return buffers[front]; }
+
+        /// Whether the front buffer is set on the output
+        bool on_screen{false};
+        /// Whether the front buffer holds an image older than the current one
+        bool stale{true};
+        MirOrientation orientation{mir_orientation_normal};
+        float scale{1.0f};
+        /// Scale of the written image relative to the cursor image
+        float image_scale{1.0f};
     private:
         gbm_device* device;
-        gbm_bo* buffer;
-        MirOrientation current_orientation;
-        GBMBOWrapper(GBMBOWrapper const&) = delete;
-        GBMBOWrapper& operator=(GBMBOWrapper const&) = delete;
+        std::vector<gbm_bo*> buffers;
+        size_t front{0};
+        OutputCursor(OutputCursor const&) = delete;
+        OutputCursor& operator=(OutputCursor const&) = delete;
     };
 
-    using image_buffer = std::tuple<uint32_t, int, GBMBOWrapper>;
-    Synchronised<std::vector<image_buffer>> buffers;
+    Synchronised<std::vector<OutputCursor>> buffers;
 
     uint32_t min_buffer_width;
     uint32_t min_buffer_height;
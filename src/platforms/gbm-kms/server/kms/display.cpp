@@ -140,6 +140,22 @@ void log_drm_details(mir::Fd const& drm_fd)
     }
 }
 
+/**
+ * Switch drm_fd to atomic modesetting, for driving overlay planes
+ *
+ * This is a property of the fd, so is done once, before any output uses it.
+ * It also exposes the primary and cursor planes; legacy modesetting carries on
+ * working as before.
+ */
+auto enable_atomic_modesetting(int drm_fd) -> bool
+{
+    if (drmSetClientCap(drm_fd, DRM_CLIENT_CAP_ATOMIC, 1) != 0)
+    {
+        mir::log_debug("Atomic modesetting unsupported; not using overlay planes");
+        return false;
+    }
+    return true;
+}
 }
 
 mgg::Display::Display(
@@ -155,7 +171,8 @@ mgg::Display::Display(
       output_container{
           std::make_shared<RealKMSOutputContainer>(
             this->drm_fd,
-            std::make_shared<KMSPageFlipper>(this->drm_fd, listener))},
+            std::make_shared<KMSPageFlipper>(this->drm_fd, listener),
+            enable_atomic_modesetting(this->drm_fd))},
       current_display_configuration{output_container},
       dirty_configuration{false},
       bypass_option(bypass_option)
@@ -19,6 +19,7 @@
 #include "kms_output.h"
 #include "cpu_addressable_fb.h"
 #include "gbm_display_allocator.h"
+#include "dmabuf_display_allocator.h"
 #include "mir/fd.h"
 #include "mir/graphics/display_report.h"
 #include "mir/graphics/platform.h"
@@ -48,15 +49,25 @@ namespace mg = mir::graphics;
 namespace mgg = mir::graphics::gbm;
 namespace geom = mir::geometry;
 
+namespace
+{
+/// KMS planes can only show buffers opaque and upright; anything else needs rendering
+auto shown_as_is(mg::DisplayElement const& element) -> bool
+{
+    return element.alpha == 1.0f && element.transformation == glm::mat4{1};
+}
+}
+
 mgg::DisplaySink::DisplaySink(
     mir::Fd drm_fd,
     std::shared_ptr<struct gbm_device> gbm,
-    mgg::BypassOption,
+    mgg::BypassOption bypass_option,
     std::shared_ptr<DisplayReport> const& listener,
     std::vector<std::shared_ptr<KMSOutput>> const& outputs,
     geom::Rectangle const& area,
     glm::mat2 const& transformation)
     : gbm{std::move(gbm)},
+      bypass_option{bypass_option},
       listener(listener),
       outputs(outputs),
       area(area),
@@ -118,30 +129,126 @@ void mgg::DisplaySink::set_transformation(glm::mat2 const& t, geometry::Rectangl
 
 bool mgg::DisplaySink::overlay(std::vector<DisplayElement> const& renderable_list)
 {
-    // TODO: implement more than the most basic case.
-    if (renderable_list.size() != 1)
+    if (renderable_list.empty() || bypass_option == BypassOption::prohibited)
     {
         return false;
     }
 
-    if (renderable_list[0].screen_positon != view_area())
+    // The bottom element has to fill the screen on the primary plane...
+    auto const& bottom = renderable_list.front();
+    if (bottom.screen_positon != view_area() || !shown_as_is(bottom))
     {
         return false;
     }
 
-    if (renderable_list[0].source_position.top_left != geom::PointF {0,0} ||
-        renderable_list[0].source_position.size.width.as_value() != view_area().size.width.as_int() ||
-        renderable_list[0].source_position.size.height.as_value() != view_area().size.height.as_int())
+    // ...which can't rotate a client's buffer to match a transformed display
+    if (transform != glm::mat2{1})
     {
         return false;
     }
 
-    if (auto fb = std::dynamic_pointer_cast<graphics::FBHandle>(renderable_list[0].buffer))
+    if (bottom.source_position.top_left != geom::PointF {0,0} ||
+        bottom.source_position.size.width.as_value() != view_area().size.width.as_int() ||
+        bottom.source_position.size.height.as_value() != view_area().size.height.as_int())
     {
-        next_swap = std::move(fb);
-        return true;
+        return false;
+    }
+
+    auto fb = std::dynamic_pointer_cast<graphics::FBHandle>(bottom.buffer);
+    if (!fb)
+    {
+        return false;
+    }
+
+    // ...and everything else on overlay planes above it
+    if (renderable_list.size() > 1)
+    {
+        if (!can_use_planes())
+        {
+            return false;
+        }
+
+        std::vector<PlaneLayer> layers;
+        for (auto element = renderable_list.begin() + 1; element != renderable_list.end(); ++element)
+        {
+            auto layer = layer_for(*element);
+            if (!layer)
+            {
+                return false;
+            }
+            layers.push_back(std::move(*layer));
+        }
+
+        if (outputs.front()->fit_layers(*fb, layers) != layers.size())
+        {
+            return false;
+        }
+        next_layers = std::move(layers);
     }
-    return false;
+
+    next_swap = std::move(fb);
+    next_is_bypass = true;
+    return true;
+}
+
+auto mgg::DisplaySink::overlay_topmost(std::vector<DisplayElement> const& renderlist) -> size_t
+{
+    /*
+     * The frame to go beneath the layers hasn't been rendered yet, but checking
+     * the layers above the frame on screen, which is the same size, is as good.
+     */
+    auto const& stand_in = scheduled_fb ? scheduled_fb : visible_fb;
+    if (bypass_option == BypassOption::prohibited || !can_use_planes() || !stand_in)
+    {
+        return 0;
+    }
+
+    std::vector<PlaneLayer> layers;
+    for (auto element = renderlist.rbegin(); element != renderlist.rend(); ++element)
+    {
+        auto layer = layer_for(*element);
+        if (!layer)
+        {
+            break;
+        }
+        layers.push_back(std::move(*layer));
+    }
+    std::reverse(layers.begin(), layers.end());
+
+    auto const count = outputs.front()->fit_layers(*stand_in, layers);
+    next_layers.assign(
+        std::make_move_iterator(layers.end() - count),
+        std::make_move_iterator(layers.end()));
+    return count;
+}
+
+auto mgg::DisplaySink::can_overlay() const -> bool
+{
+    // Neither a bypassed client buffer nor a plane can be rotated to match a transformed display
+    return bypass_option == BypassOption::allowed && transform == glm::mat2{1};
+}
+
+auto mgg::DisplaySink::can_use_planes() const -> bool
+{
+    /*
+     * Each output would need its own layers, and the planes can't be
+     * rotated to match a transformed display.
+     */
+    return planes_usable && outputs.size() == 1 && transform == glm::mat2{1} && !needs_set_crtc;
+}
+
+auto mgg::DisplaySink::layer_for(DisplayElement const& element) const -> std::optional<PlaneLayer>
+{
+    auto fb = std::dynamic_pointer_cast<graphics::FBHandle const>(element.buffer);
+    if (!fb || !shown_as_is(element) || !view_area().contains(element.screen_positon))
+    {
+        return std::nullopt;
+    }
+
+    return PlaneLayer{
+        std::move(fb),
+        element.source_position,
+        {as_point(element.screen_positon.top_left - view_area().top_left), element.screen_positon.size}};
 }
 
 void mgg::DisplaySink::for_each_display_sink(std::function<void(graphics::DisplaySink&)> const& f)
@@ -176,11 +283,13 @@ void mgg::DisplaySink::post()
      * point before the next schedule_page_flip().
      */
     wait_for_page_flip();
+    posted_presentation.reset();
 
     if (!next_swap)
     {
         // Hey! No one has given us a next frame yet, so we don't have to change what's onscreen.
         // Sweet! We can just bail.
+        next_layers.clear();
         return;
     }
     /*
@@ -188,13 +297,37 @@ void mgg::DisplaySink::post()
      */
     scheduled_fb = std::move(next_swap);
     next_swap = nullptr;
+    scheduled_layers = std::move(next_layers);
+    next_layers.clear();
+
+    /*
+     * A fullscreen client can pace the output itself: with adaptive sync its
+     * frames are shown as they arrive rather than held for the next fixed
+     * vblank. Composited frames go back to the mode's rate, which is what our
+     * own frame scheduling expects.
+     */
+    set_variable_refresh(next_is_bypass);
+
+    // Client buffers on screen can't go back to their clients until they're replaced
+    holding_client_buffers = next_is_bypass || !scheduled_layers.empty();
 
     /*
      * Try to schedule a page flip as first preference to avoid tearing.
      * [will complete in a background thread]
      */
-    if (!needs_set_crtc && !schedule_page_flip(*scheduled_fb))
+    if (!needs_set_crtc && !schedule_page_flip(*scheduled_fb, scheduled_layers))
+    {
+        if (!scheduled_layers.empty())
+        {
+            /*
+             * The driver accepted these layers in a test commit, but not for
+             * real. This frame is missing them; composite everything from now on.
+             */
+            mir::log_warning("Failed to show layers on overlay planes; no longer using them");
+            planes_usable = false;
+        }
         needs_set_crtc = true;
+    }
 
     /*
      * Fallback blitting: Not pretty, since it may tear. VirtualBox seems
@@ -206,6 +339,9 @@ void mgg::DisplaySink::post()
         // SetCrtc is immediate, so the FB is now visible and we have nothing pending
         visible_fb = std::move(scheduled_fb);
         scheduled_fb = nullptr;
+        // ...and it switches off the overlay planes
+        scheduled_layers.clear();
+        visible_layers.clear();
 
         needs_set_crtc = false;
     }
@@ -252,7 +388,7 @@ void mgg::DisplaySink::post()
     }
 
     recommend_sleep = 0ms;
-    if (outputs.size() == 1)
+    if (outputs.size() == 1 && !variable_refresh)
     {
         auto const& output = outputs.front();
         auto const min_frame_interval = 1000ms / output->max_refresh_rate();
@@ -266,7 +402,79 @@ std::chrono::milliseconds mgg::DisplaySink::recommended_sleep() const
     return recommend_sleep;
 }
 
-bool mgg::DisplaySink::schedule_page_flip(FBHandle const& bufobj)
+auto mgg::DisplaySink::next_vblank() const -> std::optional<Frame::Timestamp>
+{
+    // In clone mode the outputs needn't refresh in step, so there's no one answer.
+    // With variable refresh the next vblank is whenever the next frame is ready.
+    if (outputs.size() != 1 || !last_flip || variable_refresh)
+        return std::nullopt;
+
+    using namespace std::chrono;
+    nanoseconds const interval = duration_cast<nanoseconds>(1s) / outputs.front()->max_refresh_rate();
+    auto const now = Frame::Timestamp::now(last_flip->ust.clock_id);
+
+    // Page flips complete at a vblank, so later vblanks are whole intervals after it
+    auto const elapsed = now - last_flip->ust;
+    auto const intervals = elapsed < nanoseconds::zero() ? 1 : elapsed / interval + 1;
+    auto const next = last_flip->ust + intervals * interval;
+
+    // A flip still pending takes the next vblank, so the next frame can't be shown before the one after
+    return page_flips_pending ? next + interval : next;
+}
+
+auto mgg::DisplaySink::when_presented(std::function<void(Presentation const&)> const& handler) -> bool
+{
+    if (posted_presentation)
+    {
+        handler(*posted_presentation);
+        return true;
+    }
+
+    // Without a flip (nothing new posted, or a SetCrtc) we don't know when the content was shown
+    if (!page_flips_pending)
+        return false;
+
+    presentation_handlers.push_back(handler);
+    return true;
+}
+
+auto mgg::DisplaySink::presentation_at(std::optional<Frame> const& flip, KMSOutput const* flipped) const
+    -> Presentation
+{
+    using namespace std::chrono;
+
+    // We tell clients every timestamp is CLOCK_MONOTONIC, so one from another clock is no use
+    if (!flip || !flipped || flip->ust.clock_id != CLOCK_MONOTONIC)
+        return Presentation{{0, Frame::Timestamp::now(CLOCK_MONOTONIC)}, nanoseconds::zero(), false};
+
+    // With variable refresh there is no refresh interval to predict the next flip from. In clone mode
+    // the timestamp is that of the output flipped, so it's that output's refreshes that follow on from it.
+    auto const refresh_interval = variable_refresh ?
+        nanoseconds::zero() :
+        duration_cast<nanoseconds>(1s) / flipped->max_refresh_rate();
+    return Presentation{*flip, refresh_interval, true};
+}
+
+void mgg::DisplaySink::set_variable_refresh(bool enabled)
+{
+    // Clone mode outputs share frames, so neither can follow the other's rate
+    enabled = enabled && outputs.size() == 1 && outputs.front()->vrr_capable() && !vrr_refused;
+    if (enabled == variable_refresh)
+        return;
+
+    // Only what took effect changes how frames are timed
+    if (outputs.front()->set_vrr_enabled(enabled))
+    {
+        variable_refresh = enabled;
+    }
+    else if (enabled)
+    {
+        // Don't ask (and fail) again every frame
+        vrr_refused = true;
+    }
+}
+
+bool mgg::DisplaySink::schedule_page_flip(FBHandle const& bufobj, std::vector<PlaneLayer> const& layers)
 {
     /*
      * Schedule the current front buffer object for display. Note that
@@ -274,7 +482,10 @@ bool mgg::DisplaySink::schedule_page_flip(FBHandle const& bufobj)
      */
     for (auto& output : outputs)
     {
-        if (output->schedule_page_flip(bufobj))
+        auto const scheduled = layers.empty() ?
+            output->schedule_page_flip(bufobj) :
+            output->schedule_page_flip(bufobj, layers);
+        if (scheduled)
             page_flips_pending = true;
     }
 
@@ -285,14 +496,37 @@ void mgg::DisplaySink::wait_for_page_flip()
 {
     if (page_flips_pending)
     {
+        std::optional<Frame> shown;
+        KMSOutput const* shown_on{nullptr};
         for (auto& output : outputs)
-            output->wait_for_page_flip();
+        {
+            if (auto const frame = output->wait_for_page_flip())
+            {
+                last_flip = frame;
+                // The content isn't shown everywhere until the last of the outputs flips to it
+                if (!shown || shown->ust < frame->ust)
+                {
+                    shown = frame;
+                    shown_on = output.get();
+                }
+            }
+        }
 
         // The previously-scheduled FB has been page-flipped, and is now visible
         visible_fb = std::move(scheduled_fb);
         scheduled_fb = nullptr;
+        visible_layers = std::move(scheduled_layers);
+        scheduled_layers.clear();
 
         page_flips_pending = false;
+
+        posted_presentation = presentation_at(shown, shown_on);
+        auto const handlers = std::move(presentation_handlers);
+        presentation_handlers.clear();
+        for (auto const& handler : handlers)
+        {
+            handler(*posted_presentation);
+        }
     }
 }
 
@@ -313,20 +547,15 @@ auto mgg::DisplaySink::gbm_device() const -> std::shared_ptr<struct gbm_device>
 
 void mir::graphics::gbm::DisplaySink::set_next_image(std::unique_ptr<Framebuffer> content)
 {
-    std::vector<DisplayElement> const single_buffer = {
-        DisplayElement {
-            view_area(),
-            geom::RectangleF{
-                {0, 0},
-                {view_area().size.width.as_value(), view_area().size.height.as_value()}},
-            std::move(content)
-        }
-    };
-    if (!overlay(single_buffer))
+    // Our own rendering is already transformed to suit the outputs, so needs none of overlay()'s checks
+    auto fb = std::dynamic_pointer_cast<graphics::FBHandle const>(std::shared_ptr<Framebuffer>{std::move(content)});
+    if (!fb)
     {
-        // Oh, oh! We should be *guaranteed* to “overlay” a single Framebuffer; this is likely a programming error
+        // We should be *guaranteed* to be given a Framebuffer we can show; this is likely a programming error
         BOOST_THROW_EXCEPTION((std::runtime_error{"Failed to post buffer to display"}));
     }
+    next_swap = std::move(fb);
+    next_is_bypass = false;
 }
 
 auto mgg::DisplaySink::maybe_create_allocator(DisplayAllocator::Tag const& type_tag)
@@ -344,9 +573,22 @@ auto mgg::DisplaySink::maybe_create_allocator(DisplayAllocator::Tag const& type_
     {
         if (!gbm_allocator)
         {
-            gbm_allocator = std::make_unique<GBMDisplayAllocator>(drm_fd(), gbm, outputs.front()->size());
+            gbm_allocator = std::make_unique<GBMDisplayAllocator>(
+                drm_fd(),
+                gbm,
+                outputs.front()->size(),
+                // A client buffer can only be scanned out where it fills the single output
+                outputs.size() == 1 ? outputs.front() : nullptr);
         }
         return gbm_allocator.get();
     }
+    if (dynamic_cast<mg::DmaBufDisplayAllocator::Tag const*>(&type_tag))
+    {
+        if (!dmabuf_allocator)
+        {
+            dmabuf_allocator = std::make_unique<DmaBufDisplayAllocator>(drm_fd(), gbm);
+        }
+        return dmabuf_allocator.get();
+    }
     return nullptr;
 }
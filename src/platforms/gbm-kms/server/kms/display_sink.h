@@ -24,7 +24,9 @@
 #include "mir/graphics/platform.h"
 #include "platform_common.h"
 #include "kms_framebuffer.h"
+#include "kms_planes.h"
 
+#include <optional>
 #include <vector>
 #include <memory>
 #include <atomic>
@@ -62,11 +64,15 @@ public:
     void set_next_image(std::unique_ptr<Framebuffer> content) override;
 
     bool overlay(std::vector<DisplayElement> const& renderlist) override;
+    auto overlay_topmost(std::vector<DisplayElement> const& renderlist) -> size_t override;
+    auto can_overlay() const -> bool override;
 
     void for_each_display_sink(
         std::function<void(graphics::DisplaySink&)> const& f) override;
     void post() override;
     std::chrono::milliseconds recommended_sleep() const override;
+    auto next_vblank() const -> std::optional<Frame::Timestamp> override;
+    auto when_presented(std::function<void(Presentation const&)> const& handler) -> bool override;
 
     glm::mat2 transformation() const override;
 
@@ -82,10 +88,20 @@ protected:
     auto maybe_create_allocator(DisplayAllocator::Tag const& type_tag) -> DisplayAllocator* override;
 
 private:
-    bool schedule_page_flip(FBHandle const& bufobj);
+    bool schedule_page_flip(FBHandle const& bufobj, std::vector<PlaneLayer> const& layers);
+    /// Let a single VRR-capable output refresh at the rate frames arrive, or go back to its fixed rate
+    void set_variable_refresh(bool enabled);
     void set_crtc(FBHandle const&);
+    /// How the content of a post() was shown, going by the last flip (if any) to show it, and the output it was on
+    auto presentation_at(std::optional<Frame> const& flip, KMSOutput const* flipped) const -> Presentation;
+    /// Whether elements can be shown on overlay planes in this configuration
+    auto can_use_planes() const -> bool;
+    /// element as a layer of the (single) output, if it could be shown on an overlay plane
+    auto layer_for(DisplayElement const& element) const -> std::optional<PlaneLayer>;
 
     std::shared_ptr<struct gbm_device> const gbm;
+    /// Whether a client's buffer may be shown in place of a frame we composite
+    BypassOption const bypass_option;
     bool holding_client_buffers{false};
     std::shared_ptr<FBHandle const> bypass_bufobj{nullptr};
     std::shared_ptr<DisplayReport> const listener;
@@ -94,6 +110,7 @@ private:
 
     std::shared_ptr<CPUAddressableDisplayAllocator> kms_allocator;
     std::unique_ptr<GBMDisplayAllocator> gbm_allocator;
+    std::unique_ptr<graphics::DmaBufDisplayAllocator> dmabuf_allocator;
 
     // Framebuffer handling
     // KMS does not take a reference to submitted framebuffers; if you destroy a framebuffer while
@@ -101,12 +118,29 @@ private:
     std::shared_ptr<FBHandle const> next_swap{nullptr};    //< Next frame to submit to the hardware
     std::shared_ptr<FBHandle const> scheduled_fb{nullptr}; //< Frame currently submitted to the hardware, not yet on-screen
     std::shared_ptr<FBHandle const> visible_fb{nullptr};   //< Frame currently onscreen
+    // ...and the same for whatever is on the overlay planes above each frame
+    std::vector<PlaneLayer> next_layers;
+    std::vector<PlaneLayer> scheduled_layers;
+    std::vector<PlaneLayer> visible_layers;
+    bool planes_usable{true};
+    /// Whether next_swap is a client's buffer, rather than a frame we composited
+    bool next_is_bypass{false};
+    /// Whether the output is refreshing as each frame arrives
+    bool variable_refresh{false};
+    /// Whether the output has failed to enable variable refresh, so shouldn't be asked again
+    bool vrr_refused{false};
 
     geometry::Rectangle area;
     glm::mat2 transform;
     std::atomic<bool> needs_set_crtc;
     std::chrono::milliseconds recommend_sleep{0};
     bool page_flips_pending;
+    /// The most recent page flip to complete (only meaningful with a single output)
+    std::optional<Frame> last_flip;
+    /// How the content of the most recent post() was shown, once its flip has completed
+    std::optional<Presentation> posted_presentation;
+    /// Waiting for the flip of the most recent post() to complete
+    std::vector<std::function<void(Presentation const&)>> presentation_handlers;
 };
 
 }
@@ -25,8 +25,11 @@
 #include "mir/graphics/dmabuf_buffer.h"
 #include "mir_toolkit/common.h"
 #include "kms-utils/drm_mode_resources.h"
+#include "kms_planes.h"
 
 #include <gbm.h>
+#include <optional>
+#include <vector>
 
 namespace mir
 {
@@ -61,6 +64,18 @@ public:
      */
     virtual int max_refresh_rate() const = 0;
 
+    /// Whether the connector and its driver support variable refresh rate (adaptive sync)
+    virtual bool vrr_capable() const = 0;
+    /**
+     * Let the output refresh as each page flip arrives (up to max_refresh_rate())
+     * rather than at the fixed rate of its mode.
+     *
+     * Has no effect unless the output is vrr_capable().
+     *
+     * \returns Whether the output now refreshes as asked; if not, it is as it was
+     */
+    virtual bool set_vrr_enabled(bool enabled) = 0;
+
     virtual bool set_crtc(FBHandle const& fb) = 0;
 
     /**
@@ -70,7 +85,30 @@ public:
     virtual bool has_crtc_mismatch() = 0;
     virtual void clear_crtc() = 0;
     virtual bool schedule_page_flip(FBHandle const& fb) = 0;
-    virtual void wait_for_page_flip() = 0;
+    /// \returns the last page flip to complete, or std::nullopt if the output is off
+    virtual auto wait_for_page_flip() -> std::optional<Frame> = 0;
+
+    /**
+     * How many of the topmost layers the hardware can show on overlay planes,
+     * above fb on the primary plane.
+     *
+     * This is checked against the driver without changing what's on screen.
+     * \returns 0 if the output has no usable overlay planes
+     */
+    virtual auto fit_layers(FBHandle const& fb, std::vector<PlaneLayer> const& layers) -> size_t = 0;
+    /**
+     * Schedule a page flip to fb, with each of layers on an overlay plane above it.
+     *
+     * layers should be no more than fit_layers() found would fit.
+     */
+    virtual bool schedule_page_flip(FBHandle const& fb, std::vector<PlaneLayer> const& layers) = 0;
+
+    /**
+     * The DRM format and modifier pairs the primary plane can scan out
+     *
+     * \returns an empty list if the planes of the output can't be probed
+     */
+    virtual auto scanout_formats() -> std::vector<std::pair<uint32_t, uint64_t>> = 0;
 
     virtual bool set_cursor(gbm_bo* buffer) = 0;
     virtual void move_cursor(geometry::Point destination) = 0;
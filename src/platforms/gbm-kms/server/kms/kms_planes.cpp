@@ -0,0 +1,374 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "kms_planes.h"
+#include "kms_framebuffer.h"
+#include "kms-utils/drm_mode_resources.h"
+#include "mir/log.h"
+
+#include <boost/throw_exception.hpp>
+#include <drm_fourcc.h>
+#include <xf86drm.h>
+
+#include <algorithm>
+#include <cmath>
+#include <optional>
+#include <stdexcept>
+#include <tuple>
+
+namespace mgg = mir::graphics::gbm;
+namespace mgk = mir::graphics::kms;
+namespace geom = mir::geometry;
+
+namespace
+{
+auto index_of_crtc(int drm_fd, uint32_t crtc_id) -> std::optional<int>
+{
+    mgk::DRMModeResources resources{drm_fd};
+
+    int index = 0;
+    for (auto const& crtc : resources.crtcs())
+    {
+        if (crtc->crtc_id == crtc_id)
+        {
+            return index;
+        }
+        ++index;
+    }
+    return std::nullopt;
+}
+
+/**
+ * The format and modifier pairs plane can scan out
+ *
+ * From its IN_FORMATS blob where the driver has one; otherwise from its format
+ * list, which is only good for implicit modifiers.
+ */
+auto formats_of(int drm_fd, mgk::DRMModePlaneUPtr const& plane, mgk::ObjectProperties const& props)
+    -> std::vector<std::pair<uint32_t, uint64_t>>
+{
+    std::vector<std::pair<uint32_t, uint64_t>> formats;
+
+    if (props.has_property("IN_FORMATS"))
+    {
+        std::unique_ptr<drmModePropertyBlobRes, void(*)(drmModePropertyBlobPtr)> const blob{
+            drmModeGetPropertyBlob(drm_fd, props["IN_FORMATS"]),
+            &drmModeFreePropertyBlob};
+
+        if (blob && blob->length >= sizeof(drm_format_modifier_blob))
+        {
+            auto const data = static_cast<char const*>(blob->data);
+            auto const header = reinterpret_cast<drm_format_modifier_blob const*>(data);
+            auto const blob_formats = reinterpret_cast<uint32_t const*>(data + header->formats_offset);
+            auto const modifiers = reinterpret_cast<drm_format_modifier const*>(data + header->modifiers_offset);
+
+            for (auto i = 0u; i < header->count_modifiers; ++i)
+            {
+                // Each modifier applies to a 64-format window of the format list, as a bitmask
+                for (auto bit = 0u; bit < 64; ++bit)
+                {
+                    auto const index = modifiers[i].offset + bit;
+                    if ((modifiers[i].formats & (uint64_t{1} << bit)) && index < header->count_formats)
+                    {
+                        formats.emplace_back(blob_formats[index], modifiers[i].modifier);
+                    }
+                }
+            }
+            return formats;
+        }
+    }
+
+    for (auto i = 0u; i < plane->count_formats; ++i)
+    {
+        formats.emplace_back(plane->formats[i], DRM_FORMAT_MOD_INVALID);
+    }
+    return formats;
+}
+
+/// Where a plane stacks, from its zpos property
+struct Stacking
+{
+    uint64_t current;
+    /// The range we can move the plane within; just current if we can't move it
+    uint64_t min, max;
+    bool settable;
+};
+
+auto stacking_of(int drm_fd, mgk::ObjectProperties const& props) -> std::optional<Stacking>
+{
+    if (!props.has_property("zpos"))
+    {
+        return std::nullopt;
+    }
+
+    auto const current = props["zpos"];
+    mgk::DRMModePropertyUPtr const property{drmModeGetProperty(drm_fd, props.id_for("zpos")), &drmModeFreeProperty};
+    if (!property || (property->flags & DRM_MODE_PROP_IMMUTABLE) || property->count_values < 2)
+    {
+        return Stacking{current, current, current, false};
+    }
+    return Stacking{current, property->values[0], property->values[1], true};
+}
+
+/// Plane coordinates in the buffer are 16.16 fixed point
+auto fixed_point(float value) -> uint64_t
+{
+    return static_cast<uint64_t>(std::lround(value * 65536.0f));
+}
+}
+
+auto mgg::KMSPlanes::create_if_supported(int drm_fd, uint32_t crtc_id) -> std::unique_ptr<KMSPlanes>
+{
+    try
+    {
+        auto const crtc_index = index_of_crtc(drm_fd, crtc_id);
+        if (!crtc_index)
+        {
+            return nullptr;
+        }
+
+        std::optional<Plane> primary;
+        std::optional<Stacking> primary_stacking;
+        std::vector<std::pair<uint32_t, uint64_t>> primary_formats;
+        std::vector<std::pair<Plane, Stacking>> candidates;
+        /// The legacy cursor goes above everything; overlays have to stay beneath it
+        std::optional<uint64_t> cursor_zpos;
+        size_t unordered{0};
+
+        mgk::PlaneResources resources{drm_fd};
+        for (auto const& plane : resources.planes())
+        {
+            if (!(plane->possible_crtcs & (1u << *crtc_index)))
+            {
+                continue;
+            }
+
+            mgk::ObjectProperties const props{drm_fd, plane};
+            auto const stacking = stacking_of(drm_fd, props);
+            Plane description{
+                plane->plane_id,
+                {
+                    props.id_for("FB_ID"),
+                    props.id_for("CRTC_ID"),
+                    props.id_for("SRC_X"),
+                    props.id_for("SRC_Y"),
+                    props.id_for("SRC_W"),
+                    props.id_for("SRC_H"),
+                    props.id_for("CRTC_X"),
+                    props.id_for("CRTC_Y"),
+                    props.id_for("CRTC_W"),
+                    props.id_for("CRTC_H"),
+                    stacking && stacking->settable ? props.id_for("zpos") : 0},
+                stacking ? stacking->current : 0};
+
+            switch (props["type"])
+            {
+            case DRM_PLANE_TYPE_PRIMARY:
+                // Where more than one primary could drive this CRTC, use the one already driving it
+                if (!primary || plane->crtc_id == crtc_id)
+                {
+                    primary = description;
+                    primary_stacking = stacking;
+                    primary_formats = formats_of(drm_fd, plane, props);
+                }
+                break;
+
+            case DRM_PLANE_TYPE_OVERLAY:
+                if (stacking)
+                {
+                    candidates.emplace_back(description, *stacking);
+                }
+                else
+                {
+                    ++unordered;
+                }
+                break;
+
+            case DRM_PLANE_TYPE_CURSOR:
+                if (stacking && !stacking->settable)
+                {
+                    cursor_zpos = stacking->current;
+                }
+                break;
+
+            default:
+                break;
+            }
+        }
+
+        if (!primary)
+        {
+            return nullptr;
+        }
+
+        /*
+         * An overlay the driver gives no zpos could stack anywhere, so we can't
+         * use it. The rest we stack in order above the primary plane (which
+         * is at the bottom where it doesn't say otherwise), moving those we can
+         * so no two tie; any that can't get into the order are left unused.
+         */
+        std::sort(
+            candidates.begin(),
+            candidates.end(),
+            [](auto const& a, auto const& b)
+            {
+                return std::tie(a.second.min, a.first.id) < std::tie(b.second.min, b.first.id);
+            });
+
+        primary->zpos = primary_stacking ? primary_stacking->min : 0;
+        auto below = primary->zpos;
+
+        std::vector<Plane> overlays;
+        for (auto& [plane, stacking] : candidates)
+        {
+            auto const zpos = std::max(stacking.min, below + 1);
+            if (zpos > stacking.max || (cursor_zpos && zpos >= *cursor_zpos))
+            {
+                ++unordered;
+                continue;
+            }
+            plane.zpos = zpos;
+            overlays.push_back(plane);
+            below = zpos;
+        }
+
+        if (unordered)
+        {
+            mir::log_debug("Not using %zu overlay planes of CRTC %u that can't be stacked in order", unordered, crtc_id);
+        }
+        mir::log_info("Found %zu overlay planes for CRTC %u", overlays.size(), crtc_id);
+        return std::unique_ptr<KMSPlanes>{new KMSPlanes{crtc_id, *primary, std::move(primary_formats), std::move(overlays)}};
+    }
+    catch (std::exception const& error)
+    {
+        mir::log_warning("Failed to enumerate planes for CRTC %u: %s", crtc_id, error.what());
+        return nullptr;
+    }
+}
+
+mgg::KMSPlanes::KMSPlanes(
+    uint32_t crtc_id,
+    Plane primary,
+    std::vector<std::pair<uint32_t, uint64_t>> primary_formats,
+    std::vector<Plane> overlays)
+    : crtc_id{crtc_id},
+      primary{primary},
+      primary_formats_{std::move(primary_formats)},
+      overlays{std::move(overlays)}
+{
+}
+
+auto mgg::KMSPlanes::overlay_count() const -> size_t
+{
+    return overlays.size();
+}
+
+auto mgg::KMSPlanes::primary_formats() const -> std::vector<std::pair<uint32_t, uint64_t>> const&
+{
+    return primary_formats_;
+}
+
+auto mgg::KMSPlanes::in_use() const -> bool
+{
+    return active_overlays > 0;
+}
+
+auto mgg::KMSPlanes::request_for(
+    uint32_t primary_fb,
+    geom::Rectangle const& primary_source,
+    std::vector<PlaneLayer> const& layers,
+    size_t count) const -> AtomicRequestUPtr
+{
+    if (count > std::min(layers.size(), overlays.size()))
+    {
+        BOOST_THROW_EXCEPTION((std::logic_error{"More layers requested than there are overlay planes"}));
+    }
+
+    AtomicRequestUPtr request{drmModeAtomicAlloc(), &drmModeAtomicFree};
+
+    show(
+        request.get(),
+        primary,
+        primary_fb,
+        geom::RectangleF{
+            {primary_source.top_left.x.as_value(), primary_source.top_left.y.as_value()},
+            {primary_source.size.width.as_value(), primary_source.size.height.as_value()}},
+        {{0, 0}, primary_source.size});
+
+    auto layer = layers.end() - count;
+    for (size_t i = 0; i != count; ++i, ++layer)
+    {
+        show(request.get(), overlays[i], *layer->fb, layer->source, layer->destination);
+    }
+    for (size_t i = count; i < active_overlays; ++i)
+    {
+        hide(request.get(), overlays[i]);
+    }
+
+    return request;
+}
+
+auto mgg::KMSPlanes::request_disabling_overlays() const -> AtomicRequestUPtr
+{
+    AtomicRequestUPtr request{drmModeAtomicAlloc(), &drmModeAtomicFree};
+
+    for (size_t i = 0; i != active_overlays; ++i)
+    {
+        hide(request.get(), overlays[i]);
+    }
+
+    return request;
+}
+
+void mgg::KMSPlanes::committed(size_t count)
+{
+    active_overlays = count;
+}
+
+void mgg::KMSPlanes::show(
+    drmModeAtomicReq* request,
+    Plane const& plane,
+    uint32_t fb,
+    geom::RectangleF const& source,
+    geom::Rectangle const& destination) const
+{
+    drmModeAtomicAddProperty(request, plane.id, plane.prop.fb_id, fb);
+    drmModeAtomicAddProperty(request, plane.id, plane.prop.crtc_id, crtc_id);
+
+    drmModeAtomicAddProperty(request, plane.id, plane.prop.src_x, fixed_point(source.top_left.x.as_value()));
+    drmModeAtomicAddProperty(request, plane.id, plane.prop.src_y, fixed_point(source.top_left.y.as_value()));
+    drmModeAtomicAddProperty(request, plane.id, plane.prop.src_w, fixed_point(source.size.width.as_value()));
+    drmModeAtomicAddProperty(request, plane.id, plane.prop.src_h, fixed_point(source.size.height.as_value()));
+
+    // CRTC_X and CRTC_Y are signed, so a plane can hang off the top-left of the output
+    drmModeAtomicAddProperty(
+        request, plane.id, plane.prop.crtc_x, static_cast<uint64_t>(int64_t{destination.top_left.x.as_int()}));
+    drmModeAtomicAddProperty(
+        request, plane.id, plane.prop.crtc_y, static_cast<uint64_t>(int64_t{destination.top_left.y.as_int()}));
+    drmModeAtomicAddProperty(request, plane.id, plane.prop.crtc_w, destination.size.width.as_uint32_t());
+    drmModeAtomicAddProperty(request, plane.id, plane.prop.crtc_h, destination.size.height.as_uint32_t());
+
+    if (plane.prop.zpos)
+    {
+        drmModeAtomicAddProperty(request, plane.id, plane.prop.zpos, plane.zpos);
+    }
+}
+
+void mgg::KMSPlanes::hide(drmModeAtomicReq* request, Plane const& plane) const
+{
+    drmModeAtomicAddProperty(request, plane.id, plane.prop.fb_id, 0);
+    drmModeAtomicAddProperty(request, plane.id, plane.prop.crtc_id, 0);
+}
@@ -0,0 +1,141 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_GRAPHICS_GBM_KMS_PLANES_H_
+#define MIR_GRAPHICS_GBM_KMS_PLANES_H_
+
+#include "mir/geometry/rectangle.h"
+
+#include <xf86drmMode.h>
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace mir
+{
+namespace graphics
+{
+class FBHandle;
+
+namespace gbm
+{
+/**
+ * A framebuffer to be shown on a hardware plane, above whatever is on the
+ * primary plane.
+ */
+struct PlaneLayer
+{
+    std::shared_ptr<FBHandle const> fb;
+    /// Region of fb to show
+    geometry::RectangleF source;
+    /// Where to show it, relative to the top-left of the output
+    geometry::Rectangle destination;
+};
+
+using AtomicRequestUPtr = std::unique_ptr<drmModeAtomicReq, void(*)(drmModeAtomicReqPtr)>;
+
+/**
+ * The primary and overlay planes usable with a CRTC, driven through atomic
+ * modesetting.
+ *
+ * The cursor plane is left to the legacy cursor interface.
+ */
+class KMSPlanes
+{
+public:
+    /**
+     * Find the planes usable with crtc_id
+     *
+     * \pre    Atomic modesetting has been enabled on drm_fd, which is what exposes
+     *         the primary plane.
+     * \returns nullptr if the driver doesn't expose the planes of crtc_id.
+     */
+    static auto create_if_supported(int drm_fd, uint32_t crtc_id) -> std::unique_ptr<KMSPlanes>;
+
+    /// The number of overlay planes available to show layers on
+    auto overlay_count() const -> size_t;
+
+    /// The DRM format and modifier pairs the primary plane can scan out
+    auto primary_formats() const -> std::vector<std::pair<uint32_t, uint64_t>> const&;
+
+    /// Whether any overlay plane was left showing a layer by the last commit
+    auto in_use() const -> bool;
+
+    /**
+     * Build a request showing primary_fb on the primary plane and the topmost
+     * count of layers on overlay planes, switching off any other overlay
+     * that's in use.
+     *
+     * \param primary_source    The region of primary_fb to show, filling the output
+     */
+    auto request_for(
+        uint32_t primary_fb,
+        geometry::Rectangle const& primary_source,
+        std::vector<PlaneLayer> const& layers,
+        size_t count) const -> AtomicRequestUPtr;
+
+    /// Build a request switching off every overlay plane in use
+    auto request_disabling_overlays() const -> AtomicRequestUPtr;
+
+    /// Record that a request showing count layers has been committed
+    void committed(size_t count);
+
+private:
+    struct Plane
+    {
+        uint32_t id;
+        /// The ids of the plane properties we set
+        struct
+        {
+            uint32_t fb_id;
+            uint32_t crtc_id;
+            uint32_t src_x, src_y, src_w, src_h;
+            uint32_t crtc_x, crtc_y, crtc_w, crtc_h;
+            /// 0 where the driver fixes the plane's place in the stack
+            uint32_t zpos;
+        } prop;
+        /// The plane's place in the stack, which we set where the driver lets us
+        uint64_t zpos;
+    };
+
+    KMSPlanes(
+        uint32_t crtc_id,
+        Plane primary,
+        std::vector<std::pair<uint32_t, uint64_t>> primary_formats,
+        std::vector<Plane> overlays);
+
+    void show(
+        drmModeAtomicReq* request,
+        Plane const& plane,
+        uint32_t fb,
+        geometry::RectangleF const& source,
+        geometry::Rectangle const& destination) const;
+    void hide(drmModeAtomicReq* request, Plane const& plane) const;
+
+    uint32_t const crtc_id;
+    Plane const primary;
+    std::vector<std::pair<uint32_t, uint64_t>> const primary_formats_;
+    /// Bottom to top
+    std::vector<Plane> const overlays;
+    size_t active_overlays{0};
+};
+}
+}
+}
+
+#endif /* MIR_GRAPHICS_GBM_KMS_PLANES_H_ */
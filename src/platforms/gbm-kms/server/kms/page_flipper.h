@@ -19,6 +19,7 @@
 
 #include "mir/graphics/frame.h"
 #include <cstdint>
+#include <xf86drmMode.h>
 
 namespace mir
 {
@@ -33,6 +34,8 @@ public:
     virtual ~PageFlipper() {}
 
     virtual bool schedule_flip(uint32_t crtc_id, uint32_t fb_id, uint32_t connector_id) = 0;
+    /// Commit an atomic request updating the planes of crtc_id, to complete like a page flip
+    virtual bool schedule_atomic_flip(uint32_t crtc_id, drmModeAtomicReq* request, uint32_t connector_id) = 0;
     virtual Frame wait_for_flip(uint32_t crtc_id) = 0;
 
 protected:
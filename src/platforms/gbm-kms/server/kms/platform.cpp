@@ -35,6 +35,8 @@
 #include <boost/throw_exception.hpp>
 #include <drm_fourcc.h>
 #include <gbm.h>
+#include <xf86drm.h>
+#include <cstring>
 #include <system_error>
 
 #define MIR_LOG_COMPONENT "platform-graphics-gbm-kms"
@@ -387,6 +389,29 @@ mgg::RenderingPlatform::RenderingPlatform(
 {
 }
 
+namespace
+{
+/// The device's fd, if its syncobjs can back the explicit synchronisation of dma-buf client buffers
+auto maybe_explicit_sync_device(gbm_device* gbm, bool supports_dmabuf) -> std::optional<mir::Fd>
+{
+    uint64_t timeline_syncobjs{0};
+    auto const drm_fd = gbm_device_get_fd(gbm);
+    if (!supports_dmabuf || drmGetCap(drm_fd, DRM_CAP_SYNCOBJ_TIMELINE, &timeline_syncobjs) != 0 || !timeline_syncobjs)
+    {
+        return std::nullopt;
+    }
+
+    // The allocator may outlive the gbm_device, so take a reference of our own
+    auto const fd = fcntl(drm_fd, F_DUPFD_CLOEXEC, 0);
+    if (fd < 0)
+    {
+        mir::log_warning("Failed to dup DRM fd for explicit synchronisation: %s", strerror(errno));
+        return std::nullopt;
+    }
+    return mir::Fd{fd};
+}
+}
+
 mgg::RenderingPlatform::RenderingPlatform(
     std::variant<std::shared_ptr<mg::GBMDisplayProvider>, std::shared_ptr<gbm_device>> hw)
     : device{std::visit(gbm_device_from_hw{}, hw)},
@@ -405,7 +430,8 @@ mir::UniqueModulePtr<mg::GraphicBufferAllocator> mgg::RenderingPlatform::create_
     return make_module_ptr<mgg::BufferAllocator>(
         std::make_unique<SurfacelessEGLContext>(share_ctx->egl_display(), static_cast<EGLContext>(*share_ctx)),
         egl_delegate,
-        dmabuf_provider);
+        dmabuf_provider,
+        maybe_explicit_sync_device(device.get(), dmabuf_provider != nullptr));
 }
 
 auto mgg::RenderingPlatform::maybe_create_provider(
@@ -92,7 +92,8 @@ void add_graphics_platform_options(boost::program_options::options_description&
     config.add_options()
         (bypass_option_name,
          boost::program_options::value<bool>()->default_value(false),
-         "[platform-specific] utilize the bypass optimization for fullscreen surfaces.");
+         "[platform-specific] utilize the bypass optimization for fullscreen surfaces. "
+         "Variable refresh rate outputs only follow fullscreen clients that are bypassed, so need this.");
     mgg::Quirks::add_quirks_option(config);
 }
 
@@ -49,14 +49,30 @@ bool kms_modes_are_equal(drmModeModeInfo const& info1, drmModeModeInfo const& in
             info1.vsync_end == info2.vsync_end &&
             info1.vtotal == info2.vtotal);
 }
+
+bool connector_is_vrr_capable(int drm_fd, mgk::DRMModeConnectorUPtr const& connector)
+{
+    try
+    {
+        mgk::ObjectProperties const props{drm_fd, connector};
+        return props.has_property("vrr_capable") && props["vrr_capable"];
+    }
+    catch (std::exception const& error)
+    {
+        mir::log_debug("Failed to query vrr_capable on connector %u: %s", connector->connector_id, error.what());
+        return false;
+    }
+}
 }
 
 mgg::RealKMSOutput::RealKMSOutput(
     int drm_fd,
     kms::DRMModeConnectorUPtr&& connector,
-    std::shared_ptr<PageFlipper> const& page_flipper)
+    std::shared_ptr<PageFlipper> const& page_flipper,
+    bool atomic_modesetting)
     : drm_fd_{drm_fd},
       page_flipper{page_flipper},
+      atomic_modesetting{atomic_modesetting},
       connector{std::move(connector)},
       mode_index{0},
       current_crtc(),
@@ -81,6 +97,7 @@ mgg::RealKMSOutput::RealKMSOutput(
 
 mgg::RealKMSOutput::~RealKMSOutput()
 {
+    disable_overlays();
     restore_saved_crtc();
 }
 
@@ -117,8 +134,11 @@ void mgg::RealKMSOutput::reset()
         }
     }
 
+    vrr_capable_ = connector_is_vrr_capable(drm_fd_, connector);
+
     /* Discard previously current crtc */
     current_crtc = nullptr;
+    vrr_enabled = false;
 }
 
 geom::Size mgg::RealKMSOutput::size() const
@@ -140,6 +160,53 @@ int mgg::RealKMSOutput::max_refresh_rate() const
     return current_mode.vrefresh;
 }
 
+bool mgg::RealKMSOutput::vrr_capable() const
+{
+    return vrr_capable_;
+}
+
+bool mgg::RealKMSOutput::set_vrr_enabled(bool enabled)
+{
+    if (enabled == vrr_enabled)
+        return true;
+    if (!vrr_capable_ || !current_crtc)
+        return false;
+
+    try
+    {
+        mgk::ObjectProperties const crtc_props{drm_fd_, current_crtc};
+        if (!crtc_props.has_property("VRR_ENABLED"))
+        {
+            return false;
+        }
+
+        auto const ret = drmModeObjectSetProperty(
+            drm_fd_,
+            current_crtc->crtc_id,
+            DRM_MODE_OBJECT_CRTC,
+            crtc_props.id_for("VRR_ENABLED"),
+            enabled);
+        if (ret)
+        {
+            mir::log_warning(
+                "Failed to %s variable refresh rate on output %s: %s (%i)",
+                enabled ? "enable" : "disable",
+                mgk::connector_name(connector).c_str(),
+                strerror(-ret),
+                -ret);
+            return false;
+        }
+    }
+    catch (std::exception const& error)
+    {
+        mir::log_warning("Failed to query CRTC properties for variable refresh rate: %s", error.what());
+        return false;
+    }
+
+    vrr_enabled = enabled;
+    return true;
+}
+
 void mgg::RealKMSOutput::configure(geom::Displacement offset, size_t kms_mode_index)
 {
     fb_offset = offset;
@@ -155,6 +222,9 @@ bool mgg::RealKMSOutput::set_crtc(FBHandle const& fb)
         return false;
     }
 
+    // Setting the CRTC only replaces the primary plane; anything on the overlays would linger
+    disable_overlays();
+
     auto ret = drmModeSetCrtc(drm_fd_, current_crtc->crtc_id,
                               fb, fb_offset.dx.as_int(), fb_offset.dy.as_int(),
                               &connector->connector_id, 1,
@@ -198,6 +268,11 @@ void mgg::RealKMSOutput::clear_crtc()
         return;
     }
 
+    // The CRTC can't be switched off while overlay planes are still showing on it
+    disable_overlays();
+    // ...and whatever drives it next shouldn't inherit our refresh rate policy
+    set_vrr_enabled(false);
+
     auto result = drmModeSetCrtc(drm_fd_, current_crtc->crtc_id,
                                  0, 0, 0, nullptr, 0, nullptr);
     if (result)
@@ -237,23 +312,87 @@ bool mgg::RealKMSOutput::schedule_page_flip(FBHandle const& fb)
                        mgk::connector_name(connector).c_str());
         return false;
     }
+    if (planes_ && planes_->in_use() && planes_crtc_id == current_crtc->crtc_id)
+    {
+        // A legacy page flip would leave the overlays showing their last layers
+        return schedule_atomic_flip(*planes_, fb, {});
+    }
     return page_flipper->schedule_flip(
         current_crtc->crtc_id,
         fb,
         connector->connector_id);
 }
 
-void mgg::RealKMSOutput::wait_for_page_flip()
+auto mgg::RealKMSOutput::fit_layers(FBHandle const& fb, std::vector<PlaneLayer> const& layers) -> size_t
+{
+    auto const planes = this->planes();
+    if (!planes)
+    {
+        return 0;
+    }
+
+    // Try the most layers first, leaving the lowest of them to be composited if need be
+    for (auto count = std::min(layers.size(), planes->overlay_count()); count > 0; --count)
+    {
+        auto const request = planes->request_for(fb, primary_source(), layers, count);
+        if (drmModeAtomicCommit(drm_fd_, request.get(), DRM_MODE_ATOMIC_TEST_ONLY, nullptr) == 0)
+        {
+            return count;
+        }
+    }
+    return 0;
+}
+
+bool mgg::RealKMSOutput::schedule_page_flip(FBHandle const& fb, std::vector<PlaneLayer> const& layers)
 {
     std::unique_lock lg(power_mutex);
     if (power_mode != mir_power_mode_on)
-        return;
+        return true;
+    if (!current_crtc)
+    {
+        mir::log_error("Output %s has no associated CRTC to schedule page flips on",
+                       mgk::connector_name(connector).c_str());
+        return false;
+    }
+    auto const planes = this->planes();
+    if (!planes)
+    {
+        if (!layers.empty())
+        {
+            mir::log_error("Output %s has no overlay planes to show layers on",
+                           mgk::connector_name(connector).c_str());
+            return false;
+        }
+        return page_flipper->schedule_flip(current_crtc->crtc_id, fb, connector->connector_id);
+    }
+    return schedule_atomic_flip(*planes, fb, layers);
+}
+
+bool mgg::RealKMSOutput::schedule_atomic_flip(
+    KMSPlanes& planes,
+    FBHandle const& fb,
+    std::vector<PlaneLayer> const& layers)
+{
+    auto const request = planes.request_for(fb, primary_source(), layers, layers.size());
+    if (!page_flipper->schedule_atomic_flip(current_crtc->crtc_id, request.get(), connector->connector_id))
+    {
+        return false;
+    }
+    planes.committed(layers.size());
+    return true;
+}
+
+auto mgg::RealKMSOutput::wait_for_page_flip() -> std::optional<Frame>
+{
+    std::unique_lock lg(power_mutex);
+    if (power_mode != mir_power_mode_on)
+        return std::nullopt;
     if (!current_crtc)
     {
         fatal_error("Output %s has no associated CRTC to wait on",
                    mgk::connector_name(connector).c_str());
     }
-    page_flipper->wait_for_flip(current_crtc->crtc_id);
+    return page_flipper->wait_for_flip(current_crtc->crtc_id);
 }
 
 bool mgg::RealKMSOutput::set_cursor(gbm_bo* buffer)
@@ -331,6 +470,47 @@ bool mgg::RealKMSOutput::ensure_crtc()
     return (current_crtc != nullptr);
 }
 
+auto mgg::RealKMSOutput::scanout_formats() -> std::vector<std::pair<uint32_t, uint64_t>>
+{
+    if (auto const planes = this->planes())
+    {
+        return planes->primary_formats();
+    }
+    return {};
+}
+
+auto mgg::RealKMSOutput::planes() -> KMSPlanes*
+{
+    if (!current_crtc || !atomic_modesetting)
+        return nullptr;
+
+    if (planes_crtc_id != current_crtc->crtc_id)
+    {
+        disable_overlays();
+        planes_ = KMSPlanes::create_if_supported(drm_fd_, current_crtc->crtc_id);
+        planes_crtc_id = current_crtc->crtc_id;
+    }
+    return planes_.get();
+}
+
+auto mgg::RealKMSOutput::primary_source() const -> geom::Rectangle
+{
+    return {{fb_offset.dx.as_int(), fb_offset.dy.as_int()}, size()};
+}
+
+void mgg::RealKMSOutput::disable_overlays()
+{
+    if (planes_ && planes_->in_use())
+    {
+        auto const request = planes_->request_disabling_overlays();
+        if (auto const result = drmModeAtomicCommit(drm_fd_, request.get(), 0, nullptr))
+        {
+            mir::log_warning("Failed to disable overlay planes: %s", strerror(-result));
+        }
+        planes_->committed(0);
+    }
+}
+
 void mgg::RealKMSOutput::restore_saved_crtc()
 {
     if (!using_saved_crtc)
@@ -398,7 +578,9 @@ void mgg::RealKMSOutput::set_gamma(mg::GammaCurves const& gamma)
 void mgg::RealKMSOutput::refresh_hardware_state()
 {
     connector = kms::get_connector(drm_fd_, connector->connector_id);
+    vrr_capable_ = connector_is_vrr_capable(drm_fd_, connector);
     current_crtc = nullptr;
+    vrr_enabled = false;
 
     if (connector->encoder_id)
     {
@@ -606,6 +788,7 @@ void mgg::RealKMSOutput::update_from_hardware_state(
     output.subpixel_arrangement = kms_subpixel_to_mir_subpixel(connector->subpixel);
     output.gamma = gamma;
     output.edid = edid;
+    output.vrr_capable = vrr_capable_;
 }
 
 int mgg::RealKMSOutput::drm_fd() const
@@ -22,6 +22,7 @@
 
 #include <memory>
 #include <mutex>
+#include <optional>
 
 namespace mir
 {
@@ -38,7 +39,8 @@ public:
     RealKMSOutput(
         int drm_fd,
         kms::DRMModeConnectorUPtr&& connector,
-        std::shared_ptr<PageFlipper> const& page_flipper);
+        std::shared_ptr<PageFlipper> const& page_flipper,
+        bool atomic_modesetting);
     ~RealKMSOutput();
 
     uint32_t id() const override;
@@ -47,12 +49,18 @@ public:
     void configure(geometry::Displacement fb_offset, size_t kms_mode_index) override;
     geometry::Size size() const override;
     int max_refresh_rate() const override;
+    bool vrr_capable() const override;
+    bool set_vrr_enabled(bool enabled) override;
 
     bool set_crtc(FBHandle const& fb) override;
     bool has_crtc_mismatch() override;
     void clear_crtc() override;
     bool schedule_page_flip(FBHandle const& fb) override;
-    void wait_for_page_flip() override;
+    auto wait_for_page_flip() -> std::optional<Frame> override;
+
+    auto fit_layers(FBHandle const& fb, std::vector<PlaneLayer> const& layers) -> size_t override;
+    bool schedule_page_flip(FBHandle const& fb, std::vector<PlaneLayer> const& layers) override;
+    auto scanout_formats() -> std::vector<std::pair<uint32_t, uint64_t>> override;
 
     bool set_cursor(gbm_bo* buffer) override;
     void move_cursor(geometry::Point destination) override;
@@ -70,9 +78,16 @@ public:
 private:
     bool ensure_crtc();
     void restore_saved_crtc();
+    /// The planes of the current CRTC, or nullptr if they can't be driven
+    auto planes() -> KMSPlanes*;
+    auto primary_source() const -> geometry::Rectangle;
+    bool schedule_atomic_flip(KMSPlanes& planes, FBHandle const& fb, std::vector<PlaneLayer> const& layers);
+    void disable_overlays();
 
     int const drm_fd_;
     std::shared_ptr<PageFlipper> const page_flipper;
+    /// Whether drm_fd_ has atomic modesetting enabled, without which there are no planes to use
+    bool const atomic_modesetting;
 
     kms::DRMModeConnectorUPtr connector;
     size_t mode_index;
@@ -82,6 +97,12 @@ private:
     bool using_saved_crtc;
     bool has_cursor_;
 
+    std::unique_ptr<KMSPlanes> planes_;
+    std::optional<uint32_t> planes_crtc_id; ///< The CRTC planes_ were probed for
+
+    bool vrr_capable_{false};
+    bool vrr_enabled{false};
+
     MirPowerMode power_mode;
     int dpms_enum_id;
 
@@ -23,9 +23,11 @@ namespace mgg = mir::graphics::gbm;
 
 mgg::RealKMSOutputContainer::RealKMSOutputContainer(
     mir::Fd drm_fd,
-    std::shared_ptr<PageFlipper> page_flipper)
+    std::shared_ptr<PageFlipper> page_flipper,
+    bool atomic_modesetting)
     : drm_fd{std::move(drm_fd)},
-      page_flipper{std::move(page_flipper)}
+      page_flipper{std::move(page_flipper)},
+      atomic_modesetting{atomic_modesetting}
 {
 }
 
@@ -69,7 +71,8 @@ void mgg::RealKMSOutputContainer::update_from_hardware_state()
             new_outputs.push_back(std::make_shared<RealKMSOutput>(
                 drm_fd,
                 std::move(connector),
-                page_flipper));
+                page_flipper,
+                atomic_modesetting));
         }
     }
 
@@ -35,7 +35,8 @@ class RealKMSOutputContainer : public KMSOutputContainer
 public:
     RealKMSOutputContainer(
         mir::Fd drm_fd,
-        std::shared_ptr<PageFlipper> page_flipper);
+        std::shared_ptr<PageFlipper> page_flipper,
+        bool atomic_modesetting);
 
     void for_each_output(std::function<void(std::shared_ptr<KMSOutput> const&)> functor) const override;
 
@@ -44,6 +45,7 @@ private:
     mir::Fd const drm_fd;
     std::vector<std::shared_ptr<KMSOutput>> outputs;
     std::shared_ptr<PageFlipper> const page_flipper;
+    bool const atomic_modesetting;
 };
 
 }
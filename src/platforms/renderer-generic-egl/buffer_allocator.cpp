@@ -238,7 +238,8 @@ void mge::BufferAllocator::bind_display(wl_display* display, std::shared_ptr<Exe
                 std::unique_ptr<LinuxDmaBufUnstable, std::function<void(LinuxDmaBufUnstable * )>>(
                     new LinuxDmaBufUnstable{
                         display,
-                        dmabuf_provider
+                        dmabuf_provider,
+                        wayland_executor
                     },
                     [wayland_executor](LinuxDmaBufUnstable* global)
                     {
@@ -315,12 +316,16 @@ std::shared_ptr<mg::Buffer> mge::BufferAllocator::buffer_from_resource(
 
 auto mge::BufferAllocator::buffer_from_shm(
     std::shared_ptr<renderer::software::RWMappableBuffer> data,
+    std::shared_ptr<Buffer> const& previous,
+    std::optional<geom::Rectangles> const& damage,
     std::function<void()>&& on_consumed,
     std::function<void()>&& on_release) -> std::shared_ptr<Buffer>
 {
     return std::make_shared<mgc::NotifyingMappableBackedShmBuffer>(
         std::move(data),
         egl_delegate,
+        previous,
+        damage,
         std::move(on_consumed),
         std::move(on_release));
 }
@@ -443,21 +448,34 @@ auto mge::GLRenderingProvider::surface_for_sink(
         config);
 }
 
-auto mge::GLRenderingProvider::make_framebuffer_provider(DisplaySink& /*sink*/)
+auto mge::GLRenderingProvider::make_framebuffer_provider(DisplaySink& sink)
     -> std::unique_ptr<FramebufferProvider>
 {
-    // TODO: Work out under what circumstances the EGL renderer *can* provide overlayable framebuffers
-    class NullFramebufferProvider : public FramebufferProvider
+    // Where the display can import client dma-bufs they can be shown without us
+    class DmaBufFramebufferProvider : public FramebufferProvider
     {
     public:
-        auto buffer_to_framebuffer(std::shared_ptr<Buffer>) -> std::unique_ptr<Framebuffer> override
+        explicit DmaBufFramebufferProvider(DmaBufDisplayAllocator* importer)
+            : importer{importer}
+        {
+        }
+
+        auto buffer_to_framebuffer(std::shared_ptr<Buffer> buffer) -> std::unique_ptr<Framebuffer> override
         {
             // It is safe to return nullptr; this will be treated as “this buffer cannot be used as
             // a framebuffer”.
-            return {};
+            if (!importer)
+            {
+                return {};
+            }
+            return importer->framebuffer_for(std::move(buffer));
         }
+
+    private:
+        /// Owned by the sink, which outlives us
+        DmaBufDisplayAllocator* const importer;
     };
-    return std::make_unique<NullFramebufferProvider>();
+    return std::make_unique<DmaBufFramebufferProvider>(sink.acquire_compatible_allocator<DmaBufDisplayAllocator>());
 }
 
 mge::GLRenderingProvider::GLRenderingProvider(
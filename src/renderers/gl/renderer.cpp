@@ -36,8 +36,10 @@
 #include <EGL/egl.h>
 
 #include <boost/throw_exception.hpp>
+#include <algorithm>
 #include <stdexcept>
 #include <cmath>
+#include <deque>
 #include <sstream>
 #include <mutex>
 
@@ -252,6 +254,332 @@ private:
     std::mutex compilation_mutex;
 };
 
+namespace
+{
+/// The part of the screen a renderable covers, ignoring any transformation
+auto visible_area_of(mg::Renderable const& renderable) -> geom::Rectangle
+{
+    auto const position = renderable.screen_position();
+    if (auto const clip_area = renderable.clip_area())
+    {
+        return intersection_of(position, clip_area.value());
+    }
+    return position;
+}
+
+/// Beyond this, splitting a renderable up costs more than blending it
+size_t const max_opaque_rectangles{16};
+
+/// The pieces of \a pieces that don't overlap \a hole
+auto subtract(std::vector<geom::Rectangle> const& pieces, geom::Rectangle const& hole)
+    -> std::vector<geom::Rectangle>
+{
+    std::vector<geom::Rectangle> result;
+    for (auto const& piece : pieces)
+    {
+        auto const overlap = intersection_of(piece, hole);
+        if (overlap == geom::Rectangle{})
+        {
+            result.push_back(piece);
+            continue;
+        }
+
+        auto const add = [&result](geom::X left, geom::Y top, geom::X right, geom::Y bottom)
+            {
+                if (left < right && top < bottom)
+                {
+                    result.push_back({{left, top}, {as_width(right - left), as_height(bottom - top)}});
+                }
+            };
+
+        add(piece.left(), piece.top(), piece.right(), overlap.top());
+        add(piece.left(), overlap.bottom(), piece.right(), piece.bottom());
+        add(piece.left(), overlap.top(), overlap.left(), overlap.bottom());
+        add(overlap.right(), overlap.top(), piece.right(), overlap.bottom());
+    }
+    return result;
+}
+
+/// The part of the rectangular primitive \a whole that covers \a part, with texture coordinates to match
+auto sub_primitive(mgl::Primitive const& whole, geom::Rectangle const& part) -> mgl::Primitive
+{
+    auto const& top_left = whole.vertices[0];
+    auto const& bottom_right = whole.vertices[3];
+
+    auto const vertex = [&](geom::X x, geom::Y y) -> mgl::Vertex
+        {
+            auto const fx = (x.as_int() - top_left.position[0]) / (bottom_right.position[0] - top_left.position[0]);
+            auto const fy = (y.as_int() - top_left.position[1]) / (bottom_right.position[1] - top_left.position[1]);
+            return {
+                {GLfloat(x.as_int()), GLfloat(y.as_int()), 0.0f},
+                {top_left.texcoord[0] + fx * (bottom_right.texcoord[0] - top_left.texcoord[0]),
+                 top_left.texcoord[1] + fy * (bottom_right.texcoord[1] - top_left.texcoord[1])}};
+        };
+
+    mgl::Primitive result;
+    result.type = GL_TRIANGLE_STRIP;
+    result.vertices[0] = vertex(part.left(), part.top());
+    result.vertices[1] = vertex(part.left(), part.bottom());
+    result.vertices[2] = vertex(part.right(), part.top());
+    result.vertices[3] = vertex(part.right(), part.bottom());
+    return result;
+}
+
+/**
+ * Replaces the single rectangle covering \a renderable with separate rectangles for its
+ * opaque region and the rest of it, so the opaque part can be drawn without blending.
+ *
+ * \returns the number of (leading) primitives that are opaque
+ */
+auto split_out_opaque_region(std::vector<mgl::Primitive>& primitives, mg::Renderable const& renderable) -> size_t
+{
+    // We only know how to split up the default tessellation
+    if (primitives.size() != 1 || primitives[0].type != GL_TRIANGLE_STRIP || primitives[0].nvertices != 4)
+    {
+        return 0;
+    }
+
+    auto const opaque_region = renderable.opaque_region();
+    if (opaque_region.size() == 0 || opaque_region.size() > max_opaque_rectangles)
+    {
+        return 0;
+    }
+
+    auto const position = renderable.screen_position();
+    std::vector<geom::Rectangle> opaque;
+    std::vector<geom::Rectangle> translucent{position};
+    for (auto const& rect : opaque_region)
+    {
+        auto const clipped = intersection_of(rect, position);
+        if (clipped != geom::Rectangle{})
+        {
+            opaque.push_back(clipped);
+            translucent = subtract(translucent, clipped);
+        }
+    }
+
+    if (opaque.empty())
+    {
+        return 0;
+    }
+
+    auto const whole = primitives[0];
+    primitives.clear();
+    for (auto const& rect : opaque)
+    {
+        primitives.push_back(sub_primitive(whole, rect));
+    }
+    for (auto const& rect : translucent)
+    {
+        primitives.push_back(sub_primitive(whole, rect));
+    }
+    return opaque.size();
+}
+}
+
+/*
+ * Works out which parts of the output have changed since each of the last
+ * few frames, from the damage the renderables report and from how the
+ * renderables themselves have moved, appeared or disappeared.
+ */
+class mrg::Renderer::DamageTracker
+{
+public:
+    /**
+     * Account for a new frame and calculate the area of the output that needs
+     * repainting.
+     *
+     * \param [in] buffer_age   The age of the buffer about to be rendered to,
+     *                          in the sense of EGL_EXT_buffer_age.
+     * \returns                 The area to repaint, or std::nullopt if the whole
+     *                          output needs repainting.
+     */
+    auto repaint_area(
+        mg::RenderableList const& renderables,
+        geom::Rectangle const& viewport,
+        unsigned buffer_age) -> std::optional<geom::Rectangles>
+    {
+        auto const damage = frame_damage(renderables, viewport);
+
+        history.push_front(damage.value_or(geom::Rectangles{viewport}));
+        if (history.size() > max_tracked_frames)
+        {
+            history.pop_back();
+        }
+
+        // The buffer still holds the frame from buffer_age frames ago, so
+        // everything that has changed since then needs repainting. We also need
+        // to have rendered that frame ourselves to know what is in it.
+        if (!damage || buffer_age == 0 || buffer_age >= history.size())
+        {
+            return std::nullopt;
+        }
+
+        geom::Rectangles area;
+        for (auto i = 0u; i != buffer_age; ++i)
+        {
+            for (auto const& rect : history[i])
+            {
+                area.add(rect);
+            }
+        }
+
+        // Each rectangle costs a clear and a pass over the renderables; past a
+        // handful it's cheaper to repaint the bounding box.
+        if (area.size() > max_repaint_rectangles)
+        {
+            return geom::Rectangles{area.bounding_rectangle()};
+        }
+        return area;
+    }
+
+    /// Forget everything; the next frame will be fully repainted
+    void reset()
+    {
+        last_frame.clear();
+        history.clear();
+    }
+
+private:
+    static size_t const max_tracked_frames = 5;
+    static size_t const max_repaint_rectangles = 8;
+
+    struct RenderableState
+    {
+        mg::Renderable::ID id;
+        mg::BufferID buffer;
+        geom::Rectangle position;
+        std::optional<geom::Rectangle> clip_area;
+        float alpha;
+        glm::mat4 transformation;
+
+        auto appearance_matches(RenderableState const& other) const -> bool
+        {
+            return position == other.position &&
+                   clip_area == other.clip_area &&
+                   alpha == other.alpha &&
+                   transformation == other.transformation;
+        }
+
+        auto visible_area() const -> geom::Rectangle
+        {
+            return clip_area ? intersection_of(position, clip_area.value()) : position;
+        }
+    };
+
+    /// The area changed since the last frame, or std::nullopt if we can't tell
+    auto frame_damage(mg::RenderableList const& renderables, geom::Rectangle const& viewport)
+        -> std::optional<geom::Rectangles>
+    {
+        std::vector<RenderableState> this_frame;
+        this_frame.reserve(renderables.size());
+        std::vector<bool> still_present(last_frame.size(), false);
+        bool can_track{true};
+        size_t next_in_stacking_order{0};
+        geom::Rectangles damage;
+
+        auto const add_damage =
+            [&damage, &viewport](geom::Rectangle const& rect)
+            {
+                auto const on_output = intersection_of(rect, viewport);
+                if (on_output.size != geom::Size{})
+                {
+                    damage.add(on_output);
+                }
+            };
+
+        for (auto const& renderable : renderables)
+        {
+            auto const& state = this_frame.emplace_back(
+                RenderableState{
+                    renderable->id(),
+                    renderable->buffer()->id(),
+                    renderable->screen_position(),
+                    renderable->clip_area(),
+                    renderable->alpha(),
+                    renderable->transformation()});
+
+            if (!can_track)
+            {
+                continue;
+            }
+
+            if (state.transformation != glm::mat4{1})
+            {
+                // We'd need to project the renderable to know where it lands
+                can_track = false;
+                continue;
+            }
+
+            auto const previous = std::find_if(
+                last_frame.begin(), last_frame.end(),
+                [&state](auto const& candidate) { return candidate.id == state.id; });
+
+            if (previous == last_frame.end())
+            {
+                add_damage(state.visible_area());
+                continue;
+            }
+
+            auto const previous_index = static_cast<size_t>(previous - last_frame.begin());
+            if (previous_index < next_in_stacking_order)
+            {
+                // Restacked; whatever this now covers or uncovers needs blending again
+                can_track = false;
+                continue;
+            }
+            next_in_stacking_order = previous_index + 1;
+            still_present[previous_index] = true;
+
+            if (!state.appearance_matches(*previous))
+            {
+                add_damage(previous->visible_area());
+                add_damage(state.visible_area());
+                continue;
+            }
+
+            auto renderable_damage = renderable->damage();
+            if (renderable_damage && renderable_damage->size() == 0 && state.buffer != previous->buffer)
+            {
+                // The content has changed under us without reporting damage
+                renderable_damage = std::nullopt;
+            }
+
+            if (renderable_damage)
+            {
+                for (auto const& rect : renderable_damage.value())
+                {
+                    add_damage(intersection_of(rect, state.visible_area()));
+                }
+            }
+            else
+            {
+                add_damage(state.visible_area());
+            }
+        }
+
+        for (auto i = 0u; i != last_frame.size(); ++i)
+        {
+            if (!still_present[i])
+            {
+                add_damage(last_frame[i].visible_area());
+            }
+        }
+
+        last_frame = std::move(this_frame);
+
+        if (!can_track)
+        {
+            return std::nullopt;
+        }
+        return damage;
+    }
+
+    std::vector<RenderableState> last_frame;
+    /// The damage of each of the most recent frames, newest first
+    std::deque<geom::Rectangles> history;
+};
+
 mrg::Renderer::Program::Program(GLuint program_id)
 {
     id = program_id;
@@ -287,6 +615,7 @@ mrg::Renderer::Renderer(
     : output_surface{make_output_current(std::move(output))},
       clear_color{0.0f, 0.0f, 0.0f, 1.0f},
       program_factory{std::make_unique<ProgramFactory>()},
+      damage_tracker{std::make_unique<DamageTracker>()},
       display_transform(1),
       gl_interface{std::move(gl_interface)}
 {
@@ -356,14 +685,54 @@ auto mrg::Renderer::render(mg::RenderableList const& renderables) const -> std::
     output_surface->make_current();
     output_surface->bind();
 
+    std::optional<geom::Rectangles> partial_repaint;
+    if (auto const buffer_age = output_surface->buffer_age(); buffer_age && can_repaint_partially())
+    {
+        partial_repaint = damage_tracker->repaint_area(renderables, viewport, buffer_age.value());
+    }
+    else
+    {
+        damage_tracker->reset();
+    }
+
     glClearColor(clear_color[0], clear_color[1], clear_color[2], clear_color[3]);
     glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
-    glClear(GL_COLOR_BUFFER_BIT);
 
     ++frameno;
-    for (auto const& r : renderables)
+    if (!partial_repaint)
     {
-        draw(*r);
+        glClear(GL_COLOR_BUFFER_BIT);
+        for (auto const& r : renderables)
+        {
+            draw(*r);
+        }
+    }
+    else
+    {
+        // The rest of the buffer already holds what we want, so only touch the damaged areas
+        glEnable(GL_SCISSOR_TEST);
+        for (auto const& area : partial_repaint.value())
+        {
+            repaint_area = area;
+            scissor_to(area);
+            glClear(GL_COLOR_BUFFER_BIT);
+            for (auto const& r : renderables)
+            {
+                if (visible_area_of(*r).overlaps(area))
+                {
+                    draw(*r);
+                }
+            }
+        }
+        repaint_area.reset();
+        glDisable(GL_SCISSOR_TEST);
+
+        geom::Rectangles surface_damage;
+        for (auto const& area : partial_repaint.value())
+        {
+            surface_damage.add(surface_area_of(area));
+        }
+        output_surface->set_damage_hint(surface_damage);
     }
 
     auto output = output_surface->commit();
@@ -379,7 +748,11 @@ void mrg::Renderer::draw(mg::Renderable const& renderable) const
 {
     auto const texture = gl_interface->as_texture(renderable.buffer());
     auto const clip_area = renderable.clip_area();
-    if (clip_area)
+    if (clip_area && repaint_area)
+    {
+        scissor_to(intersection_of(clip_area.value(), repaint_area.value()));
+    }
+    else if (clip_area)
     {
         glEnable(GL_SCISSOR_TEST);
         auto clip_x = clip_area.value().top_left.x.as_int();
@@ -464,6 +837,13 @@ void mrg::Renderer::draw(mg::Renderable const& renderable) const
     primitives.clear();
     tessellate(primitives, renderable);
 
+    // These renderable method names could be better (see LP: #1236224)
+    auto const shaped = renderable.shaped();
+
+    // A client can tell us that parts of an RGBA surface are opaque anyway
+    auto const opaque_primitives =
+        shaped && renderable.alpha() == 1.0f ? split_out_opaque_region(primitives, renderable) : 0;
+
     // if we fail to load the texture, we need to carry on (part of lp:1629275)
     try
     {
@@ -473,17 +853,17 @@ void mrg::Renderer::draw(mg::Renderable const& renderable) const
         } BlendSeparate;
 
         BlendSeparate client_blend;
+        BlendSeparate const opaque_blend{GL_ONE,  GL_ZERO,
+                                         GL_ZERO, GL_ONE};
 
-        // These renderable method names could be better (see LP: #1236224)
-        if (renderable.shaped())  // Client is RGBA:
+        if (shaped)  // Client is RGBA:
         {
             client_blend = {GL_ONE, GL_ONE_MINUS_SRC_ALPHA,
                             GL_ONE, GL_ONE_MINUS_SRC_ALPHA};
         }
         else if (renderable.alpha() == 1.0f)  // RGBX and no window translucency:
         {
-            client_blend = {GL_ONE,  GL_ZERO,
-                            GL_ZERO, GL_ONE};  // Avoid using src_alpha!
+            client_blend = opaque_blend;  // Avoid using src_alpha!
         }
         else
         {   // Client is RGBX but we also have window translucency.
@@ -494,11 +874,12 @@ void mrg::Renderer::draw(mg::Renderable const& renderable) const
             glBlendColor(0.0f, 0.0f, 0.0f, renderable.alpha());
         }
 
-        for (auto const& p : primitives)
+        for (auto i = 0u; i < primitives.size(); ++i)
         {
+            auto const& p = primitives[i];
             BlendSeparate blend;
 
-            blend = client_blend;
+            blend = i < opaque_primitives ? opaque_blend : client_blend;
             texture->bind();
 
             glVertexAttribPointer(prog->position_attr, 3, GL_FLOAT,
@@ -532,12 +913,43 @@ void mrg::Renderer::draw(mg::Renderable const& renderable) const
 
     glDisableVertexAttribArray(prog->texcoord_attr);
     glDisableVertexAttribArray(prog->position_attr);
-    if (renderable.clip_area())
+    if (clip_area && repaint_area)
+    {
+        scissor_to(repaint_area.value());
+    }
+    else if (clip_area)
     {
         glDisable(GL_SCISSOR_TEST);
     }
 }
 
+void mrg::Renderer::scissor_to(geom::Rectangle const& area) const
+{
+    auto const on_surface = surface_area_of(area);
+    glScissor(
+        on_surface.top_left.x.as_int(), on_surface.top_left.y.as_int(),
+        on_surface.size.width.as_int(), on_surface.size.height.as_int());
+}
+
+auto mrg::Renderer::surface_area_of(geom::Rectangle const& area) const -> geom::Rectangle
+{
+    // Only valid when the output is the same size as the viewport; see can_repaint_partially()
+    auto const x = area.top_left.x.as_int() - viewport.top_left.x.as_int();
+    auto const y_from_top = area.top_left.y.as_int() - viewport.top_left.y.as_int();
+    auto const y =
+        output_surface->layout() == graphics::gl::OutputSurface::Layout::GL ?
+            viewport.size.height.as_int() - y_from_top - area.size.height.as_int() :
+            y_from_top;
+
+    return {{x, y}, area.size};
+}
+
+auto mrg::Renderer::can_repaint_partially() const -> bool
+{
+    // Otherwise screen coordinates don't map straightforwardly onto output pixels
+    return output_transform_is_identity && output_surface->size() == viewport.size;
+}
+
 void mrg::Renderer::set_viewport(geometry::Rectangle const& rect)
 {
     if (rect == viewport)
@@ -578,6 +990,7 @@ void mrg::Renderer::set_viewport(geometry::Rectangle const& rect)
                       0.0f});
 
     viewport = rect;
+    damage_tracker->reset();
     update_gl_viewport();
 }
 
@@ -635,14 +1048,19 @@ void mrg::Renderer::set_output_transform(glm::mat2 const& t)
         break;
     }
 
+    output_transform_is_identity = (t == glm::mat2{1});
+
     if (new_display_transform != display_transform)
     {
         display_transform = new_display_transform;
+        damage_tracker->reset();
         update_gl_viewport();
     }
 }
 
 void mrg::Renderer::suspend()
 {
+    // Whatever is displayed in the meantime isn't tracked, so start afresh
+    damage_tracker->reset();
     output_surface->release_current();
 }
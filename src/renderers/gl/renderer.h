@@ -19,11 +19,13 @@
 
 #include <mir/renderer/renderer.h>
 #include <mir/geometry/rectangle.h>
+#include <mir/geometry/rectangles.h>
 #include <mir/graphics/buffer_id.h>
 #include <mir/graphics/renderable.h>
 #include <mir/gl/primitive.h>
 
 #include <GLES2/gl2.h>
+#include <optional>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
@@ -101,12 +103,21 @@ protected:
 
 private:
     void update_gl_viewport();
+    void scissor_to(geometry::Rectangle const& area) const;
+    /// Where area of the viewport lands on the output surface, in GL window coordinates
+    auto surface_area_of(geometry::Rectangle const& area) const -> geometry::Rectangle;
+    auto can_repaint_partially() const -> bool;
 
     class ProgramFactory;
     std::unique_ptr<ProgramFactory> const program_factory;
+    class DamageTracker;
+    std::unique_ptr<DamageTracker> const damage_tracker;
     geometry::Rectangle viewport;
     glm::mat4 screen_to_gl_coords;
     glm::mat4 display_transform;
+    bool output_transform_is_identity{true};
+    /// The area of the output being repainted, when only part of it is
+    std::optional<geometry::Rectangle> mutable repaint_area;
     std::vector<mir::gl::Primitive> mutable primitives;
     std::shared_ptr<graphics::GLRenderingProvider> const gl_interface;
 };
@@ -22,14 +22,55 @@
 #include "mir/graphics/renderable.h"
 #include "mir/graphics/display_sink.h"
 #include "mir/graphics/buffer.h"
+#include "mir/graphics/dmabuf_buffer.h"
 #include "mir/graphics/platform.h"
 #include "mir/compositor/buffer_stream.h"
 #include "mir/renderer/renderer.h"
 #include "occlusion.h"
 
+#include <algorithm>
+
 namespace mc = mir::compositor;
 namespace mg = mir::graphics;
 
+namespace
+{
+/// The buffer of the topmost renderable, if it exactly fills the display unblended and untransformed
+auto scanout_candidate_in(mg::RenderableList const& renderables, mir::geometry::Rectangle const& view_area)
+    -> std::shared_ptr<mg::Buffer>
+{
+    if (renderables.empty())
+    {
+        return nullptr;
+    }
+
+    auto const& topmost = renderables.back();
+    if (topmost->screen_position() != view_area ||
+        topmost->alpha() != 1.0f ||
+        topmost->shaped() ||
+        topmost->transformation() != glm::mat4{1})
+    {
+        return nullptr;
+    }
+    return topmost->buffer();
+}
+
+/// Tell the buffers of the renderables in [begin, end) that the display is committed to showing them
+void claim_for_scanout(mg::RenderableList::const_iterator begin, mg::RenderableList::const_iterator end)
+{
+    for (auto renderable = begin; renderable != end; ++renderable)
+    {
+        if (auto const buffer = (*renderable)->buffer())
+        {
+            if (auto const scanout = dynamic_cast<mg::DirectScanoutBuffer*>(buffer->native_buffer_base()))
+            {
+                scanout->claim_for_scanout();
+            }
+        }
+    }
+}
+}
+
 mc::DefaultDisplayBufferCompositor::DefaultDisplayBufferCompositor(
     mg::DisplaySink& display_sink,
     graphics::GLRenderingProvider& gl_provider,
@@ -74,51 +115,84 @@ bool mc::DefaultDisplayBufferCompositor::composite(mc::SceneElementSequence&& sc
      */
     scene_elements.clear();  // Those in use are still in renderable_list
 
+    /*
+     * The framebuffers of the topmost renderables, down to the first (from the
+     * top) that the display can't scan out directly. There's no need to import
+     * any if the display couldn't show them.
+     */
     std::vector<mg::DisplayElement> framebuffers;
-    framebuffers.reserve(renderable_list.size());
+    bool const can_overlay = display_sink.can_overlay();
 
-    for (auto const& renderable : renderable_list)
+    fb_adaptor->scanout_candidate(can_overlay ? scanout_candidate_in(renderable_list, view_area) : nullptr);
+
+    if (can_overlay)
     {
-        auto fb = fb_adaptor->buffer_to_framebuffer(renderable->buffer());
-        if (!fb)
-        {
-            break;
-        }
-        geometry::Rectangle clipped_dest;
-        if (renderable->clip_area())
-        {
-            clipped_dest = intersection_of(renderable->screen_position(), *renderable->clip_area());
-        }
-        else
+        framebuffers.reserve(renderable_list.size());
+        for (auto r = renderable_list.rbegin(); r != renderable_list.rend(); ++r)
         {
-            clipped_dest = renderable->screen_position();
+            auto const& renderable = *r;
+            auto fb = fb_adaptor->buffer_to_framebuffer(renderable->buffer());
+            if (!fb)
+            {
+                // Nothing beneath this can be shown without rendering it
+                break;
+            }
+            geometry::Rectangle clipped_dest;
+            if (renderable->clip_area())
+            {
+                clipped_dest = intersection_of(renderable->screen_position(), *renderable->clip_area());
+            }
+            else
+            {
+                clipped_dest = renderable->screen_position();
+            }
+            geometry::SizeF const source_size{
+                clipped_dest.size.width.as_value(),
+                clipped_dest.size.height.as_value()};
+            geometry::PointF const source_origin{
+                clipped_dest.top_left.x.as_value() - renderable->screen_position().top_left.x.as_value(),
+                clipped_dest.top_left.y.as_value() - renderable->screen_position().top_left.y.as_value()
+            };
+
+            framebuffers.emplace_back(mg::DisplayElement{
+                renderable->screen_position(),
+                geometry::RectangleF{source_origin, source_size},
+                std::move(fb),
+                renderable->alpha(),
+                renderable->transformation()
+            });
         }
-        geometry::SizeF const source_size{
-            clipped_dest.size.width.as_value(),
-            clipped_dest.size.height.as_value()};
-        geometry::PointF const source_origin{
-            clipped_dest.top_left.x.as_value() - renderable->screen_position().top_left.x.as_value(),
-            clipped_dest.top_left.y.as_value() - renderable->screen_position().top_left.y.as_value()
-        };
-
-        framebuffers.emplace_back(mg::DisplayElement{
-            renderable->screen_position(),
-            geometry::RectangleF{source_origin, source_size},
-            std::move(fb)
-        });
+        std::reverse(framebuffers.begin(), framebuffers.end());
     }
 
     if (framebuffers.size() == renderable_list.size() && display_sink.overlay(framebuffers))
     {
+        claim_for_scanout(renderable_list.begin(), renderable_list.end());
         report->renderables_in_frame(this, renderable_list);
         renderer->suspend();
     }
     else
     {
+        /*
+         * The display may still be able to show the topmost renderables
+         * itself, leaving only those beneath to render.
+         */
+        auto overlaid = framebuffers.empty() ? 0 : display_sink.overlay_topmost(framebuffers);
+        overlaid = std::min(overlaid, framebuffers.size());
+        claim_for_scanout(renderable_list.end() - overlaid, renderable_list.end());
+
         renderer->set_output_transform(display_sink.transformation());
         renderer->set_viewport(view_area);
 
-        display_sink.set_next_image(renderer->render(renderable_list));
+        if (overlaid)
+        {
+            mg::RenderableList const beneath{renderable_list.begin(), renderable_list.end() - overlaid};
+            display_sink.set_next_image(renderer->render(beneath));
+        }
+        else
+        {
+            display_sink.set_next_image(renderer->render(renderable_list));
+        }
 
         report->renderables_in_frame(this, renderable_list);
         report->rendered_frame(this);
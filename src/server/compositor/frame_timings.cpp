@@ -0,0 +1,236 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/compositor/frame_timings.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+namespace mc = mir::compositor;
+namespace mg = mir::graphics;
+namespace mt = mir::time;
+
+using namespace std::chrono;
+
+/*
+ * Durations below sub_buckets microseconds get a bucket each. Above that, each
+ * power of two is split into sub_buckets buckets: the bucket is found from the
+ * top bits of the duration, and how far they had to be shifted down.
+ */
+void mc::LatencyHistogram::record(microseconds duration)
+{
+    std::uint64_t const longest_recordable = (std::uint64_t{2 * sub_buckets} << (max_shift - 1)) - 1;
+    auto const value = std::min<std::uint64_t>(std::max<microseconds::rep>(duration.count(), 0), longest_recordable);
+
+    auto index = static_cast<int>(std::min<std::uint64_t>(value, sub_buckets));
+    if (value >= sub_buckets)
+    {
+        int const shift = std::bit_width(value) - std::bit_width(unsigned{sub_buckets});
+        index = (shift + 1) * sub_buckets + static_cast<int>((value >> shift) - sub_buckets);
+    }
+
+    ++buckets[index];
+    ++total;
+    longest = std::max(longest, microseconds(value));
+}
+
+void mc::LatencyHistogram::clear()
+{
+    buckets.fill(0);
+    total = 0;
+    longest = microseconds{0};
+}
+
+auto mc::LatencyHistogram::count() const -> std::uint64_t
+{
+    return total;
+}
+
+auto mc::LatencyHistogram::max() const -> microseconds
+{
+    return longest;
+}
+
+auto mc::LatencyHistogram::percentile(double fraction) const -> microseconds
+{
+    if (total == 0)
+    {
+        return microseconds{0};
+    }
+
+    auto const rank = std::max<std::uint64_t>(1, std::ceil(std::clamp(fraction, 0.0, 1.0) * total));
+
+    std::uint64_t seen = 0;
+    for (int index = 0; index != bucket_count; ++index)
+    {
+        seen += buckets[index];
+        if (seen >= rank)
+        {
+            // The top of the bucket, as nothing in it is longer
+            std::uint64_t top = index;
+            if (index >= sub_buckets)
+            {
+                int const shift = index / sub_buckets - 1;
+                top = ((std::uint64_t(index % sub_buckets + sub_buckets) + 1) << shift) - 1;
+            }
+            return std::min(microseconds(top), longest);
+        }
+    }
+
+    return longest;
+}
+
+namespace
+{
+auto summary_of(mc::LatencyHistogram const& histogram) -> mc::LatencySummary
+{
+    return {
+        histogram.percentile(0.50),
+        histogram.percentile(0.90),
+        histogram.percentile(0.99),
+        histogram.max(),
+        histogram.count()};
+}
+
+auto as_microseconds(mt::Duration duration) -> microseconds
+{
+    return duration_cast<microseconds>(duration);
+}
+
+/// Presentations not yet reported for a display whose frames have stopped being presented
+std::size_t const max_awaiting_presentation = 4;
+}
+
+void mc::FrameTimings::scheduled(mt::Timestamp when)
+{
+    std::lock_guard lock{mutex};
+    for (auto& [_, display] : displays)
+    {
+        if (!display.pending_since)
+        {
+            display.pending_since = when;
+        }
+    }
+}
+
+void mc::FrameTimings::began_frame(DisplayId id, mt::Timestamp when)
+{
+    std::lock_guard lock{mutex};
+    auto& display = displays[id];
+
+    display.frame_in_progress = {when, display.pending_since};
+    if (display.pending_since)
+    {
+        display.schedule_latency.record(as_microseconds(when - *display.pending_since));
+        display.pending_since.reset();
+    }
+}
+
+void mc::FrameTimings::rendered_frame(DisplayId id, mt::Timestamp when)
+{
+    std::lock_guard lock{mutex};
+    auto& display = displays[id];
+
+    display.render_time.record(as_microseconds(when - display.frame_in_progress.began));
+}
+
+void mc::FrameTimings::finished_frame(DisplayId id, mt::Timestamp)
+{
+    std::lock_guard lock{mutex};
+    auto& display = displays[id];
+
+    if (display.awaiting_presentation.size() == max_awaiting_presentation)
+    {
+        display.awaiting_presentation.pop_front();
+    }
+    display.awaiting_presentation.push_back(display.frame_in_progress);
+    ++display.frames;
+}
+
+void mc::FrameTimings::presented_frame(DisplayId id, mt::Timestamp when, mg::Presentation const& presentation)
+{
+    std::lock_guard lock{mutex};
+    auto& display = displays[id];
+
+    if (display.awaiting_presentation.empty())
+    {
+        return;
+    }
+    auto const frame = display.awaiting_presentation.front();
+    display.awaiting_presentation.pop_front();
+
+    display.present_latency.record(as_microseconds(when - frame.began));
+
+    // Only a frame that was waiting to be composited when the last one was shown could have made the next vblank
+    bool const back_to_back =
+        display.last_presented && frame.scheduled && *frame.scheduled <= *display.last_presented;
+    if (back_to_back && display.last_msc && presentation.from_hardware)
+    {
+        auto const vblanks = presentation.frame.msc - *display.last_msc;
+        if (vblanks > 1)
+        {
+            display.missed_vblanks += vblanks - 1;
+        }
+    }
+    display.last_presented = when;
+    display.last_msc = presentation.from_hardware ? std::optional{presentation.frame.msc} : std::nullopt;
+}
+
+auto mc::FrameTimings::time_of(mg::Presentation const& presentation, mt::Timestamp now) -> mt::Timestamp
+{
+    auto const ust = presentation.frame.ust;
+    return now - (mg::Frame::Timestamp::now(ust.clock_id) - ust);
+}
+
+void mc::FrameTimings::clear()
+{
+    std::lock_guard lock{mutex};
+    displays.clear();
+}
+
+auto mc::FrameTimings::stats() const -> std::unordered_map<DisplayId, FrameTimingStats>
+{
+    std::lock_guard lock{mutex};
+
+    std::unordered_map<DisplayId, FrameTimingStats> result;
+    for (auto const& [id, display] : displays)
+    {
+        result.emplace(id, display.summarise());
+    }
+    return result;
+}
+
+auto mc::FrameTimings::stats_for(DisplayId id) const -> std::optional<FrameTimingStats>
+{
+    std::lock_guard lock{mutex};
+
+    if (auto const display = displays.find(id); display != displays.end())
+    {
+        return display->second.summarise();
+    }
+    return std::nullopt;
+}
+
+auto mc::FrameTimings::Display::summarise() const -> FrameTimingStats
+{
+    return {
+        summary_of(render_time),
+        summary_of(schedule_latency),
+        summary_of(present_latency),
+        frames,
+        missed_vblanks};
+}
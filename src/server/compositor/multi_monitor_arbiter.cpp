@@ -35,6 +35,9 @@ struct mc::MultiMonitorArbiter::Submission
     std::shared_ptr<mg::Buffer> buffer;
     geom::Size output_size;
     geom::RectangleD source_sample;
+    /// Damage relative to the submission with the previous serial
+    std::optional<geom::Rectangles> damage;
+    uint64_t serial;
 };
 
 namespace
@@ -44,8 +47,10 @@ class TrackingSubmission : public mc::BufferStream::Submission
 public:
     TrackingSubmission(
         std::shared_ptr<mc::MultiMonitorArbiter::Submission> submission,
+        std::optional<geom::Rectangles> damage,
         std::function<void()> on_claimed)
         : submission{std::move(submission)},
+          damage_{std::move(damage)},
           on_claimed{std::move(on_claimed)}
     {
     }
@@ -70,16 +75,39 @@ public:
     {
         return mg::DRMFormat::from_mir_format(submission->buffer->pixel_format());
     }
+
+    auto damage() const -> std::optional<geom::Rectangles> override
+    {
+        return damage_;
+    }
 private:
     std::shared_ptr<mc::MultiMonitorArbiter::Submission> submission;
+    std::optional<geom::Rectangles> const damage_;
     std::function<void()> on_claimed;
 };
+
+/// Combines damage from consecutive submissions; std::nullopt (everything) absorbs anything else
+auto combine(std::optional<geom::Rectangles> const& earlier, std::optional<geom::Rectangles> const& later)
+    -> std::optional<geom::Rectangles>
+{
+    if (!earlier || !later)
+        return std::nullopt;
+
+    auto combined = earlier.value();
+    for (auto const& rect : later.value())
+    {
+        combined.add(rect);
+    }
+    return combined;
+}
 }
 
 mc::MultiMonitorArbiter::MultiMonitorArbiter()
 {
     // We're highly unlikely to have more than 6 outputs
-    state.lock()->current_buffer_users.reserve(6);
+    auto const current_state = state.lock();
+    current_state->current_buffer_users.reserve(6);
+    current_state->claims.reserve(6);
 }
 
 mc::MultiMonitorArbiter::~MultiMonitorArbiter()
@@ -111,6 +139,7 @@ auto mc::MultiMonitorArbiter::compositor_acquire(compositor::CompositorID id)
 
     return std::make_shared<TrackingSubmission>(
         current_state->current_submission,
+        damage_for(*current_state, id),
         [me = shared_from_this(), submission = current_state->current_submission, id]()
         {
             auto state = me->state.lock();
@@ -120,15 +149,36 @@ auto mc::MultiMonitorArbiter::compositor_acquire(compositor::CompositorID id)
             // The compositor is now a user of the current buffer
             // This means we will try to give it a new buffer next time it asks
             add_current_buffer_user(*state, id);
+            set_claim(*state, id, *submission);
         });
 }
 
 void mc::MultiMonitorArbiter::submit_buffer(
     std::shared_ptr<mg::Buffer> buffer,
     geom::Size output_size,
-    geom::RectangleD source)
+    geom::RectangleD source,
+    std::optional<geom::Rectangles> damage)
 {
-    state.lock()->next_submission = std::make_shared<Submission>(std::move(buffer), output_size, source);
+    auto current_state = state.lock();
+
+    if (auto const& replaced = current_state->next_submission)
+    {
+        // No compositor has seen the submission we're replacing, so its damage still needs to be applied
+        auto const combined_damage = replaced->output_size == output_size ?
+            combine(replaced->damage, damage) :
+            std::nullopt;
+        current_state->next_submission = std::make_shared<Submission>(
+            std::move(buffer), output_size, source, combined_damage, replaced->serial);
+    }
+    else
+    {
+        if (current_state->current_submission && current_state->current_submission->output_size != output_size)
+        {
+            damage = std::nullopt;
+        }
+        current_state->next_submission = std::make_shared<Submission>(
+            std::move(buffer), output_size, source, std::move(damage), current_state->next_serial++);
+    }
 }
 
 bool mc::MultiMonitorArbiter::buffer_ready_for(mc::CompositorID id)
@@ -186,3 +236,56 @@ void mc::MultiMonitorArbiter::clear_current_users(State& state)
         slot = {};
     }
 }
+
+auto mc::MultiMonitorArbiter::claimed_buffer(mc::CompositorID id) -> std::optional<mg::BufferID>
+{
+    auto const current_state = state.lock();
+    for (auto const& claim : current_state->claims)
+    {
+        if (claim.compositor == id)
+        {
+            return claim.buffer;
+        }
+    }
+    return std::nullopt;
+}
+
+void mc::MultiMonitorArbiter::set_claim(State& state, mc::CompositorID id, Submission const& submission)
+{
+    for (auto& claim : state.claims)
+    {
+        if (claim.compositor == id)
+        {
+            claim.serial = submission.serial;
+            claim.buffer = submission.buffer->id();
+            return;
+        }
+    }
+    state.claims.push_back({id, submission.serial, submission.buffer->id()});
+}
+
+auto mc::MultiMonitorArbiter::damage_for(State const& state, mc::CompositorID id) -> std::optional<geom::Rectangles>
+{
+    auto const& submission = state.current_submission;
+
+    for (auto const& claim : state.claims)
+    {
+        if (claim.compositor == id)
+        {
+            if (claim.serial == submission->serial)
+            {
+                // This compositor has already seen this content
+                return geom::Rectangles{};
+            }
+            else if (claim.serial + 1 == submission->serial)
+            {
+                return submission->damage;
+            }
+            // The compositor has missed at least one submission, and we don't keep a history
+            return std::nullopt;
+        }
+    }
+
+    // The first time a compositor sees this stream everything is new
+    return std::nullopt;
+}
@@ -21,10 +21,14 @@
 #include "mir/compositor/compositor_id.h"
 #include "mir/compositor/buffer_stream.h"
 #include "mir/geometry/forward.h"
+#include "mir/geometry/rectangles.h"
+#include "mir/graphics/buffer_id.h"
 #include "mir/synchronised.h"
+#include <cstdint>
 #include <memory>
 #include <vector>
 #include <optional>
+#include <utility>
 
 namespace mir
 {
@@ -42,10 +46,20 @@ public:
     auto compositor_acquire(compositor::CompositorID id) -> std::shared_ptr<BufferStream::Submission>;
     bool buffer_ready_for(compositor::CompositorID id);
 
+    /**
+     * Submit a new buffer
+     *
+     * \param [in] damage  The region (in logical coordinates) that has changed since the previous
+     *                     submission, or std::nullopt if everything should be considered changed
+     */
     void submit_buffer(
         std::shared_ptr<graphics::Buffer> buffer,
         geometry::Size output_size,
-        geometry::RectangleD source_sample);
+        geometry::RectangleD source_sample,
+        std::optional<geometry::Rectangles> damage);
+
+    /// The buffer compositor id most recently claimed, if it has claimed one
+    auto claimed_buffer(compositor::CompositorID id) -> std::optional<graphics::BufferID>;
 
     struct Submission;
 private:
@@ -54,12 +68,23 @@ private:
         std::vector<std::optional<compositor::CompositorID>> current_buffer_users;
         std::shared_ptr<Submission> current_submission;
         std::shared_ptr<Submission> next_submission;
+        /// The last submission each compositor claimed, used to work out what it has missed
+        struct Claim
+        {
+            compositor::CompositorID compositor;
+            uint64_t serial;
+            graphics::BufferID buffer;
+        };
+        std::vector<Claim> claims;
+        uint64_t next_serial{1};
     };
     Synchronised<State> state;
 
     static void add_current_buffer_user(State& state, compositor::CompositorID id);
     static bool is_user_of_current_buffer(State& state, compositor::CompositorID id);
     static void clear_current_users(State& state);
+    static void set_claim(State& state, compositor::CompositorID id, Submission const& submission);
+    static auto damage_for(State const& state, compositor::CompositorID id) -> std::optional<geometry::Rectangles>;
 };
 
 }
@@ -15,8 +15,10 @@
  */
 
 #include "multi_threaded_compositor.h"
+#include "render_time_predictor.h"
 #include "mir/graphics/display.h"
 #include "mir/graphics/display_sink.h"
+#include "mir/graphics/frame.h"
 #include "mir/compositor/display_buffer_compositor.h"
 #include "mir/compositor/display_buffer_compositor_factory.h"
 #include "mir/compositor/display_listener.h"
@@ -30,6 +32,7 @@
 #include "mir/executor.h"
 #include "mir/signal.h"
 
+#include <algorithm>
 #include <atomic>
 #include <thread>
 #include <chrono>
@@ -115,6 +118,9 @@ public:
 
         started.set_value();
 
+        std::vector<CompositorReport::SubCompositorId> composited;
+        composited.reserve(compositors.size());
+
         try
         {
             while (running)
@@ -128,28 +134,57 @@ public:
                  */
                 if (running)
                 {
-                    bool needs_post = false;
+                    auto const frame_start = std::chrono::steady_clock::now();
+                    auto const vblank = target_vblank();
+                    composited.clear();
                     for (auto& tuple : compositors)
                     {
+                        auto const& sink = std::get<0>(tuple);
                         auto& compositor = std::get<1>(tuple);
-                        if (compositor->composite(scene->scene_elements_for(compositor.get())))
-                            needs_post = true;
+                        if (compositor->composite(scene->scene_elements_for(compositor.get(), sink->view_area())))
+                            composited.push_back(compositor.get());
                     }
 
                     // We can skip the post if none of the compositors ended up compositing
-                    if (needs_post)
+                    if (!composited.empty())
+                    {
+                        render_times.record(std::chrono::steady_clock::now() - frame_start);
+
+                        // What each compositor took from the scene for this frame, before it takes the next
+                        std::vector<std::function<void(mg::Presentation const&)>> presenters;
+                        presenters.reserve(composited.size());
+                        for (auto const compositor : composited)
+                        {
+                            presenters.push_back(scene->frame_presenter(compositor));
+                        }
+                        auto const present =
+                            [presenters = std::move(presenters), report = report, composited = composited,
+                             vblank, missed_vblanks = missed_vblanks](mg::Presentation const& presentation)
+                            {
+                                if (vblank && shown_after(presentation, *vblank))
+                                {
+                                    ++*missed_vblanks;
+                                }
+                                for (auto const& presenter : presenters)
+                                {
+                                    presenter(presentation);
+                                }
+                                for (auto const compositor : composited)
+                                {
+                                    report->presented_frame(compositor, presentation);
+                                }
+                            };
+
                         group.post();
 
-                    /*
-                     * "Predictive bypass" optimization: If the last frame was
-                     * bypassed/overlayed or you simply have a fast GPU, it is
-                     * beneficial to sleep for most of the next frame. This reduces
-                     * the latency between snapshotting the scene and post()
-                     * completing by almost a whole frame.
-                     */
-                    auto delay = force_sleep >= std::chrono::milliseconds::zero() ?
-                                 force_sleep : group.recommended_sleep();
-                    std::this_thread::sleep_for(delay);
+                        // Where the display can't say when the frame is shown, the best we can do is now
+                        if (!group.when_presented(present))
+                        {
+                            present(mg::Presentation{{0, mg::Frame::Timestamp::now(CLOCK_MONOTONIC)}, {}, false});
+                        }
+                    }
+
+                    std::this_thread::sleep_for(composite_delay(composited));
                 }
             }
         }
@@ -163,6 +198,73 @@ public:
         started.set_exception(std::current_exception());
     }
 
+    /*
+     * "Predictive bypass" optimization: If the last frame was
+     * bypassed/overlayed or you simply have a fast GPU, it is
+     * beneficial to sleep for most of the next frame. This reduces
+     * the latency between snapshotting the scene and post()
+     * completing by almost a whole frame.
+     *
+     * Where the display can tell us when it next refreshes, we sleep
+     * until just long enough before then to composite the next frame,
+     * going by how long recent frames took. Otherwise we fall back on
+     * the display's own guess.
+     */
+    auto composite_delay(std::vector<CompositorReport::SubCompositorId> const& composited)
+        -> std::chrono::nanoseconds
+    {
+        if (force_sleep >= std::chrono::milliseconds::zero())
+            return force_sleep;
+
+        for (auto missed = missed_vblanks->exchange(0); missed != 0; --missed)
+            render_times.missed_vblank();
+
+        auto const vblank = group.next_vblank();
+        auto const render_time = render_times.predicted();
+        if (!vblank || !render_time)
+            return group.recommended_sleep();
+
+        auto const until_vblank = *vblank - mg::Frame::Timestamp::now(vblank->clock_id);
+        auto const delay = std::max(until_vblank - *render_time, std::chrono::nanoseconds::zero());
+
+        for (auto const compositor : composited)
+            report->scheduled_next_frame(compositor, *render_time, delay);
+
+        return delay;
+    }
+
+    /*
+     * The vblank a frame starting now should make, if it has (give or take
+     * scheduling jitter) as long as we predict it needs. Only such a frame
+     * missing it says the prediction is too short.
+     */
+    auto target_vblank() const -> std::optional<mg::Frame::Timestamp>
+    {
+        if (force_sleep >= std::chrono::milliseconds::zero())
+            return std::nullopt;
+
+        auto const vblank = group.next_vblank();
+        auto const render_time = render_times.predicted();
+        if (!vblank || !render_time)
+            return std::nullopt;
+
+        auto const until_vblank = *vblank - mg::Frame::Timestamp::now(vblank->clock_id);
+        if (until_vblank < *render_time - RenderTimePredictor::margin)
+            return std::nullopt;
+
+        return vblank;
+    }
+
+    /// Whether the display hardware showed the frame at a later vblank than \a vblank
+    static auto shown_after(mg::Presentation const& presentation, mg::Frame::Timestamp vblank) -> bool
+    {
+        // Without a fixed refresh interval there's no telling which vblank the flip was at
+        return presentation.from_hardware &&
+               presentation.refresh_interval > std::chrono::nanoseconds::zero() &&
+               presentation.frame.ust.clock_id == vblank.clock_id &&
+               presentation.frame.ust - vblank > presentation.refresh_interval / 2;
+    }
+
     void schedule_compositing()
     {
         wakeup.raise();
@@ -210,6 +312,9 @@ private:
     mir::Signal wakeup;
     std::atomic<bool> running;
     std::chrono::milliseconds force_sleep{-1};
+    RenderTimePredictor render_times;
+    /// Frames shown after the vblank they were given time to make, counted by presentation handlers
+    std::shared_ptr<std::atomic<int>> const missed_vblanks{std::make_shared<std::atomic<int>>(0)};
     std::shared_ptr<DisplayListener> const display_listener;
     std::shared_ptr<CompositorReport> const report;
     std::promise<void> started;
@@ -332,7 +437,7 @@ void mc::MultiThreadedCompositor::create_compositing_threads()
             display_buffer_compositor_factory, group, scene, display_listener,
             fixed_composite_delay, report);
 
-        mir::thread_pool_executor.spawn(std::ref(*thread_functor));
+        mir::ThreadPoolExecutor::spawn_on_dedicated_thread(std::ref(*thread_functor));
         thread_functors.push_back(std::move(thread_functor));
     });
 
@@ -18,8 +18,7 @@
 #include "mir/compositor/scene_element.h"
 #include "mir/graphics/renderable.h"
 #include "occlusion.h"
-
-#include <vector>
+#include "region.h"
 
 using namespace mir::geometry;
 using namespace mir::graphics;
@@ -27,37 +26,82 @@ using namespace mir::compositor;
 
 namespace
 {
-bool renderable_is_occluded(
-    Renderable const& renderable, 
-    Rectangle const& area,
-    std::vector<Rectangle>& coverage)
+/// A renderable restricted to the part of it that isn't hidden by what's above it
+class ClippedRenderable : public Renderable
 {
-    static glm::mat4 const identity(1);
-    static Rectangle const empty{};
+public:
+    ClippedRenderable(std::shared_ptr<Renderable> const& renderable, Rectangle const& clip_area)
+        : renderable{renderable},
+          clip_area_{clip_area}
+    {
+    }
 
-    if (renderable.transformation() != identity)
-        return false;  // Weirdly transformed. Assume never occluded.
+    auto id() const -> ID override { return renderable->id(); }
+    auto buffer() const -> std::shared_ptr<Buffer> override { return renderable->buffer(); }
+    auto screen_position() const -> Rectangle override { return renderable->screen_position(); }
+    auto src_bounds() const -> RectangleD override { return renderable->src_bounds(); }
+    auto clip_area() const -> std::optional<Rectangle> override { return clip_area_; }
+    auto alpha() const -> float override { return renderable->alpha(); }
+    auto transformation() const -> glm::mat4 override { return renderable->transformation(); }
+    auto shaped() const -> bool override { return renderable->shaped(); }
+    auto damage() const -> std::optional<Rectangles> override { return renderable->damage(); }
+    auto opaque_region() const -> Rectangles override { return renderable->opaque_region(); }
+    auto surface_if_any() const -> std::optional<mir::scene::Surface const*> override
+    {
+        return renderable->surface_if_any();
+    }
+
+private:
+    std::shared_ptr<Renderable> const renderable;
+    Rectangle const clip_area_;
+};
+
+class ClippedSceneElement : public SceneElement
+{
+public:
+    ClippedSceneElement(std::shared_ptr<SceneElement> const& element, Rectangle const& clip_area)
+        : element{element},
+          renderable_{std::make_shared<ClippedRenderable>(element->renderable(), clip_area)}
+    {
+    }
 
-    auto const& window = renderable.screen_position();
-    auto const& clipped_window = intersection_of(window, area);
+    auto renderable() const -> std::shared_ptr<Renderable> override { return renderable_; }
+    void rendered() override { element->rendered(); }
+    void occluded() override { element->occluded(); }
 
-    if (clipped_window == empty)
-        return true;  // Not in the area; definitely occluded.
+private:
+    std::shared_ptr<SceneElement> const element;
+    std::shared_ptr<Renderable> const renderable_;
+};
 
-    bool occluded = false;
-    for (auto const& r : coverage)
+/// The part of the screen the renderable might draw to, ignoring any transformation
+auto extent_of(Renderable const& renderable, Rectangle const& area) -> Rectangle
+{
+    auto const extent = intersection_of(renderable.screen_position(), area);
+    if (auto const clip_area = renderable.clip_area())
     {
-        if (r.contains(clipped_window))
-        {
-            occluded = true;
-            break;
-        }
+        return intersection_of(extent, clip_area.value());
     }
+    return extent;
+}
 
-    if (!occluded && renderable.alpha() == 1.0f && !renderable.shaped())
-        coverage.push_back(clipped_window);
+/// The part of the renderable that hides whatever is beneath it
+auto opaque_part_of(Renderable const& renderable, Rectangle const& extent) -> Region
+{
+    if (renderable.alpha() != 1.0f)
+    {
+        return {};
+    }
 
-    return occluded;
+    if (!renderable.shaped())
+    {
+        return extent;
+    }
+
+    // Only the parts the client promises are opaque
+    Region opaque{renderable.opaque_region()};
+    opaque.intersect(extent);
+    return opaque;
 }
 }
 
@@ -65,22 +109,44 @@ SceneElementSequence mir::compositor::filter_occlusions_from(
     SceneElementSequence& elements,
     Rectangle const& area)
 {
+    static glm::mat4 const identity(1);
+
     SceneElementSequence occluded;
-    std::vector<Rectangle> coverage;
+    Region coverage;
 
     auto it = elements.rbegin();
     while (it != elements.rend())
     {
         auto const renderable = (*it)->renderable();
-        if (renderable_is_occluded(*renderable, area, coverage))
+
+        if (renderable->transformation() != identity)
+        {
+            // Weirdly transformed. Assume never occluded.
+            it++;
+            continue;
+        }
+
+        auto const extent = extent_of(*renderable, area);
+
+        Region visible{extent};
+        visible.subtract(coverage);
+
+        if (visible.is_empty())
         {
             occluded.insert(occluded.begin(), *it);
             it = SceneElementSequence::reverse_iterator(elements.erase(std::prev(it.base())));
+            continue;
         }
-        else
+
+        coverage.add(opaque_part_of(*renderable, extent));
+
+        // Don't draw the parts of the renderable we know can't be seen
+        if (auto const visible_extent = visible.bounding_rectangle(); visible_extent != extent)
         {
-            it++;
+            *it = std::make_shared<ClippedSceneElement>(*it, visible_extent);
         }
+
+        it++;
     }
 
     return occluded;
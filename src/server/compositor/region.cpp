@@ -0,0 +1,246 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "region.h"
+
+#include <algorithm>
+#include <limits>
+#include <ostream>
+
+namespace mc = mir::compositor;
+namespace geom = mir::geometry;
+
+namespace
+{
+auto const unbounded = std::numeric_limits<int>::max();
+}
+
+mc::Region::Region(geom::Rectangle const& rect)
+{
+    if (rect.size.width > geom::Width{0} && rect.size.height > geom::Height{0})
+    {
+        bands.push_back({
+            rect.top().as_int(),
+            rect.bottom().as_int(),
+            {{rect.left().as_int(), rect.right().as_int()}}});
+    }
+}
+
+mc::Region::Region(geom::Rectangles const& rects)
+{
+    for (auto const& rect : rects)
+    {
+        add(rect);
+    }
+}
+
+auto mc::Region::is_empty() const -> bool
+{
+    return bands.empty();
+}
+
+auto mc::Region::contains(geom::Rectangle const& rect) const -> bool
+{
+    Region uncovered{rect};
+    uncovered.subtract(*this);
+    return uncovered.is_empty();
+}
+
+auto mc::Region::bounding_rectangle() const -> geom::Rectangle
+{
+    if (bands.empty())
+    {
+        return {};
+    }
+
+    auto left = unbounded;
+    auto right = -unbounded;
+    for (auto const& band : bands)
+    {
+        left = std::min(left, band.spans.front().left);
+        right = std::max(right, band.spans.back().right);
+    }
+
+    return {{left, bands.front().top}, {right - left, bands.back().bottom - bands.front().top}};
+}
+
+auto mc::Region::rectangles() const -> geom::Rectangles
+{
+    geom::Rectangles result;
+    for (auto const& band : bands)
+    {
+        for (auto const& span : band.spans)
+        {
+            result.add({{span.left, band.top}, {span.right - span.left, band.bottom - band.top}});
+        }
+    }
+    return result;
+}
+
+void mc::Region::add(Region const& other)
+{
+    bands = combine(bands, other.bands, [](bool in_this, bool in_other) { return in_this || in_other; });
+}
+
+void mc::Region::subtract(Region const& other)
+{
+    bands = combine(bands, other.bands, [](bool in_this, bool in_other) { return in_this && !in_other; });
+}
+
+void mc::Region::intersect(Region const& other)
+{
+    bands = combine(bands, other.bands, [](bool in_this, bool in_other) { return in_this && in_other; });
+}
+
+/*
+ * Both combine()s sweep across the sorted, disjoint intervals of their inputs,
+ * stopping wherever either input starts or stops, and keep the intervals for
+ * which op() says the result should be filled. Adjacent intervals with the same
+ * content are merged so the result stays canonical.
+ */
+template<typename Op>
+auto mc::Region::combine(std::vector<Band> const& a, std::vector<Band> const& b, Op op) -> std::vector<Band>
+{
+    static std::vector<Span> const nothing;
+    bool const keeps_a_alone = op(true, false);
+    bool const keeps_b_alone = op(false, true);
+    std::vector<Band> result;
+
+    auto next_a = a.begin();
+    auto next_b = b.begin();
+
+    // Where only one input matters there's no need to look at the other outside it
+    if (!keeps_b_alone && !a.empty())
+    {
+        next_b = std::partition_point(
+            b.begin(), b.end(), [top = a.front().top](Band const& band) { return band.bottom <= top; });
+    }
+    if (!keeps_a_alone && !b.empty())
+    {
+        next_a = std::partition_point(
+            a.begin(), a.end(), [top = b.front().top](Band const& band) { return band.bottom <= top; });
+    }
+
+    auto y = -unbounded;
+    while (next_a != a.end() || next_b != b.end())
+    {
+        if ((next_a == a.end() && !keeps_b_alone) || (next_b == b.end() && !keeps_a_alone))
+        {
+            break;
+        }
+
+        auto const a_top = next_a != a.end() ? std::max(next_a->top, y) : unbounded;
+        auto const b_top = next_b != b.end() ? std::max(next_b->top, y) : unbounded;
+        auto const top = std::min(a_top, b_top);
+        bool const in_a = next_a != a.end() && a_top == top;
+        bool const in_b = next_b != b.end() && b_top == top;
+
+        auto bottom = unbounded;
+        if (next_a != a.end())
+        {
+            bottom = std::min(bottom, in_a ? next_a->bottom : next_a->top);
+        }
+        if (next_b != b.end())
+        {
+            bottom = std::min(bottom, in_b ? next_b->bottom : next_b->top);
+        }
+
+        auto spans =
+            in_a && in_b ? combine(next_a->spans, next_b->spans, op) :
+            in_a ? (keeps_a_alone ? next_a->spans : nothing) :
+            (keeps_b_alone ? next_b->spans : nothing);
+        if (!spans.empty())
+        {
+            if (!result.empty() && result.back().bottom == top && result.back().spans == spans)
+            {
+                result.back().bottom = bottom;
+            }
+            else
+            {
+                result.push_back({top, bottom, std::move(spans)});
+            }
+        }
+
+        y = bottom;
+        if (next_a != a.end() && next_a->bottom <= y)
+        {
+            ++next_a;
+        }
+        if (next_b != b.end() && next_b->bottom <= y)
+        {
+            ++next_b;
+        }
+    }
+
+    return result;
+}
+
+template<typename Op>
+auto mc::Region::combine(std::vector<Span> const& a, std::vector<Span> const& b, Op op) -> std::vector<Span>
+{
+    std::vector<Span> result;
+
+    auto next_a = a.begin();
+    auto next_b = b.begin();
+    auto x = -unbounded;
+    while (next_a != a.end() || next_b != b.end())
+    {
+        auto const a_left = next_a != a.end() ? std::max(next_a->left, x) : unbounded;
+        auto const b_left = next_b != b.end() ? std::max(next_b->left, x) : unbounded;
+        auto const left = std::min(a_left, b_left);
+        bool const in_a = next_a != a.end() && a_left == left;
+        bool const in_b = next_b != b.end() && b_left == left;
+
+        auto right = unbounded;
+        if (next_a != a.end())
+        {
+            right = std::min(right, in_a ? next_a->right : next_a->left);
+        }
+        if (next_b != b.end())
+        {
+            right = std::min(right, in_b ? next_b->right : next_b->left);
+        }
+
+        if (op(in_a, in_b))
+        {
+            if (!result.empty() && result.back().right == left)
+            {
+                result.back().right = right;
+            }
+            else
+            {
+                result.push_back({left, right});
+            }
+        }
+
+        x = right;
+        if (next_a != a.end() && next_a->right <= x)
+        {
+            ++next_a;
+        }
+        if (next_b != b.end() && next_b->right <= x)
+        {
+            ++next_b;
+        }
+    }
+
+    return result;
+}
+
+auto mc::operator<<(std::ostream& out, Region const& region) -> std::ostream&
+{
+    return out << region.rectangles();
+}
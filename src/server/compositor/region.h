@@ -0,0 +1,86 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_COMPOSITOR_REGION_H_
+#define MIR_COMPOSITOR_REGION_H_
+
+#include "mir/geometry/rectangle.h"
+#include "mir/geometry/rectangles.h"
+
+#include <iosfwd>
+#include <vector>
+
+namespace mir
+{
+namespace compositor
+{
+/**
+ * An arbitrary set of pixels, built up from rectangles.
+ *
+ * The region is stored as horizontal bands, each holding the sorted, disjoint
+ * spans of the region crossing it, so a region has a single representation
+ * regardless of how it was built, and union, intersection and subtraction are
+ * all linear in the size of the operands.
+ */
+class Region
+{
+public:
+    Region() = default;
+    Region(geometry::Rectangle const& rect);
+    Region(geometry::Rectangles const& rects);
+
+    auto is_empty() const -> bool;
+    /// Whether every pixel of \a rect is in the region
+    auto contains(geometry::Rectangle const& rect) const -> bool;
+    auto bounding_rectangle() const -> geometry::Rectangle;
+    /// The region as non-overlapping rectangles, top to bottom, then left to right
+    auto rectangles() const -> geometry::Rectangles;
+
+    void add(Region const& other);
+    void subtract(Region const& other);
+    void intersect(Region const& other);
+
+    auto operator==(Region const& other) const -> bool = default;
+
+private:
+    struct Span
+    {
+        int left;
+        int right;
+        auto operator==(Span const& other) const -> bool = default;
+    };
+
+    struct Band
+    {
+        int top;
+        int bottom;
+        std::vector<Span> spans;
+        auto operator==(Band const& other) const -> bool = default;
+    };
+
+    template<typename Op>
+    static auto combine(std::vector<Band> const& a, std::vector<Band> const& b, Op op) -> std::vector<Band>;
+    template<typename Op>
+    static auto combine(std::vector<Span> const& a, std::vector<Span> const& b, Op op) -> std::vector<Span>;
+
+    std::vector<Band> bands;
+};
+
+auto operator<<(std::ostream& out, Region const& region) -> std::ostream&;
+}
+}
+
+#endif // MIR_COMPOSITOR_REGION_H_
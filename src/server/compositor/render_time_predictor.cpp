@@ -0,0 +1,56 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "render_time_predictor.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace mc = mir::compositor;
+
+void mc::RenderTimePredictor::record(std::chrono::nanoseconds render_time)
+{
+    samples[next] = std::max(render_time, std::chrono::nanoseconds::zero());
+    next = (next + 1) % window;
+    count = std::min(count + 1, window);
+    penalty = std::max(penalty - miss_penalty / std::chrono::nanoseconds::rep{window}, std::chrono::nanoseconds::zero());
+}
+
+void mc::RenderTimePredictor::missed_vblank()
+{
+    penalty = std::min(penalty + miss_penalty, max_penalty);
+}
+
+void mc::RenderTimePredictor::clear()
+{
+    next = 0;
+    count = 0;
+    penalty = std::chrono::nanoseconds::zero();
+}
+
+auto mc::RenderTimePredictor::predicted() const -> std::optional<std::chrono::nanoseconds>
+{
+    if (count < min_samples)
+    {
+        return std::nullopt;
+    }
+
+    auto recent = samples;
+    auto const rank = static_cast<std::size_t>(std::ceil(percentile * count)) - 1;
+    std::nth_element(recent.begin(), recent.begin() + rank, recent.begin() + count);
+
+    return recent[rank] + margin + penalty;
+}
@@ -0,0 +1,69 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_COMPOSITOR_RENDER_TIME_PREDICTOR_H_
+#define MIR_COMPOSITOR_RENDER_TIME_PREDICTOR_H_
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <optional>
+
+namespace mir
+{
+namespace compositor
+{
+/**
+ * Predicts how long compositing the next frame will take, from how long recent frames took
+ *
+ * The prediction is a high percentile of the recent frames, plus a margin for the work
+ * that isn't measured (such as submitting the frame to the display), so that starting to
+ * composite that long before a vblank rarely misses it.
+ *
+ * What is measured stops at the CPU, so where frames given that long still miss their
+ * vblank (because the GPU or the flip takes longer) the prediction is raised for each miss,
+ * and eases back as frames are recorded.
+ */
+class RenderTimePredictor
+{
+public:
+    void record(std::chrono::nanoseconds render_time);
+    /// A frame started the predicted time before a vblank was shown after it
+    void missed_vblank();
+    void clear();
+
+    /// Nothing until enough frames have been recorded to predict from
+    auto predicted() const -> std::optional<std::chrono::nanoseconds>;
+
+    static std::size_t constexpr window = 64;
+    static std::size_t constexpr min_samples = 8;
+    /// The fraction of recent frames that would have been on time
+    static double constexpr percentile = 0.95;
+    static std::chrono::nanoseconds constexpr margin = std::chrono::milliseconds{2};
+    /// What each missed vblank adds to the prediction, until window frames have been recorded since
+    static std::chrono::nanoseconds constexpr miss_penalty = std::chrono::milliseconds{2};
+    static std::chrono::nanoseconds constexpr max_penalty = std::chrono::milliseconds{10};
+
+private:
+    std::array<std::chrono::nanoseconds, window> samples{};
+    std::size_t next{0};
+    std::size_t count{0};
+    std::chrono::nanoseconds penalty{0};
+};
+}
+}
+
+#endif // MIR_COMPOSITOR_RENDER_TIME_PREDICTOR_H_
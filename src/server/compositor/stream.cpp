@@ -18,6 +18,7 @@
 #include "multi_monitor_arbiter.h"
 #include "mir/geometry/rectangle.h"
 #include "mir/graphics/buffer.h"
+#include "mir/graphics/frame.h"
 #include <boost/throw_exception.hpp>
 #include <math.h>
 
@@ -27,10 +28,50 @@ namespace mc = mir::compositor;
 namespace mg = mir::graphics;
 namespace geom = mir::geometry;
 
+namespace
+{
+/// Maps damage in buffer coordinates to logical coordinates relative to the top-left of the destination
+auto to_logical_damage(
+    geom::Rectangles const& buffer_damage,
+    geom::Size dst_size,
+    geom::RectangleD const& src_bounds) -> geom::Rectangles
+{
+    geom::Rectangles logical_damage;
+
+    if (src_bounds.size.width.as_value() <= 0 || src_bounds.size.height.as_value() <= 0)
+        return logical_damage;
+
+    auto const x_scale = dst_size.width.as_value() / src_bounds.size.width.as_value();
+    auto const y_scale = dst_size.height.as_value() / src_bounds.size.height.as_value();
+    geom::Rectangle const dst_rect{{0, 0}, dst_size};
+
+    for (auto const& rect : buffer_damage)
+    {
+        // Round outwards so we never under-report damage
+        auto const left = std::floor((rect.left().as_value() - src_bounds.left().as_value()) * x_scale);
+        auto const top = std::floor((rect.top().as_value() - src_bounds.top().as_value()) * y_scale);
+        auto const right = std::ceil((rect.right().as_value() - src_bounds.left().as_value()) * x_scale);
+        auto const bottom = std::ceil((rect.bottom().as_value() - src_bounds.top().as_value()) * y_scale);
+
+        geom::Rectangle const mapped{
+            {static_cast<int>(left), static_cast<int>(top)},
+            {static_cast<int>(right - left), static_cast<int>(bottom - top)}};
+
+        auto const clipped = intersection_of(mapped, dst_rect);
+        if (clipped.size.width > geom::Width{0} && clipped.size.height > geom::Height{0})
+            logical_damage.add(clipped);
+    }
+
+    return logical_damage;
+}
+}
+
 mc::Stream::Stream() :
     arbiter(std::make_shared<mc::MultiMonitorArbiter>()),
     first_frame_posted(false),
-    frame_callback{[](auto){}}
+    frame_callback{[](auto){}},
+    presented_state{std::make_shared<Synchronised<PresentedState>>(
+        PresentedState{[](auto, auto const&){}, std::nullopt})}
 {
 }
 
@@ -39,24 +80,44 @@ mc::Stream::~Stream() = default;
 void mc::Stream::submit_buffer(
     std::shared_ptr<mg::Buffer> const& buffer,
     geom::Size dst_size,
-    geom::RectangleD src_bounds)
+    geom::RectangleD src_bounds,
+    std::optional<geom::Rectangles> const& damage)
 {
     if (!buffer)
         BOOST_THROW_EXCEPTION(std::invalid_argument("cannot submit null buffer"));
 
-    arbiter->submit_buffer(buffer, dst_size, src_bounds);
+    std::optional<geom::Rectangles> logical_damage;
+    if (damage)
+    {
+        logical_damage = to_logical_damage(damage.value(), dst_size, src_bounds);
+    }
+
+    *latest_size.lock() = dst_size;
+    arbiter->submit_buffer(buffer, dst_size, src_bounds, logical_damage);
+    // The same buffer may be resubmitted (with a new scale, say), and that's new content to present
+    presented_state->lock()->last_presented = std::nullopt;
     first_frame_posted = true;
     {
-        (*frame_callback.lock())(buffer->size());
+        // Even if nothing visible changed, the new buffer (and its frame callbacks) need a composite
+        auto const changed_area = logical_damage && logical_damage->size() > 0 ?
+            logical_damage->bounding_rectangle() :
+            geom::Rectangle{{0, 0}, dst_size};
+        (*frame_callback.lock())(changed_area);
     }
 }
 
 void mc::Stream::set_frame_posted_callback(
-    std::function<void(geometry::Size const&)> const& callback)
+    std::function<void(geometry::Rectangle const&)> const& callback)
 {
     *frame_callback.lock() = callback;
 }
 
+void mc::Stream::set_frame_presented_callback(
+    std::function<void(mg::BufferID, mg::Presentation const&)> const& callback)
+{
+    presented_state->lock()->callback = callback;
+}
+
 auto mc::Stream::next_submission_for_compositor(void const* id) -> std::shared_ptr<Submission>
 {
     return arbiter->compositor_acquire(id);
@@ -67,3 +128,26 @@ bool mc::Stream::has_submitted_buffer() const
     // Don't need to lock mutex because first_frame_posted is atomic
     return first_frame_posted;
 }
+
+auto mc::Stream::stream_size() const -> geom::Size
+{
+    return *latest_size.lock();
+}
+
+auto mc::Stream::presenter(void const* id) -> std::function<void(mg::Presentation const&)>
+{
+    // By the time the frame is shown this compositor may have taken a newer buffer
+    auto const buffer = arbiter->claimed_buffer(id);
+    if (!buffer)
+        return [](auto const&){};
+
+    return [presented_state = presented_state, buffer = *buffer](mg::Presentation const& presentation)
+        {
+            auto const state = presented_state->lock();
+            if (state->last_presented == buffer)
+                return;
+
+            state->last_presented = buffer;
+            state->callback(buffer, presentation);
+        };
+}
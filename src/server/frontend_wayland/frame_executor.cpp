@@ -16,58 +16,157 @@
 
 #include "frame_executor.h"
 
-#include <mir/main_loop.h>
+#include <mir/graphics/frame.h>
+#include <mir/time/alarm.h>
+#include <mir/time/alarm_factory.h>
+#include <mir/time/clock.h>
 
+#include <map>
 #include <mutex>
+#include <optional>
 #include <vector>
 
 namespace mf = mir::frontend;
+namespace mt = mir::time;
 
 namespace
 {
-auto const delay = std::chrono::milliseconds{16};
+/// When we don't know which output a surface is on, assume it's 60Hz
+auto const default_delay = std::chrono::milliseconds{16};
+/// Surfaces that can't be seen get one frame a second
+auto const throttled_delay = std::chrono::seconds{1};
 }
 
 struct mf::FrameExecutor::Callbacks
 {
+    struct Work
+    {
+        std::function<void()> run;
+        /// The owner passed to spawn_throttled(), or nullptr
+        void const* throttled_for;
+    };
+
     std::mutex mutex;
-    std::vector<std::function<void()>> queued;
+    /// Ordered by when they should run
+    std::multimap<mt::Timestamp, Work> queued;
+    /// Cleared when the FrameExecutor (which owns the alarm) is destroyed
+    mt::Alarm* alarm{nullptr};
 };
 
-mf::FrameExecutor::FrameExecutor(time::AlarmFactory& alarm_factory)
-    : callbacks{std::make_shared<Callbacks>()},
-      alarm{alarm_factory.create_alarm([weak_callbacks = std::weak_ptr<Callbacks>{callbacks}]()
+mf::FrameExecutor::FrameExecutor(time::AlarmFactory& alarm_factory, std::shared_ptr<time::Clock> const& clock)
+    : clock{clock},
+      callbacks{std::make_shared<Callbacks>()},
+      alarm{alarm_factory.create_alarm([weak_callbacks = std::weak_ptr<Callbacks>{callbacks}, clock]()
           {
-              fire_callbacks(weak_callbacks);
+              fire_callbacks(weak_callbacks, *clock);
           })}
 {
+    std::lock_guard lock{callbacks->mutex};
+    callbacks->alarm = alarm.get();
 }
 
-mf::FrameExecutor::~FrameExecutor() = default;
+mf::FrameExecutor::~FrameExecutor()
+{
+    std::lock_guard lock{callbacks->mutex};
+    callbacks->alarm = nullptr;
+}
 
 void mf::FrameExecutor::spawn(std::function<void()>&& work)
 {
-    std::unique_lock lock{callbacks->mutex};
-    bool const needs_alarm = callbacks->queued.empty();
-    callbacks->queued.push_back(std::move(work));
-    lock.unlock();
+    spawn_at(clock->now() + default_delay, std::move(work));
+}
+
+void mf::FrameExecutor::spawn_at_next_refresh(graphics::Presentation const& presentation, std::function<void()>&& work)
+{
+    spawn_at(next_refresh(presentation), std::move(work));
+}
+
+void mf::FrameExecutor::spawn_throttled(void const* owner, std::function<void()>&& work)
+{
+    spawn_at(clock->now() + throttled_delay, std::move(work), owner);
+}
+
+void mf::FrameExecutor::hurry_throttled(void const* owner, std::optional<graphics::Presentation> const& presentation)
+{
+    auto const when = presentation ? next_refresh(presentation.value()) : clock->now() + default_delay;
+
+    std::lock_guard lock{callbacks->mutex};
+    for (auto i = callbacks->queued.begin(); i != callbacks->queued.end();)
+    {
+        if (i->second.throttled_for == owner && i->first > when)
+        {
+            // Goes back in ahead of i, so the loop won't see it again
+            auto work = callbacks->queued.extract(i++);
+            work.key() = when;
+            work.mapped().throttled_for = nullptr;
+            callbacks->queued.insert(std::move(work));
+        }
+        else
+        {
+            ++i;
+        }
+    }
+
+    if (!callbacks->queued.empty())
+    {
+        alarm->reschedule_for(callbacks->queued.begin()->first);
+    }
+}
 
-    if (needs_alarm)
+auto mf::FrameExecutor::next_refresh(graphics::Presentation const& presentation) const -> mt::Timestamp
+{
+    if (presentation.frame.ust.clock_id != CLOCK_MONOTONIC)
     {
-        alarm->reschedule_in(delay);
+        // We can't relate this output's refreshes to our clock
+        return clock->now() + default_delay;
     }
+
+    // Where the output doesn't have a fixed refresh (with VRR, say) keep to a 60Hz timeline from the presentation
+    mt::Duration const refresh = presentation.refresh_interval > std::chrono::nanoseconds::zero() ?
+        std::chrono::duration_cast<mt::Duration>(presentation.refresh_interval) :
+        std::chrono::duration_cast<mt::Duration>(default_delay);
+
+    // Our Timestamps are steady_clock, which is CLOCK_MONOTONIC
+    mt::Timestamp const presented{std::chrono::duration_cast<mt::Duration>(presentation.frame.ust.nanoseconds)};
+    auto const now = clock->now();
+    auto const refreshes_since = now > presented ? (now - presented) / refresh : 0;
+
+    return presented + (refreshes_since + 1) * refresh;
 }
 
-void mf::FrameExecutor::fire_callbacks(std::weak_ptr<Callbacks> const& weak_callbacks)
+void mf::FrameExecutor::spawn_at(time::Timestamp when, std::function<void()>&& work, void const* throttled_for)
+{
+    std::lock_guard lock{callbacks->mutex};
+    callbacks->queued.emplace(when, Callbacks::Work{std::move(work), throttled_for});
+
+    // Rescheduling only adds a timer to the main loop, so it can't call fire_callbacks() while we hold the lock.
+    // Holding it means racing spawn_at()s and fire_callbacks() always leave the alarm set for the earliest work.
+    alarm->reschedule_for(callbacks->queued.begin()->first);
+}
+
+void mf::FrameExecutor::fire_callbacks(std::weak_ptr<Callbacks> const& weak_callbacks, time::Clock const& clock)
 {
     if (auto const callbacks = weak_callbacks.lock())
     {
+        std::vector<std::function<void()>> due;
+
         std::unique_lock lock{callbacks->mutex};
-        auto const queued = std::move(callbacks->queued);
-        callbacks->queued.clear();
+        auto const now = clock.now();
+        auto const first_not_due = callbacks->queued.upper_bound(now);
+        for (auto i = callbacks->queued.begin(); i != first_not_due; ++i)
+        {
+            due.push_back(std::move(i->second.run));
+        }
+        callbacks->queued.erase(callbacks->queued.begin(), first_not_due);
+
+        // Anything left is in the future, so the alarm won't fire (and call us) before we unlock
+        if (!callbacks->queued.empty() && callbacks->alarm)
+        {
+            callbacks->alarm->reschedule_for(callbacks->queued.begin()->first);
+        }
         lock.unlock();
 
-        for (auto const& callback : queued)
+        for (auto const& callback : due)
         {
             callback();
         }
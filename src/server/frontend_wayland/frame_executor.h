@@ -18,38 +18,62 @@
 #define MIR_FRONTEND_FRAME_CALLBACK_EXECUTOR_H
 
 #include <mir/executor.h>
+#include <mir/time/types.h>
 
 #include <memory>
+#include <optional>
 
 namespace mir
 {
+namespace graphics
+{
+struct Presentation;
+}
 namespace time
 {
 class Alarm;
 class AlarmFactory;
+class Clock;
 }
 
 namespace frontend
 {
 
 /// Runs frame callbacks that do not have a buffer to be attached to.
+///
+/// All methods can be called from any thread. Callbacks are run on the main loop thread. The wayland executor is NOT
+/// automatically used.
 class FrameExecutor : public Executor
 {
 public:
-    explicit FrameExecutor(time::AlarmFactory& alarm_factory);
+    FrameExecutor(time::AlarmFactory& alarm_factory, std::shared_ptr<time::Clock> const& clock);
     ~FrameExecutor() override;
 
-    // This can be called from any thread. Given callback is run on the main loop thread. The wayland executor is NOT
-    // automatically used.
+    /// Run work after a typical frame interval, for when we don't know which output it's for
     void spawn(std::function<void()>&& work) override;
 
+    /// Run work at the first refresh after now of the output that made presentation (or, where that output
+    /// doesn't have a fixed refresh rate, the first 60Hz frame after now since presentation)
+    void spawn_at_next_refresh(graphics::Presentation const& presentation, std::function<void()>&& work);
+
+    /// Run work after a long delay, for surfaces that can't currently be seen. The work is kept against owner so it
+    /// can be brought forward by hurry_throttled() if owner is seen again first
+    void spawn_throttled(void const* owner, std::function<void()>&& work);
+
+    /// Move work throttled for owner to the next refresh of the output that made presentation (or, without one, to
+    /// when spawn() would run it)
+    void hurry_throttled(void const* owner, std::optional<graphics::Presentation> const& presentation);
+
 private:
     struct Callbacks;
 
+    std::shared_ptr<time::Clock> const clock;
     std::shared_ptr<Callbacks> const callbacks; // shared_ptr so it can potentially outlive this object
     std::unique_ptr<time::Alarm> const alarm;
 
-    static void fire_callbacks(std::weak_ptr<Callbacks> const& weak_callbacks);
+    auto next_refresh(graphics::Presentation const& presentation) const -> time::Timestamp;
+    void spawn_at(time::Timestamp when, std::function<void()>&& work, void const* throttled_for = nullptr);
+    static void fire_callbacks(std::weak_ptr<Callbacks> const& weak_callbacks, time::Clock const& clock);
 };
 
 }
@@ -0,0 +1,101 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "input_batch.h"
+
+#include <mir/events/pointer_event.h>
+
+#include <algorithm>
+
+namespace mf = mir::frontend;
+
+namespace
+{
+/// A pointer motion that can be merged with its neighbours without the client missing anything but intermediate
+/// positions
+auto is_plain_motion(MirInputEvent const& event) -> bool
+{
+    if (mir_input_event_get_type(&event) != mir_input_event_type_pointer)
+    {
+        return false;
+    }
+
+    auto const& pointer_event = *mir_input_event_get_pointer_event(&event);
+    return mir_pointer_event_action(&pointer_event) == mir_pointer_action_motion &&
+           pointer_event.h_scroll() == mir::events::ScrollAxisH{} &&
+           pointer_event.v_scroll() == mir::events::ScrollAxisV{};
+}
+}
+
+auto mf::InputBatcher::add(std::shared_ptr<MirInputEvent const> const& event) -> std::shared_ptr<Batch>
+{
+    std::shared_ptr<Batch> new_batch;
+
+    auto const batch = open_batch.lock();
+    if (!*batch)
+    {
+        new_batch = std::make_shared<Batch>();
+        *batch = new_batch;
+    }
+    (*batch)->push_back(event);
+
+    return new_batch;
+}
+
+void mf::InputBatcher::handling(std::shared_ptr<Batch> const& batch)
+{
+    auto const open = open_batch.lock();
+    if (*open == batch)
+    {
+        *open = nullptr;
+    }
+}
+
+void mf::InputBatcher::close()
+{
+    *open_batch.lock() = nullptr;
+}
+
+void mf::for_each_motion_run(
+    std::vector<std::shared_ptr<MirInputEvent const>> const& events,
+    std::function<void(std::shared_ptr<MirInputEvent const> const& event)> const& on_event,
+    std::function<void(std::vector<std::shared_ptr<MirPointerEvent const>> const& run)> const& on_motion)
+{
+    for (auto run_start = events.begin(); run_start != events.end();)
+    {
+        if (!is_plain_motion(**run_start))
+        {
+            on_event(*run_start);
+            ++run_start;
+            continue;
+        }
+
+        auto const run_end = std::find_if_not(
+            run_start,
+            events.end(),
+            [](auto const& event) { return is_plain_motion(*event); });
+
+        std::vector<std::shared_ptr<MirPointerEvent const>> run;
+        std::transform(
+            run_start,
+            run_end,
+            back_inserter(run),
+            [](auto const& event) { return std::dynamic_pointer_cast<MirPointerEvent const>(event); });
+        on_motion(run);
+
+        run_start = run_end;
+    }
+}
@@ -0,0 +1,71 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_FRONTEND_INPUT_BATCH_H_
+#define MIR_FRONTEND_INPUT_BATCH_H_
+
+#include <mir/synchronised.h>
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+struct MirInputEvent;
+struct MirPointerEvent;
+
+namespace mir
+{
+namespace frontend
+{
+/// Gathers the input consumed by a surface into batches, each of which costs a single hop to the Wayland thread
+class InputBatcher
+{
+public:
+    using Batch = std::vector<std::shared_ptr<MirInputEvent const>>;
+
+    /**
+     * Add event to the open batch
+     *
+     * \returns A new batch holding event, for the caller to send to the Wayland thread, or nullptr if event joined a
+     *          batch already on its way there
+     */
+    auto add(std::shared_ptr<MirInputEvent const> const& event) -> std::shared_ptr<Batch>;
+
+    /// The Wayland thread has got to batch, so later input starts a new one
+    void handling(std::shared_ptr<Batch> const& batch);
+
+    /// Other work is being sent to the Wayland thread, so later input has to be handled after it
+    void close();
+
+private:
+    /// Null when there is no batch waiting to be handled, or once other work has been sent after it
+    Synchronised<std::shared_ptr<Batch>> open_batch;
+};
+
+/**
+ * Split events into what can be sent to a client together
+ *
+ * Each run of consecutive plain pointer motion (no buttons changing, no scrolling) goes to on_motion, every event of
+ * it included, and each other event to on_event, in the order they occur.
+ */
+void for_each_motion_run(
+    std::vector<std::shared_ptr<MirInputEvent const>> const& events,
+    std::function<void(std::shared_ptr<MirInputEvent const> const& event)> const& on_event,
+    std::function<void(std::vector<std::shared_ptr<MirPointerEvent const>> const& run)> const& on_motion);
+}
+}
+
+#endif // MIR_FRONTEND_INPUT_BATCH_H_
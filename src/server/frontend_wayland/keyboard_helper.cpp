@@ -16,19 +16,129 @@
 
 #include "keyboard_helper.h"
 
-#include "mir/anonymous_shm_file.h"
 #include "mir/input/keymap.h"
 #include "mir/events/keyboard_event.h"
 #include "mir/input/seat.h"
+#include "mir/synchronised.h"
 #include "mir/fatal.h"
 
-#include <cstring> // memcpy
+#include <boost/throw_exception.hpp>
+#include <xkbcommon/xkbcommon.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cstring> // strlen
+#include <system_error>
 #include <unordered_set>
+#include <vector>
 
 namespace mf = mir::frontend;
 namespace mw = mir::wayland;
 namespace mi = mir::input;
 
+/// A keymap's text, in a sealed file every client can map
+class mf::KeyboardHelper::KeymapFile
+{
+public:
+    KeymapFile(char const* text, size_t size)
+        : fd_{memfd_create("mir-keymap", MFD_CLOEXEC | MFD_ALLOW_SEALING)},
+          size_{size}
+    {
+        if (fd_ < 0)
+        {
+            BOOST_THROW_EXCEPTION((std::system_error{errno, std::system_category(), "Failed to create keymap file"}));
+        }
+        // Written at explicit offsets, leaving the file offset (which every client's copy of the fd shares) at the start
+        for (size_t written = 0; written < size;)
+        {
+            auto const result = pwrite(fd_, text + written, size - written, static_cast<off_t>(written));
+            if (result < 0)
+            {
+                BOOST_THROW_EXCEPTION((std::system_error{errno, std::system_category(), "Failed to write keymap file"}));
+            }
+            written += result;
+        }
+        // Every client maps the same file (which the protocol allows for, as clients must map it MAP_PRIVATE), so no
+        // client may change it
+        if (fcntl(fd_, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL) < 0)
+        {
+            BOOST_THROW_EXCEPTION((std::system_error{errno, std::system_category(), "Failed to seal keymap file"}));
+        }
+    }
+
+    auto fd() const -> Fd const& { return fd_; }
+    auto size() const -> size_t { return size_; }
+
+private:
+    Fd const fd_;
+    size_t const size_;
+};
+
+namespace
+{
+/// Keymap files in use by any keyboard, so each keymap is only compiled and serialised once for all clients
+class KeymapFileCache
+{
+public:
+    auto file_for(std::shared_ptr<mi::Keymap> const& keymap) -> std::shared_ptr<mf::KeyboardHelper::KeymapFile>
+    {
+        auto const locked = state.lock();
+
+        std::erase_if(locked->entries, [](Entry const& entry) { return entry.file.expired(); });
+
+        for (auto const& entry : locked->entries)
+        {
+            if (entry.keymap == keymap || entry.keymap->matches(*keymap))
+            {
+                if (auto const file = entry.file.lock())
+                {
+                    return file;
+                }
+            }
+        }
+
+        if (!locked->context)
+        {
+            locked->context.reset(xkb_context_new(XKB_CONTEXT_NO_FLAGS));
+            if (!locked->context)
+            {
+                mir::fatal_error("Failed to create XKB context");
+            }
+        }
+
+        auto const compiled = keymap->make_unique_xkb_keymap(locked->context.get());
+        std::unique_ptr<char, void(*)(void*)> const text{
+            xkb_keymap_get_as_string(compiled.get(), XKB_KEYMAP_FORMAT_TEXT_V1),
+            free};
+        // so the null terminator is included
+        auto const file = std::make_shared<mf::KeyboardHelper::KeymapFile>(text.get(), strlen(text.get()) + 1);
+
+        locked->entries.push_back({keymap, file});
+        return file;
+    }
+
+private:
+    struct Entry
+    {
+        std::shared_ptr<mi::Keymap> keymap;
+        std::weak_ptr<mf::KeyboardHelper::KeymapFile> file;
+    };
+
+    struct State
+    {
+        std::unique_ptr<xkb_context, void(*)(xkb_context*)> context{nullptr, &xkb_context_unref};
+        std::vector<Entry> entries;
+    };
+
+    /// In theory a single process could run multiple Wayland displays, each with its own thread
+    mir::Synchronised<State> state;
+};
+
+KeymapFileCache keymap_file_cache;
+}
+
 mf::KeyboardHelper::KeyboardHelper(
     KeyboardCallbacks* callbacks,
     std::shared_ptr<mi::Keymap> const& initial_keymap,
@@ -36,15 +146,8 @@ mf::KeyboardHelper::KeyboardHelper(
     bool enable_key_repeat)
     : callbacks{callbacks},
       mir_seat{seat},
-      current_keymap{nullptr}, // will be set later in the constructor by set_keymap()
-      compiled_keymap{nullptr, &xkb_keymap_unref},
-      context{xkb_context_new(XKB_CONTEXT_NO_FLAGS), &xkb_context_unref}
+      current_keymap{nullptr} // will be set later in the constructor by set_keymap()
 {
-    if (!context)
-    {
-        fatal_error("Failed to create XKB context");
-    }
-
     /* The wayland::Keyboard constructor has already run, creating the keyboard
      * resource. It is thus safe to send a keymap event to it; the client will receive
      * the keyboard object before this event.
@@ -131,19 +234,9 @@ void mf::KeyboardHelper::set_keymap(std::shared_ptr<mi::Keymap> const& new_keyma
     }
 
     current_keymap = new_keymap;
-    compiled_keymap = new_keymap->make_unique_xkb_keymap(context.get());
-
-    std::unique_ptr<char, void(*)(void*)> buffer{xkb_keymap_get_as_string(
-        compiled_keymap.get(),
-        XKB_KEYMAP_FORMAT_TEXT_V1),
-        free};
-    // so the null terminator is included
-    auto length = strlen(buffer.get()) + 1;
-
-    mir::AnonymousShmFile shm_buffer{length};
-    memcpy(shm_buffer.base_ptr(), buffer.get(), length);
+    keymap_file = keymap_file_cache.file_for(new_keymap);
 
-    callbacks->send_keymap_xkb_v1(Fd{IntOwnedFd{shm_buffer.fd()}}, length);
+    callbacks->send_keymap_xkb_v1(keymap_file->fd(), keymap_file->size());
 }
 
 void mf::KeyboardHelper::set_modifiers(MirXkbModifiers const& new_modifiers)
@@ -26,11 +26,6 @@
 struct MirEvent;
 struct MirKeyboardEvent;
 
-// from <xkbcommon/xkbcommon.h>
-struct xkb_keymap;
-struct xkb_state;
-struct xkb_context;
-
 namespace mir
 {
 namespace input
@@ -73,6 +68,8 @@ public:
     /// Updates the modifiers from the seat
     void refresh_modifiers();
 
+    class KeymapFile;
+
 private:
     void handle_keyboard_event(std::shared_ptr<MirKeyboardEvent const> const& event);
     void set_keymap(std::shared_ptr<mir::input::Keymap> const& new_keymap);
@@ -82,8 +79,8 @@ private:
     std::shared_ptr<input::Seat> const mir_seat;
     MirXkbModifiers modifiers;
     std::shared_ptr<mir::input::Keymap> current_keymap;
-    std::unique_ptr<xkb_keymap, void (*)(xkb_keymap *)> compiled_keymap;
-    std::unique_ptr<xkb_context, void (*)(xkb_context *)> const context;
+    /// Shared with every other keyboard using the same keymap
+    std::shared_ptr<KeymapFile> keymap_file;
 };
 }
 }
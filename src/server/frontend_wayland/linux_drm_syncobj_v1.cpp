@@ -0,0 +1,227 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "linux_drm_syncobj_v1.h"
+#include "mir/wayland/protocol_error.h"
+#include "shm.h"
+#include "wl_surface.h"
+
+#include <boost/throw_exception.hpp>
+#include <wayland-server-core.h>
+
+#include <system_error>
+
+namespace mf = mir::frontend;
+namespace mg = mir::graphics;
+namespace mw = mir::wayland;
+
+namespace
+{
+class Timeline : public mw::LinuxDrmSyncobjTimelineV1
+{
+public:
+    Timeline(wl_resource* new_timeline, std::shared_ptr<mg::DRMTimeline> timeline)
+        : LinuxDrmSyncobjTimelineV1(new_timeline, Version<1>{}),
+          timeline{std::move(timeline)}
+    {
+    }
+
+    static auto from(wl_resource* resource) -> Timeline*
+    {
+        return dynamic_cast<Timeline*>(LinuxDrmSyncobjTimelineV1::from(resource));
+    }
+
+    /// Shared with the points set on it, which outlive this object
+    std::shared_ptr<mg::DRMTimeline> const timeline;
+};
+
+class ManagerInstance : public mw::LinuxDrmSyncobjManagerV1
+{
+public:
+    ManagerInstance(wl_resource* resource, mir::Fd drm_fd)
+        : LinuxDrmSyncobjManagerV1(resource, Version<1>{}),
+          drm_fd{std::move(drm_fd)}
+    {
+    }
+
+private:
+    void get_surface(wl_resource* id, wl_resource* surface) override
+    {
+        try
+        {
+            new mf::LinuxDrmSyncobjSurfaceV1(id, mf::WlSurface::from(surface));
+        }
+        catch (std::logic_error const&)
+        {
+            // We get a std::logic_error if the surface already had a syncobj surface; translate to protocol exception here
+            throw mw::ProtocolError{
+                resource,
+                Error::surface_exists,
+                "Surface already has an explicit synchronization object associated"};
+        }
+    }
+
+    void import_timeline(wl_resource* id, mir::Fd fd) override
+    {
+        try
+        {
+            new Timeline(id, std::make_shared<mg::DRMTimeline>(drm_fd, fd));
+        }
+        catch (std::system_error const& error)
+        {
+            throw mw::ProtocolError{
+                resource,
+                Error::invalid_timeline,
+                "Failed to import DRM syncobj timeline: %s",
+                error.what()};
+        }
+    }
+
+    mir::Fd const drm_fd;
+};
+}
+
+mf::LinuxDrmSyncobjManagerV1::LinuxDrmSyncobjManagerV1(wl_display* display, mir::Fd drm_fd)
+    : Global(display, Version<1>{}),
+      drm_fd{std::move(drm_fd)}
+{
+}
+
+void mf::LinuxDrmSyncobjManagerV1::bind(wl_resource* new_resource)
+{
+    new ManagerInstance(new_resource, drm_fd);
+}
+
+mf::LinuxDrmSyncobjSurfaceV1::LinuxDrmSyncobjSurfaceV1(wl_resource* new_surface, WlSurface* surface)
+    : wayland::LinuxDrmSyncobjSurfaceV1(new_surface, Version<1>{})
+{
+    surface->associate_syncobj_surface(wayland::make_weak<LinuxDrmSyncobjSurfaceV1>(this));
+    this->surface = wayland::make_weak<wayland::Surface>(surface);
+}
+
+void mf::LinuxDrmSyncobjSurfaceV1::commit(WlSurfaceState& state)
+{
+    bool const buffer_attached = state.buffer && state.buffer.value();
+
+    if (auto const error = points_error(buffer_attached, acquire_point, release_point))
+    {
+        throw wayland::ProtocolError{resource, error->code, "%s", error->message.c_str()};
+    }
+    if (!buffer_attached)
+    {
+        return;
+    }
+    if (ShmBuffer::from(state.buffer.value().value()))
+    {
+        unsupported_buffer();
+    }
+
+    state.acquire_point = std::exchange(acquire_point, std::nullopt);
+    state.release_point = std::exchange(release_point, std::nullopt);
+}
+
+auto mf::LinuxDrmSyncobjSurfaceV1::points_error(
+    bool buffer_attached,
+    std::optional<mg::DRMTimelinePoint> const& acquire,
+    std::optional<mg::DRMTimelinePoint> const& release) -> std::optional<PointsError>
+{
+    if (!buffer_attached)
+    {
+        if (acquire || release)
+        {
+            return PointsError{Error::no_buffer, "Timeline points set without attaching a buffer"};
+        }
+        return std::nullopt;
+    }
+
+    if (!acquire)
+    {
+        return PointsError{Error::no_acquire_point, "Buffer attached without an acquire point"};
+    }
+    if (!release)
+    {
+        return PointsError{Error::no_release_point, "Buffer attached without a release point"};
+    }
+    if (acquire->timeline == release->timeline && acquire->point >= release->point)
+    {
+        return PointsError{
+            Error::conflicting_points,
+            "Acquire point " + std::to_string(acquire->point) +
+                " is not before release point " + std::to_string(release->point) + " on the same timeline"};
+    }
+    return std::nullopt;
+}
+
+void mf::LinuxDrmSyncobjSurfaceV1::unsupported_buffer()
+{
+    throw wayland::ProtocolError{
+        resource,
+        Error::unsupported_buffer,
+        "Buffer does not support explicit synchronization"};
+}
+
+void mf::LinuxDrmSyncobjSurfaceV1::set_acquire_point(wl_resource* timeline, uint32_t point_hi, uint32_t point_lo)
+{
+    acquire_point = point_on(timeline, point_hi, point_lo);
+}
+
+void mf::LinuxDrmSyncobjSurfaceV1::set_release_point(wl_resource* timeline, uint32_t point_hi, uint32_t point_lo)
+{
+    release_point = point_on(timeline, point_hi, point_lo);
+}
+
+auto mf::LinuxDrmSyncobjSurfaceV1::point_on(wl_resource* timeline, uint32_t point_hi, uint32_t point_lo) const
+    -> mg::DRMTimelinePoint
+{
+    if (!surface)
+    {
+        throw wayland::ProtocolError{
+            resource,
+            Error::no_surface,
+            "Surface associated with explicit synchronization object has been destroyed"};
+    }
+
+    return mg::DRMTimelinePoint{
+        Timeline::from(timeline)->timeline,
+        (static_cast<uint64_t>(point_hi) << 32) | point_lo};
+}
+
+mf::DRMTimelinePointWatch::DRMTimelinePointWatch(
+    wl_event_loop* loop,
+    mg::DRMTimelinePoint const& point,
+    std::function<void()> on_fence)
+    : notify{point.timeline->eventfd_for_fence(point.point)},
+      on_fence{std::move(on_fence)},
+      source{wl_event_loop_add_fd(loop, notify, WL_EVENT_READABLE, &on_readable, this)}
+{
+    if (!source)
+    {
+        BOOST_THROW_EXCEPTION((std::system_error{errno, std::system_category(), "Failed to watch DRM timeline point"}));
+    }
+}
+
+mf::DRMTimelinePointWatch::~DRMTimelinePointWatch()
+{
+    wl_event_source_remove(source);
+}
+
+int mf::DRMTimelinePointWatch::on_readable(int, uint32_t, void* data)
+{
+    // on_fence may well destroy this watch, so don't leave it running from a destroyed std::function
+    auto const on_fence = static_cast<DRMTimelinePointWatch*>(data)->on_fence;
+    on_fence();
+    return 0;
+}
@@ -0,0 +1,126 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_FRONTEND_LINUX_DRM_SYNCOBJ_V1_H
+#define MIR_FRONTEND_LINUX_DRM_SYNCOBJ_V1_H
+
+#include "mir/wayland/weak.h"
+#include "linux-drm-syncobj-v1_wrapper.h"
+#include "wayland_wrapper.h"
+
+#include "mir/fd.h"
+#include "mir/graphics/drm_syncobj.h"
+
+#include <functional>
+#include <optional>
+#include <string>
+
+struct wl_event_loop;
+struct wl_event_source;
+
+namespace mir::frontend
+{
+class WlSurface;
+struct WlSurfaceState;
+
+class LinuxDrmSyncobjManagerV1 : public wayland::LinuxDrmSyncobjManagerV1::Global
+{
+public:
+    /// \param drm_fd   The DRM device in which to import clients' timelines
+    LinuxDrmSyncobjManagerV1(wl_display* display, mir::Fd drm_fd);
+
+private:
+    void bind(wl_resource* new_wp_linux_drm_syncobj_manager_v1) override;
+
+    mir::Fd const drm_fd;
+};
+
+/**
+ * Manages the wp_linux_drm_syncobj_surface_v1 state
+ *
+ * Threadsafety: This is a Wayland object, and should only be accessed from the Wayland thread
+ */
+class LinuxDrmSyncobjSurfaceV1 : public wayland::LinuxDrmSyncobjSurfaceV1
+{
+public:
+    LinuxDrmSyncobjSurfaceV1(wl_resource* new_surface, WlSurface* surface);
+
+    /**
+     * Move the timeline points set since the last commit into the surface state being committed
+     *
+     * \throws A wayland::ProtocolError if the points don't fit the committed buffer
+     */
+    void commit(WlSurfaceState& state);
+
+    /// \throws A wayland::ProtocolError, as the committed buffer can't be explicitly synchronised
+    [[noreturn]] void unsupported_buffer();
+
+    /// A protocol error in the timeline points of a commit
+    struct PointsError
+    {
+        uint32_t code;
+        std::string message;
+    };
+
+    /**
+     * Check the acquire and release points committed with (or without) a buffer
+     *
+     * \returns The protocol error the commit raises, if any
+     */
+    static auto points_error(
+        bool buffer_attached,
+        std::optional<graphics::DRMTimelinePoint> const& acquire,
+        std::optional<graphics::DRMTimelinePoint> const& release) -> std::optional<PointsError>;
+
+private:
+    void set_acquire_point(wl_resource* timeline, uint32_t point_hi, uint32_t point_lo) override;
+    void set_release_point(wl_resource* timeline, uint32_t point_hi, uint32_t point_lo) override;
+
+    auto point_on(wl_resource* timeline, uint32_t point_hi, uint32_t point_lo) const -> graphics::DRMTimelinePoint;
+
+    wayland::Weak<wayland::Surface> surface;
+    std::optional<graphics::DRMTimelinePoint> acquire_point;
+    std::optional<graphics::DRMTimelinePoint> release_point;
+};
+
+/**
+ * Calls on_fence, from the Wayland event loop, once a timeline point has a fence
+ *
+ * Threadsafety: This should only be created and destroyed on the Wayland thread
+ */
+class DRMTimelinePointWatch
+{
+public:
+    /// \throws std::system_error if the point can't be watched
+    DRMTimelinePointWatch(
+        wl_event_loop* loop,
+        graphics::DRMTimelinePoint const& point,
+        std::function<void()> on_fence);
+    ~DRMTimelinePointWatch();
+
+    DRMTimelinePointWatch(DRMTimelinePointWatch const&) = delete;
+    DRMTimelinePointWatch& operator=(DRMTimelinePointWatch const&) = delete;
+
+private:
+    static int on_readable(int fd, uint32_t mask, void* data);
+
+    mir::Fd const notify;
+    std::function<void()> const on_fence;
+    wl_event_source* const source;
+};
+}
+
+#endif // MIR_FRONTEND_LINUX_DRM_SYNCOBJ_V1_H
@@ -29,6 +29,8 @@
 #include "desktop_file_manager.h"
 #include "foreign_toplevel_manager_v1.h"
 #include "wp_viewporter.h"
+#include "wp_presentation.h"
+#include "linux_drm_syncobj_v1.h"
 
 #include "mir/main_loop.h"
 #include "mir/thread_name.h"
@@ -66,7 +68,7 @@ public:
     WlCompositor(
         struct wl_display* display,
         std::shared_ptr<mir::Executor> const& wayland_executor,
-        std::shared_ptr<mir::Executor> const& frame_callback_executor,
+        std::shared_ptr<FrameExecutor> const& frame_callback_executor,
         std::shared_ptr<mg::GraphicBufferAllocator> const& allocator)
         : Global(display, Version<4>()),
           allocator{allocator},
@@ -80,7 +82,7 @@ public:
 private:
     std::shared_ptr<mg::GraphicBufferAllocator> const allocator;
     std::shared_ptr<mir::Executor> const wayland_executor;
-    std::shared_ptr<mir::Executor> const frame_callback_executor;
+    std::shared_ptr<FrameExecutor> const frame_callback_executor;
     std::map<std::pair<wl_client*, uint32_t>, std::vector<std::function<void(WlSurface*)>>> surface_callbacks;
 
     class Instance : wayland::Compositor
@@ -283,7 +285,7 @@ mf::WaylandConnector::WaylandConnector(
     compositor_global = std::make_unique<mf::WlCompositor>(
         display.get(),
         executor,
-        std::make_shared<FrameExecutor>(*main_loop),
+        std::make_shared<FrameExecutor>(*main_loop, clock),
         this->allocator);
     subcompositor_global = std::make_unique<mf::WlSubcompositor>(display.get());
     seat_global = std::make_unique<mf::WlSeat>(
@@ -333,6 +335,11 @@ mf::WaylandConnector::WaylandConnector(
     shm_global = std::make_unique<WlShm>(display.get(), executor);
 
     viewporter = std::make_unique<WpViewporter>(display.get());
+    presentation = std::make_unique<WpPresentation>(display.get());
+    if (auto drm_fd = this->allocator->explicit_sync_device())
+    {
+        drm_syncobj = std::make_unique<LinuxDrmSyncobjManagerV1>(display.get(), std::move(*drm_fd));
+    }
 
     char const* wayland_display = nullptr;
 
@@ -86,6 +86,8 @@ class WlShm;
 class WlSubcompositor;
 class WlSurface;
 class WpViewporter;
+class WpPresentation;
+class LinuxDrmSyncobjManagerV1;
 class DesktopFileManager;
 
 class WaylandExtensions
@@ -212,6 +214,8 @@ private:
     std::unique_ptr<WlDataDeviceManager> data_device_manager_global;
     std::unique_ptr<WlShm> shm_global;
     std::unique_ptr<WpViewporter> viewporter;
+    std::unique_ptr<WpPresentation> presentation;
+    std::unique_ptr<LinuxDrmSyncobjManagerV1> drm_syncobj;
     std::shared_ptr<Executor> const executor;
     std::shared_ptr<graphics::GraphicBufferAllocator> const allocator;
     std::shared_ptr<shell::Shell> const shell;
@@ -15,6 +15,7 @@
  */
 
 #include "wayland_input_dispatcher.h"
+#include "input_batch.h"
 #include "wl_surface.h"
 #include "wl_seat.h"
 #include "wl_pointer.h"
@@ -73,3 +74,25 @@ void mf::WaylandInputDispatcher::handle_event(std::shared_ptr<MirInputEvent cons
         break;
     }
 }
+
+void mf::WaylandInputDispatcher::handle_events(std::vector<std::shared_ptr<MirInputEvent const>> const& events)
+{
+    for_each_motion_run(
+        events,
+        [this](auto const& event)
+        {
+            handle_event(event);
+        },
+        [this](auto const& motion)
+        {
+            if (!wl_surface)
+            {
+                return;
+            }
+
+            seat->for_each_listener(wl_surface.value().client, [&](PointerEventDispatcher* pointer)
+                {
+                    pointer->coalesced_motion(motion, wl_surface.value());
+                });
+        });
+}
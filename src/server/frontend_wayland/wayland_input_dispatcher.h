@@ -23,6 +23,7 @@
 
 #include <memory>
 #include <chrono>
+#include <vector>
 
 struct wl_client;
 struct MirInputEvent;
@@ -50,6 +51,10 @@ public:
 
     void handle_event(std::shared_ptr<MirInputEvent const> const& event);
 
+    /// Handles events received together, sending each run of consecutive pointer motion as a single motion (while
+    /// still sending every relative motion)
+    void handle_events(std::vector<std::shared_ptr<MirInputEvent const>> const& events);
+
 private:
     WaylandInputDispatcher(WaylandInputDispatcher const&) = delete;
     WaylandInputDispatcher& operator=(WaylandInputDispatcher const&) = delete;
@@ -116,12 +116,33 @@ void mf::WaylandSurfaceObserver::placed_relative(ms::Surface const*, geometry::R
 
 void mf::WaylandSurfaceObserver::input_consumed(ms::Surface const*, std::shared_ptr<MirEvent const> const& event)
 {
-    if (mir_event_get_type(event.get()) == mir_event_type_input)
+    if (mir_event_get_type(event.get()) != mir_event_type_input)
     {
-        run_on_wayland_thread_unless_window_destroyed(
-            [event](Impl* impl, WindowWlSurfaceRole*)
+        return;
+    }
+
+    auto const input_event = std::dynamic_pointer_cast<MirInputEvent const>(event);
+
+    if (mir_input_event_get_type(input_event.get()) == mir_input_event_type_key &&
+        mir_keyboard_event_action(mir_input_event_get_keyboard_event(input_event.get())) == mir_keyboard_action_repeat)
+    {
+        // Wayland clients repeat keys themselves, as told by wl_keyboard.repeat_info, so there's no need to wake the
+        // Wayland thread for our repeats
+        return;
+    }
+
+    if (auto new_batch = impl->input_batcher.add(input_event))
+    {
+        // Everything consumed before the Wayland thread gets to this batch goes with it, in a single hop
+        wayland_executor.spawn(
+            [impl=impl, batch=std::move(new_batch)]
             {
-                impl->input_dispatcher->handle_event(std::dynamic_pointer_cast<MirInputEvent const>(event));
+                impl->input_batcher.handling(batch);
+
+                if (impl->window)
+                {
+                    impl->input_dispatcher->handle_events(*batch);
+                }
             });
     }
 }
@@ -156,6 +177,9 @@ void mf::WaylandSurfaceObserver::rescale_output(ms::Surface const*, graphics::Di
 void mf::WaylandSurfaceObserver::run_on_wayland_thread_unless_window_destroyed(
     std::function<void(Impl* impl, WindowWlSurfaceRole* window)>&& work)
 {
+    // Input consumed after this must be handled after it
+    impl->input_batcher.close();
+
     wayland_executor.spawn(
         [impl=impl, work=std::move(work)]
         {
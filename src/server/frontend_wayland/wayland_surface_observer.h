@@ -18,6 +18,7 @@
 #define MIR_FRONTEND_WAYLAND_SURFACE_OBSERVER_H_
 
 #include "wayland_input_dispatcher.h"
+#include "input_batch.h"
 #include <mir/scene/null_surface_observer.h>
 #include <mir/wayland/weak.h>
 
@@ -95,6 +96,8 @@ private:
         geometry::Size window_size{};
         std::optional<geometry::Size> requested_size{};
         MirWindowState current_state{mir_window_state_unknown};
+
+        InputBatcher input_batcher;
     };
 
     void run_on_wayland_thread_unless_window_destroyed(
@@ -219,6 +219,21 @@ void mir::frontend::WlPointer::event(std::shared_ptr<MirPointerEvent const> cons
     maybe_frame();
 }
 
+void mf::WlPointer::coalesced_motion(
+    std::vector<std::shared_ptr<MirPointerEvent const>> const& events,
+    WlSurface& root_surface)
+{
+    // Relative pointer consumers (games, 3D viewports) want every motion the device reported, each in its own frame.
+    // Everyone else only needs to know where the pointer ended up.
+    for (auto i = events.begin(); i != std::prev(events.end()); ++i)
+    {
+        relative_motion(*i);
+        maybe_frame();
+    }
+
+    event(events.back(), root_surface);
+}
+
 void mf::WlPointer::leave(std::optional<std::shared_ptr<MirPointerEvent const>> const& event)
 {
     if (!surface_under_cursor)
@@ -28,6 +28,7 @@
 #include <functional>
 #include <optional>
 #include <set>
+#include <vector>
 
 struct MirInputEvent;
 typedef unsigned int MirPointerButtons;
@@ -74,6 +75,9 @@ public:
     /// Convert the Mir event into Wayland events and send them to the client. root_surface is the one that received
     /// the Mir event, but the final Wayland event may be sent to a subsurface.
     void event(std::shared_ptr<MirPointerEvent const> const& event, WlSurface& root_surface);
+    /// Send a run of consecutive plain motion events as a single motion, but with the relative motion of each. events
+    /// must not be empty.
+    void coalesced_motion(std::vector<std::shared_ptr<MirPointerEvent const>> const& events, WlSurface& root_surface);
     void leave(std::optional<std::shared_ptr<MirPointerEvent const>> const& event);
 
     struct Cursor;
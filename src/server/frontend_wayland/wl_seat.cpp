@@ -382,6 +382,21 @@ void mf::PointerEventDispatcher::event(std::shared_ptr<MirPointerEvent const> co
     }
 }
 
+void mf::PointerEventDispatcher::coalesced_motion(
+    std::vector<std::shared_ptr<MirPointerEvent const>> const& events,
+    WlSurface& root_surface)
+{
+    if (wl_data_device)
+    {
+        // Drag-and-drop only follows the position
+        wl_data_device.value().event(events.back(), root_surface);
+    }
+    else if (wl_pointer)
+    {
+        wl_pointer.value().coalesced_motion(events, root_surface);
+    }
+}
+
 void mf::PointerEventDispatcher::start_dispatch_to_data_device(WlDataDevice* wl_data_device)
 {
     this->wl_data_device = wayland::Weak<WlDataDevice>{wl_data_device};
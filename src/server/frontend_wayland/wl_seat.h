@@ -58,6 +58,8 @@ public:
     explicit PointerEventDispatcher(WlPointer* wl_pointer);
 
     void event(std::shared_ptr<MirPointerEvent const> const& event, WlSurface& root_surface);
+    /// See WlPointer::coalesced_motion()
+    void coalesced_motion(std::vector<std::shared_ptr<MirPointerEvent const>> const& events, WlSurface& root_surface);
 
     void start_dispatch_to_data_device(WlDataDevice* wl_data_device);
     void stop_dispatch_to_data_device();
@@ -38,16 +38,22 @@
 #include "mir/compositor/buffer_stream.h"
 #include "mir/executor.h"
 #include "mir/graphics/graphic_buffer_allocator.h"
+#include "mir/graphics/scanout_feedback.h"
 #include "mir/scene/surface.h"
+#include "mir/scene/null_surface_observer.h"
 #include "mir/shell/surface_specification.h"
 #include "mir/log.h"
 #include "wp_viewporter.h"
+#include "linux_drm_syncobj_v1.h"
+#include "wp_presentation.h"
+#include "frame_executor.h"
 
 #include <chrono>
 #include <boost/throw_exception.hpp>
 #include <cmath>
 #include <limits>
 #include <optional>
+#include <system_error>
 #include <wayland-server-protocol.h>
 
 namespace mf = mir::frontend;
@@ -55,6 +61,23 @@ namespace geom = mir::geometry;
 namespace mw = mir::wayland;
 namespace msh = mir::shell;
 
+namespace
+{
+/// Clients commonly pass INT32_MAX to mean "everything", so make sure the far edge remains representable
+auto sanitised_damage(int32_t x, int32_t y, int32_t width, int32_t height) -> std::optional<geom::Rectangle>
+{
+    if (width <= 0 || height <= 0)
+    {
+        return std::nullopt;
+    }
+
+    auto const max = std::numeric_limits<int32_t>::max();
+    width = std::min(width, max - std::max(x, 0));
+    height = std::min(height, max - std::max(y, 0));
+    return geom::Rectangle{{x, y}, {width, height}};
+}
+}
+
 mf::WlSurfaceState::Callback::Callback(wl_resource* new_resource)
     : mw::Callback{new_resource, Version<1>()}
 {
@@ -74,13 +97,31 @@ void mf::WlSurfaceState::update_from(WlSurfaceState const& source)
     if (source.input_shape)
         input_shape = source.input_shape;
 
+    if (source.opaque_region)
+        opaque_region = source.opaque_region;
+
     frame_callbacks.insert(end(frame_callbacks),
                            begin(source.frame_callbacks),
                            end(source.frame_callbacks));
 
+    presentation_feedbacks.insert(
+        end(presentation_feedbacks),
+        begin(source.presentation_feedbacks),
+        end(source.presentation_feedbacks));
+
     if (source.viewport)
         viewport = source.viewport;
 
+    if (source.buffer)
+    {
+        // The points belong to the buffer they were committed with
+        acquire_point = source.acquire_point;
+        release_point = source.release_point;
+    }
+
+    surface_damage.insert(end(surface_damage), begin(source.surface_damage), end(source.surface_damage));
+    buffer_damage.insert(end(buffer_damage), begin(source.buffer_damage), end(source.buffer_damage));
+
     if (source.surface_data_invalidated)
         surface_data_invalidated = true;
 }
@@ -89,13 +130,82 @@ bool mf::WlSurfaceState::surface_data_needs_refresh() const
 {
     return offset ||
            input_shape ||
+           opaque_region ||
            surface_data_invalidated;
 }
 
+auto mf::WlSurfaceState::buffer_space_damage(float buffer_scale) const -> std::optional<geom::Rectangles>
+{
+    if (surface_damage.empty() && buffer_damage.empty())
+    {
+        return std::nullopt;
+    }
+
+    geom::Rectangles damage;
+    for (auto const& rect : surface_damage)
+    {
+        // Round outwards so a fractional scale never loses damage
+        auto const left = std::floor(static_cast<double>(rect.left().as_int()) * buffer_scale);
+        auto const top = std::floor(static_cast<double>(rect.top().as_int()) * buffer_scale);
+        auto const right = std::ceil(static_cast<double>(rect.right().as_int()) * buffer_scale);
+        auto const bottom = std::ceil(static_cast<double>(rect.bottom().as_int()) * buffer_scale);
+        auto const max = static_cast<double>(std::numeric_limits<int32_t>::max());
+        damage.add({
+            {static_cast<int>(left), static_cast<int>(top)},
+            {static_cast<int>(std::min(right, max) - left), static_cast<int>(std::min(bottom, max) - top)}});
+    }
+    for (auto const& rect : buffer_damage)
+    {
+        damage.add(rect);
+    }
+    return damage;
+}
+
+class mf::WlSurface::VisibilityObserver : public scene::NullSurfaceObserver
+{
+public:
+    VisibilityObserver(mw::Weak<WlSurface> surface, std::shared_ptr<Executor> const& executor)
+        : executor{executor},
+          surface{std::move(surface)}
+    {
+    }
+
+    void attrib_changed(scene::Surface const*, MirWindowAttrib attrib, int value) override
+    {
+        if (attrib == mir_window_attrib_visibility && value == mir_window_visibility_exposed)
+        {
+            hurry_frame_callbacks();
+        }
+    }
+
+    void hidden_set_to(scene::Surface const*, bool hide) override
+    {
+        if (!hide)
+        {
+            hurry_frame_callbacks();
+        }
+    }
+
+private:
+    std::shared_ptr<Executor> const executor;
+    mw::Weak<WlSurface> const surface;
+
+    void hurry_frame_callbacks()
+    {
+        executor->spawn([surface = surface]()
+            {
+                if (surface)
+                {
+                    surface.value().hurry_frame_callbacks();
+                }
+            });
+    }
+};
+
 mf::WlSurface::WlSurface(
     wl_resource* new_resource,
     std::shared_ptr<Executor> const& wayland_executor,
-    std::shared_ptr<Executor> const& frame_callback_executor,
+    std::shared_ptr<FrameExecutor> const& frame_callback_executor,
     std::shared_ptr<graphics::GraphicBufferAllocator> const& allocator)
     : Surface(new_resource, Version<4>()),
         session{client->client_session()},
@@ -104,8 +214,32 @@ mf::WlSurface::WlSurface(
         wayland_executor{wayland_executor},
         frame_callback_executor{frame_callback_executor},
         null_role{this},
-        role{&null_role}
+        role{&null_role},
+        visibility_observer{std::make_shared<VisibilityObserver>(mw::make_weak(this), wayland_executor)}
 {
+    stream->set_frame_presented_callback(
+        [executor = wayland_executor, weak_self = mw::make_weak(this)](
+            graphics::BufferID buffer, graphics::Presentation const& presentation)
+        {
+            executor->spawn([weak_self, buffer, presentation]()
+                {
+                    if (weak_self)
+                    {
+                        weak_self.value().buffer_presented(buffer, presentation);
+                    }
+                });
+        });
+
+    on_scene_surface_created([weak_self = mw::make_weak(this)](std::shared_ptr<scene::Surface> scene_surface)
+        {
+            if (weak_self)
+            {
+                // Use immediate_executor so uninteresting observations are processed quickly, the observer punts
+                // interesting ones to the wayland executor itself
+                scene_surface->register_interest(weak_self.value().visibility_observer, mir::immediate_executor);
+                weak_self.value().observed_scene_surface = scene_surface;
+            }
+        });
 }
 
 mf::WlSurface::~WlSurface()
@@ -115,6 +249,19 @@ mf::WlSurface::~WlSurface()
     // all bases and non-variant members have already been destroyed."
     try
     {
+        if (auto const scene_surface = observed_scene_surface.lock())
+        {
+            scene_surface->unregister_interest(*visibility_observer);
+        }
+
+        // Whatever was waiting to be shown won't be now
+        presentation_feedback.unmapped();
+        PresentationFeedbackTracker::discard(pending.presentation_feedbacks);
+        for (auto const& state : held_commits)
+        {
+            PresentationFeedbackTracker::discard(state.presentation_feedbacks);
+        }
+
         // Destroy the buffer stream first, as surface_destroyed() may throw
         session->destroy_buffer_stream(stream);
         role->surface_destroyed();
@@ -219,7 +366,7 @@ void mf::WlSurface::populate_surface_data(std::vector<shell::StreamSpecification
 {
     geometry::Displacement offset = parent_offset + offset_;
 
-    buffer_streams.push_back(msh::StreamSpecification{stream, offset});
+    buffer_streams.push_back(msh::StreamSpecification{stream, offset, opaque_region});
     geom::Rectangle surface_rect = {geom::Point{} + offset, buffer_size_.value_or(geom::Size{})};
     if (input_shape)
     {
@@ -271,6 +418,37 @@ void mf::WlSurface::send_frame_callbacks()
     frame_callbacks.clear();
 }
 
+void mf::WlSurface::schedule_frame_callbacks(std::function<void()>&& send)
+{
+    auto const surface = scene_surface().value_or(nullptr);
+    if (surface &&
+        (!surface->visible() || surface->query(mir_window_attrib_visibility) == mir_window_visibility_occluded))
+    {
+        // There's no point the client drawing at the output's rate when no one can see it
+        frame_callback_executor->spawn_throttled(this, std::move(send));
+    }
+    else if (last_presentation)
+    {
+        frame_callback_executor->spawn_at_next_refresh(last_presentation.value(), std::move(send));
+    }
+    else
+    {
+        // Not yet shown anywhere, so we don't know which output's refresh to use
+        frame_callback_executor->spawn(std::move(send));
+    }
+}
+
+void mf::WlSurface::hurry_frame_callbacks()
+{
+    frame_callback_executor->hurry_throttled(this, last_presentation);
+}
+
+void mf::WlSurface::buffer_presented(graphics::BufferID buffer, graphics::Presentation const& presentation)
+{
+    last_presentation = presentation;
+    presentation_feedback.presented(buffer, presentation);
+}
+
 void mf::WlSurface::attach(std::optional<wl_resource*> const& buffer, int32_t x, int32_t y)
 {
     if (x != 0 || y != 0)
@@ -283,20 +461,18 @@ void mf::WlSurface::attach(std::optional<wl_resource*> const& buffer, int32_t x,
 
 void mf::WlSurface::damage(int32_t x, int32_t y, int32_t width, int32_t height)
 {
-    (void)x;
-    (void)y;
-    (void)width;
-    (void)height;
-    // This isn't essential, but could enable optimizations
+    if (auto const rect = sanitised_damage(x, y, width, height))
+    {
+        pending.surface_damage.push_back(rect.value());
+    }
 }
 
 void mf::WlSurface::damage_buffer(int32_t x, int32_t y, int32_t width, int32_t height)
 {
-    (void)x;
-    (void)y;
-    (void)width;
-    (void)height;
-    // This isn't essential, but could enable optimizations
+    if (auto const rect = sanitised_damage(x, y, width, height))
+    {
+        pending.buffer_damage.push_back(rect.value());
+    }
 }
 
 void mf::WlSurface::frame(wl_resource* new_callback)
@@ -305,10 +481,22 @@ void mf::WlSurface::frame(wl_resource* new_callback)
     pending.frame_callbacks.push_back(wayland::make_weak(callback));
 }
 
+void mf::WlSurface::add_presentation_feedback(PresentationFeedback* feedback)
+{
+    pending.presentation_feedbacks.push_back(mw::make_weak<PresentationFeedbackTracker::Feedback>(feedback));
+}
+
 void mf::WlSurface::set_opaque_region(std::optional<wl_resource*> const& region)
 {
-    (void)region;
-    // This isn't essential, but could enable optimizations
+    if (region)
+    {
+        pending.opaque_region = WlRegion::from(region.value())->rectangle_vector();
+    }
+    else
+    {
+        // A null region means nothing is known to be opaque
+        pending.opaque_region = std::vector<geom::Rectangle>{};
+    }
 }
 
 void mf::WlSurface::set_input_region(std::optional<wl_resource*> const& region)
@@ -339,6 +527,9 @@ void mf::WlSurface::commit(WlSurfaceState const& state)
     if (state.input_shape)
         input_shape = state.input_shape.value();
 
+    if (state.opaque_region)
+        opaque_region = state.opaque_region.value();
+
     if (state.scale)
         scale = state.scale.value();
 
@@ -354,6 +545,21 @@ void mf::WlSurface::commit(WlSurfaceState const& state)
                                                                      // ...then we'll need to submit a new frame, even if the client hasn't
                                                                      // attached a new buffer.
 
+    // Any of the above changes how the whole surface is drawn, regardless of what the client damaged
+    bool const metadata_changed = needs_buffer_submission;
+    auto const previous_buffer_size = current_buffer ? std::make_optional(current_buffer->size()) : std::nullopt;
+
+    // We only trust the client's damage if it describes a change to the same sized buffer of a mapped
+    // surface drawn the same way; an attach without any damage is also treated as a full update
+    auto const trusted_damage = [&](geom::Size const& buffer_size) -> std::optional<geom::Rectangles>
+        {
+            if (!metadata_changed && !viewport && buffer_size_ && previous_buffer_size == buffer_size)
+            {
+                return state.buffer_space_damage(scale);
+            }
+            return std::nullopt;
+        };
+
     auto const executor_send_frame_callbacks = [executor = wayland_executor, weak_self = mw::make_weak(this)]()
         {
             executor->spawn([weak_self]()
@@ -390,8 +596,12 @@ void mf::WlSurface::commit(WlSurfaceState const& state)
 
             if (auto const shm_buffer = ShmBuffer::from(weak_buffer.value()))
             {
+                auto const data = shm_buffer->data();
+                auto const content_damage = trusted_damage(data->size());
                 current_buffer = allocator->buffer_from_shm(
-                    shm_buffer->data(),
+                    data,
+                    current_buffer,
+                    content_damage,
                     std::move(executor_send_frame_callbacks),
                     std::move(release_buffer));
                 tracepoint(
@@ -406,6 +616,18 @@ void mf::WlSurface::commit(WlSurfaceState const& state)
                     weak_buffer.value(),
                     std::move(executor_send_frame_callbacks),
                     std::move(release_buffer));
+                if (state.acquire_point && state.release_point)
+                {
+                    set_sync_points(*state.acquire_point, *state.release_point);
+                }
+                if (auto const feedback = allocator->scanout_feedback_for(resource))
+                {
+                    if (auto const buffer = dynamic_cast<graphics::ScanoutFeedbackBuffer*>(
+                            current_buffer->native_buffer_base()))
+                    {
+                        buffer->set_scanout_feedback(feedback);
+                    }
+                }
                 tracepoint(
                     mir_server_wayland,
                     hw_buffer_committed,
@@ -418,7 +640,7 @@ void mf::WlSurface::commit(WlSurfaceState const& state)
     }
     else
     {
-        frame_callback_executor->spawn(std::move(executor_send_frame_callbacks));
+        schedule_frame_callbacks(std::move(executor_send_frame_callbacks));
     }
 
     if (needs_buffer_submission && current_buffer)
@@ -436,7 +658,9 @@ void mf::WlSurface::commit(WlSurfaceState const& state)
             logical_size = current_buffer->size() / scale;
         }
 
-        stream->submit_buffer(current_buffer, logical_size, src_sample);
+        stream->submit_buffer(current_buffer, logical_size, src_sample, trusted_damage(current_buffer->size()));
+
+        presentation_feedback.submitted(current_buffer->id(), state.presentation_feedbacks);
 
         if (std::make_optional(logical_size) != buffer_size_)
         {
@@ -445,6 +669,15 @@ void mf::WlSurface::commit(WlSurfaceState const& state)
 
         buffer_size_ = logical_size;
     }
+    else
+    {
+        presentation_feedback.unchanged(state.presentation_feedbacks);
+    }
+
+    if (state.buffer && !state.buffer.value())
+    {
+        presentation_feedback.unmapped();
+    }
 
     for (WlSubsurface* child: children)
     {
@@ -463,9 +696,107 @@ void mf::WlSurface::commit()
     if (pending.input_shape && *pending.input_shape == input_shape)
         pending.input_shape = std::nullopt;
 
+    if (pending.opaque_region && *pending.opaque_region == opaque_region)
+        pending.opaque_region = std::nullopt;
+
+    if (syncobj_surface)
+    {
+        syncobj_surface.value().commit(pending);
+    }
+
     // order is important
-    auto const state = std::move(pending);
+    auto state = std::move(pending);
     pending = WlSurfaceState();
+
+    /* A client may commit a buffer before submitting the drawing that signals its acquire point. Rather than
+     * have the renderer wait for that, hold back this commit (and any after it) until the point has a fence.
+     */
+    if (!held_commits.empty() || !acquire_point_has_fence(state))
+    {
+        held_commits.push_back(std::move(state));
+        if (!held_commit_watch)
+        {
+            watch_held_commits();
+        }
+        return;
+    }
+
+    apply_commit(state);
+}
+
+auto mf::WlSurface::acquire_point_has_fence(WlSurfaceState const& state) -> bool
+{
+    if (!state.acquire_point)
+    {
+        return true;
+    }
+
+    try
+    {
+        return state.acquire_point->timeline->has_fence_for(state.acquire_point->point);
+    }
+    catch (std::system_error const& error)
+    {
+        // We won't find out any better by waiting
+        log_warning("Failed to check client buffer acquire point: %s", error.what());
+        return true;
+    }
+}
+
+void mf::WlSurface::watch_held_commits()
+{
+    auto const& acquire = held_commits.front().acquire_point.value();
+    try
+    {
+        held_commit_watch = std::make_unique<DRMTimelinePointWatch>(
+            wl_display_get_event_loop(wl_client_get_display(wl_resource_get_client(resource))),
+            acquire,
+            [this]()
+            {
+                // We're called from the event loop rather than a request, so handle errors as a request would
+                try
+                {
+                    apply_held_commits();
+                }
+                catch (mw::ProtocolError const& err)
+                {
+                    wl_resource_post_error(err.resource(), err.code(), "%s", err.message());
+                }
+                catch (...)
+                {
+                    mw::internal_error_processing_request(wl_resource_get_client(resource), "WlSurface::commit()");
+                }
+            });
+    }
+    catch (std::system_error const& error)
+    {
+        // Showing what may be an incomplete frame beats never showing anything
+        log_warning("Failed to watch client buffer acquire point: %s", error.what());
+        apply_held_commits();
+    }
+}
+
+void mf::WlSurface::apply_held_commits()
+{
+    held_commit_watch.reset();
+
+    // The first held commit is due, either because its acquire point has a fence or because we can't wait for one
+    while (!held_commits.empty())
+    {
+        auto const state = std::move(held_commits.front());
+        held_commits.pop_front();
+        apply_commit(state);
+
+        if (!held_commits.empty() && !acquire_point_has_fence(held_commits.front()))
+        {
+            watch_held_commits();
+            return;
+        }
+    }
+}
+
+void mf::WlSurface::apply_commit(WlSurfaceState const& state)
+{
     role->commit(state);
 
     if (scene_surface_created_callbacks.size())
@@ -514,6 +845,39 @@ void mf::WlSurface::associate_viewport(wayland::Weak<Viewport> viewport)
     pending.viewport = viewport;
 }
 
+void mf::WlSurface::associate_syncobj_surface(wayland::Weak<LinuxDrmSyncobjSurfaceV1> syncobj_surface)
+{
+    if (this->syncobj_surface)
+    {
+        BOOST_THROW_EXCEPTION((std::logic_error{"Cannot associate a syncobj surface to a surface with an existing one"}));
+    }
+    this->syncobj_surface = syncobj_surface;
+}
+
+void mf::WlSurface::set_sync_points(graphics::DRMTimelinePoint const& acquire, graphics::DRMTimelinePoint const& release)
+{
+    if (auto const buffer = dynamic_cast<graphics::ExplicitSyncBuffer*>(current_buffer->native_buffer_base()))
+    {
+        buffer->set_sync_points(acquire, release);
+    }
+    else if (syncobj_surface)
+    {
+        syncobj_surface.value().unsupported_buffer();
+    }
+    else
+    {
+        // Too late to tell the client; at least don't leave it waiting to reuse the buffer
+        try
+        {
+            release.timeline->signal(release.point);
+        }
+        catch (std::system_error const& error)
+        {
+            mir::log_warning("Failed to signal client buffer release point: %s", error.what());
+        }
+    }
+}
+
 void mir::frontend::WlSurface::update_surface_spec(shell::SurfaceSpecification const& spec)
 {
     pending.surface_spec.update_from(spec);
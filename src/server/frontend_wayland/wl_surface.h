@@ -23,13 +23,20 @@
 #include "mir/wayland/weak.h"
 
 #include "wl_surface_role.h"
+#include "wp_presentation.h"
 
 #include "mir/geometry/displacement.h"
 #include "mir/geometry/size.h"
 #include "mir/geometry/point.h"
 #include "mir/geometry/rectangle.h"
+#include "mir/geometry/rectangles.h"
 #include "mir/shell/surface_specification.h"
+#include "mir/graphics/buffer_id.h"
+#include "mir/graphics/frame.h"
+#include "mir/graphics/drm_syncobj.h"
 
+#include <deque>
+#include <memory>
 #include <vector>
 #include <map>
 
@@ -59,7 +66,10 @@ namespace frontend
 class WlSurface;
 class WlSubsurface;
 class ResourceLifetimeTracker;
+class FrameExecutor;
 class Viewport;
+class LinuxDrmSyncobjSurfaceV1;
+class DRMTimelinePointWatch;
 
 struct WlSurfaceState
 {
@@ -76,6 +86,10 @@ struct WlSurfaceState
 
     bool surface_data_needs_refresh() const;
 
+    /// The damage accumulated by this state in buffer coordinates, given the buffer scale
+    /// \returns std::nullopt if the client has not reported any damage
+    auto buffer_space_damage(float buffer_scale) const -> std::optional<geometry::Rectangles>;
+
     // NOTE: nullopt has a distinct meaning from the optional containing a null Weak here
     // nullopt: the current state should not be changed
     // null Weak: the current buffer, if any, should be cleared
@@ -85,8 +99,18 @@ struct WlSurfaceState
     std::optional<float> scale;
     std::optional<geometry::Displacement> offset;
     std::optional<std::optional<std::vector<geometry::Rectangle>>> input_shape;
+    /// nullopt: unchanged; an empty vector means nothing is known to be opaque
+    std::optional<std::vector<geometry::Rectangle>> opaque_region;
     std::vector<wayland::Weak<Callback>> frame_callbacks;
+    PresentationFeedbackTracker::Feedbacks presentation_feedbacks;
     wayland::Weak<Viewport> viewport;
+    /// Explicit synchronisation of buffer, if the client uses it; set along with buffer
+    std::optional<graphics::DRMTimelinePoint> acquire_point;
+    std::optional<graphics::DRMTimelinePoint> release_point;
+    /// Damage reported by wl_surface.damage, in surface-local coordinates
+    std::vector<geometry::Rectangle> surface_damage;
+    /// Damage reported by wl_surface.damage_buffer, in buffer coordinates
+    std::vector<geometry::Rectangle> buffer_damage;
 
 private:
     // only set to true if invalidate_surface_data() is called
@@ -114,7 +138,7 @@ class WlSurface : public wayland::Surface
 public:
     WlSurface(wl_resource* new_resource,
               std::shared_ptr<mir::Executor> const& wayland_executor,
-              std::shared_ptr<mir::Executor> const& frame_callback_executor,
+              std::shared_ptr<FrameExecutor> const& frame_callback_executor,
               std::shared_ptr<graphics::GraphicBufferAllocator> const& allocator);
 
     ~WlSurface();
@@ -156,15 +180,27 @@ public:
      */
     void associate_viewport(wayland::Weak<Viewport> viewport);
 
+    /**
+     * Associate explicit synchronisation of committed buffers with this surface
+     *
+     * \throws A std::logic_error if the surface already has a syncobj surface associated
+     */
+    void associate_syncobj_surface(wayland::Weak<LinuxDrmSyncobjSurfaceV1> syncobj_surface);
+
+    /// Report when the content of the next commit is shown
+    void add_presentation_feedback(PresentationFeedback* feedback);
+
     std::shared_ptr<scene::Session> const session;
     std::shared_ptr<compositor::BufferStream> const stream;
 
     static WlSurface* from(wl_resource* resource);
 
 private:
+    class VisibilityObserver;
+
     std::shared_ptr<mir::graphics::GraphicBufferAllocator> const allocator;
     std::shared_ptr<mir::Executor> const wayland_executor;
-    std::shared_ptr<mir::Executor> const frame_callback_executor;
+    std::shared_ptr<FrameExecutor> const frame_callback_executor;
 
     NullWlSurfaceRole null_role;
     WlSurfaceRole* role;
@@ -184,12 +220,34 @@ private:
     float scale{1};
     std::optional<geometry::Size> buffer_size_;
     std::vector<wayland::Weak<WlSurfaceState::Callback>> frame_callbacks;
+    PresentationFeedbackTracker presentation_feedback;
+    /// The most recent time this surface's content was shown, giving the refresh timeline of its output
+    std::optional<graphics::Presentation> last_presentation;
+    /// Brings frame callbacks throttled while the surface couldn't be seen forward once it can
+    std::shared_ptr<VisibilityObserver> const visibility_observer;
+    std::weak_ptr<scene::Surface> observed_scene_surface;
     std::optional<std::vector<mir::geometry::Rectangle>> input_shape;
+    std::vector<mir::geometry::Rectangle> opaque_region;
     std::vector<SceneSurfaceCreatedCallback> scene_surface_created_callbacks;
     wayland::Weak<Viewport> viewport;
     wayland::Weak<FractionalScaleV1> fractional_scale;
+    wayland::Weak<LinuxDrmSyncobjSurfaceV1> syncobj_surface;
+    /// Commits held back, in order, until the acquire point of the first has a fence
+    std::deque<WlSurfaceState> held_commits;
+    std::unique_ptr<DRMTimelinePointWatch> held_commit_watch;
 
+    void apply_commit(WlSurfaceState const& state);
+    static auto acquire_point_has_fence(WlSurfaceState const& state) -> bool;
+    void watch_held_commits();
+    void apply_held_commits();
     void send_frame_callbacks();
+    /// Schedules callbacks that aren't tied to a new buffer for the next refresh of the output the surface is on
+    void schedule_frame_callbacks(std::function<void()>&& send);
+    /// Moves callbacks throttled while the surface couldn't be seen onto its output's refresh
+    void hurry_frame_callbacks();
+    void buffer_presented(graphics::BufferID buffer, graphics::Presentation const& presentation);
+    /// Have current_buffer wait for acquire, and signal release once it's done with
+    void set_sync_points(graphics::DRMTimelinePoint const& acquire, graphics::DRMTimelinePoint const& release);
 
     void attach(std::optional<wl_resource*> const& buffer, int32_t x, int32_t y) override;
     void damage(int32_t x, int32_t y, int32_t width, int32_t height) override;
@@ -0,0 +1,156 @@
+
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "wp_presentation.h"
+#include "wl_surface.h"
+
+#include "mir/graphics/frame.h"
+
+#include <time.h>
+
+namespace mf = mir::frontend;
+namespace mg = mir::graphics;
+
+namespace
+{
+class PresentationInstance : public mir::wayland::Presentation
+{
+public:
+    explicit PresentationInstance(wl_resource* resource)
+        : Presentation(resource, Version<1>{})
+    {
+        // Page flip timestamps from the kernel, and our own estimates, are all CLOCK_MONOTONIC
+        send_clock_id_event(CLOCK_MONOTONIC);
+    }
+
+private:
+    void feedback(wl_resource* surface, wl_resource* callback) override
+    {
+        mf::WlSurface::from(surface)->add_presentation_feedback(new mf::PresentationFeedback{callback});
+    }
+};
+
+auto hi(uint64_t value) -> uint32_t
+{
+    return static_cast<uint32_t>(value >> 32);
+}
+
+auto lo(uint64_t value) -> uint32_t
+{
+    return static_cast<uint32_t>(value & 0xffffffff);
+}
+}
+
+mf::WpPresentation::WpPresentation(wl_display* display)
+    : Global(display, Version<1>{})
+{
+}
+
+void mf::WpPresentation::bind(wl_resource* new_resource)
+{
+    new PresentationInstance(new_resource);
+}
+
+mf::PresentationFeedback::PresentationFeedback(wl_resource* new_feedback)
+    : wayland::PresentationFeedback(new_feedback, Version<1>{})
+{
+}
+
+void mf::PresentationFeedback::presented(mg::Presentation const& presentation)
+{
+    using namespace std::chrono;
+
+    auto const since_epoch = presentation.frame.ust.nanoseconds;
+    auto const sec = static_cast<uint64_t>(duration_cast<seconds>(since_epoch).count());
+    auto const nsec = static_cast<uint32_t>((since_epoch - duration_cast<seconds>(since_epoch)).count());
+    auto const msc = static_cast<uint64_t>(presentation.frame.msc);
+
+    // We only know the vblank a frame was shown at when the kernel tells us
+    uint32_t const flags = presentation.from_hardware ?
+        Kind::vsync | Kind::hw_clock | Kind::hw_completion :
+        0;
+
+    send_presented_event(
+        hi(sec), lo(sec), nsec,
+        static_cast<uint32_t>(presentation.refresh_interval.count()),
+        hi(msc), lo(msc),
+        flags);
+    destroy_and_delete();
+}
+
+void mf::PresentationFeedback::discarded()
+{
+    send_discarded_event();
+    destroy_and_delete();
+}
+
+void mf::PresentationFeedbackTracker::submitted(mg::BufferID buffer, Feedbacks const& feedbacks)
+{
+    discard(waiting);
+    waiting = feedbacks;
+    awaited_buffer = buffer;
+}
+
+void mf::PresentationFeedbackTracker::unchanged(Feedbacks const& feedbacks)
+{
+    if (awaited_buffer)
+    {
+        waiting.insert(end(waiting), begin(feedbacks), end(feedbacks));
+    }
+    else
+    {
+        // Either the current content has already been shown, or there's none to show
+        discard(feedbacks);
+    }
+}
+
+void mf::PresentationFeedbackTracker::unmapped()
+{
+    discard(waiting);
+    waiting.clear();
+    awaited_buffer = std::nullopt;
+}
+
+void mf::PresentationFeedbackTracker::presented(mg::BufferID buffer, mg::Presentation const& presentation)
+{
+    if (awaited_buffer != buffer)
+    {
+        // The client has since committed something else
+        return;
+    }
+
+    for (auto const& feedback : waiting)
+    {
+        if (feedback)
+        {
+            feedback.value().presented(presentation);
+        }
+    }
+    waiting.clear();
+    awaited_buffer = std::nullopt;
+}
+
+void mf::PresentationFeedbackTracker::discard(Feedbacks const& feedbacks)
+{
+    for (auto const& feedback : feedbacks)
+    {
+        if (feedback)
+        {
+            feedback.value().discarded();
+        }
+    }
+}
@@ -0,0 +1,103 @@
+
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef MIR_FRONTEND_WP_PRESENTATION_H
+#define MIR_FRONTEND_WP_PRESENTATION_H
+
+#include "presentation-time_wrapper.h"
+#include "mir/graphics/buffer_id.h"
+#include "mir/wayland/weak.h"
+
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace mir
+{
+namespace graphics
+{
+struct Presentation;
+}
+namespace frontend
+{
+class WpPresentation : public wayland::Presentation::Global
+{
+public:
+    explicit WpPresentation(wl_display* display);
+
+private:
+    void bind(wl_resource* new_wp_presentation) override;
+};
+
+/**
+ * Answers the presentation feedback of a wl_surface's commits as their content
+ * is shown, superseded or unmapped
+ *
+ * Threadsafety: should only be accessed from the Wayland thread
+ */
+class PresentationFeedbackTracker
+{
+public:
+    class Feedback
+    {
+    public:
+        virtual ~Feedback() = default;
+        virtual auto destroyed_flag() const -> std::shared_ptr<bool const> = 0;
+        /// Send the presented event and destroy this object
+        virtual void presented(graphics::Presentation const& presentation) = 0;
+        /// Send the discarded event and destroy this object
+        virtual void discarded() = 0;
+    };
+    using Feedbacks = std::vector<wayland::Weak<Feedback>>;
+
+    /// A commit submitted \a buffer, superseding whatever was still waiting to be shown
+    void submitted(graphics::BufferID buffer, Feedbacks const& feedbacks);
+    /// A commit left the content alone, so is shown along with whatever is still waiting to be
+    void unchanged(Feedbacks const& feedbacks);
+    /// The surface has been unmapped (or destroyed), so nothing still waiting will be shown
+    void unmapped();
+    /// \a buffer has been shown
+    void presented(graphics::BufferID buffer, graphics::Presentation const& presentation);
+
+    static void discard(Feedbacks const& feedbacks);
+
+private:
+    /// Feedback waiting for awaited_buffer to be shown
+    Feedbacks waiting;
+    std::optional<graphics::BufferID> awaited_buffer;
+};
+
+/**
+ * Feedback on when a wl_surface commit was shown
+ *
+ * Threadsafety: This is a Wayland object, and should only be accessed from the Wayland thread
+ */
+class PresentationFeedback : public wayland::PresentationFeedback, public PresentationFeedbackTracker::Feedback
+{
+public:
+    explicit PresentationFeedback(wl_resource* new_feedback);
+
+    auto destroyed_flag() const -> std::shared_ptr<bool const> override
+    {
+        return wayland::PresentationFeedback::destroyed_flag();
+    }
+    void presented(graphics::Presentation const& presentation) override;
+    void discarded() override;
+};
+}
+}
+
+#endif // MIR_FRONTEND_WP_PRESENTATION_H
@@ -30,17 +30,25 @@ mf::ScaledBufferStream::ScaledBufferStream(std::shared_ptr<compositor::BufferStr
 void mf::ScaledBufferStream::submit_buffer(
     std::shared_ptr<graphics::Buffer> const& buffer,
     geom::Size dest_size,
-    geom::RectangleD src_bounds)
+    geom::RectangleD src_bounds,
+    std::optional<geom::Rectangles> const& damage)
 {
-    inner->submit_buffer(buffer, dest_size * scale, src_bounds);
+    // Damage is in buffer coordinates, so is unaffected by the scale
+    inner->submit_buffer(buffer, dest_size * scale, src_bounds, damage);
 }
 
-void mf::ScaledBufferStream::set_frame_posted_callback(std::function<void(geometry::Size const&)> const& callback)
+void mf::ScaledBufferStream::set_frame_posted_callback(std::function<void(geometry::Rectangle const&)> const& callback)
 {
-    // Does this need to be scaled? I don't ? think ? so? compositor::Stream seems to leave it unscaled.
+    // The inner stream reports damage relative to the scaled size, which is what the scene sees
     inner->set_frame_posted_callback(callback);
 }
 
+void mf::ScaledBufferStream::set_frame_presented_callback(
+    std::function<void(graphics::BufferID, graphics::Presentation const&)> const& callback)
+{
+    inner->set_frame_presented_callback(callback);
+}
+
 auto mf::ScaledBufferStream::next_submission_for_compositor(void const* user_id) -> std::shared_ptr<Submission>
 {
     return inner->next_submission_for_compositor(user_id);
@@ -51,3 +59,13 @@ auto mf::ScaledBufferStream::has_submitted_buffer() const -> bool
     return inner->has_submitted_buffer();
 }
 
+auto mf::ScaledBufferStream::stream_size() const -> geom::Size
+{
+    // The inner stream is given the scaled size on submission
+    return inner->stream_size();
+}
+
+auto mf::ScaledBufferStream::presenter(void const* user_id) -> std::function<void(graphics::Presentation const&)>
+{
+    return inner->presenter(user_id);
+}
@@ -38,14 +38,19 @@ public:
     void submit_buffer(
         std::shared_ptr<graphics::Buffer> const& buffer,
         geometry::Size dst_size,
-        geometry::RectangleD src_bounds);
-    void set_frame_posted_callback(std::function<void(geometry::Size const&)> const& callback);
+        geometry::RectangleD src_bounds,
+        std::optional<geometry::Rectangles> const& damage);
+    void set_frame_posted_callback(std::function<void(geometry::Rectangle const&)> const& callback);
+    void set_frame_presented_callback(
+        std::function<void(graphics::BufferID, graphics::Presentation const&)> const& callback);
     /// @}
 
     /// Overrides from compositor::BufferStream
     /// @{
     auto next_submission_for_compositor(void const* user_id) -> std::shared_ptr<Submission>;
     auto has_submitted_buffer() const -> bool;
+    auto stream_size() const -> geometry::Size;
+    auto presenter(void const* user_id) -> std::function<void(graphics::Presentation const&)>;
     /// @}
 
 private:
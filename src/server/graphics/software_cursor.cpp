@@ -105,6 +105,17 @@ public:
         return true;
     }
 
+    auto damage() const -> std::optional<geom::Rectangles> override
+    {
+        // A new renderable is created whenever the cursor image changes
+        return geom::Rectangles{};
+    }
+
+    auto opaque_region() const -> geom::Rectangles override
+    {
+        return {};
+    }
+
     auto surface_if_any() const
         -> std::optional<mir::scene::Surface const*> override
     {
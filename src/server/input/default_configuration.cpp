@@ -159,7 +159,7 @@ mir::DefaultServerConfiguration::the_input_dispatcher()
                 std::make_shared<mi::KeyboardResyncDispatcher>(idle_poking_dispatcher);
 
             return std::make_shared<mi::KeyRepeatDispatcher>(
-                keyboard_resync_dispatcher, the_main_loop(),
+                keyboard_resync_dispatcher, the_main_loop(), the_clock(),
                 enable_repeat, key_repeat_timeout, key_repeat_delay, false);
         });
 }
@@ -20,14 +20,19 @@
 #include "mir/input/input_device_hub.h"
 #include "mir/time/alarm_factory.h"
 #include "mir/time/alarm.h"
+#include "mir/time/clock.h"
 #include "mir/events/event_builders.h"
+#include "mir/events/event_pool.h"
+#include "mir/events/input_event.h"
 
 #include <xkbcommon/xkbcommon-keysyms.h>
 
 #include <boost/throw_exception.hpp>
 
+#include <algorithm>
 #include <stdexcept>
 #include <chrono>
+#include <vector>
 
 namespace mi = mir::input;
 namespace mev = mir::events;
@@ -87,12 +92,14 @@ auto is_meta_key(MirKeyboardEvent const* event) -> bool
 mi::KeyRepeatDispatcher::KeyRepeatDispatcher(
     std::shared_ptr<mi::InputDispatcher> const& next_dispatcher,
     std::shared_ptr<mir::time::AlarmFactory> const& factory,
+    std::shared_ptr<mir::time::Clock> const& clock,
     bool repeat_enabled,
     std::chrono::milliseconds repeat_timeout,
     std::chrono::milliseconds repeat_delay,
     bool disable_repeat_on_touchscreen)
     : next_dispatcher(next_dispatcher),
       alarm_factory(factory),
+      clock(clock),
       repeat_enabled(repeat_enabled),
       repeat_timeout(repeat_timeout),
       repeat_delay(repeat_delay),
@@ -100,6 +107,8 @@ mi::KeyRepeatDispatcher::KeyRepeatDispatcher(
 {
 }
 
+mi::KeyRepeatDispatcher::~KeyRepeatDispatcher() = default;
+
 void mi::KeyRepeatDispatcher::set_input_device_hub(std::shared_ptr<InputDeviceHub> const& hub)
 {
     hub->add_observer(std::make_shared<DeviceRemovalFilter>(this));
@@ -114,24 +123,12 @@ void mi::KeyRepeatDispatcher::set_touch_button_device(MirInputDeviceId id)
 void mi::KeyRepeatDispatcher::remove_device(MirInputDeviceId id)
 {
     std::lock_guard lock(repeat_state_mutex);
-    repeat_state_by_device.erase(id); // destructor cancels alarms
-    if (touch_button_device.is_set() && touch_button_device.value() == id)
-        touch_button_device.consume();
-}
-
-void mi::KeyRepeatDispatcher::set_alarm_for_device(
-    MirInputDeviceId id,
-    std::shared_ptr<mir::time::Alarm> repeat_alarm)
-{
+    if (repeat_state_by_device.erase(id))
     {
-        std::lock_guard lg(repeat_state_mutex);
-        // Get the current KeyboardState or insert a new one
-        auto const& iter = repeat_state_by_device.insert(std::make_pair(id, KeyboardState()));
-        // Set the new alarm
-        std::swap(repeat_alarm, iter.first->second.repeat_alarm);
+        schedule_alarm(clock->now());
     }
-    // Reset the old alarm outside the mutex lock
-    repeat_alarm.reset();
+    if (touch_button_device.is_set() && touch_button_device.value() == id)
+        touch_button_device.consume();
 }
 
 bool mi::KeyRepeatDispatcher::dispatch(std::shared_ptr<MirEvent const> const& event)
@@ -157,17 +154,22 @@ bool mi::KeyRepeatDispatcher::dispatch(std::shared_ptr<MirEvent const> const& ev
 
 void mi::KeyRepeatDispatcher::handle_key_input(MirInputDeviceId id, MirKeyboardEvent const* kev)
 {
-    auto scan_code = mir_keyboard_event_scan_code(kev);
-
     switch (mir_keyboard_event_action(kev))
     {
     case mir_keyboard_action_up:
     {
-        set_alarm_for_device(id, nullptr);
+        std::lock_guard lock(repeat_state_mutex);
+        if (repeat_state_by_device.erase(id))
+        {
+            schedule_alarm(clock->now());
+        }
         break;
     }
     case mir_keyboard_action_down:
     {
+        std::lock_guard lock(repeat_state_mutex);
+        auto const now = clock->now();
+
         // We don't want to track and auto-repeat individual meta key presses
         // That leads, for example, to alternating Ctrl and Alt repeats when
         // both keys are pressed.
@@ -175,43 +177,29 @@ void mi::KeyRepeatDispatcher::handle_key_input(MirInputDeviceId id, MirKeyboardE
         {
             // Further, we don't want to repeat with the old modifier state.
             // So just cancel any existing repeats and carry on.
-            set_alarm_for_device(id, nullptr);
+            if (repeat_state_by_device.erase(id))
+            {
+                schedule_alarm(now);
+            }
             return;
         }
 
-        auto clone_event = [scan_code, id,
-             next_dispatcher=next_dispatcher,
-             keysym = mir_keyboard_event_keysym(kev),
-             modifiers = mir_keyboard_event_modifiers(kev)]()
-             {
-                 auto const now = std::chrono::steady_clock::now().time_since_epoch();
-                 auto new_event = mev::make_key_event(
-                     id,
-                     now,
-                     mir_keyboard_action_repeat,
-                     keysym,
-                     scan_code,
-                     modifiers);
-                 next_dispatcher->dispatch(std::move(new_event));
-             };
-
-        // We need to provide the alarm lambda with the alarm (which doesn't exist yet) so
-        // that it can reschedule. This is a placeholder while we create the lambda & alarm.
-        auto const shared_weak_alarm = std::make_shared<std::weak_ptr<time::Alarm>>();
-
-        std::shared_ptr<mir::time::Alarm> alarm = alarm_factory->create_alarm(
-            [clone_event, shared_weak_alarm, repeat_delay=repeat_delay]()
-            {
-                clone_event();
-
-                if (auto const& repeat_alarm = shared_weak_alarm->lock())
-                    repeat_alarm->reschedule_in(repeat_delay);
-            });
-
-        // Fulfill the placeholder before scheduling the alarm.
-        *shared_weak_alarm = alarm;
-        alarm->reschedule_in(repeat_timeout);
-        set_alarm_for_device(id, alarm);
+        auto& state = repeat_state_by_device[id];
+        state.next_repeat = now + repeat_timeout;
+        state.repeat_event = mev::share(mev::make_key_event(
+            id,
+            now.time_since_epoch(),
+            mir_keyboard_action_repeat,
+            mir_keyboard_event_keysym(kev),
+            mir_keyboard_event_scan_code(kev),
+            mir_keyboard_event_modifiers(kev)));
+
+        if (!repeat_alarm)
+        {
+            repeat_alarm = alarm_factory->create_alarm([this] { send_due_repeats(); });
+        }
+        schedule_alarm(now);
+        break;
     }
     case mir_keyboard_action_repeat:
         // Should we consume existing repeats?
@@ -223,6 +211,77 @@ void mi::KeyRepeatDispatcher::handle_key_input(MirInputDeviceId id, MirKeyboardE
     }
 }
 
+void mi::KeyRepeatDispatcher::send_due_repeats()
+{
+    std::vector<std::shared_ptr<MirEvent const>> due_repeats;
+    {
+        std::lock_guard lock(repeat_state_mutex);
+        auto const now = clock->now();
+        // Repeat everything the alarm was due for, even if it fires a little early
+        auto const due = std::max(alarm_due.value_or(now), now);
+        alarm_due.reset();
+
+        for (auto& [id, state] : repeat_state_by_device)
+        {
+            if (state.next_repeat > due)
+            {
+                continue;
+            }
+
+            if (state.repeat_event.use_count() > 1)
+            {
+                // The last repeat is still in use downstream, so leave it be
+                state.repeat_event = mev::share(mev::clone_event(*state.repeat_event));
+            }
+            state.repeat_event->to_input()->set_event_time(now.time_since_epoch());
+            state.next_repeat = now + repeat_delay;
+
+            due_repeats.push_back(state.repeat_event);
+        }
+
+        schedule_alarm(now);
+    }
+
+    // Downstream dispatch can take a while; don't hold up key presses and releases meanwhile
+    for (auto const& repeat : due_repeats)
+    {
+        next_dispatcher->dispatch(repeat);
+    }
+}
+
+void mi::KeyRepeatDispatcher::schedule_alarm(Timestamp now)
+{
+    if (!repeat_alarm)
+    {
+        return;
+    }
+
+    if (repeat_state_by_device.empty())
+    {
+        if (alarm_due)
+        {
+            repeat_alarm->cancel();
+            alarm_due.reset();
+        }
+        return;
+    }
+
+    auto const next = std::min_element(
+        repeat_state_by_device.begin(),
+        repeat_state_by_device.end(),
+        [](auto const& lhs, auto const& rhs) { return lhs.second.next_repeat < rhs.second.next_repeat; });
+    auto const next_repeat = next->second.next_repeat;
+
+    // An alarm due later than it needs to be has to be brought forward, but one that is due earlier can just fire
+    // and find nothing to repeat yet
+    if (!alarm_due || next_repeat < *alarm_due)
+    {
+        alarm_due = next_repeat;
+        repeat_alarm->reschedule_in(
+            std::chrono::ceil<std::chrono::milliseconds>(std::max(next_repeat - now, Timestamp::duration::zero())));
+    }
+}
+
 void mi::KeyRepeatDispatcher::start()
 {
     next_dispatcher->start();
@@ -233,6 +292,7 @@ void mi::KeyRepeatDispatcher::stop()
     std::lock_guard lg(repeat_state_mutex);
 
     repeat_state_by_device.clear();
+    schedule_alarm(clock->now());
 
     next_dispatcher->stop();
 }
@@ -24,6 +24,7 @@
 #include <memory>
 #include <chrono>
 #include <mutex>
+#include <optional>
 #include <unordered_map>
 
 namespace mir
@@ -32,19 +33,25 @@ namespace time
 {
 class AlarmFactory;
 class Alarm;
+class Clock;
 }
 namespace input
 {
 class InputDeviceHub;
+
+/// Repeats the keys held on every keyboard of the seat, from a single alarm that is scheduled for the next repeat
+/// due on any of them
 class KeyRepeatDispatcher : public InputDispatcher
 {
 public:
     KeyRepeatDispatcher(std::shared_ptr<InputDispatcher> const& next_dispatcher,
                         std::shared_ptr<time::AlarmFactory> const& factory,
+                        std::shared_ptr<time::Clock> const& clock,
                         bool repeat_enabled,
                         std::chrono::milliseconds repeat_timeout, /* timeout before sending first repeat */
                         std::chrono::milliseconds repeat_delay, /* delay between repeated keys */
                         bool disable_repeat_on_touchscreen);
+    ~KeyRepeatDispatcher();
 
     // InputDispatcher
     bool dispatch(std::shared_ptr<MirEvent const> const& event) override;
@@ -56,10 +63,13 @@ public:
     void set_touch_button_device(MirInputDeviceId id);
     void remove_device(MirInputDeviceId id);
 private:
+    using Timestamp = std::chrono::steady_clock::time_point;
+
     std::mutex repeat_state_mutex;
 
     std::shared_ptr<InputDispatcher> const next_dispatcher;
     std::shared_ptr<time::AlarmFactory> const alarm_factory;
+    std::shared_ptr<time::Clock> const clock;
     bool const repeat_enabled;
     std::chrono::milliseconds const repeat_timeout;
     std::chrono::milliseconds const repeat_delay;
@@ -68,13 +78,21 @@ private:
 
     struct KeyboardState
     {
-        std::shared_ptr<mir::time::Alarm> repeat_alarm;
+        Timestamp next_repeat;
+        /// Sent again for each repeat, unless something downstream has held on to it
+        std::shared_ptr<MirEvent> repeat_event;
     };
     std::unordered_map<MirInputDeviceId, KeyboardState> repeat_state_by_device;
-    /// repeat_state_mutex must NOT be locked when calling
-    void set_alarm_for_device(MirInputDeviceId id, std::shared_ptr<mir::time::Alarm> repeat_alarm);
+    /// When repeat_alarm will next fire, or none if it is not scheduled
+    std::optional<Timestamp> alarm_due;
+    /// Created on the first key held
+    std::unique_ptr<time::Alarm> repeat_alarm;
 
     void handle_key_input(MirInputDeviceId id, MirKeyboardEvent const* ev);
+    void send_due_repeats();
+
+    // repeat_state_mutex must be locked when calling this
+    void schedule_alarm(Timestamp now);
 };
 
 }
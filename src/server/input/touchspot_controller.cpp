@@ -88,6 +88,17 @@ public:
         return true;
     }
 
+    auto damage() const -> std::optional<geom::Rectangles> override
+    {
+        // The touchspot image never changes, only its position
+        return geom::Rectangles{};
+    }
+
+    auto opaque_region() const -> geom::Rectangles override
+    {
+        return {};
+    }
+
     auto surface_if_any() const
         -> std::optional<mir::scene::Surface const*> override
     {
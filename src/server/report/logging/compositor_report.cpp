@@ -17,7 +17,10 @@
 #include "compositor_report.h"
 #include "mir/logging/logger.h"
 
+#include <string>
+
 using namespace mir::time;
+namespace mc = mir::compositor;
 namespace ml = mir::logging;
 namespace mrl = mir::report::logging;
 
@@ -25,6 +28,19 @@ namespace
 {
     const char * const component = "compositor";
     const auto min_report_interval = std::chrono::seconds(1);
+
+    std::string format(mc::LatencySummary const& summary)
+    {
+        char text[64];
+        long long const usec[] = {
+            summary.p50.count(), summary.p90.count(), summary.p99.count(), summary.max.count()};
+        snprintf(text, sizeof text, "%lld.%03lld/%lld.%03lld/%lld.%03lld/%lld.%03lld",
+                 usec[0] / 1000, usec[0] % 1000,
+                 usec[1] / 1000, usec[1] % 1000,
+                 usec[2] / 1000, usec[2] % 1000,
+                 usec[3] / 1000, usec[3] % 1000);
+        return text;
+    }
 }
 
 mrl::CompositorReport::CompositorReport(
@@ -58,6 +74,7 @@ void mrl::CompositorReport::began_frame(SubCompositorId id)
     inst.start_of_frame = t;
     inst.latency_sum += t - last_scheduled;
     inst.bypassed = true;
+    timings.began_frame(id, t);
 }
 
 void mrl::CompositorReport::renderables_in_frame(SubCompositorId, mir::graphics::RenderableList const&)
@@ -68,8 +85,10 @@ void mrl::CompositorReport::rendered_frame(SubCompositorId id)
 {
     std::lock_guard lock(mutex);
     auto& inst = instance[id];
-    inst.render_time_sum += now() - inst.start_of_frame;
+    auto t = now();
+    inst.render_time_sum += t - inst.start_of_frame;
     inst.bypassed = false;
+    timings.rendered_frame(id, t);
 }
 
 void mrl::CompositorReport::Instance::log(ml::Logger& logger, SubCompositorId id)
@@ -141,6 +160,7 @@ void mrl::CompositorReport::finished_frame(SubCompositorId id)
     inst.nframes++;
     if (inst.bypassed)
         ++inst.nbypassed;
+    timings.finished_frame(id, t);
 
     /*
      * The exact reporting interval doesn't matter because we count everything
@@ -151,7 +171,11 @@ void mrl::CompositorReport::finished_frame(SubCompositorId id)
         last_report = t;
 
         for (auto& i : instance)
+        {
+            log_latency(i.first);
+            i.second.log_schedule(*logger, i.first);
             i.second.log(*logger, i.first);
+        }
     }
 
     if (inst.bypassed != inst.prev_bypassed || inst.nframes == 1)
@@ -164,9 +188,69 @@ void mrl::CompositorReport::finished_frame(SubCompositorId id)
     inst.prev_bypassed = inst.bypassed;
 }
 
+void mrl::CompositorReport::presented_frame(SubCompositorId id, mir::graphics::Presentation const& presentation)
+{
+    timings.presented_frame(id, mc::FrameTimings::time_of(presentation, now()), presentation);
+}
+
+void mrl::CompositorReport::scheduled_next_frame(
+    SubCompositorId id,
+    std::chrono::nanoseconds predicted_render_time,
+    std::chrono::nanoseconds delay)
+{
+    std::lock_guard lock(mutex);
+    auto& inst = instance[id];
+    inst.predicted_render_time = predicted_render_time;
+    inst.composite_delay = delay;
+}
+
+void mrl::CompositorReport::Instance::log_schedule(ml::Logger& logger, SubCompositorId id) const
+{
+    if (!predicted_render_time)
+        return;
+
+    long long const predicted_usec =
+        std::chrono::duration_cast<std::chrono::microseconds>(*predicted_render_time).count();
+    long long const delay_usec =
+        std::chrono::duration_cast<std::chrono::microseconds>(composite_delay).count();
+
+    char msg[128];
+    snprintf(msg, sizeof msg, "Display %p predicted render time %lld.%03lld ms, "
+             "composite delay %lld.%03lld ms",
+             id,
+             predicted_usec / 1000, predicted_usec % 1000,
+             delay_usec / 1000, delay_usec % 1000);
+
+    logger.log(ml::Severity::informational, msg, component);
+}
+
+void mrl::CompositorReport::log_latency(SubCompositorId id)
+{
+    auto const stats = timings.stats_for(id);
+    if (!stats || stats->frames == 0)
+        return;
+
+    char msg[256];
+    snprintf(msg, sizeof msg, "Display %p latency p50/p90/p99/max: "
+             "render %s ms, "
+             "schedule %s ms, "
+             "present %s ms, "
+             "%llu missed vblanks",
+             id,
+             format(stats->render_time).c_str(),
+             format(stats->schedule_latency).c_str(),
+             format(stats->present_latency).c_str(),
+             static_cast<unsigned long long>(stats->missed_vblanks)
+             );
+
+    logger->log(ml::Severity::informational, msg, component);
+}
+
 void mrl::CompositorReport::started()
 {
     logger->log(ml::Severity::informational, "Started", component);
+
+    timings.clear();
 }
 
 void mrl::CompositorReport::stopped()
@@ -181,4 +265,10 @@ void mrl::CompositorReport::scheduled()
 {
     std::lock_guard lock(mutex);
     last_scheduled = now();
+    timings.scheduled(last_scheduled);
+}
+
+auto mrl::CompositorReport::frame_timings() const -> mc::FrameTimings const&
+{
+    return timings;
 }
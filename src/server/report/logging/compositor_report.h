@@ -18,11 +18,13 @@
 #define MIR_REPORT_LOGGING_COMPOSITOR_REPORT_H_
 
 #include "mir/compositor/compositor_report.h"
+#include "mir/compositor/frame_timings.h"
 #include "mir/time/clock.h"
 #include <memory>
 #include <mutex>
 #include <unordered_map>
 #include <chrono>
+#include <optional>
 
 namespace mir
 {
@@ -45,10 +47,18 @@ public:
     void renderables_in_frame(SubCompositorId id, graphics::RenderableList const& renderables) override;
     void rendered_frame(SubCompositorId id) override;
     void finished_frame(SubCompositorId id) override;
+    void presented_frame(SubCompositorId id, graphics::Presentation const& presentation) override;
+    void scheduled_next_frame(
+        SubCompositorId id,
+        std::chrono::nanoseconds predicted_render_time,
+        std::chrono::nanoseconds delay) override;
     void started() override;
     void stopped() override;
     void scheduled() override;
 
+    /// Timing of the frames composited since the compositor was last started
+    auto frame_timings() const -> compositor::FrameTimings const&;
+
 private:
     std::shared_ptr<mir::logging::Logger> const logger;
     std::shared_ptr<time::Clock> const clock;
@@ -74,13 +84,22 @@ private:
         long last_reported_nframes = 0;
         long last_reported_bypassed = 0;
 
+        /// From the most recent frame scheduled by predicting its render time
+        std::optional<std::chrono::nanoseconds> predicted_render_time;
+        std::chrono::nanoseconds composite_delay{0};
+
+        void log_schedule(mir::logging::Logger& logger, SubCompositorId id) const;
         void log(mir::logging::Logger& logger, SubCompositorId id);
     };
 
+    void log_latency(SubCompositorId id);
+
     std::mutex mutex; // Protects the following...
     std::unordered_map<SubCompositorId, Instance> instance;
     TimePoint last_scheduled;
     TimePoint last_report;
+
+    compositor::FrameTimings timings;
 };
 
 } // namespace logging
@@ -25,12 +25,41 @@
 
 #define COMPOSITOR_TRACE_CALL(name) MIR_LTTNG_VOID_TRACE_CALL(CompositorReport, mir_server_compositor, name)
 
-COMPOSITOR_TRACE_CALL(started)
 COMPOSITOR_TRACE_CALL(stopped)
-COMPOSITOR_TRACE_CALL(scheduled)
 
 #undef COMPOSITOR_TRACE_CALL
 
+namespace mc = mir::compositor;
+
+namespace
+{
+auto const min_report_interval = std::chrono::seconds(1);
+
+auto now() -> mir::time::Timestamp
+{
+    return std::chrono::steady_clock::now();
+}
+
+void trace_latency(void const* id, char const* measurement, mc::LatencySummary const& summary)
+{
+    mir_tracepoint(mir_server_compositor, frame_latency, id, measurement,
+                   summary.p50.count(), summary.p90.count(), summary.p99.count(), summary.max.count(),
+                   summary.samples);
+}
+}
+
+void mir::report::lttng::CompositorReport::started()
+{
+    mir_tracepoint(mir_server_compositor, started);
+    timings.clear();
+}
+
+void mir::report::lttng::CompositorReport::scheduled()
+{
+    mir_tracepoint(mir_server_compositor, scheduled);
+    timings.scheduled(now());
+}
+
 void mir::report::lttng::CompositorReport::added_display(int width, int height, int x, int y, SubCompositorId id)
 {
     mir_tracepoint(mir_server_compositor, added_display, width, height, x, y, id);
@@ -39,6 +68,7 @@ void mir::report::lttng::CompositorReport::added_display(int width, int height,
 void mir::report::lttng::CompositorReport::began_frame(SubCompositorId id)
 {
     mir_tracepoint(mir_server_compositor, began_frame, id);
+    timings.began_frame(id, now());
 }
 
 void mir::report::lttng::CompositorReport::renderables_in_frame(
@@ -54,9 +84,65 @@ void mir::report::lttng::CompositorReport::renderables_in_frame(
 void mir::report::lttng::CompositorReport::rendered_frame(SubCompositorId id)
 {
     mir_tracepoint(mir_server_compositor, rendered_frame, id);
+    timings.rendered_frame(id, now());
 }
 
 void mir::report::lttng::CompositorReport::finished_frame(SubCompositorId id)
 {
     mir_tracepoint(mir_server_compositor, finished_frame, id);
+    timings.finished_frame(id, now());
+}
+
+void mir::report::lttng::CompositorReport::presented_frame(
+    SubCompositorId id, graphics::Presentation const& presentation)
+{
+    mir_tracepoint(
+        mir_server_compositor,
+        presented_frame,
+        id,
+        presentation.frame.msc,
+        presentation.frame.ust.nanoseconds.count(),
+        presentation.from_hardware);
+
+    auto const t = now();
+    timings.presented_frame(id, mc::FrameTimings::time_of(presentation, t), presentation);
+    trace_frame_timings(t);
+}
+
+void mir::report::lttng::CompositorReport::scheduled_next_frame(
+    SubCompositorId id,
+    std::chrono::nanoseconds predicted_render_time,
+    std::chrono::nanoseconds delay)
+{
+    using std::chrono::duration_cast;
+    using std::chrono::microseconds;
+    mir_tracepoint(
+        mir_server_compositor,
+        scheduled_next_frame,
+        id,
+        duration_cast<microseconds>(predicted_render_time).count(),
+        duration_cast<microseconds>(delay).count());
+}
+
+auto mir::report::lttng::CompositorReport::frame_timings() const -> mc::FrameTimings const&
+{
+    return timings;
+}
+
+void mir::report::lttng::CompositorReport::trace_frame_timings(time::Timestamp when)
+{
+    {
+        std::lock_guard lock{mutex};
+        if (when - last_report < min_report_interval)
+            return;
+        last_report = when;
+    }
+
+    for (auto const& [id, stats] : timings.stats())
+    {
+        trace_latency(id, "render", stats.render_time);
+        trace_latency(id, "schedule", stats.schedule_latency);
+        trace_latency(id, "present", stats.present_latency);
+        mir_tracepoint(mir_server_compositor, frame_count, id, stats.frames, stats.missed_vblanks);
+    }
 }
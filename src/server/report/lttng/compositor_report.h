@@ -20,6 +20,10 @@
 #include "server_tracepoint_provider.h"
 
 #include "mir/compositor/compositor_report.h"
+#include "mir/compositor/frame_timings.h"
+#include "mir/time/types.h"
+
+#include <mutex>
 
 namespace mir
 {
@@ -38,11 +42,27 @@ public:
     void renderables_in_frame(SubCompositorId id, graphics::RenderableList const& renderables) override;
     void rendered_frame(SubCompositorId id) override;
     void finished_frame(SubCompositorId id) override;
+    void presented_frame(SubCompositorId id, graphics::Presentation const& presentation) override;
+    void scheduled_next_frame(
+        SubCompositorId id,
+        std::chrono::nanoseconds predicted_render_time,
+        std::chrono::nanoseconds delay) override;
     void started() override;
     void stopped() override;
     void scheduled() override;
+
+    /// Timing of the frames composited since the compositor was last started
+    auto frame_timings() const -> compositor::FrameTimings const&;
+
 private:
+    /// Traces the frame timings of every display, at most once per report interval
+    void trace_frame_timings(time::Timestamp when);
+
     ServerTracepointProvider tp_provider;
+    compositor::FrameTimings timings;
+
+    std::mutex mutex;
+    time::Timestamp last_report;
 };
 
 } // namespace lttng
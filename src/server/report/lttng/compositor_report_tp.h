@@ -78,6 +78,56 @@ TRACEPOINT_EVENT_INSTANCE(
     TP_ARGS(void const*, id)
 )
 
+TRACEPOINT_EVENT(
+    mir_server_compositor,
+    presented_frame,
+    TP_ARGS(void const*, id, int64_t, msc, int64_t, ust_ns, int, from_hardware),
+    TP_FIELDS(
+        ctf_integer_hex(uintptr_t, id, (uintptr_t)(id))
+        ctf_integer(int64_t, msc, msc)
+        ctf_integer(int64_t, ust_ns, ust_ns)
+        ctf_integer(int, from_hardware, from_hardware)
+    )
+)
+
+TRACEPOINT_EVENT(
+    mir_server_compositor,
+    frame_latency,
+    TP_ARGS(void const*, id, char const*, measurement,
+            uint64_t, p50_us, uint64_t, p90_us, uint64_t, p99_us, uint64_t, max_us, uint64_t, samples),
+    TP_FIELDS(
+        ctf_integer_hex(uintptr_t, id, (uintptr_t)(id))
+        ctf_string(measurement, measurement)
+        ctf_integer(uint64_t, p50_us, p50_us)
+        ctf_integer(uint64_t, p90_us, p90_us)
+        ctf_integer(uint64_t, p99_us, p99_us)
+        ctf_integer(uint64_t, max_us, max_us)
+        ctf_integer(uint64_t, samples, samples)
+    )
+)
+
+TRACEPOINT_EVENT(
+    mir_server_compositor,
+    frame_count,
+    TP_ARGS(void const*, id, uint64_t, frames, uint64_t, missed_vblanks),
+    TP_FIELDS(
+        ctf_integer_hex(uintptr_t, id, (uintptr_t)(id))
+        ctf_integer(uint64_t, frames, frames)
+        ctf_integer(uint64_t, missed_vblanks, missed_vblanks)
+    )
+)
+
+TRACEPOINT_EVENT(
+    mir_server_compositor,
+    scheduled_next_frame,
+    TP_ARGS(void const*, id, uint64_t, predicted_render_time_us, uint64_t, delay_us),
+    TP_FIELDS(
+        ctf_integer_hex(uintptr_t, id, (uintptr_t)(id))
+        ctf_integer(uint64_t, predicted_render_time_us, predicted_render_time_us)
+        ctf_integer(uint64_t, delay_us, delay_us)
+    )
+)
+
 TRACEPOINT_EVENT(
     mir_server_compositor,
     buffers_in_frame,
@@ -38,6 +38,14 @@ void mrn::CompositorReport::finished_frame(SubCompositorId)
 {
 }
 
+void mrn::CompositorReport::presented_frame(SubCompositorId, mir::graphics::Presentation const&)
+{
+}
+
+void mrn::CompositorReport::scheduled_next_frame(SubCompositorId, std::chrono::nanoseconds, std::chrono::nanoseconds)
+{
+}
+
 void mrn::CompositorReport::started()
 {
 }
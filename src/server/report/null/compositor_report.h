@@ -34,6 +34,11 @@ public:
     void renderables_in_frame(SubCompositorId id, graphics::RenderableList const& renderables) override;
     void rendered_frame(SubCompositorId id) override;
     void finished_frame(SubCompositorId id) override;
+    void presented_frame(SubCompositorId id, graphics::Presentation const& presentation) override;
+    void scheduled_next_frame(
+        SubCompositorId id,
+        std::chrono::nanoseconds predicted_render_time,
+        std::chrono::nanoseconds delay) override;
     void started() override;
     void stopped() override;
     void scheduled() override;
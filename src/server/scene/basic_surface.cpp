@@ -174,6 +174,11 @@ public:
     {
         for_each_observer(&SurfaceObserver::rescale_output, surf, id);
     }
+
+    void input_region_set_to(Surface const* surf, std::vector<geom::Rectangle> const& region) override
+    {
+        for_each_observer(&SurfaceObserver::input_region_set_to, surf, region);
+    }
 };
 
 namespace
@@ -188,6 +193,16 @@ std::shared_ptr<mc::BufferStream> default_stream(std::list<ms::StreamInfo> const
         return layers.front().stream;
 }
 
+/// Whether \a rect can't appear in \a area. Empty rects (such as those of unsized buffers) are kept if they start in it.
+auto lies_outside(geom::Rectangle const& rect, geom::Rectangle const& area) -> bool
+{
+    if (rect.size.width == geom::Width{} || rect.size.height == geom::Height{})
+    {
+        return !area.contains(rect.top_left);
+    }
+    return !rect.overlaps(area);
+}
+
 }
 
 ms::BasicSurface::BasicSurface(
@@ -324,6 +339,7 @@ std::shared_ptr<mf::BufferStream> ms::BasicSurface::primary_buffer_stream() cons
 void ms::BasicSurface::set_input_region(std::vector<geom::Rectangle> const& input_rectangles)
 {
     synchronised_state.lock()->custom_input_rectangles = input_rectangles;
+    observers->input_region_set_to(this, input_rectangles);
 }
 
 std::vector<geom::Rectangle> ms::BasicSurface::get_input_region() const
@@ -700,6 +716,7 @@ public:
         std::optional<geom::Rectangle> const& clip_area,
         glm::mat4 const& transform,
         float alpha,
+        std::vector<geom::Rectangle> const& opaque_region,
         mg::Renderable::ID id,
         ms::Surface const* surface)
     : entry{std::move(buffer)},
@@ -707,6 +724,7 @@ public:
       screen_position_{top_left, entry->size()},
       clip_area_{clip_area},
       transformation_{transform},
+      opaque_region_{screen_space(opaque_region, screen_position_)},
       id_{id},
       surface{surface}
     {
@@ -741,6 +759,36 @@ public:
         return entry->pixel_format().info().transform([](auto info) { return info.has_alpha();}).value_or(true);
     }
 
+    auto damage() const -> std::optional<geom::Rectangles> override
+    {
+        if (transformation_ != glm::mat4{1})
+        {
+            // We don't try to follow damage through arbitrary transformations
+            return std::nullopt;
+        }
+
+        return entry->damage().transform(
+            [this](auto const& logical_damage)
+            {
+                geom::Rectangles screen_damage;
+                for (auto const& rect : logical_damage)
+                {
+                    screen_damage.add({screen_position_.top_left + as_displacement(rect.top_left), rect.size});
+                }
+                return screen_damage;
+            });
+    }
+
+    auto opaque_region() const -> geom::Rectangles override
+    {
+        if (transformation_ != glm::mat4{1})
+        {
+            return {};
+        }
+
+        return opaque_region_;
+    }
+
     mg::Renderable::ID id() const override
     { return id_; }
 
@@ -749,11 +797,30 @@ public:
         return surface;
     }
 private:
+    /// The region may have been set for an earlier buffer, so clip it to what we're actually showing
+    static auto screen_space(std::vector<geom::Rectangle> const& region, geom::Rectangle const& position)
+        -> geom::Rectangles
+    {
+        geom::Rectangles result;
+        for (auto const& rect : region)
+        {
+            auto const on_screen = intersection_of(
+                geom::Rectangle{position.top_left + as_displacement(rect.top_left), rect.size},
+                position);
+            if (on_screen.size != geom::Size{})
+            {
+                result.add(on_screen);
+            }
+        }
+        return result;
+    }
+
     std::shared_ptr<mc::BufferStream::Submission> const entry;
     float const alpha_;
     geom::Rectangle const screen_position_;
     std::optional<geom::Rectangle> const clip_area_;
     glm::mat4 const transformation_;
+    geom::Rectangles const opaque_region_;
     mg::Renderable::ID const id_;
     ms::Surface const* surface;
 };
@@ -791,6 +858,20 @@ void ms::BasicSurface::set_streams(std::list<scene::StreamInfo> const& s)
 }
 
 mg::RenderableList ms::BasicSurface::generate_renderables(mc::CompositorID id) const
+{
+    return generate_renderables(id, std::optional<geom::Rectangle>{});
+}
+
+mg::RenderableList ms::BasicSurface::generate_renderables(
+    mc::CompositorID id,
+    geom::Rectangle const& view_area) const
+{
+    return generate_renderables(id, std::optional{view_area});
+}
+
+auto ms::BasicSurface::generate_renderables(
+    mc::CompositorID id,
+    std::optional<geom::Rectangle> const& view_area) const -> mg::RenderableList
 {
     auto state = synchronised_state.lock();
     mg::RenderableList list;
@@ -802,17 +883,29 @@ mg::RenderableList ms::BasicSurface::generate_renderables(mc::CompositorID id) c
     }
 
     auto const content_top_left_ = content_top_left(*state);
+    // An arbitrary transformation could put the surface anywhere, so only cull untransformed surfaces
+    auto const cull = view_area && state->transformation_matrix == glm::mat4{1};
 
     for (auto const& info : state->layers)
     {
         if (info.stream->has_submitted_buffer())
         {
+            if (cull)
+            {
+                geom::Rectangle const stream_rect{
+                    content_top_left_ + info.displacement,
+                    info.stream->stream_size()};
+                if (lies_outside(stream_rect, view_area.value()))
+                    continue;
+            }
+
             list.emplace_back(std::make_shared<SurfaceSnapshot>(
                 info.stream->next_submission_for_compositor(id),
                 content_top_left_ + info.displacement,
                 state->clip_area,
                 state->transformation_matrix,
                 state->surface_alpha,
+                info.opaque_region,
                 info.stream.get(),
                 this));
         }
@@ -820,6 +913,33 @@ mg::RenderableList ms::BasicSurface::generate_renderables(mc::CompositorID id) c
     return list;
 }
 
+auto ms::BasicSurface::frame_presenter(mc::CompositorID id) const -> std::function<void(mg::Presentation const&)>
+{
+    std::vector<std::function<void(mg::Presentation const&)>> presenters;
+    {
+        auto const state = synchronised_state.lock();
+        if (state->layers.size() == 1)
+        {
+            return state->layers.front().stream->presenter(id);
+        }
+
+        presenters.reserve(state->layers.size());
+        for (auto const& info : state->layers)
+        {
+            presenters.push_back(info.stream->presenter(id));
+        }
+    }
+
+    // The streams may call back into the frontend, so the presenters run without our lock
+    return [presenters = std::move(presenters)](mg::Presentation const& presentation)
+        {
+            for (auto const& presenter : presenters)
+            {
+                presenter(presentation);
+            }
+        };
+}
+
 void ms::BasicSurface::set_confine_pointer_state(MirPointerConfinementState state)
 {
     synchronised_state.lock()->confine_pointer_state = state;
@@ -969,11 +1089,13 @@ void mir::scene::BasicSurface::update_frame_posted_callbacks(State& state)
         auto const surface_local_position = geom::Point{} + state.margins.left + state.margins.top + layer.displacement;
         layer.stream->set_frame_posted_callback(
             [this, observers=std::weak_ptr{observers}, surface_local_position]
-                (auto const& size)
+                (geom::Rectangle const& damage)
             {
                 if (auto const o = observers.lock())
                 {
-                    o->frame_posted(this, geom::Rectangle{surface_local_position, size});
+                    o->frame_posted(
+                        this,
+                        geom::Rectangle{surface_local_position + as_displacement(damage.top_left), damage.size});
                 }
             });
     }
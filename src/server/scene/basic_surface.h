@@ -118,6 +118,10 @@ public:
     bool visible() const override;
 
     graphics::RenderableList generate_renderables(compositor::CompositorID id) const override;
+    graphics::RenderableList generate_renderables(
+        compositor::CompositorID id,
+        geometry::Rectangle const& view_area) const override;
+    auto frame_presenter(compositor::CompositorID id) const -> std::function<void(graphics::Presentation const&)> override;
 
     MirWindowType type() const override;
     MirWindowState state() const override;
@@ -180,6 +184,9 @@ private:
     class Multiplexer;
 
     bool visible(State const& state) const;
+    auto generate_renderables(
+        compositor::CompositorID id,
+        std::optional<geometry::Rectangle> const& view_area) const -> graphics::RenderableList;
     MirWindowType set_type(MirWindowType t);  // Use configure() to make public changes
     MirWindowState set_state(MirWindowState s);
     int set_dpi(int);
@@ -0,0 +1,266 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "input_region_index.h"
+
+#include "mir/scene/surface.h"
+#include "mir/geometry/rectangles.h"
+
+#include <algorithm>
+
+namespace ms = mir::scene;
+namespace geom = mir::geometry;
+
+namespace
+{
+/// Width and height of a grid cell, in logical pixels
+int const cell_size = 256;
+
+/// Surfaces covering more cells than this are checked for every point instead
+long const max_cells_per_surface = 128;
+
+auto cell_index(int coordinate) -> int
+{
+    // Round towards negative infinity, so cells don't straddle 0
+    return coordinate / cell_size - (coordinate % cell_size < 0 ? 1 : 0);
+}
+
+auto cell_at(int x, int y) -> std::uint64_t
+{
+    return (std::uint64_t{static_cast<std::uint32_t>(x)} << 32) | static_cast<std::uint32_t>(y);
+}
+
+auto is_empty(geom::Rectangle const& rect) -> bool
+{
+    return rect.size.width <= geom::Width{0} || rect.size.height <= geom::Height{0};
+}
+
+/// Call \a f with each cell \a rect touches
+template<typename F>
+void for_each_cell(geom::Rectangle const& rect, F f)
+{
+    auto const left = cell_index(rect.left().as_int());
+    auto const right = cell_index(rect.right().as_int() - 1);
+    auto const top = cell_index(rect.top().as_int());
+    auto const bottom = cell_index(rect.bottom().as_int() - 1);
+
+    for (auto y = top; y <= bottom; ++y)
+    {
+        for (auto x = left; x <= right; ++x)
+        {
+            f(cell_at(x, y));
+        }
+    }
+}
+
+auto cell_count(geom::Rectangle const& rect) -> long
+{
+    long const across = cell_index(rect.right().as_int() - 1) - cell_index(rect.left().as_int()) + 1;
+    long const down = cell_index(rect.bottom().as_int() - 1) - cell_index(rect.top().as_int()) + 1;
+    return across * down;
+}
+
+/// Everything ms::BasicSurface::input_area_contains() could accept is within this rectangle
+auto input_area_bounds(ms::Surface const& surface) -> geom::Rectangle
+{
+    auto const content = surface.input_bounds();
+    auto const region = surface.get_input_region();
+    if (region.empty())
+    {
+        return content;
+    }
+
+    geom::Rectangles input_area;
+    for (auto const& rect : region)
+    {
+        if (!is_empty(rect))
+        {
+            input_area.add({rect.top_left + as_displacement(content.top_left), rect.size});
+        }
+    }
+    return input_area.bounding_rectangle();
+}
+
+void erase_from(std::vector<ms::Surface const*>& surfaces, ms::Surface const* surface)
+{
+    surfaces.erase(std::remove(surfaces.begin(), surfaces.end(), surface), surfaces.end());
+}
+}
+
+auto ms::InputRegionIndex::needs_restack() const -> bool
+{
+    std::lock_guard lock{mutex};
+    return stale;
+}
+
+void ms::InputRegionIndex::stacking_changed()
+{
+    std::lock_guard lock{mutex};
+    stale = true;
+}
+
+void ms::InputRegionIndex::restack(std::vector<std::shared_ptr<Surface>> const& surfaces)
+{
+    std::lock_guard lock{mutex};
+
+    std::unordered_map<Surface const*, Entry> restacked;
+    restacked.reserve(surfaces.size());
+
+    unsigned rank = 0;
+    for (auto const& surface : surfaces)
+    {
+        auto const existing = entries.find(surface.get());
+        if (existing != entries.end() && existing->second.surface.lock() == surface)
+        {
+            existing->second.rank = rank++;
+            restacked.insert(entries.extract(existing));
+        }
+        else
+        {
+            // A surface destroyed without being removed may have left an entry at the same address
+            if (existing != entries.end())
+            {
+                unfile(existing->first, existing->second);
+                entries.erase(existing);
+            }
+
+            Entry entry{surface, rank++, input_area_bounds(*surface)};
+            file(surface.get(), entry);
+            restacked.emplace(surface.get(), std::move(entry));
+        }
+    }
+
+    // Whatever is left has been removed from the stack
+    for (auto const& [surface, entry] : entries)
+    {
+        unfile(surface, entry);
+    }
+
+    entries = std::move(restacked);
+    stale = false;
+}
+
+void ms::InputRegionIndex::removed(Surface const* surface)
+{
+    std::lock_guard lock{mutex};
+
+    if (auto const found = entries.find(surface); found != entries.end())
+    {
+        unfile(surface, found->second);
+        entries.erase(found);
+    }
+}
+
+void ms::InputRegionIndex::input_area_changed(Surface const* surface)
+{
+    std::lock_guard lock{mutex};
+
+    if (auto const found = entries.find(surface); found != entries.end())
+    {
+        auto& entry = found->second;
+        auto const indexed = entry.surface.lock();
+        if (!indexed)
+        {
+            return;
+        }
+
+        auto const bounds = input_area_bounds(*indexed);
+        if (bounds != entry.bounds)
+        {
+            unfile(surface, entry);
+            entry.bounds = bounds;
+            file(surface, entry);
+        }
+    }
+}
+
+auto ms::InputRegionIndex::candidates_at(geometry::Point point) const -> std::vector<std::shared_ptr<Surface>>
+{
+    std::lock_guard lock{mutex};
+
+    std::vector<Entry const*> found;
+    auto const check = [&](Surface const* surface)
+        {
+            auto const& entry = entries.at(surface);
+            if (entry.bounds.contains(point))
+            {
+                found.push_back(&entry);
+            }
+        };
+
+    auto const cell = cells.find(cell_at(cell_index(point.x.as_int()), cell_index(point.y.as_int())));
+    if (cell != cells.end())
+    {
+        std::for_each(cell->second.begin(), cell->second.end(), check);
+    }
+    std::for_each(large.begin(), large.end(), check);
+
+    std::sort(found.begin(), found.end(), [](Entry const* a, Entry const* b) { return a->rank > b->rank; });
+
+    std::vector<std::shared_ptr<Surface>> candidates;
+    candidates.reserve(found.size());
+    for (auto const entry : found)
+    {
+        if (auto const surface = entry->surface.lock())
+        {
+            candidates.push_back(surface);
+        }
+    }
+    return candidates;
+}
+
+void ms::InputRegionIndex::file(Surface const* surface, Entry const& entry)
+{
+    if (is_empty(entry.bounds))
+    {
+        return;
+    }
+
+    if (cell_count(entry.bounds) > max_cells_per_surface)
+    {
+        large.push_back(surface);
+    }
+    else
+    {
+        for_each_cell(entry.bounds, [&](Cell cell) { cells[cell].push_back(surface); });
+    }
+}
+
+void ms::InputRegionIndex::unfile(Surface const* surface, Entry const& entry)
+{
+    if (is_empty(entry.bounds))
+    {
+        return;
+    }
+
+    if (cell_count(entry.bounds) > max_cells_per_surface)
+    {
+        erase_from(large, surface);
+    }
+    else
+    {
+        for_each_cell(entry.bounds,
+            [&](Cell cell)
+            {
+                auto const filed = cells.find(cell);
+                erase_from(filed->second, surface);
+                if (filed->second.empty())
+                {
+                    cells.erase(filed);
+                }
+            });
+    }
+}
@@ -0,0 +1,90 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_SCENE_INPUT_REGION_INDEX_H_
+#define MIR_SCENE_INPUT_REGION_INDEX_H_
+
+#include "mir/geometry/point.h"
+#include "mir/geometry/rectangle.h"
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace mir
+{
+namespace scene
+{
+class Surface;
+
+/**
+ * Finds the surfaces whose input area might contain a point, without looking at every surface
+ *
+ * Each surface is filed, by the bounding rectangle of its input area, in the cells of a
+ * coarse grid that rectangle touches; a point only needs checking against the surfaces in
+ * its cell. Surfaces too large to be worth filing cell by cell are checked for every point.
+ *
+ * The index must be told whenever the stacking changes, whenever a surface is removed and
+ * whenever a surface's input area may have moved or changed shape. It doesn't keep the
+ * surfaces it has indexed alive. It is safe to use from multiple threads.
+ */
+class InputRegionIndex
+{
+public:
+    /// Whether the stacking has changed since it was last given to restack()
+    auto needs_restack() const -> bool;
+
+    /// The stacking has changed, and will be given to restack() before the next lookup
+    void stacking_changed();
+
+    /// Index \a surfaces, given bottom to top, in place of those indexed before
+    void restack(std::vector<std::shared_ptr<Surface>> const& surfaces);
+
+    /// Forget \a surface, which has been removed from the stacking
+    void removed(Surface const* surface);
+
+    /// The input area of \a surface may have changed
+    void input_area_changed(Surface const* surface);
+
+    /// The surfaces whose input area might contain \a point, topmost first
+    auto candidates_at(geometry::Point point) const -> std::vector<std::shared_ptr<Surface>>;
+
+private:
+    struct Entry
+    {
+        std::weak_ptr<Surface> surface;
+        /// Position in the stacking, higher is nearer the top
+        unsigned rank;
+        geometry::Rectangle bounds;
+    };
+
+    using Cell = std::uint64_t;
+
+    void file(Surface const* surface, Entry const& entry);
+    void unfile(Surface const* surface, Entry const& entry);
+
+    std::mutex mutable mutex;
+    bool stale{true};
+    std::unordered_map<Surface const*, Entry> entries;
+    std::unordered_map<Cell, std::vector<Surface const*>> cells;
+    std::vector<Surface const*> large;
+};
+}
+}
+
+#endif // MIR_SCENE_INPUT_REGION_INDEX_H_
@@ -47,14 +47,12 @@ class SurfaceSceneElement : public mc::SceneElement
 {
 public:
     SurfaceSceneElement(
-        std::string name,
-        std::shared_ptr<mg::Renderable> const& renderable,
+        std::shared_ptr<mg::Renderable> renderable,
         std::shared_ptr<ms::RenderingTracker> const& tracker,
         mc::CompositorID id)
-        : renderable_{renderable},
+        : renderable_{std::move(renderable)},
           tracker{tracker},
-          cid{id},
-          surface_name(name)
+          cid{id}
     {
     }
 
@@ -77,7 +75,6 @@ private:
     std::shared_ptr<mg::Renderable> const renderable_;
     std::shared_ptr<ms::RenderingTracker> const tracker;
     mc::CompositorID cid;
-    std::string const surface_name;
 };
 
 //note: something different than a 2D/HWC overlay
@@ -108,12 +105,13 @@ private:
 };
 
 /**
- * A SurfaceDepthLayerObserver must not outlive the SurfaceStack it was created for
+ * A StackedSurfaceObserver must not outlive the SurfaceStack it was created for
  */
-struct SurfaceDepthLayerObserver : ms::NullSurfaceObserver
+struct StackedSurfaceObserver : ms::NullSurfaceObserver
 {
-    SurfaceDepthLayerObserver(ms::SurfaceStack* stack)
-        : stack{stack}
+    StackedSurfaceObserver(ms::SurfaceStack* stack, ms::InputRegionIndex* input_index)
+        : stack{stack},
+          input_index{input_index}
     {
     }
 
@@ -123,16 +121,108 @@ struct SurfaceDepthLayerObserver : ms::NullSurfaceObserver
         stack->raise(surface);
     }
 
+    void moved_to(ms::Surface const* surface, geom::Point const& /*top_left*/) override
+    {
+        input_index->input_area_changed(surface);
+    }
+
+    void window_resized_to(ms::Surface const* surface, geom::Size const& /*window_size*/) override
+    {
+        input_index->input_area_changed(surface);
+    }
+
+    void content_resized_to(ms::Surface const* surface, geom::Size const& /*content_size*/) override
+    {
+        input_index->input_area_changed(surface);
+    }
+
+    void input_region_set_to(ms::Surface const* surface, std::vector<geom::Rectangle> const& /*region*/) override
+    {
+        input_index->input_area_changed(surface);
+    }
+
 private:
     ms::SurfaceStack* stack;
+    ms::InputRegionIndex* input_index;
 };
 
 }
 
+/**
+ * The scene elements of one frame
+ *
+ * These are handed out as aliases of the whole, rather than allocating each
+ * element separately. They are only added to before being handed out, and
+ * cleared once all are released, so the storage is reused from frame to frame.
+ */
+struct ms::SurfaceStack::FrameElements
+{
+    std::vector<SurfaceSceneElement> surface_elements;
+    std::vector<OverlaySceneElement> overlay_elements;
+};
+
+/// What a compositor took from the scene for its latest frame, and the storage for its next
+class ms::SurfaceStack::CompositorFrames : public std::enable_shared_from_this<CompositorFrames>
+{
+public:
+    /// Storage for the compositor's next frame of scene elements, given back here once all are released
+    auto next_frame_elements() -> std::shared_ptr<FrameElements>
+    {
+        // The compositor (or the stack) may be gone by the time the frame is released
+        return {
+            take().release(),
+            [weak_frames = weak_from_this()](FrameElements* frame)
+            {
+                std::unique_ptr<FrameElements> storage{frame};
+                if (auto const frames = weak_frames.lock())
+                {
+                    frames->give_back(std::move(storage));
+                }
+            }};
+    }
+
+    /// The surfaces that went into the latest frame. Only used from the compositor's own thread.
+    std::vector<std::weak_ptr<Surface>> composited;
+
+private:
+    auto take() -> std::unique_ptr<FrameElements>
+    {
+        std::lock_guard lock{mutex};
+        if (released.empty())
+        {
+            return std::make_unique<FrameElements>();
+        }
+
+        auto frame = std::move(released.back());
+        released.pop_back();
+        return frame;
+    }
+
+    void give_back(std::unique_ptr<FrameElements> frame)
+    {
+        // Let go of the renderables now, so their buffers can go back to clients
+        frame->surface_elements.clear();
+        frame->overlay_elements.clear();
+
+        std::lock_guard lock{mutex};
+        if (released.size() < max_released)
+        {
+            released.push_back(std::move(frame));
+        }
+    }
+
+private:
+    /// More than a compositor holds at once: the frame being composited and one on its way to the display
+    static std::size_t constexpr max_released = 3;
+
+    std::mutex mutex;
+    std::vector<std::unique_ptr<FrameElements>> released;
+};
+
 ms::SurfaceStack::SurfaceStack(std::shared_ptr<SceneReport> const& report) :
     report{report},
     scene_changed{false},
-    surface_observer{std::make_shared<SurfaceDepthLayerObserver>(this)},
+    surface_observer{std::make_shared<StackedSurfaceObserver>(this, &input_index)},
     multiplexer(linearising_executor)
 {
 }
@@ -149,37 +239,113 @@ ms::SurfaceStack::~SurfaceStack() noexcept(true)
     }
 }
 
-mc::SceneElementSequence ms::SurfaceStack::scene_elements_for(mc::CompositorID id)
+mc::SceneElementSequence ms::SurfaceStack::scene_elements_for(
+    mc::CompositorID id,
+    geom::Rectangle const& view_area)
 {
-    RecursiveReadLock lg(guard);
-
-    scene_changed = false;
-    mc::SceneElementSequence elements;
-    for (auto const& layer : surface_layers)
+    auto const frames = frames_of(id);
+    auto const frame = frames->next_frame_elements();
+    frames->composited.clear();
+    // Surfaces outside the view area are occluded as far as this compositor is concerned
+    std::vector<std::shared_ptr<RenderingTracker>> outside_view_area;
     {
-        for (auto const& surface : layer)
+        RecursiveReadLock lg(guard);
+
+        scene_changed = false;
+        auto const surfaces = stack_snapshot();
+        auto const reports_occlusion = registered_compositors.contains(id);
+        for (auto const& stacked : *surfaces)
         {
+            auto const& surface = stacked.surface;
             if (surface_can_be_shown(surface) && surface->visible())
             {
-                for (auto& renderable : surface->generate_renderables(id))
+                auto renderables = surface->generate_renderables(id, view_area);
+                if (renderables.empty() && reports_occlusion &&
+                    !geom::Rectangle{surface->top_left(), surface->window_size()}.overlaps(view_area))
+                {
+                    outside_view_area.push_back(stacked.tracker);
+                }
+
+                if (!renderables.empty())
+                {
+                    frames->composited.push_back(surface);
+                }
+                for (auto& renderable : renderables)
                 {
-                    elements.emplace_back(
-                        std::make_shared<SurfaceSceneElement>(
-                            surface->name(),
-                            renderable,
-                            rendering_trackers[surface.get()],
-                            id));
+                    frame->surface_elements.emplace_back(std::move(renderable), stacked.tracker, id);
                 }
             }
         }
+        for (auto const& renderable : overlays)
+        {
+            frame->overlay_elements.emplace_back(renderable);
+        }
     }
-    for (auto const& renderable : overlays)
+
+    for (auto const& tracker : outside_view_area)
     {
-        elements.emplace_back(std::make_shared<OverlaySceneElement>(renderable));
+        tracker->occluded_in(id);
+    }
+
+    mc::SceneElementSequence elements;
+    elements.reserve(frame->surface_elements.size() + frame->overlay_elements.size());
+    for (auto& element : frame->surface_elements)
+    {
+        elements.emplace_back(frame, &element);
+    }
+    for (auto& element : frame->overlay_elements)
+    {
+        elements.emplace_back(frame, &element);
     }
     return elements;
 }
 
+auto ms::SurfaceStack::frame_presenter(mc::CompositorID id) -> std::function<void(mg::Presentation const&)>
+{
+    // Only the surfaces that went into the frame can have had a buffer taken for it
+    auto const frames = frames_of(id);
+
+    std::vector<std::function<void(mg::Presentation const&)>> presenters;
+    presenters.reserve(frames->composited.size());
+    for (auto const& composited : frames->composited)
+    {
+        if (auto const surface = composited.lock())
+        {
+            presenters.push_back(surface->frame_presenter(id));
+        }
+    }
+
+    if (presenters.empty())
+    {
+        return [](mg::Presentation const&) {};
+    }
+    if (presenters.size() == 1)
+    {
+        return std::move(presenters.front());
+    }
+
+    // Surfaces the compositor didn't take a new buffer from since their last presentation ignore this
+    return [presenters = std::move(presenters)](mg::Presentation const& presentation)
+        {
+            for (auto const& presenter : presenters)
+            {
+                presenter(presentation);
+            }
+        };
+}
+
+auto ms::SurfaceStack::frames_of(mc::CompositorID id) -> std::shared_ptr<CompositorFrames>
+{
+    std::lock_guard lock{compositor_frames_mutex};
+
+    auto& frames = compositor_frames[id];
+    if (!frames)
+    {
+        frames = std::make_shared<CompositorFrames>();
+    }
+    return frames;
+}
+
 void ms::SurfaceStack::register_compositor(mc::CompositorID cid)
 {
     RecursiveWriteLock lg(guard);
@@ -196,6 +362,9 @@ void ms::SurfaceStack::unregister_compositor(mc::CompositorID cid)
     registered_compositors.erase(cid);
 
     update_rendering_tracker_compositors();
+
+    std::lock_guard lock{compositor_frames_mutex};
+    compositor_frames.erase(cid);
 }
 
 void ms::SurfaceStack::add_input_visualization(
@@ -242,6 +411,7 @@ void ms::SurfaceStack::add_surface(
         RecursiveWriteLock lg(guard);
         insert_surface_at_top_of_depth_layer(surface);
         create_rendering_tracker_for(surface);
+        invalidate_stack_snapshot();
         surface->register_interest(surface_observer, immediate_executor);
     }
     surface->set_reception_mode(input_mode);
@@ -266,6 +436,8 @@ void ms::SurfaceStack::remove_surface(std::weak_ptr<Surface> const& surface)
             {
                 layer.erase(surface);
                 rendering_trackers.erase(keep_alive.get());
+                input_index.removed(keep_alive.get());
+                invalidate_stack_snapshot();
                 keep_alive->unregister_interest(*surface_observer);
                 found_surface = true;
                 break;
@@ -281,34 +453,32 @@ void ms::SurfaceStack::remove_surface(std::weak_ptr<Surface> const& surface)
     // TODO: error logging when surface not found
 }
 
-namespace
-{
-template <typename Container>
-struct InReverse {
-    Container& container;
-    auto begin() -> decltype(container.rbegin()) { return container.rbegin(); }
-    auto end() -> decltype(container.rend()) { return container.rend(); }
-};
-
-template <typename Container>
-InReverse<Container> in_reverse(Container& container) { return InReverse<Container>{container}; }
-}
-
 auto ms::SurfaceStack::surface_at(geometry::Point cursor) const
 -> std::shared_ptr<Surface>
 {
     RecursiveReadLock lg(guard);
-    for (auto const& layer : in_reverse(surface_layers))
+
+    // The stack can't change while we hold guard, so restacking here can't miss a change
+    if (input_index.needs_restack())
     {
-        for (auto const& surface : in_reverse(layer))
+        auto const surfaces = stack_snapshot();
+        std::vector<std::shared_ptr<Surface>> stacking;
+        stacking.reserve(surfaces->size());
+        for (auto const& stacked : *surfaces)
         {
-            // TODO There's a lack of clarity about how the input area will
-            // TODO be maintained and whether this test will detect clicks on
-            // TODO decorations (it should) as these may be outside the area
-            // TODO known to the client.  But it works for now.
-            if (surface_can_be_shown(surface) && surface->input_area_contains(cursor))
-                    return surface;
+            stacking.push_back(stacked.surface);
         }
+        input_index.restack(stacking);
+    }
+
+    for (auto const& surface : input_index.candidates_at(cursor))
+    {
+        // TODO There's a lack of clarity about how the input area will
+        // TODO be maintained and whether this test will detect clicks on
+        // TODO decorations (it should) as these may be outside the area
+        // TODO known to the client.  But it works for now.
+        if (surface_can_be_shown(surface) && surface->input_area_contains(cursor))
+                return surface;
     }
 
     return {};
@@ -340,6 +510,7 @@ void ms::SurfaceStack::raise(Surface const* surface)
                 std::shared_ptr<Surface> surface_shared = *p;
                 layer.erase(p);
                 insert_surface_at_top_of_depth_layer(surface_shared);
+                invalidate_stack_snapshot();
                 affected_surfaces.insert(surface_shared);
                 break;
             }
@@ -391,6 +562,9 @@ void ms::SurfaceStack::raise(SurfaceSet const& ss)
             if (old_layer != layer)
                 surfaces_reordered = true;
         }
+
+        if (surfaces_reordered)
+            invalidate_stack_snapshot();
     }
 
     if (surfaces_reordered)
@@ -457,6 +631,8 @@ void ms::SurfaceStack::swap_z_order(SurfaceSet const& first, SurfaceSet const& s
                     return to_back.count(s2) == 0;
             });
         }
+
+        invalidate_stack_snapshot();
     }
 
     observers.surfaces_reordered(first);
@@ -491,6 +667,9 @@ void ms::SurfaceStack::send_to_back(const mir::scene::SurfaceSet &ss)
                 surfaces_reordered = true;
             }
         }
+
+        if (surfaces_reordered)
+            invalidate_stack_snapshot();
     }
 
     if (surfaces_reordered)
@@ -529,6 +708,33 @@ auto ms::SurfaceStack::surface_can_be_shown(std::shared_ptr<Surface> const& surf
     return !is_locked || surface->visible_on_lock_screen();
 }
 
+auto ms::SurfaceStack::stack_snapshot() const -> std::shared_ptr<StackSnapshot const>
+{
+    std::lock_guard lock{snapshot_mutex};
+    if (!snapshot)
+    {
+        auto fresh = std::make_shared<StackSnapshot>();
+        for (auto const& layer : surface_layers)
+        {
+            for (auto const& surface : layer)
+            {
+                fresh->push_back({surface, rendering_trackers.at(surface.get())});
+            }
+        }
+        snapshot = std::move(fresh);
+    }
+    return snapshot;
+}
+
+void ms::SurfaceStack::invalidate_stack_snapshot()
+{
+    {
+        std::lock_guard lock{snapshot_mutex};
+        snapshot.reset();
+    }
+    input_index.stacking_changed();
+}
+
 void ms::SurfaceStack::add_observer(std::shared_ptr<ms::Observer> const& observer)
 {
     observers.add(observer);
@@ -25,6 +25,7 @@
 #include "mir/input/scene.h"
 #include "mir/recursive_read_write_mutex.h"
 #include "mir/scene/session_lock.h"
+#include "input_region_index.h"
 
 #include "mir/basic_observers.h"
 #include "mir/scene/surface_observer.h"
@@ -33,7 +34,9 @@
 #include <atomic>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <set>
+#include <unordered_map>
 #include <vector>
 
 namespace mir
@@ -87,7 +90,10 @@ public:
     virtual ~SurfaceStack() noexcept(true);
 
     // From Scene
-    compositor::SceneElementSequence scene_elements_for(compositor::CompositorID id) override;
+    compositor::SceneElementSequence scene_elements_for(
+        compositor::CompositorID id,
+        geometry::Rectangle const& view_area) override;
+    auto frame_presenter(compositor::CompositorID id) -> std::function<void(graphics::Presentation const&)> override;
     void register_compositor(compositor::CompositorID id) override;
     void unregister_compositor(compositor::CompositorID id) override;
 
@@ -140,6 +146,22 @@ private:
     void insert_surface_at_top_of_depth_layer(std::shared_ptr<Surface> const& surface);
     auto surface_can_be_shown(std::shared_ptr<Surface> const& surface) const -> bool;
 
+    struct StackedSurface
+    {
+        std::shared_ptr<Surface> surface;
+        std::shared_ptr<RenderingTracker> tracker;
+    };
+    using StackSnapshot = std::vector<StackedSurface>;
+
+    /// The surfaces in the stack, bottom to top. Must be called with guard held.
+    auto stack_snapshot() const -> std::shared_ptr<StackSnapshot const>;
+    /// Must be called with guard held for writing whenever the stack is changed.
+    void invalidate_stack_snapshot();
+
+    struct FrameElements;
+    class CompositorFrames;
+    auto frames_of(compositor::CompositorID id) -> std::shared_ptr<CompositorFrames>;
+
     RecursiveReadWriteMutex mutable guard;
 
     std::shared_ptr<SceneReport> const report;
@@ -157,6 +179,27 @@ private:
 
     std::vector<std::shared_ptr<graphics::Renderable>> overlays;
 
+    /**
+     * A flattened copy of surface_layers with the rendering tracker of each surface
+     *
+     * It is shared by all compositors and rebuilt only after the stack changes, so
+     * that composing a frame doesn't need to walk the layers or look up trackers.
+     */
+    std::mutex mutable snapshot_mutex;
+    std::shared_ptr<StackSnapshot const> mutable snapshot;
+
+    /**
+     * What each compositor took from the scene for its latest frame
+     *
+     * A compositor releases the elements of a frame once it has been composited, so
+     * its next frames can reuse their storage rather than allocating afresh.
+     */
+    std::mutex compositor_frames_mutex;
+    std::unordered_map<compositor::CompositorID, std::shared_ptr<CompositorFrames>> compositor_frames;
+
+    /// Where to look for the surface under a point, brought up to date with the stacking by surface_at()
+    InputRegionIndex mutable input_index;
+
     Observers observers;
     /// If not expired the screen is locked (and only surfaces that appear on the lock screen should be shown)
     std::atomic<bool> is_locked = false;
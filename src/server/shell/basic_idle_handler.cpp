@@ -91,6 +91,17 @@ public:
         return false;
     }
 
+    auto damage() const -> std::optional<geom::Rectangles> override
+    {
+        // The content never changes
+        return geom::Rectangles{};
+    }
+
+    auto opaque_region() const -> geom::Rectangles override
+    {
+        return {};
+    }
+
     auto surface_if_any() const
         -> std::optional<mir::scene::Surface const*> override
     {
@@ -432,6 +432,7 @@ void msd::BasicDecoration::update(
             pair.first->submit_buffer(
                 pair.second.value(),
                 pair.second.value()->size() * inv_scale,
-                {{0, 0}, geom::SizeD{pair.second.value()->size()}});
+                {{0, 0}, geom::SizeD{pair.second.value()->size()}},
+                std::nullopt);
     }
 }
@@ -29,7 +29,8 @@ auto msh::operator==(StreamSpecification const& lhs, StreamSpecification const&
 {
     return
         lhs.stream.lock() == rhs.stream.lock() &&
-        lhs.displacement == rhs.displacement;
+        lhs.displacement == rhs.displacement &&
+        lhs.opaque_region == rhs.opaque_region;
 }
 
 bool msh::SurfaceSpecification::is_empty() const
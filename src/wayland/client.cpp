@@ -18,16 +18,48 @@
 #include "mir/synchronised.h"
 #include "mir/fatal.h"
 
+#include <wayland-server-core.h>
+
 #include <vector>
 #include <algorithm>
+#include <type_traits>
 
 namespace mw = mir::wayland;
 
 namespace
 {
-/// All operations for the same display should happen on the same thread, but since in theory a single process could
-/// manage multiple Wayland displays, best to keep global state threadsafe.
-mir::Synchronised<std::vector<std::pair<wl_client*, std::weak_ptr<mw::Client>>>> client_map;
+/// Attached to each registered wl_client, so finding the Client is a walk of that client's (few) destroy listeners
+/// rather than of every connected client. Owned by the wl_client, and deleted when it is destroyed.
+struct ClientSlot
+{
+    wl_listener destroy_listener;
+    /// Needs to be a pointer so std::is_standard_layout passes
+    std::weak_ptr<mw::Client>* const client;
+};
+
+static_assert(
+    std::is_standard_layout<ClientSlot>::value,
+    "ClientSlot must be standard layout for wl_container_of to be defined behaviour");
+
+/// Clients whose wl_client is being destroyed, but that are still alive while their resources are cleaned up. All
+/// operations for the same display should happen on the same thread, but since in theory a single process could manage
+/// multiple Wayland displays, best to keep global state threadsafe.
+mir::Synchronised<std::vector<std::pair<wl_client*, std::weak_ptr<mw::Client>>>> destroyed_clients;
+
+void client_slot_destroyed(wl_listener* listener, void* data)
+{
+    ClientSlot* slot;
+    slot = wl_container_of(listener, slot, destroy_listener);
+
+    // The Client outlives its wl_client until its resources are gone, and it should still be found until then
+    if (!slot->client->expired())
+    {
+        destroyed_clients.lock()->push_back({static_cast<wl_client*>(data), std::move(*slot->client)});
+    }
+
+    delete slot->client;
+    delete slot;
+}
 }
 
 auto mw::Client::from(wl_client* client) -> Client&
@@ -37,12 +69,15 @@ auto mw::Client::from(wl_client* client) -> Client&
 
 void mw::Client::register_client(wl_client* raw, std::shared_ptr<Client> const& shared)
 {
-    client_map.lock()->push_back({raw, shared});
+    auto const slot = new ClientSlot{{}, new std::weak_ptr<Client>{shared}};
+    slot->destroy_listener.notify = &client_slot_destroyed;
+    wl_client_add_destroy_listener(raw, &slot->destroy_listener);
 }
 
 void mw::Client::unregister_client(wl_client* raw)
 {
-    auto const map = client_map.lock();
+    // Only clients whose wl_client has been destroyed are left to forget; the slots of any others go with them
+    auto const map = destroyed_clients.lock();
     map->erase(remove_if(
             begin(*map),
             end(*map),
@@ -52,7 +87,28 @@ void mw::Client::unregister_client(wl_client* raw)
 
 auto mw::Client::shared_from(wl_client* client) -> std::shared_ptr<Client>
 {
-    auto const locked = client_map.lock();
+    if (!client)
+    {
+        mir::fatal_error("wl_client %p is null", static_cast<void*>(client));
+    }
+
+    if (auto const listener = wl_client_get_destroy_listener(client, &client_slot_destroyed))
+    {
+        ClientSlot* slot;
+        slot = wl_container_of(listener, slot, destroy_listener);
+        if (auto const shared = slot->client->lock())
+        {
+            return shared;
+        }
+        else
+        {
+            // The client should unregister itself in it's destructor and should be destroyed/accessed on a single
+            // thread, so this should never happen
+            mir::fatal_error("wl_client %p expired", static_cast<void*>(client));
+        }
+    }
+
+    auto const locked = destroyed_clients.lock();
     for (auto& info : *locked)
     {
         if (info.first == client)
@@ -63,12 +119,10 @@ auto mw::Client::shared_from(wl_client* client) -> std::shared_ptr<Client>
             }
             else
             {
-                // The client should remove itself from the map in it's destructor and should be destroyed/accessed on a
-                // single thread, so this should never happen
-                mir::fatal_error("wl_client %p expired");
+                mir::fatal_error("wl_client %p expired", static_cast<void*>(client));
             }
         }
     }
-    mir::fatal_error("wl_client %p is %s", static_cast<void*>(client), client ? "unknown" : "null");
+    mir::fatal_error("wl_client %p is unknown", static_cast<void*>(client));
     abort(); // Make compiler happy
 }
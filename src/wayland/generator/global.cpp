@@ -32,6 +32,8 @@ Emitter Global::declaration() const
         "public:",
         Emitter::layout(Lines{
             {"Global(", constructor_args(), ");"},
+            {"/// Advertises advertised_version, for when clients must not use the newest supported version"},
+            {"Global(", constructor_args(), ", int advertised_version);"},
             empty_line,
             {"auto interface_name() const -> char const* override;"}
         }, true, true, Emitter::single_indent),
@@ -49,12 +51,18 @@ Emitter Global::implementation() const
 {
     return EmptyLineList{
         Lines{
-            {nmspace, "Global::Global(", constructor_args(), ")"},
+            {nmspace, "Global::Global(", constructor_args(), " version)"},
+            {"    : Global{display, version, Thunks::supported_version}"},
+            Block{
+            }
+        },
+        Lines{
+            {nmspace, "Global::Global(", constructor_args(), ", int advertised_version)"},
             {"    : wayland::Global{"},
             {"          wl_global_create("},
             {"              display,"},
             {"              &", wl_name, "_interface_data,"},
-            {"              Thunks::supported_version,"},
+            {"              std::min(advertised_version, Thunks::supported_version),"},
             {"              this,"},
             {"              &Thunks::bind_thunk)}"},
             Block{
@@ -228,12 +228,17 @@ void mw::Compositor::destroy_and_delete() const
     wl_resource_destroy(resource);
 }
 
-mw::Compositor::Global::Global(wl_display* display, Version<4>)
+mw::Compositor::Global::Global(wl_display* display, Version<4> version)
+    : Global{display, version, Thunks::supported_version}
+{
+}
+
+mw::Compositor::Global::Global(wl_display* display, Version<4>, int advertised_version)
     : wayland::Global{
           wl_global_create(
               display,
               &wl_compositor_interface_data,
-              Thunks::supported_version,
+              std::min(advertised_version, Thunks::supported_version),
               this,
               &Thunks::bind_thunk)}
 {
@@ -551,12 +556,17 @@ uint32_t const mw::Shm::Format::yvu422;
 uint32_t const mw::Shm::Format::yuv444;
 uint32_t const mw::Shm::Format::yvu444;
 
-mw::Shm::Global::Global(wl_display* display, Version<1>)
+mw::Shm::Global::Global(wl_display* display, Version<1> version)
+    : Global{display, version, Thunks::supported_version}
+{
+}
+
+mw::Shm::Global::Global(wl_display* display, Version<1>, int advertised_version)
     : wayland::Global{
           wl_global_create(
               display,
               &wl_shm_interface_data,
-              Thunks::supported_version,
+              std::min(advertised_version, Thunks::supported_version),
               this,
               &Thunks::bind_thunk)}
 {
@@ -1435,12 +1445,17 @@ uint32_t const mw::DataDeviceManager::DndAction::copy;
 uint32_t const mw::DataDeviceManager::DndAction::move;
 uint32_t const mw::DataDeviceManager::DndAction::ask;
 
-mw::DataDeviceManager::Global::Global(wl_display* display, Version<3>)
+mw::DataDeviceManager::Global::Global(wl_display* display, Version<3> version)
+    : Global{display, version, Thunks::supported_version}
+{
+}
+
+mw::DataDeviceManager::Global::Global(wl_display* display, Version<3>, int advertised_version)
     : wayland::Global{
           wl_global_create(
               display,
               &wl_data_device_manager_interface_data,
-              Thunks::supported_version,
+              std::min(advertised_version, Thunks::supported_version),
               this,
               &Thunks::bind_thunk)}
 {
@@ -1568,12 +1583,17 @@ void mw::Shell::destroy_and_delete() const
 
 uint32_t const mw::Shell::Error::role;
 
-mw::Shell::Global::Global(wl_display* display, Version<1>)
+mw::Shell::Global::Global(wl_display* display, Version<1> version)
+    : Global{display, version, Thunks::supported_version}
+{
+}
+
+mw::Shell::Global::Global(wl_display* display, Version<1>, int advertised_version)
     : wayland::Global{
           wl_global_create(
               display,
               &wl_shell_interface_data,
-              Thunks::supported_version,
+              std::min(advertised_version, Thunks::supported_version),
               this,
               &Thunks::bind_thunk)}
 {
@@ -2430,12 +2450,17 @@ uint32_t const mw::Seat::Capability::keyboard;
 uint32_t const mw::Seat::Capability::touch;
 uint32_t const mw::Seat::Error::missing_capability;
 
-mw::Seat::Global::Global(wl_display* display, Version<8>)
+mw::Seat::Global::Global(wl_display* display, Version<8> version)
+    : Global{display, version, Thunks::supported_version}
+{
+}
+
+mw::Seat::Global::Global(wl_display* display, Version<8>, int advertised_version)
     : wayland::Global{
           wl_global_create(
               display,
               &wl_seat_interface_data,
-              Thunks::supported_version,
+              std::min(advertised_version, Thunks::supported_version),
               this,
               &Thunks::bind_thunk)}
 {
@@ -3304,12 +3329,17 @@ uint32_t const mw::Output::Transform::flipped_270;
 uint32_t const mw::Output::Mode::current;
 uint32_t const mw::Output::Mode::preferred;
 
-mw::Output::Global::Global(wl_display* display, Version<4>)
+mw::Output::Global::Global(wl_display* display, Version<4> version)
+    : Global{display, version, Thunks::supported_version}
+{
+}
+
+mw::Output::Global::Global(wl_display* display, Version<4>, int advertised_version)
     : wayland::Global{
           wl_global_create(
               display,
               &wl_output_interface_data,
-              Thunks::supported_version,
+              std::min(advertised_version, Thunks::supported_version),
               this,
               &Thunks::bind_thunk)}
 {
@@ -3566,12 +3596,17 @@ bool mw::Subcompositor::is_instance(wl_resource* resource)
 
 uint32_t const mw::Subcompositor::Error::bad_surface;
 
-mw::Subcompositor::Global::Global(wl_display* display, Version<1>)
+mw::Subcompositor::Global::Global(wl_display* display, Version<1> version)
+    : Global{display, version, Thunks::supported_version}
+{
+}
+
+mw::Subcompositor::Global::Global(wl_display* display, Version<1>, int advertised_version)
     : wayland::Global{
           wl_global_create(
               display,
               &wl_subcompositor_interface_data,
-              Thunks::supported_version,
+              std::min(advertised_version, Thunks::supported_version),
               this,
               &Thunks::bind_thunk)}
 {
@@ -87,6 +87,8 @@ public:
     {
     public:
         Global(wl_display* display, Version<4>);
+        /// Advertises advertised_version, for when clients must not use the newest supported version
+        Global(wl_display* display, Version<4>, int advertised_version);
 
         auto interface_name() const -> char const* override;
 
@@ -216,6 +218,8 @@ public:
     {
     public:
         Global(wl_display* display, Version<1>);
+        /// Advertises advertised_version, for when clients must not use the newest supported version
+        Global(wl_display* display, Version<1>, int advertised_version);
 
         auto interface_name() const -> char const* override;
 
@@ -417,6 +421,8 @@ public:
     {
     public:
         Global(wl_display* display, Version<3>);
+        /// Advertises advertised_version, for when clients must not use the newest supported version
+        Global(wl_display* display, Version<3>, int advertised_version);
 
         auto interface_name() const -> char const* override;
 
@@ -455,6 +461,8 @@ public:
     {
     public:
         Global(wl_display* display, Version<1>);
+        /// Advertises advertised_version, for when clients must not use the newest supported version
+        Global(wl_display* display, Version<1>, int advertised_version);
 
         auto interface_name() const -> char const* override;
 
@@ -616,6 +624,8 @@ public:
     {
     public:
         Global(wl_display* display, Version<8>);
+        /// Advertises advertised_version, for when clients must not use the newest supported version
+        Global(wl_display* display, Version<8>, int advertised_version);
 
         auto interface_name() const -> char const* override;
 
@@ -871,6 +881,8 @@ public:
     {
     public:
         Global(wl_display* display, Version<4>);
+        /// Advertises advertised_version, for when clients must not use the newest supported version
+        Global(wl_display* display, Version<4>, int advertised_version);
 
         auto interface_name() const -> char const* override;
 
@@ -926,6 +938,8 @@ public:
     {
     public:
         Global(wl_display* display, Version<1>);
+        /// Advertises advertised_version, for when clients must not use the newest supported version
+        Global(wl_display* display, Version<1>, int advertised_version);
 
         auto interface_name() const -> char const* override;
 
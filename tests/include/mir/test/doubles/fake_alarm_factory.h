@@ -34,6 +34,8 @@ class FakeAlarmFactory : public time::AlarmFactory
 {
 public:
     FakeAlarmFactory();
+    /// Share clock with whatever else the test needs to agree with the alarms on the time
+    explicit FakeAlarmFactory(std::shared_ptr<AdvanceableClock> const& clock);
 
     std::unique_ptr<time::Alarm> create_alarm(
         std::function<void()> const& callback) override;
@@ -51,10 +51,19 @@ public:
     FakeRenderable(geometry::Rectangle display_area,
                    float opacity,
                    bool rectangular)
+        : FakeRenderable{display_area, opacity, rectangular, {}}
+    {
+    }
+
+    FakeRenderable(geometry::Rectangle display_area,
+                   float opacity,
+                   bool rectangular,
+                   geometry::Rectangles opaque_region)
         : buf{std::make_shared<StubBuffer>()},
           rect(display_area),
           opacity(opacity),
-          rectangular(rectangular)
+          rectangular(rectangular),
+          opaque_region_(std::move(opaque_region))
     {
     }
 
@@ -103,6 +112,16 @@ public:
         return std::optional<geometry::Rectangle>();
     }
 
+    auto damage() const -> std::optional<geometry::Rectangles> override
+    {
+        return std::nullopt;
+    }
+
+    auto opaque_region() const -> geometry::Rectangles override
+    {
+        return opaque_region_;
+    }
+
     auto surface_if_any() const
         -> std::optional<mir::scene::Surface const*> override
     {
@@ -114,6 +133,7 @@ private:
     mir::geometry::Rectangle rect;
     float opacity;
     bool rectangular;
+    geometry::Rectangles opaque_region_;
 };
 
 } // namespace doubles
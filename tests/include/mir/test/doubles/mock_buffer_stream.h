@@ -19,6 +19,7 @@
 
 #include "mir/compositor/buffer_stream.h"
 #include "mir/graphics/drm_formats.h"
+#include "mir/graphics/frame.h"
 #include "mir_toolkit/common.h"
 #include "stub_buffer.h"
 #include <gmock/gmock.h>
@@ -37,10 +38,11 @@ struct MockBufferStream : public compositor::BufferStream
         MOCK_METHOD(geometry::Size, size, (), (const override));
         MOCK_METHOD(geometry::RectangleD, source_rect, (), (const override));
         MOCK_METHOD(graphics::DRMFormat, pixel_format, (), (const override));
+        MOCK_METHOD(std::optional<geometry::Rectangles>, damage, (), (const override));
     };
 
     int buffers_ready_{0};
-    std::function<void(geometry::Size const&)> frame_posted_callback;
+    std::function<void(geometry::Rectangle const&)> frame_posted_callback;
     int buffers_ready(void const*)
     {
         if (buffers_ready_)
@@ -63,22 +65,36 @@ struct MockBufferStream : public compositor::BufferStream
 
         ON_CALL(*this, has_submitted_buffer())
             .WillByDefault(testing::Return(true));
+        ON_CALL(*this, stream_size())
+            .WillByDefault(testing::Return(buffer->size()));
         ON_CALL(*this, set_frame_posted_callback(testing::_))
             .WillByDefault(testing::Invoke([&](auto const& callback){ frame_posted_callback = callback; }));
         ON_CALL(*this, next_submission_for_compositor(testing::_))
             .WillByDefault(testing::Return(submission));
+        ON_CALL(*this, presenter(testing::_))
+            .WillByDefault(testing::Return(std::function<void(graphics::Presentation const&)>{[](auto const&){}}));
     }
     std::shared_ptr<StubBuffer> buffer { std::make_shared<StubBuffer>() };
     std::shared_ptr<MockSubmission> submission { std::make_shared<testing::NiceMock<MockSubmission>>() };
     MOCK_METHOD(std::shared_ptr<Submission>, next_submission_for_compositor, (void const*), (override));
-    MOCK_METHOD(void, set_frame_posted_callback, (std::function<void(geometry::Size const&)> const&), (override));
+    MOCK_METHOD(void, set_frame_posted_callback, (std::function<void(geometry::Rectangle const&)> const&), (override));
+    MOCK_METHOD(
+        void,
+        set_frame_presented_callback,
+        ((std::function<void(graphics::BufferID, graphics::Presentation const&)> const&)),
+        (override));
 
     MOCK_METHOD(
         void,
         submit_buffer,
-        (std::shared_ptr<graphics::Buffer> const&, geometry::Size, geometry::RectangleD),
+        (std::shared_ptr<graphics::Buffer> const&,
+            geometry::Size,
+            geometry::RectangleD,
+            std::optional<geometry::Rectangles> const&),
         (override));
     MOCK_METHOD(bool, has_submitted_buffer, (), (const override));
+    MOCK_METHOD(geometry::Size, stream_size, (), (const override));
+    MOCK_METHOD(std::function<void(graphics::Presentation const&)>, presenter, (void const*), (override));
 };
 }
 }
@@ -18,6 +18,7 @@
 #define MIR_TEST_DOUBLES_MOCK_COMPOSITOR_REPORT_H_
 
 #include "mir/compositor/compositor_report.h"
+#include "mir/graphics/frame.h"
 #include <gmock/gmock.h>
 
 namespace mir
@@ -36,6 +37,11 @@ public:
                  (compositor::CompositorReport::SubCompositorId, graphics::RenderableList const&), (override));
     MOCK_METHOD(void, rendered_frame, (compositor::CompositorReport::SubCompositorId), (override));
     MOCK_METHOD(void, finished_frame, (compositor::CompositorReport::SubCompositorId), (override));
+    MOCK_METHOD(void, presented_frame,
+                (compositor::CompositorReport::SubCompositorId, graphics::Presentation const&), (override));
+    MOCK_METHOD(void, scheduled_next_frame,
+                (compositor::CompositorReport::SubCompositorId, std::chrono::nanoseconds, std::chrono::nanoseconds),
+                (override));
     MOCK_METHOD(void, started, (), (override));
     MOCK_METHOD(void, stopped, (), (override));
     MOCK_METHOD(void, scheduled, (), (override));
@@ -37,10 +37,14 @@ public:
         using namespace testing;
         ON_CALL(*this, view_area())
             .WillByDefault(Return(geometry::Rectangle{{0,0},{0,0}}));
+        ON_CALL(*this, can_overlay())
+            .WillByDefault(Return(true));
     }
     MOCK_METHOD(geometry::Rectangle, view_area, (), (const override));
     MOCK_METHOD(geometry::Size, pixel_size, (), (const override));
     MOCK_METHOD(bool, overlay, (std::vector<graphics::DisplayElement> const&), (override));
+    MOCK_METHOD(size_t, overlay_topmost, (std::vector<graphics::DisplayElement> const&), (override));
+    MOCK_METHOD(bool, can_overlay, (), (const override));
     MOCK_METHOD(void, set_next_image, (std::unique_ptr<graphics::Framebuffer>), (override));
     MOCK_METHOD(glm::mat2, transformation, (), (const override));
     MOCK_METHOD(graphics::DisplayAllocator*, maybe_create_allocator, (graphics::DisplayAllocator::Tag const&), (override));
@@ -25,6 +25,7 @@
 
 #include <xf86drm.h>
 #include <xf86drmMode.h>
+#include <optional>
 #include <unordered_map>
 
 namespace mir
@@ -51,6 +52,17 @@ public:
                        std::vector<uint32_t>& possible_encoder_ids,
                        geometry::Size const& physical_size,
                        drmModeSubPixel subpixel_arrangement = DRM_MODE_SUBPIXEL_UNKNOWN);
+    /**
+     * Add a plane with the properties needed to drive it through atomic modesetting
+     *
+     * \param zpos  The plane's (settable) place in the stack, or nullopt if the driver
+     *              doesn't say where it stacks
+     */
+    void add_plane(
+        uint32_t plane_id,
+        uint32_t possible_crtcs_mask,
+        uint64_t type,
+        std::optional<uint64_t> zpos = 0);
 
     void prepare();
     void reset();
@@ -58,6 +70,10 @@ public:
     drmModeCrtc* find_crtc(uint32_t id);
     drmModeEncoder* find_encoder(uint32_t id);
     drmModeConnector* find_connector(uint32_t id);
+    drmModePlane* find_plane(uint32_t id);
+    drmModePlaneRes* plane_resources_ptr();
+    drmModeObjectProperties* find_object_properties(uint32_t object_id);
+    drmModePropertyRes* find_property(uint32_t property_id);
 
     enum ModePreference {NormalMode, PreferredMode};
     static drmModeModeInfo create_mode(uint16_t hdisplay, uint16_t vdisplay,
@@ -80,6 +96,19 @@ private:
     std::vector<drmModeModeInfo> modes;
     std::vector<drmModeModeInfo> modes_empty;
     std::vector<uint32_t> connector_encoder_ids;
+
+    struct PlaneProperties
+    {
+        std::vector<uint32_t> ids;
+        std::vector<uint64_t> values;
+        drmModeObjectProperties properties;
+    };
+
+    drmModePlaneRes plane_resources;
+    std::vector<drmModePlane> planes;
+    std::vector<uint32_t> plane_ids;
+    std::unordered_map<uint32_t, PlaneProperties> plane_properties;
+    std::vector<drmModePropertyRes> properties;
 };
 
 class MockDRM
@@ -125,6 +154,8 @@ public:
 
     MOCK_METHOD(int, drmModePageFlip,
                 (int fd, uint32_t crtc_id, uint32_t fb_id, uint32_t flags, void *user_data));
+    MOCK_METHOD(int, drmModeAtomicCommit,
+                (int fd, drmModeAtomicReqPtr req, uint32_t flags, void *user_data));
     MOCK_METHOD(int, drmHandleEvent, (int fd, drmEventContextPtr evctx));
 
     MOCK_METHOD(int, drmGetCap, (int fd, uint64_t capability, uint64_t *value));
@@ -163,6 +194,18 @@ public:
 
     MOCK_METHOD(int, drmCheckModesettingSupported, (char const*));
 
+    MOCK_METHOD(int, drmSyncobjCreate, (int fd, uint32_t flags, uint32_t* handle));
+    MOCK_METHOD(int, drmSyncobjDestroy, (int fd, uint32_t handle));
+    MOCK_METHOD(int, drmSyncobjFDToHandle, (int fd, int obj_fd, uint32_t* handle));
+    MOCK_METHOD(int, drmSyncobjImportSyncFile, (int fd, uint32_t handle, int sync_file_fd));
+    MOCK_METHOD(int, drmSyncobjExportSyncFile, (int fd, uint32_t handle, int* sync_file_fd));
+    MOCK_METHOD(int, drmSyncobjTimelineSignal, (int fd, uint32_t const* handles, uint64_t* points, uint32_t handle_count));
+    MOCK_METHOD(int, drmSyncobjTimelineWait, (int fd, uint32_t* handles, uint64_t* points, unsigned num_handles,
+                                             int64_t timeout_nsec, unsigned flags, uint32_t* first_signaled));
+    MOCK_METHOD(int, drmSyncobjTransfer, (int fd, uint32_t dst_handle, uint64_t dst_point,
+                                         uint32_t src_handle, uint64_t src_point, uint32_t flags));
+    MOCK_METHOD(int, drmSyncobjEventfd, (int fd, uint32_t handle, uint64_t point, int ev_fd, uint32_t flags));
+
     MOCK_METHOD(void*, mmap, (void* addr, size_t length, int prot, int flags, int fd, off_t offset));
     MOCK_METHOD(int, munmap, (void* addr, size_t length));
 
@@ -185,6 +228,12 @@ public:
         std::vector<uint32_t>& possible_encoder_ids,
         geometry::Size const& physical_size,
         drmModeSubPixel subpixel_arrangement = DRM_MODE_SUBPIXEL_UNKNOWN);
+    void add_plane(
+        char const* device,
+        uint32_t plane_id,
+        uint32_t possible_crtcs_mask,
+        uint64_t type,
+        std::optional<uint64_t> zpos = 0);
 
     void prepare(char const* device);
     void reset(char const* device);
@@ -32,6 +32,8 @@ public:
     MOCK_METHOD(std::unique_ptr<graphics::Framebuffer>, commit, (), (override));
     MOCK_METHOD(mir::geometry::Size, size, (), (const override));
     MOCK_METHOD(Layout, layout, (), (const override));
+    MOCK_METHOD(std::optional<unsigned>, buffer_age, (), (const override));
+    MOCK_METHOD(void, set_damage_hint, (mir::geometry::Rectangles const&), (override));
 };
 }
 
@@ -18,6 +18,7 @@
 #define MIR_TEST_DOUBLES_MOCK_SCENE_H_
 
 #include "mir/compositor/scene.h"
+#include "mir/graphics/frame.h"
 #include <gmock/gmock.h>
 
 namespace mir
@@ -32,14 +33,17 @@ class MockScene : public compositor::Scene
 public:
     MockScene()
     {
-        ON_CALL(*this, scene_elements_for(testing::_))
+        ON_CALL(*this, scene_elements_for(testing::_, testing::_))
             .WillByDefault(testing::Return(compositor::SceneElementSequence{}));
         ON_CALL(*this, frames_pending(testing::_))
             .WillByDefault(testing::Return(0));
+        ON_CALL(*this, frame_presenter(testing::_))
+            .WillByDefault(testing::Return(std::function<void(graphics::Presentation const&)>{[](auto const&){}}));
     }
 
-    MOCK_METHOD1(scene_elements_for, compositor::SceneElementSequence(compositor::CompositorID));
+    MOCK_METHOD2(scene_elements_for, compositor::SceneElementSequence(compositor::CompositorID, geometry::Rectangle const&));
     MOCK_CONST_METHOD1(frames_pending, int(compositor::CompositorID));
+    MOCK_METHOD1(frame_presenter, std::function<void(graphics::Presentation const&)>(compositor::CompositorID));
     MOCK_METHOD1(register_compositor, void(compositor::CompositorID));
     MOCK_METHOD1(unregister_compositor, void(compositor::CompositorID));
 
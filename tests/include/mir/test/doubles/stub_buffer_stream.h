@@ -66,6 +66,11 @@ public:
             {
                 return graphics::DRMFormat::from_mir_format(mir_pixel_format_xbgr_8888);
             }
+
+            auto damage() const -> std::optional<geometry::Rectangles> override
+            {
+                return std::nullopt;
+            }
         private:
             std::shared_ptr<graphics::Buffer> const buf;
         };
@@ -77,12 +82,20 @@ public:
     void submit_buffer(
         std::shared_ptr<graphics::Buffer> const& b,
         geometry::Size /*dst_size*/,
-        geometry::RectangleD /*src_bounds*/) override
+        geometry::RectangleD /*src_bounds*/,
+        std::optional<geometry::Rectangles> const& /*damage*/) override
     {
         if (b) ++nready;
     }
-    void set_frame_posted_callback(std::function<void(geometry::Size const&)> const&) override {}
+    void set_frame_posted_callback(std::function<void(geometry::Rectangle const&)> const&) override {}
+    void set_frame_presented_callback(
+        std::function<void(graphics::BufferID, graphics::Presentation const&)> const&) override {}
     bool has_submitted_buffer() const override { return true; }
+    auto stream_size() const -> geometry::Size override { return stub_compositor_buffer->size(); }
+    auto presenter(void const*) -> std::function<void(graphics::Presentation const&)> override
+    {
+        return [](auto const&){};
+    }
 
     std::shared_ptr<graphics::Buffer> stub_compositor_buffer;
     int nready = 0;
@@ -30,10 +30,14 @@ namespace doubles
 class StubScene : public compositor::Scene
 {
 public:
-    compositor::SceneElementSequence scene_elements_for(compositor::CompositorID) override
+    compositor::SceneElementSequence scene_elements_for(compositor::CompositorID, geometry::Rectangle const&) override
     {
         return {};
     }
+    auto frame_presenter(compositor::CompositorID) -> std::function<void(graphics::Presentation const&)> override
+    {
+        return [](auto const&){};
+    }
     void register_compositor(compositor::CompositorID) override
     {
     }
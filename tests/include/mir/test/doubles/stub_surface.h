@@ -49,6 +49,14 @@ struct StubSurface : scene::Surface
     void set_transformation(glm::mat4 const&) override {}
     bool visible() const override { return false; }
     graphics::RenderableList generate_renderables(compositor::CompositorID) const override { return {}; }
+    graphics::RenderableList generate_renderables(compositor::CompositorID, geometry::Rectangle const&) const override
+    {
+        return {};
+    }
+    auto frame_presenter(compositor::CompositorID) const -> std::function<void(graphics::Presentation const&)> override
+    {
+        return [](auto const&){};
+    }
     MirWindowType type() const override { return mir_window_type_normal; }
     auto state_tracker() const -> scene::SurfaceStateTracker override
     {
@@ -129,7 +129,12 @@ bool mtd::FakeAlarmFactory::FakeAlarm::reschedule_for(mir::time::Timestamp timeo
 }
 
 mtd::FakeAlarmFactory::FakeAlarmFactory()
-    : clock{std::make_shared<mtd::AdvanceableClock>()}
+    : FakeAlarmFactory{std::make_shared<mtd::AdvanceableClock>()}
+{
+}
+
+mtd::FakeAlarmFactory::FakeAlarmFactory(std::shared_ptr<AdvanceableClock> const& clock)
+    : clock{clock}
 {
 }
 
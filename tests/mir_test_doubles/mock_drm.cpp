@@ -20,6 +20,7 @@
 #include "mir/geometry/size.h"
 #include <gtest/gtest.h>
 
+#include <cstring>
 #include <stdexcept>
 #include <unistd.h>
 #include <dlfcn.h>
@@ -32,10 +33,22 @@ namespace geom = mir::geometry;
 namespace
 {
 mtd::MockDRM* global_mock = nullptr;
+
+/// The plane properties atomic modesetting needs, in the order of their (fake) ids
+char const* const plane_property_names[] = {
+    "type", "FB_ID", "CRTC_ID",
+    "SRC_X", "SRC_Y", "SRC_W", "SRC_H",
+    "CRTC_X", "CRTC_Y", "CRTC_W", "CRTC_H",
+    "zpos"};
+uint32_t const first_plane_property_id{100};
+
+/// The range planes can be stacked over
+uint64_t zpos_range[] = {0, 255};
 }
 
 mtd::FakeDRMResources::FakeDRMResources()
-    : pipe_fds{-1, -1}
+    : pipe_fds{-1, -1},
+      plane_resources()
 {
     /* Use the read end of a pipe as the fake DRM fd */
     if (pipe(pipe_fds) < 0 || pipe_fds[0] < 0)
@@ -70,6 +83,23 @@ mtd::FakeDRMResources::FakeDRMResources()
                   modes, connector_encoder_ids,
                   geom::Size{121, 144});
 
+    uint32_t property_id{first_plane_property_id};
+    for (auto const name : plane_property_names)
+    {
+        drmModePropertyRes property = drmModePropertyRes();
+
+        property.prop_id = property_id++;
+        strncpy(property.name, name, DRM_PROP_NAME_LEN);
+        if (strcmp(name, "zpos") == 0)
+        {
+            property.flags = DRM_MODE_PROP_RANGE;
+            property.count_values = 2;
+            property.values = zpos_range;
+        }
+
+        properties.push_back(property);
+    }
+
     prepare();
 }
 
@@ -113,6 +143,11 @@ void mtd::FakeDRMResources::prepare()
     for (auto const& connector: connectors)
         connector_ids.push_back(connector.connector_id);
     resources.connectors = connector_ids.data();
+
+    plane_resources.count_planes = planes.size();
+    for (auto const& plane: planes)
+        plane_ids.push_back(plane.plane_id);
+    plane_resources.planes = plane_ids.data();
 }
 
 void mtd::FakeDRMResources::reset()
@@ -126,6 +161,11 @@ void mtd::FakeDRMResources::reset()
     crtc_ids.clear();
     encoder_ids.clear();
     connector_ids.clear();
+
+    plane_resources = drmModePlaneRes();
+    planes.clear();
+    plane_ids.clear();
+    plane_properties.clear();
 }
 
 void mtd::FakeDRMResources::add_crtc(uint32_t id, drmModeModeInfo mode)
@@ -176,6 +216,40 @@ void mtd::FakeDRMResources::add_connector(uint32_t connector_id,
     connectors.push_back(connector);
 }
 
+void mtd::FakeDRMResources::add_plane(
+    uint32_t plane_id,
+    uint32_t possible_crtcs_mask,
+    uint64_t type,
+    std::optional<uint64_t> zpos)
+{
+    drmModePlane plane = drmModePlane();
+
+    plane.plane_id = plane_id;
+    plane.possible_crtcs = possible_crtcs_mask;
+
+    planes.push_back(plane);
+
+    auto& props = plane_properties[plane_id];
+    for (auto const& property : properties)
+    {
+        if (strcmp(property.name, "zpos") == 0)
+        {
+            if (zpos)
+            {
+                props.ids.push_back(property.prop_id);
+                props.values.push_back(*zpos);
+            }
+            continue;
+        }
+        props.ids.push_back(property.prop_id);
+        props.values.push_back(strcmp(property.name, "type") == 0 ? type : 0);
+    }
+    props.properties = drmModeObjectProperties();
+    props.properties.count_props = props.ids.size();
+    props.properties.props = props.ids.data();
+    props.properties.prop_values = props.values.data();
+}
+
 drmModeCrtc* mtd::FakeDRMResources::find_crtc(uint32_t id)
 {
     for (auto& crtc : crtcs)
@@ -207,6 +281,38 @@ drmModeConnector* mtd::FakeDRMResources::find_connector(uint32_t id)
 }
 
 
+drmModePlane* mtd::FakeDRMResources::find_plane(uint32_t id)
+{
+    for (auto& plane : planes)
+    {
+        if (plane.plane_id == id)
+            return &plane;
+    }
+    return nullptr;
+}
+
+drmModePlaneRes* mtd::FakeDRMResources::plane_resources_ptr()
+{
+    // Drivers without planes fail to provide any plane resources
+    return planes.empty() ? nullptr : &plane_resources;
+}
+
+drmModeObjectProperties* mtd::FakeDRMResources::find_object_properties(uint32_t object_id)
+{
+    auto const props = plane_properties.find(object_id);
+    return props != plane_properties.end() ? &props->second.properties : nullptr;
+}
+
+drmModePropertyRes* mtd::FakeDRMResources::find_property(uint32_t property_id)
+{
+    for (auto& property : properties)
+    {
+        if (property.prop_id == property_id)
+            return &property;
+    }
+    return nullptr;
+}
+
 drmModeModeInfo mtd::FakeDRMResources::create_mode(uint16_t hdisplay, uint16_t vdisplay,
                                                    uint32_t clock, uint16_t htotal,
                                                    uint16_t vtotal,
@@ -332,8 +438,46 @@ mtd::MockDRM::MockDRM()
                     return fd_to_drm.at(fd).find_connector(connector_id);
                 }));
 
+    ON_CALL(*this, drmModeGetPlaneResources(_))
+        .WillByDefault(
+            Invoke(
+                [this](int fd)
+                {
+                    return fd_to_drm.at(fd).plane_resources_ptr();
+                }));
+
+    ON_CALL(*this, drmModeGetPlane(_, _))
+        .WillByDefault(
+            Invoke(
+                [this](int fd, uint32_t plane_id)
+                {
+                    return fd_to_drm.at(fd).find_plane(plane_id);
+                }));
+
     ON_CALL(*this, drmModeObjectGetProperties(_, _, _))
-        .WillByDefault(Return(&empty_object_props));
+        .WillByDefault(
+            Invoke(
+                [this](int fd, uint32_t id, uint32_t)
+                {
+                    auto const drm = fd_to_drm.find(fd);
+                    if (drm != fd_to_drm.end())
+                    {
+                        if (auto const props = drm->second.find_object_properties(id))
+                        {
+                            return props;
+                        }
+                    }
+                    return &empty_object_props;
+                }));
+
+    ON_CALL(*this, drmModeGetProperty(_, _))
+        .WillByDefault(
+            Invoke(
+                [this](int fd, uint32_t property_id) -> drmModePropertyPtr
+                {
+                    auto const drm = fd_to_drm.find(fd);
+                    return drm != fd_to_drm.end() ? drm->second.find_property(property_id) : nullptr;
+                }));
 
     ON_CALL(*this, drmSetInterfaceVersion(_, _))
         .WillByDefault(
@@ -437,6 +581,16 @@ void mtd::MockDRM::add_encoder(
     fake_drms[device].add_encoder(encoder_id, crtc_id, possible_crtcs_mask);
 }
 
+void mtd::MockDRM::add_plane(
+    char const* device,
+    uint32_t plane_id,
+    uint32_t possible_crtcs_mask,
+    uint64_t type,
+    std::optional<uint64_t> zpos)
+{
+    fake_drms[device].add_plane(plane_id, possible_crtcs_mask, type, zpos);
+}
+
 void mtd::MockDRM::prepare(char const *device)
 {
     fake_drms[device].prepare();
@@ -747,6 +901,11 @@ int drmModePageFlip(int fd, uint32_t crtc_id, uint32_t fb_id,
                                         flags, user_data);
 }
 
+int drmModeAtomicCommit(int fd, drmModeAtomicReqPtr req, uint32_t flags, void *user_data)
+{
+    return global_mock->drmModeAtomicCommit(fd, req, flags, user_data);
+}
+
 int drmHandleEvent(int fd, drmEventContextPtr evctx)
 {
     return global_mock->drmHandleEvent(fd, evctx);
@@ -826,4 +985,51 @@ int drmCheckModesettingSupported(char const* busid)
 {
     return global_mock->drmCheckModesettingSupported(busid);
 }
+
+int drmSyncobjCreate(int fd, uint32_t flags, uint32_t* handle)
+{
+    return global_mock->drmSyncobjCreate(fd, flags, handle);
+}
+
+int drmSyncobjDestroy(int fd, uint32_t handle)
+{
+    return global_mock->drmSyncobjDestroy(fd, handle);
+}
+
+int drmSyncobjFDToHandle(int fd, int obj_fd, uint32_t* handle)
+{
+    return global_mock->drmSyncobjFDToHandle(fd, obj_fd, handle);
+}
+
+int drmSyncobjImportSyncFile(int fd, uint32_t handle, int sync_file_fd)
+{
+    return global_mock->drmSyncobjImportSyncFile(fd, handle, sync_file_fd);
+}
+
+int drmSyncobjExportSyncFile(int fd, uint32_t handle, int* sync_file_fd)
+{
+    return global_mock->drmSyncobjExportSyncFile(fd, handle, sync_file_fd);
+}
+
+int drmSyncobjTimelineSignal(int fd, uint32_t const* handles, uint64_t* points, uint32_t handle_count)
+{
+    return global_mock->drmSyncobjTimelineSignal(fd, handles, points, handle_count);
+}
+
+int drmSyncobjTimelineWait(
+    int fd, uint32_t* handles, uint64_t* points, unsigned num_handles,
+    int64_t timeout_nsec, unsigned flags, uint32_t* first_signaled)
+{
+    return global_mock->drmSyncobjTimelineWait(fd, handles, points, num_handles, timeout_nsec, flags, first_signaled);
+}
+
+int drmSyncobjTransfer(int fd, uint32_t dst_handle, uint64_t dst_point, uint32_t src_handle, uint64_t src_point, uint32_t flags)
+{
+    return global_mock->drmSyncobjTransfer(fd, dst_handle, dst_point, src_handle, src_point, flags);
+}
+
+int drmSyncobjEventfd(int fd, uint32_t handle, uint64_t point, int ev_fd, uint32_t flags)
+{
+    return global_mock->drmSyncobjEventfd(fd, handle, point, ev_fd, flags);
+}
 }
@@ -88,12 +88,16 @@ auto mtd::StubBufferAllocator::buffer_from_resource(wl_resource*, std::function<
 
 auto mtd::StubBufferAllocator::buffer_from_shm(
     std::shared_ptr<mir::renderer::software::RWMappableBuffer> data,
+    std::shared_ptr<mg::Buffer> const& previous,
+    std::optional<mir::geometry::Rectangles> const& damage,
     std::function<void()>&& on_consumed,
     std::function<void()>&& on_release) -> std::shared_ptr<mg::Buffer>
 {
     auto buffer = std::make_shared<mg::common::NotifyingMappableBackedShmBuffer>(
         std::move(data),
         std::make_shared<mg::common::EGLContextExecutor>(std::make_unique<mtd::NullGLContext>()),
+        previous,
+        damage,
         std::move(on_consumed),
         std::move(on_release));
 
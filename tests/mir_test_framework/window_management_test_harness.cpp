@@ -84,6 +84,7 @@ struct mir_test_framework::WindowManagementTestHarness::Self : public ms::Surfac
     void entered_output(ms::Surface const*, mg::DisplayConfigurationOutputId const&) override {}
     void left_output(ms::Surface const*, mg::DisplayConfigurationOutputId const&) override {}
     void rescale_output(ms::Surface const*, mg::DisplayConfigurationOutputId const&) override {}
+    void input_region_set_to(ms::Surface const*, std::vector<geom::Rectangle> const&) override {}
     std::mutex mutable mutex;
     std::vector<std::shared_ptr<mc::BufferStream>> streams;
     std::vector<std::shared_ptr<ms::Surface>> known_surfaces;
@@ -0,0 +1,180 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "microbenchmark.h"
+
+#include "src/platforms/evdev/libinput_device.h"
+#include "src/server/input/default_event_builder.h"
+
+#include "mir/events/event_builders.h"
+#include "mir/events/event_pool.h"
+#include "mir/input/input_report.h"
+#include "mir/input/input_sink.h"
+#include "mir/geometry/rectangle.h"
+#include "mir/time/steady_clock.h"
+#include "mir_test_framework/libinput_environment.h"
+
+#include <gtest/gtest.h>
+#include <libinput.h>
+#include <linux/input.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <vector>
+
+namespace mt = mir::test;
+namespace mtf = mir_test_framework;
+namespace mi = mir::input;
+namespace mie = mi::evdev;
+namespace mev = mir::events;
+namespace geom = mir::geometry;
+
+namespace
+{
+std::atomic<long> heap_allocations{0};
+}
+
+// Count every heap allocation in the process, so the benchmarks can report those made per event
+void* operator new(std::size_t size)
+{
+    ++heap_allocations;
+    if (auto const block = std::malloc(size ? size : 1))
+    {
+        return block;
+    }
+    throw std::bad_alloc{};
+}
+
+void operator delete(void* block) noexcept
+{
+    std::free(block);
+}
+
+void operator delete(void* block, std::size_t) noexcept
+{
+    std::free(block);
+}
+
+namespace
+{
+int const events_per_run = 100;
+int const runs = 1'000;
+
+struct NullReport : mi::InputReport
+{
+    void received_event_from_kernel(int64_t, int, int, int) override {}
+};
+
+/// Holds on to each event until the next arrives, after copying it as the SurfaceInputDispatcher does when delivering
+struct DeliveringSink : mi::InputSink
+{
+    void handle_input(std::shared_ptr<MirEvent> const& event) override
+    {
+        delivered = mev::share(mev::clone_event(*event));
+    }
+
+    auto bounding_rectangle() const -> geom::Rectangle override
+    {
+        return {{0, 0}, {1920, 1080}};
+    }
+
+    auto output_info(uint32_t) const -> mi::OutputInfo override
+    {
+        return {};
+    }
+
+    void key_state(std::vector<uint32_t> const&) override {}
+    void pointer_state(MirPointerButtons) override {}
+
+    std::shared_ptr<MirEvent const> delivered;
+};
+
+struct InputEventBenchmark : testing::Test
+{
+    mtf::LibInputEnvironment env;
+    std::shared_ptr<libinput> const lib{mie::make_libinput(nullptr)};
+    DeliveringSink sink;
+    mi::DefaultEventBuilder builder{MirInputDeviceId{3}, std::make_shared<mir::time::SteadyClock>()};
+
+    /// Replays events (set up once, as mock_libinput looks events up linearly) through device as fast as possible
+    void drive(std::string const& name, mie::LibInputDevice& device, std::vector<libinput_event*> const& events)
+    {
+        device.start(&sink, &builder);
+
+        // Let the event pool grow to its steady state size
+        for (auto const event : events)
+        {
+            device.process_event(event);
+        }
+
+        long allocations{0};
+        auto const per_run = mt::benchmark(
+            name,
+            runs,
+            [] { return 0; },
+            [&](int)
+            {
+                auto const before = heap_allocations.load();
+                for (auto const event : events)
+                {
+                    device.process_event(event);
+                }
+                allocations += heap_allocations.load() - before;
+            });
+
+        auto const allocations_per_event = static_cast<double>(allocations) / (runs * events.size());
+        std::cout << "[ BENCHMARK] " << name << ": " << per_run.count() / events.size() << " ns/event, "
+                  << allocations_per_event << " heap allocations/event (including mock_libinput's own)" << std::endl;
+        RecordProperty(name + "_allocations_per_event", std::to_string(allocations_per_event));
+
+        device.stop();
+    }
+};
+}
+
+TEST_F(InputEventBenchmark, pointer_motion)
+{
+    auto const fake_device = env.setup_device(mtf::LibInputEnvironment::usb_mouse);
+    mie::LibInputDevice mouse{std::make_shared<NullReport>(), mie::make_libinput_device(lib, fake_device)};
+
+    std::vector<libinput_event*> events;
+    for (auto i = 0; i != events_per_run; ++i)
+    {
+        events.push_back(env.mock_libinput.setup_pointer_event(fake_device, 1000 * i, i % 2 ? 1.0f : -1.0f, 0.5f));
+    }
+
+    drive("pointer_motion", mouse, events);
+}
+
+TEST_F(InputEventBenchmark, key_presses)
+{
+    auto const fake_device = env.setup_device(mtf::LibInputEnvironment::laptop_keyboard);
+    mie::LibInputDevice keyboard{std::make_shared<NullReport>(), mie::make_libinput_device(lib, fake_device)};
+
+    std::vector<libinput_event*> events;
+    for (auto i = 0; i != events_per_run; ++i)
+    {
+        events.push_back(env.mock_libinput.setup_key_event(
+            fake_device,
+            1000 * i,
+            KEY_A,
+            i % 2 ? LIBINPUT_KEY_STATE_RELEASED : LIBINPUT_KEY_STATE_PRESSED));
+    }
+
+    drive("key_presses", keyboard, events);
+}
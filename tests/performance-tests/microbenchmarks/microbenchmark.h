@@ -0,0 +1,60 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_TEST_MICROBENCHMARK_H_
+#define MIR_TEST_MICROBENCHMARK_H_
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <iostream>
+#include <string>
+
+namespace mir
+{
+namespace test
+{
+/**
+ * Times \a iterations runs of \a operation, each preceded by an untimed \a setup
+ * whose result is passed to \a operation.
+ *
+ * The mean time per run is printed and recorded as a property of the current test
+ * (so it ends up in --gtest_output reports); benchmarks don't fail on timing.
+ */
+template<typename Setup, typename Operation>
+auto benchmark(std::string const& name, int iterations, Setup&& setup, Operation&& operation)
+    -> std::chrono::nanoseconds
+{
+    using clock = std::chrono::steady_clock;
+
+    clock::duration total{0};
+    for (auto i = 0; i != iterations; ++i)
+    {
+        auto input = setup();
+        auto const start = clock::now();
+        operation(input);
+        total += clock::now() - start;
+    }
+
+    auto const mean = std::chrono::duration_cast<std::chrono::nanoseconds>(total / iterations);
+    std::cout << "[ BENCHMARK] " << name << ": " << mean.count() << " ns/iteration" << std::endl;
+    ::testing::Test::RecordProperty(name, std::to_string(mean.count()));
+    return mean;
+}
+}
+}
+
+#endif // MIR_TEST_MICROBENCHMARK_H_
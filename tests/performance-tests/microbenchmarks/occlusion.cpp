@@ -0,0 +1,99 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "microbenchmark.h"
+
+#include "mir/geometry/rectangle.h"
+#include "src/server/compositor/occlusion.h"
+#include "mir/test/doubles/fake_renderable.h"
+#include "mir/test/doubles/stub_scene_element.h"
+
+#include <gtest/gtest.h>
+
+namespace mc = mir::compositor;
+namespace mt = mir::test;
+namespace mtd = mir::test::doubles;
+namespace geom = mir::geometry;
+
+namespace
+{
+geom::Rectangle const screen{{0, 0}, {1920, 1200}};
+
+auto iterations_for(int windows) -> int
+{
+    return 100'000 / windows;
+}
+
+struct OcclusionBenchmark : testing::TestWithParam<int>
+{
+    void add(geom::Rectangle const& rect)
+    {
+        scene.push_back(std::make_shared<mtd::StubSceneElement>(std::make_shared<mtd::FakeRenderable>(rect)));
+    }
+
+    auto name(char const* scene_type) const -> std::string
+    {
+        return std::string{scene_type} + "_" + std::to_string(GetParam()) + "_windows";
+    }
+
+    void run(std::string const& name)
+    {
+        mt::benchmark(
+            name,
+            iterations_for(GetParam()),
+            [this] { return scene; },
+            [this](mc::SceneElementSequence& elements) { occluded = mc::filter_occlusions_from(elements, screen); });
+    }
+
+    mc::SceneElementSequence scene;
+    mc::SceneElementSequence occluded;
+};
+}
+
+// Overlapping windows of a typical desktop, none of them completely hidden
+TEST_P(OcclusionBenchmark, cascaded_windows)
+{
+    auto const windows = GetParam();
+    for (auto i = 0; i != windows; ++i)
+    {
+        add({{(i * 37) % 1120, (i * 23) % 600}, {800, 600}});
+    }
+
+    run(name("cascaded"));
+}
+
+// Half the windows tiled over the screen, hiding the other half between them
+TEST_P(OcclusionBenchmark, windows_hidden_behind_tiles)
+{
+    auto const windows = GetParam();
+    auto const tiles = windows / 2;
+    for (auto i = tiles; i != windows; ++i)
+    {
+        add({{(i * 37) % 1520, (i * 23) % 800}, {400, 400}});
+    }
+    auto const tile_width = screen.size.width.as_int() / tiles;
+    for (auto i = 0; i != tiles; ++i)
+    {
+        auto const width = i + 1 == tiles ? screen.size.width.as_int() - i * tile_width : tile_width;
+        add({{i * tile_width, 0}, {width, screen.size.height.as_int()}});
+    }
+
+    run(name("tiled"));
+
+    EXPECT_THAT(occluded.size(), testing::Eq(static_cast<size_t>(windows - tiles)));
+}
+
+INSTANTIATE_TEST_SUITE_P(Occlusion, OcclusionBenchmark, testing::Values(10, 100, 1000));
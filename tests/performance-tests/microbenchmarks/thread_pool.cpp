@@ -0,0 +1,114 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "microbenchmark.h"
+
+#include "mir/executor.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace mt = mir::test;
+
+namespace
+{
+int const burst_size = 1000;
+
+/// Starts a thread for every piece of work, as the ThreadPoolExecutor effectively did under bursts
+struct ThreadPerTask : mir::Executor
+{
+    void spawn(std::function<void()>&& work) override
+    {
+        std::thread{std::move(work)}.detach();
+    }
+};
+
+/// Counts down as work completes, and lets the benchmark wait for it all
+struct Countdown
+{
+    explicit Countdown(int count) : remaining{count} {}
+
+    void done()
+    {
+        if (--remaining == 0)
+        {
+            std::lock_guard lock{mutex};
+            finished.notify_all();
+        }
+    }
+
+    void wait()
+    {
+        std::unique_lock lock{mutex};
+        finished.wait(lock, [this] { return remaining == 0; });
+    }
+
+    std::atomic<int> remaining;
+    std::mutex mutex;
+    std::condition_variable finished;
+};
+
+// The time between spawning a single piece of work and it completing
+void spawn_latency(std::string const& name, mir::Executor& executor)
+{
+    mt::benchmark(
+        name,
+        10'000,
+        [] { return std::make_shared<Countdown>(1); },
+        [&executor](std::shared_ptr<Countdown>& countdown)
+        {
+            executor.spawn([countdown] { countdown->done(); });
+            countdown->wait();
+        });
+}
+
+// The time taken to spawn, and complete, a burst of small pieces of work
+void burst_throughput(std::string const& name, mir::Executor& executor)
+{
+    mt::benchmark(
+        name,
+        100,
+        [] { return std::make_shared<Countdown>(burst_size); },
+        [&executor](std::shared_ptr<Countdown>& countdown)
+        {
+            for (auto i = 0; i != burst_size; ++i)
+            {
+                executor.spawn([countdown] { countdown->done(); });
+            }
+            countdown->wait();
+        });
+}
+}
+
+TEST(ThreadPoolBenchmark, spawn_latency)
+{
+    ThreadPerTask thread_per_task;
+
+    spawn_latency("thread_pool_spawn_latency", mir::thread_pool_executor);
+    spawn_latency("thread_per_task_spawn_latency", thread_per_task);
+}
+
+TEST(ThreadPoolBenchmark, burst_throughput)
+{
+    ThreadPerTask thread_per_task;
+
+    burst_throughput("thread_pool_burst_of_1000", mir::thread_pool_executor);
+    burst_throughput("thread_per_task_burst_of_1000", thread_per_task);
+}
@@ -0,0 +1,167 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "microbenchmark.h"
+
+#include "mir/wayland/client.h"
+#include "mir/wayland/resource.h"
+
+#include <wayland-server-core.h>
+#include <wayland-server-protocol.h>
+
+#include <gtest/gtest.h>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <system_error>
+#include <vector>
+
+namespace mt = mir::test;
+namespace mw = mir::wayland;
+
+namespace
+{
+/// Just enough of a Client for resources to find
+class StubClient : public mw::Client
+{
+public:
+    static auto create(wl_client* raw) -> std::shared_ptr<StubClient>
+    {
+        auto const shared = std::make_shared<StubClient>(raw);
+        register_client(raw, shared);
+        return shared;
+    }
+
+    explicit StubClient(wl_client* raw)
+        : raw{raw}
+    {
+    }
+
+    ~StubClient()
+    {
+        unregister_client(raw);
+    }
+
+    auto raw_client() const -> wl_client* override { return raw; }
+    auto is_being_destroyed() const -> bool override { return false; }
+    auto client_session() const -> std::shared_ptr<mir::scene::Session> override { return nullptr; }
+    auto next_serial(std::shared_ptr<MirEvent const>) -> uint32_t override { return 0; }
+    auto event_for(uint32_t) -> std::optional<std::shared_ptr<MirEvent const>> override { return std::nullopt; }
+    void set_output_geometry_scale(float) override {}
+    auto output_geometry_scale() -> float override { return 1; }
+
+private:
+    wl_client* const raw;
+};
+
+/// A display with a number of connected clients, as a server running many test clients has
+class ConnectedClients
+{
+public:
+    explicit ConnectedClients(int count)
+        : display{wl_display_create()}
+    {
+        for (auto i = 0; i != count; ++i)
+        {
+            int fds[2];
+            if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) != 0)
+            {
+                throw std::system_error{errno, std::system_category(), "Failed to create client socket"};
+            }
+            client_ends.push_back(fds[1]);
+
+            auto const raw = wl_client_create(display, fds[0]);
+            raw_clients.push_back(raw);
+            clients.push_back(StubClient::create(raw));
+        }
+    }
+
+    ~ConnectedClients()
+    {
+        for (auto const raw : raw_clients)
+        {
+            wl_client_destroy(raw);
+        }
+        clients.clear();
+        for (auto const fd : client_ends)
+        {
+            close(fd);
+        }
+        wl_display_destroy(display);
+    }
+
+    /// Each client in turn, so lookups aren't all for the first (or last) client to connect
+    auto next_client() -> wl_client*
+    {
+        return raw_clients[next++ % raw_clients.size()];
+    }
+
+private:
+    wl_display* const display;
+    std::vector<wl_client*> raw_clients;
+    std::vector<std::shared_ptr<StubClient>> clients;
+    std::vector<int> client_ends;
+    size_t next{0};
+};
+
+/// The libwayland side of a resource, such as the wl_callback clients create every frame
+struct RawCallback
+{
+    explicit RawCallback(wl_client* client)
+        : resource{wl_resource_create(client, &wl_callback_interface, 1, 0)}
+    {
+    }
+
+    ~RawCallback()
+    {
+        wl_resource_destroy(resource);
+    }
+
+    RawCallback(RawCallback const&) = delete;
+    RawCallback& operator=(RawCallback const&) = delete;
+
+    wl_resource* const resource;
+};
+
+// The time taken to create (and destroy) the Mir side of a resource, which looks up the resource's Client
+void resource_creation(int client_count)
+{
+    ConnectedClients connected{client_count};
+
+    mt::benchmark(
+        "resource_creation_with_" + std::to_string(client_count) + "_clients",
+        100'000,
+        [&connected] { return std::make_unique<RawCallback>(connected.next_client()); },
+        [](std::unique_ptr<RawCallback>& raw)
+        {
+            mw::Resource const resource{raw->resource};
+        });
+}
+}
+
+TEST(WaylandResourceBenchmark, resource_creation_with_50_clients)
+{
+    resource_creation(50);
+}
+
+TEST(WaylandResourceBenchmark, resource_creation_with_500_clients)
+{
+    resource_creation(500);
+}
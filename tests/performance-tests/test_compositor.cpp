@@ -29,12 +29,14 @@ struct CompositorPerformance : SystemPerformanceTest
     void SetUp() override
     {
         compositor_fps = compositor_render_time = -1.0f;
+        render_p50 = render_p99 = present_p99 = -1.0f;
+        missed_vblanks = 0;
         SystemPerformanceTest::set_up_with("--compositor-report=log");
     }
 
     void read_compositor_report()
     {
-        char line[256];
+        char line[512];
 
         const ::testing::TestInfo *const test_info =
                 ::testing::UnitTest::GetInstance()->current_test_info();
@@ -71,6 +73,23 @@ struct CompositorPerformance : SystemPerformanceTest
                     compositor_render_time = render_time;
                 }
             }
+            if (char const* latency = strstr(line, "latency p50/p90/p99/max: "))
+            {
+                float render[4], present[4];
+                unsigned long long missed;
+                if (9 == sscanf(latency, "latency p50/p90/p99/max: "
+                                "render %f/%f/%f/%f ms, schedule %*f/%*f/%*f/%*f ms, "
+                                "present %f/%f/%f/%f ms, %llu missed vblanks",
+                                &render[0], &render[1], &render[2], &render[3],
+                                &present[0], &present[1], &present[2], &present[3],
+                                &missed))
+                {
+                    render_p50 = render[0];
+                    render_p99 = render[2];
+                    present_p99 = present[2];
+                    missed_vblanks = missed;
+                }
+            }
             if (char const* renderer = strstr(line, "GL renderer: "))
             {
                 server_renderer.assign(renderer + 13, strlen(renderer) - 14);
@@ -83,6 +102,8 @@ struct CompositorPerformance : SystemPerformanceTest
     }
 
     float compositor_fps, compositor_render_time;
+    float render_p50, render_p99, present_p99;
+    unsigned long long missed_vblanks;
     std::string server_renderer, server_mode;
 };
 } // anonymous namespace
@@ -97,8 +118,14 @@ TEST_F(CompositorPerformance, regression_test_1563287)
     read_compositor_report();
     RecordProperty("framerate", std::to_string(compositor_fps));
     RecordProperty("render_time", std::to_string(compositor_render_time));
+    RecordProperty("render_time_p50", std::to_string(render_p50));
+    RecordProperty("render_time_p99", std::to_string(render_p99));
+    RecordProperty("present_latency_p99", std::to_string(present_p99));
+    RecordProperty("missed_vblanks", std::to_string(missed_vblanks));
     RecordProperty("server_renderer", server_renderer);
     RecordProperty("server_mode", server_mode);
     EXPECT_GE(compositor_fps, 0);
     EXPECT_GT(compositor_render_time, 0);
+    EXPECT_GT(render_p99, 0);
+    EXPECT_LE(render_p50, render_p99);
 }
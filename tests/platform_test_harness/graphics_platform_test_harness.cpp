@@ -456,6 +456,16 @@ void basic_software_buffer_drawing(
             this->top_left = top_left;
         }
 
+        auto damage() const -> std::optional<mir::geometry::Rectangles> override
+        {
+            return std::nullopt;
+        }
+
+        auto opaque_region() const -> mir::geometry::Rectangles override
+        {
+            return {};
+        }
+
         auto surface_if_any() const
             -> std::optional<mir::scene::Surface const*> override
         {
@@ -30,6 +30,8 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <algorithm>
+
 namespace mg = mir::graphics;
 namespace mc = mir::compositor;
 namespace geom = mir::geometry;
@@ -331,3 +333,194 @@ TEST_F(DefaultDisplayBufferCompositor, marks_occluded_scene_elements)
     compositor.composite({element0_occluded, element1_rendered, element2_occluded});
 }
 
+
+namespace
+{
+/// Can scan out the buffers of the given renderables, and only those
+struct ScanoutGlRenderingProvider : mtd::StubGlRenderingProvider
+{
+    ScanoutGlRenderingProvider(std::initializer_list<std::shared_ptr<mg::Renderable>> scannable)
+    {
+        for (auto const& renderable : scannable)
+        {
+            buffers.push_back(renderable->buffer());
+        }
+    }
+
+    auto make_framebuffer_provider(mg::DisplaySink&) -> std::unique_ptr<FramebufferProvider> override
+    {
+        struct StubFramebuffer : mg::Framebuffer
+        {
+            auto size() const -> geom::Size override
+            {
+                return {};
+            }
+        };
+
+        struct ScanoutFramebufferProvider : FramebufferProvider
+        {
+            ScanoutFramebufferProvider(std::vector<std::shared_ptr<mg::Buffer>> const& buffers) :
+                buffers{buffers}
+            {
+            }
+
+            auto buffer_to_framebuffer(std::shared_ptr<mg::Buffer> buffer) -> std::unique_ptr<mg::Framebuffer> override
+            {
+                if (std::find(buffers.begin(), buffers.end(), buffer) == buffers.end())
+                {
+                    return {};
+                }
+                return std::make_unique<StubFramebuffer>();
+            }
+
+            std::vector<std::shared_ptr<mg::Buffer>> const buffers;
+        };
+
+        return std::make_unique<ScanoutFramebufferProvider>(buffers);
+    }
+
+    std::vector<std::shared_ptr<mg::Buffer>> buffers;
+};
+}
+
+TEST_F(DefaultDisplayBufferCompositor, elements_the_display_overlays_are_not_rendered)
+{
+    using namespace testing;
+
+    ScanoutGlRenderingProvider scanout_provider{small};
+
+    EXPECT_CALL(display_sink, overlay_topmost(SizeIs(1)))
+        .WillOnce(Return(1));
+    EXPECT_CALL(mock_renderer, render(ContainerEq(mg::RenderableList{big})));
+
+    mc::DefaultDisplayBufferCompositor compositor(
+        display_sink,
+        scanout_provider,
+        mt::fake_shared(mock_renderer),
+        mr::null_compositor_report());
+
+    compositor.composite(make_scene_elements({
+        big,
+        small
+    }));
+}
+
+TEST_F(DefaultDisplayBufferCompositor, only_elements_above_any_needing_rendering_are_offered_to_overlay)
+{
+    using namespace testing;
+
+    auto const window = std::make_shared<mtd::FakeRenderable>(geom::Rectangle{{200, 300}, {10, 10}});
+    ScanoutGlRenderingProvider scanout_provider{fullscreen, window};
+
+    EXPECT_CALL(display_sink, overlay_topmost(SizeIs(1)))
+        .WillOnce(Return(0));
+    EXPECT_CALL(mock_renderer, render(ContainerEq(mg::RenderableList{fullscreen, big, window})));
+
+    mc::DefaultDisplayBufferCompositor compositor(
+        display_sink,
+        scanout_provider,
+        mt::fake_shared(mock_renderer),
+        mr::null_compositor_report());
+
+    compositor.composite(make_scene_elements({
+        fullscreen,
+        big,
+        window
+    }));
+}
+
+TEST_F(DefaultDisplayBufferCompositor, nothing_is_offered_to_overlay_when_the_display_cannot_overlay)
+{
+    using namespace testing;
+
+    ScanoutGlRenderingProvider scanout_provider{fullscreen, small};
+
+    ON_CALL(display_sink, can_overlay())
+        .WillByDefault(Return(false));
+    EXPECT_CALL(display_sink, overlay(_))
+        .Times(0);
+    EXPECT_CALL(display_sink, overlay_topmost(_))
+        .Times(0);
+    EXPECT_CALL(mock_renderer, render(ContainerEq(mg::RenderableList{fullscreen, small})));
+
+    mc::DefaultDisplayBufferCompositor compositor(
+        display_sink,
+        scanout_provider,
+        mt::fake_shared(mock_renderer),
+        mr::null_compositor_report());
+
+    compositor.composite(make_scene_elements({
+        fullscreen,
+        small
+    }));
+}
+
+namespace
+{
+/// Records each frame's scanout candidate
+struct CandidateRecordingGlRenderingProvider : mtd::StubGlRenderingProvider
+{
+    auto make_framebuffer_provider(mg::DisplaySink&) -> std::unique_ptr<FramebufferProvider> override
+    {
+        struct CandidateRecordingFramebufferProvider : FramebufferProvider
+        {
+            CandidateRecordingFramebufferProvider(std::vector<std::shared_ptr<mg::Buffer>>& candidates) :
+                candidates{candidates}
+            {
+            }
+
+            auto buffer_to_framebuffer(std::shared_ptr<mg::Buffer>) -> std::unique_ptr<mg::Framebuffer> override
+            {
+                return {};
+            }
+
+            void scanout_candidate(std::shared_ptr<mg::Buffer> const& buffer) override
+            {
+                candidates.push_back(buffer);
+            }
+
+            std::vector<std::shared_ptr<mg::Buffer>>& candidates;
+        };
+
+        return std::make_unique<CandidateRecordingFramebufferProvider>(candidates);
+    }
+
+    std::vector<std::shared_ptr<mg::Buffer>> candidates;
+};
+}
+
+TEST_F(DefaultDisplayBufferCompositor, topmost_fullscreen_buffer_is_the_scanout_candidate)
+{
+    using namespace testing;
+
+    CandidateRecordingGlRenderingProvider provider;
+
+    mc::DefaultDisplayBufferCompositor compositor(
+        display_sink,
+        provider,
+        mt::fake_shared(mock_renderer),
+        mr::null_compositor_report());
+
+    compositor.composite(make_scene_elements({big, fullscreen}));
+    compositor.composite(make_scene_elements({fullscreen, big}));
+
+    EXPECT_THAT(provider.candidates, ElementsAre(fullscreen->buffer(), nullptr));
+}
+
+TEST_F(DefaultDisplayBufferCompositor, translucent_fullscreen_buffer_is_not_a_scanout_candidate)
+{
+    using namespace testing;
+
+    auto const translucent = std::make_shared<mtd::FakeRenderable>(screen, 0.5f);
+    CandidateRecordingGlRenderingProvider provider;
+
+    mc::DefaultDisplayBufferCompositor compositor(
+        display_sink,
+        provider,
+        mt::fake_shared(mock_renderer),
+        mr::null_compositor_report());
+
+    compositor.composite(make_scene_elements({translucent}));
+
+    EXPECT_THAT(provider.candidates, ElementsAre(nullptr));
+}
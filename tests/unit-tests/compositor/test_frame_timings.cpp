@@ -0,0 +1,293 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/compositor/frame_timings.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+using namespace testing;
+using namespace std::chrono_literals;
+namespace mc = mir::compositor;
+namespace mg = mir::graphics;
+
+namespace
+{
+/// Whether arg is within the 1/32 precision of the histogram of value
+MATCHER_P(About, value, "")
+{
+    auto const tolerance = std::max(value / 32, decltype(value){1});
+    return value - tolerance <= arg && arg <= value + tolerance;
+}
+
+struct LatencyHistogram : Test
+{
+    mc::LatencyHistogram histogram;
+};
+
+struct FrameTimings : Test
+{
+    /// Composites a frame, scheduled now, that takes \a render to render and is shown \a vblanks after the last,
+    /// \a post after it finished
+    void frame(std::chrono::microseconds render, std::chrono::microseconds post, int vblanks = 1)
+    {
+        timings.scheduled(now);
+        timings.began_frame(display, now);
+        now += render;
+        timings.rendered_frame(display, now);
+        timings.finished_frame(display, now);
+        now += post;
+        present(vblanks);
+    }
+
+    /// Shows the oldest frame not yet presented, \a vblanks after the last
+    void present(int vblanks = 1)
+    {
+        msc += vblanks;
+        timings.presented_frame(display, now, mg::Presentation{{msc, mg::Frame::Timestamp{}}, 16ms, true});
+    }
+
+    mc::FrameTimings timings;
+    void const* const display{"display"};
+    mir::time::Timestamp now{};
+    int64_t msc{0};
+};
+}
+
+TEST_F(LatencyHistogram, is_empty_to_start_with)
+{
+    EXPECT_THAT(histogram.count(), Eq(0u));
+    EXPECT_THAT(histogram.percentile(0.5), Eq(0us));
+    EXPECT_THAT(histogram.max(), Eq(0us));
+}
+
+TEST_F(LatencyHistogram, short_durations_are_exact)
+{
+    for (auto i = 1; i <= 20; ++i)
+    {
+        histogram.record(std::chrono::microseconds{i});
+    }
+
+    EXPECT_THAT(histogram.count(), Eq(20u));
+    EXPECT_THAT(histogram.percentile(0.5), Eq(10us));
+    EXPECT_THAT(histogram.percentile(0.9), Eq(18us));
+    EXPECT_THAT(histogram.max(), Eq(20us));
+}
+
+TEST_F(LatencyHistogram, long_durations_are_within_precision)
+{
+    for (auto i = 1; i <= 1000; ++i)
+    {
+        histogram.record(std::chrono::milliseconds{i});
+    }
+
+    EXPECT_THAT(histogram.percentile(0.5), About(500'000us));
+    EXPECT_THAT(histogram.percentile(0.9), About(900'000us));
+    EXPECT_THAT(histogram.percentile(0.99), About(990'000us));
+    EXPECT_THAT(histogram.max(), Eq(1'000'000us));
+}
+
+TEST_F(LatencyHistogram, shows_tail_hidden_by_average)
+{
+    for (auto i = 0; i != 98; ++i)
+    {
+        histogram.record(1ms);
+    }
+    histogram.record(100ms);
+    histogram.record(100ms);
+
+    EXPECT_THAT(histogram.percentile(0.5), About(1000us));
+    EXPECT_THAT(histogram.percentile(0.99), About(100'000us));
+}
+
+TEST_F(LatencyHistogram, can_be_cleared)
+{
+    histogram.record(5ms);
+    histogram.clear();
+
+    EXPECT_THAT(histogram.count(), Eq(0u));
+    EXPECT_THAT(histogram.max(), Eq(0us));
+}
+
+TEST_F(FrameTimings, has_no_stats_for_unknown_display)
+{
+    EXPECT_THAT(timings.stats_for(display), Eq(std::nullopt));
+    EXPECT_THAT(timings.stats(), IsEmpty());
+}
+
+TEST_F(FrameTimings, records_render_time_and_present_latency)
+{
+    for (auto i = 0; i != 10; ++i)
+    {
+        timings.began_frame(display, now);
+        now += 2ms;
+        timings.rendered_frame(display, now);
+        timings.finished_frame(display, now);
+        now += 10ms;
+        present();
+        now += 50ms;
+    }
+
+    auto const stats = timings.stats_for(display);
+    ASSERT_THAT(stats, Ne(std::nullopt));
+    EXPECT_THAT(stats->frames, Eq(10u));
+    EXPECT_THAT(stats->render_time.p50, About(2000us));
+    EXPECT_THAT(stats->render_time.max, Eq(2ms));
+    EXPECT_THAT(stats->present_latency.p99, About(12'000us));
+    EXPECT_THAT(stats->present_latency.samples, Eq(10u));
+}
+
+TEST_F(FrameTimings, matches_each_presentation_to_the_frame_it_shows)
+{
+    // The second frame is composited while the first is still waiting for its flip
+    timings.began_frame(display, now);
+    now += 2ms;
+    timings.finished_frame(display, now);
+    now += 2ms;
+    timings.began_frame(display, now);
+    now += 2ms;
+    timings.finished_frame(display, now);
+    now += 10ms;
+    present();
+    now += 16ms;
+    present();
+
+    auto const stats = timings.stats_for(display);
+    ASSERT_THAT(stats, Ne(std::nullopt));
+    EXPECT_THAT(stats->present_latency.samples, Eq(2u));
+    EXPECT_THAT(stats->present_latency.p50, About(16'000us));
+    EXPECT_THAT(stats->present_latency.max, Eq(28ms));
+}
+
+TEST_F(FrameTimings, presentations_without_a_frame_are_ignored)
+{
+    present();
+
+    timings.began_frame(display, now);
+    timings.finished_frame(display, now);
+    now += 10ms;
+    present();
+    present();
+
+    auto const stats = timings.stats_for(display);
+    ASSERT_THAT(stats, Ne(std::nullopt));
+    EXPECT_THAT(stats->present_latency.samples, Eq(1u));
+    EXPECT_THAT(stats->present_latency.max, Eq(10ms));
+}
+
+TEST_F(FrameTimings, bypassed_frames_have_no_render_time)
+{
+    timings.began_frame(display, now);
+    now += 1ms;
+    timings.finished_frame(display, now);
+
+    auto const stats = timings.stats_for(display);
+    ASSERT_THAT(stats, Ne(std::nullopt));
+    EXPECT_THAT(stats->frames, Eq(1u));
+    EXPECT_THAT(stats->render_time.samples, Eq(0u));
+}
+
+TEST_F(FrameTimings, measures_schedule_latency_from_earliest_pending_schedule)
+{
+    timings.began_frame(display, now);
+    timings.finished_frame(display, now);
+
+    timings.scheduled(now + 1ms);
+    timings.scheduled(now + 3ms);
+    now += 5ms;
+    timings.began_frame(display, now);
+
+    auto const stats = timings.stats_for(display);
+    ASSERT_THAT(stats, Ne(std::nullopt));
+    EXPECT_THAT(stats->schedule_latency.samples, Eq(1u));
+    EXPECT_THAT(stats->schedule_latency.max, Eq(4ms));
+}
+
+TEST_F(FrameTimings, counts_vblanks_missed_between_back_to_back_frames)
+{
+    // A frame every vblank, each scheduled when the last was presented
+    timings.began_frame(display, now);
+    timings.finished_frame(display, now);
+    present();
+    for (auto i = 0; i != 5; ++i)
+    {
+        frame(2ms, 14ms);
+    }
+
+    // Then take long enough over one frame for the display to flip two vblanks late
+    frame(34ms, 14ms, 3);
+
+    auto const stats = timings.stats_for(display);
+    ASSERT_THAT(stats, Ne(std::nullopt));
+    EXPECT_THAT(stats->missed_vblanks, Eq(2u));
+}
+
+TEST_F(FrameTimings, idle_time_between_frames_is_not_a_missed_vblank)
+{
+    timings.began_frame(display, now);
+    timings.finished_frame(display, now);
+    present();
+    for (auto i = 0; i != 5; ++i)
+    {
+        frame(2ms, 14ms);
+    }
+
+    // Nothing to composite for a second, then a frame scheduled after the last was presented
+    now += 1s;
+    frame(2ms, 14ms, 62);
+
+    auto const stats = timings.stats_for(display);
+    ASSERT_THAT(stats, Ne(std::nullopt));
+    EXPECT_THAT(stats->missed_vblanks, Eq(0u));
+}
+
+TEST_F(FrameTimings, counts_no_missed_vblanks_where_the_display_cannot_say_when_frames_were_shown)
+{
+    timings.began_frame(display, now);
+    timings.finished_frame(display, now);
+    present();
+
+    timings.scheduled(now);
+    timings.began_frame(display, now);
+    now += 50ms;
+    timings.finished_frame(display, now);
+    timings.presented_frame(display, now, mg::Presentation{{0, mg::Frame::Timestamp{}}, {}, false});
+
+    auto const stats = timings.stats_for(display);
+    ASSERT_THAT(stats, Ne(std::nullopt));
+    EXPECT_THAT(stats->missed_vblanks, Eq(0u));
+}
+
+TEST_F(FrameTimings, takes_the_time_of_a_presentation_relative_to_now)
+{
+    mir::time::Timestamp const reading{1h};
+    mg::Presentation const presentation{{1, mg::Frame::Timestamp::now(CLOCK_MONOTONIC) - 5ms}, 16ms, true};
+
+    auto const shown = mc::FrameTimings::time_of(presentation, reading);
+
+    // Allowing for however long it's taken to get here
+    EXPECT_THAT(shown, Le(reading - 5ms));
+    EXPECT_THAT(shown, Gt(reading - 1s));
+}
+
+TEST_F(FrameTimings, can_be_cleared)
+{
+    timings.began_frame(display, now);
+    timings.finished_frame(display, now);
+    timings.clear();
+
+    EXPECT_THAT(timings.stats(), IsEmpty());
+}
@@ -117,7 +117,7 @@ TEST_F(MultiMonitorArbiter, compositor_access_before_any_submission_throws)
     }, std::logic_error);
 
     auto [buffer, size, source] = default_submission_data_from_buffer(buffers.front());
-    arbiter->submit_buffer(buffer, size, source);
+    arbiter->submit_buffer(buffer, size, source, std::nullopt);
 
     //something scheduled, should be ok
     arbiter->compositor_acquire(this);
@@ -126,7 +126,7 @@ TEST_F(MultiMonitorArbiter, compositor_access_before_any_submission_throws)
 TEST_F(MultiMonitorArbiter, compositor_access)
 {
     auto [buffer, size, source] = default_submission_data_from_buffer(buffers[0]);
-    arbiter->submit_buffer(buffer, size, source);
+    arbiter->submit_buffer(buffer, size, source, std::nullopt);
     auto cbuffer = arbiter->compositor_acquire(this);
     EXPECT_THAT(cbuffer->claim_buffer(), IsSameBufferAs(buffers[0]));
 }
@@ -136,14 +136,14 @@ TEST_F(MultiMonitorArbiter, compositor_release_sends_buffer_back)
     auto buffer_released = std::make_shared<bool>(false);
     auto notifying_buffer = wrap_with_destruction_notifier(buffers[0], buffer_released);
     auto [buffer, size, source] = default_submission_data_from_buffer(std::move(notifying_buffer));
-    arbiter->submit_buffer(std::move(buffer), size, source);
+    arbiter->submit_buffer(std::move(buffer), size, source, std::nullopt);
 
     auto cbuffer = arbiter->compositor_acquire(this);
     cbuffer->claim_buffer();
     cbuffer.reset();
     // We need to acquire a new buffer - the current one is on-screen, so can't be sent back.
     std::tie(buffer, size, source) = default_submission_data_from_buffer(buffers[1]);
-    arbiter->submit_buffer(buffer, size, source);
+    arbiter->submit_buffer(buffer, size, source, std::nullopt);
     arbiter->compositor_acquire(this)->claim_buffer();
 
     EXPECT_TRUE(*buffer_released);
@@ -152,10 +152,10 @@ TEST_F(MultiMonitorArbiter, compositor_release_sends_buffer_back)
 TEST_F(MultiMonitorArbiter, compositor_can_acquire_different_buffers)
 {
     auto [buffer, size, source] = default_submission_data_from_buffer(buffers[0]);
-    arbiter->submit_buffer(buffer, size, source);
+    arbiter->submit_buffer(buffer, size, source, std::nullopt);
     auto cbuffer1 = arbiter->compositor_acquire(this)->claim_buffer();
     std::tie(buffer, size, source) = default_submission_data_from_buffer(buffers[1]);
-    arbiter->submit_buffer(buffer, size, source);
+    arbiter->submit_buffer(buffer, size, source, std::nullopt);
     auto cbuffer2 = arbiter->compositor_acquire(this)->claim_buffer();
     EXPECT_THAT(cbuffer1, Not(IsSameBufferAs(cbuffer2)));
 }
@@ -166,21 +166,21 @@ TEST_F(MultiMonitorArbiter, compositor_buffer_syncs_to_fastest_compositor)
     int comp_id2{0};
 
     auto [buffer, size, source] = default_submission_data_from_buffer(buffers[0]);
-    arbiter->submit_buffer(buffer, size, source);
+    arbiter->submit_buffer(buffer, size, source, std::nullopt);
     auto cbuffer1 = arbiter->compositor_acquire(&comp_id1)->claim_buffer();
     auto cbuffer2 = arbiter->compositor_acquire(&comp_id2)->claim_buffer();
 
     std::tie(buffer, size, source) = default_submission_data_from_buffer(buffers[1]);
-    arbiter->submit_buffer(buffer, size, source);
+    arbiter->submit_buffer(buffer, size, source, std::nullopt);
     auto cbuffer3 = arbiter->compositor_acquire(&comp_id1)->claim_buffer();
 
     std::tie(buffer, size, source) = default_submission_data_from_buffer(buffers[0]);
-    arbiter->submit_buffer(buffer, size, source);
+    arbiter->submit_buffer(buffer, size, source, std::nullopt);
     auto cbuffer4 = arbiter->compositor_acquire(&comp_id1)->claim_buffer();
     auto cbuffer5 = arbiter->compositor_acquire(&comp_id2)->claim_buffer();
 
     std::tie(buffer, size, source) = default_submission_data_from_buffer(buffers[1]);
-    arbiter->submit_buffer(buffer, size, source);
+    arbiter->submit_buffer(buffer, size, source, std::nullopt);
     auto cbuffer6 = arbiter->compositor_acquire(&comp_id2)->claim_buffer();
     auto cbuffer7 = arbiter->compositor_acquire(&comp_id2)->claim_buffer();
 
@@ -196,23 +196,23 @@ TEST_F(MultiMonitorArbiter, compositor_buffer_syncs_to_fastest_compositor)
 TEST_F(MultiMonitorArbiter, compositor_consumes_all_buffers_when_operating_as_a_composited_scene_would)
 {
     auto [buffer, size, source] = default_submission_data_from_buffer(buffers[0]);
-    arbiter->submit_buffer(buffer, size, source);
+    arbiter->submit_buffer(buffer, size, source, std::nullopt);
     auto id1 = arbiter->compositor_acquire(this)->claim_buffer()->id();
 
     std::tie(buffer, size, source) = default_submission_data_from_buffer(buffers[1]);
-    arbiter->submit_buffer(buffer, size, source);
+    arbiter->submit_buffer(buffer, size, source, std::nullopt);
     auto id2 = arbiter->compositor_acquire(this)->claim_buffer()->id();
 
     std::tie(buffer, size, source) = default_submission_data_from_buffer(buffers[2]);
-    arbiter->submit_buffer(buffer, size, source);
+    arbiter->submit_buffer(buffer, size, source, std::nullopt);
     auto id3 = arbiter->compositor_acquire(this)->claim_buffer()->id();
 
     std::tie(buffer, size, source) = default_submission_data_from_buffer(buffers[3]);
-    arbiter->submit_buffer(buffer, size, source);
+    arbiter->submit_buffer(buffer, size, source, std::nullopt);
     auto id4 = arbiter->compositor_acquire(this)->claim_buffer()->id();
 
     std::tie(buffer, size, source) = default_submission_data_from_buffer(buffers[4]);
-    arbiter->submit_buffer(buffer, size, source);
+    arbiter->submit_buffer(buffer, size, source, std::nullopt);
     auto iddqd = arbiter->compositor_acquire(this)->claim_buffer()->id();
 
     EXPECT_THAT(id1, Eq(buffers[0]->id()));
@@ -225,30 +225,30 @@ TEST_F(MultiMonitorArbiter, compositor_consumes_all_buffers_when_operating_as_a_
 TEST_F(MultiMonitorArbiter, compositor_consumes_all_buffers_when_operating_as_a_bypassed_buffer_would)
 {
     auto [buffer, size, source] = default_submission_data_from_buffer(buffers[0]);
-    arbiter->submit_buffer(buffer, size, source);
+    arbiter->submit_buffer(buffer, size, source, std::nullopt);
     auto cbuffer1 = arbiter->compositor_acquire(this)->claim_buffer();
 
     std::tie(buffer, size, source) = default_submission_data_from_buffer(buffers[1]);
-    arbiter->submit_buffer(buffer, size, source);
+    arbiter->submit_buffer(buffer, size, source, std::nullopt);
     auto cbuffer2 = arbiter->compositor_acquire(this)->claim_buffer();
     auto id1 = cbuffer1->id();
 
     cbuffer1.reset();
 
     std::tie(buffer, size, source) = default_submission_data_from_buffer(buffers[2]);
-    arbiter->submit_buffer(buffer, size, source);
+    arbiter->submit_buffer(buffer, size, source, std::nullopt);
     auto cbuffer3 = arbiter->compositor_acquire(this)->claim_buffer();
     auto id2 = cbuffer2->id();
     cbuffer2.reset();
 
     std::tie(buffer, size, source) = default_submission_data_from_buffer(buffers[3]);
-    arbiter->submit_buffer(buffer, size, source);
+    arbiter->submit_buffer(buffer, size, source, std::nullopt);
     auto cbuffer4 = arbiter->compositor_acquire(this)->claim_buffer();
     auto id3 = cbuffer3->id();
     cbuffer3.reset();
 
     std::tie(buffer, size, source) = default_submission_data_from_buffer(buffers[4]);
-    arbiter->submit_buffer(buffer, size, source);
+    arbiter->submit_buffer(buffer, size, source, std::nullopt);
     auto cbuffer5 = arbiter->compositor_acquire(this)->claim_buffer();
     auto id4 = cbuffer4->id();
     cbuffer4.reset();
@@ -270,11 +270,11 @@ TEST_F(MultiMonitorArbiter, compositor_can_acquire_a_few_times_and_only_sends_on
     auto buffer_released = std::make_shared<bool>(false);
     auto [buffer, size, source] =
         default_submission_data_from_buffer(wrap_with_destruction_notifier(buffers[0], buffer_released));
-    arbiter->submit_buffer(std::move(buffer), size, source);
+    arbiter->submit_buffer(std::move(buffer), size, source, std::nullopt);
     auto cbuffer1 = arbiter->compositor_acquire(&comp_id1)->claim_buffer();
 
     std::tie(buffer, size, source) = default_submission_data_from_buffer(buffers[1]);
-    arbiter->submit_buffer(buffer, size, source);
+    arbiter->submit_buffer(buffer, size, source, std::nullopt);
     auto cbuffer2 = arbiter->compositor_acquire(&comp_id2)->claim_buffer();
     EXPECT_THAT(cbuffer1, IsSameBufferAs(cbuffer2));
 
@@ -291,10 +291,10 @@ TEST_F(MultiMonitorArbiter, advance_on_fastest_has_same_buffer)
     int comp_id2{0};
 
     auto [buffer, size, source] = default_submission_data_from_buffer(buffers[0]);
-    arbiter->submit_buffer(buffer, size, source);
+    arbiter->submit_buffer(buffer, size, source, std::nullopt);
     auto id1 = arbiter->compositor_acquire(&comp_id1)->claim_buffer()->id(); //buffer[0]
     std::tie(buffer, size, source) = default_submission_data_from_buffer(buffers[1]);
-    arbiter->submit_buffer(buffer, size, source);
+    arbiter->submit_buffer(buffer, size, source, std::nullopt);
     auto id2 = arbiter->compositor_acquire(&comp_id2)->claim_buffer()->id(); //buffer[0]
 
     auto cbuffer3 = arbiter->compositor_acquire(&comp_id1)->claim_buffer(); //buffer[1]
@@ -325,23 +325,23 @@ TEST_F(MultiMonitorArbiter, buffers_are_sent_back)
 
 
     auto [buffer, size, source] = default_submission_data_from_buffer(buf_queue.front());
-    arbiter->submit_buffer(buffer, size, source);
+    arbiter->submit_buffer(buffer, size, source, std::nullopt);
     buf_queue.pop_front();
     auto b1 = arbiter->compositor_acquire(&comp_id1)->claim_buffer();
     b1.reset();
     std::tie(buffer, size, source) = default_submission_data_from_buffer(buf_queue.front());
-    arbiter->submit_buffer(buffer, size, source);
+    arbiter->submit_buffer(buffer, size, source, std::nullopt);
     buf_queue.pop_front();
     auto b2 = arbiter->compositor_acquire(&comp_id1)->claim_buffer();
     b2.reset();
     std::tie(buffer, size, source) = default_submission_data_from_buffer(buf_queue.front());
-    arbiter->submit_buffer(buffer, size, source);
+    arbiter->submit_buffer(buffer, size, source, std::nullopt);
     buf_queue.pop_front();
     auto b3 = arbiter->compositor_acquire(&comp_id1)->claim_buffer();
     auto b5 = arbiter->compositor_acquire(&comp_id2)->claim_buffer();
     b3.reset();
     std::tie(buffer, size, source) = default_submission_data_from_buffer(buf_queue.front());
-    arbiter->submit_buffer(buffer, size, source);
+    arbiter->submit_buffer(buffer, size, source, std::nullopt);
     buf_queue.pop_front();
     auto b4 = arbiter->compositor_acquire(&comp_id1)->claim_buffer();
     b5.reset();
@@ -357,7 +357,7 @@ TEST_F(MultiMonitorArbiter, can_check_if_buffers_are_ready)
     int comp_id1{0};
     int comp_id2{0};
     auto [buffer, size, source] = default_submission_data_from_buffer(buffers[3]);
-    arbiter->submit_buffer(buffer, size, source);
+    arbiter->submit_buffer(buffer, size, source, std::nullopt);
 
     EXPECT_TRUE(arbiter->buffer_ready_for(&comp_id1));
     EXPECT_TRUE(arbiter->buffer_ready_for(&comp_id2));
@@ -378,19 +378,19 @@ TEST_F(MultiMonitorArbiter, other_compositor_ready_status_advances_with_fastest_
     int comp_id2{0};
 
     auto [buffer, size, source] = default_submission_data_from_buffer(buffers[0]);
-    arbiter->submit_buffer(buffer, size, source);
+    arbiter->submit_buffer(buffer, size, source, std::nullopt);
     EXPECT_TRUE(arbiter->buffer_ready_for(&comp_id1));
     EXPECT_TRUE(arbiter->buffer_ready_for(&comp_id2));
 
     arbiter->compositor_acquire(&comp_id1)->claim_buffer();
     std::tie(buffer, size, source) = default_submission_data_from_buffer(buffers[1]);
-    arbiter->submit_buffer(buffer, size, source);
+    arbiter->submit_buffer(buffer, size, source, std::nullopt);
     EXPECT_TRUE(arbiter->buffer_ready_for(&comp_id1));
     EXPECT_TRUE(arbiter->buffer_ready_for(&comp_id2));
 
     arbiter->compositor_acquire(&comp_id1)->claim_buffer();
     std::tie(buffer, size, source) = default_submission_data_from_buffer(buffers[2]);
-    arbiter->submit_buffer(buffer, size, source);
+    arbiter->submit_buffer(buffer, size, source, std::nullopt);
     EXPECT_TRUE(arbiter->buffer_ready_for(&comp_id1));
     EXPECT_TRUE(arbiter->buffer_ready_for(&comp_id2));
 
@@ -409,18 +409,18 @@ TEST_F(MultiMonitorArbiter, will_release_buffer_in_nbuffers_2_starvation_scenari
     int comp_id2{0};
 
     auto [buffer, size, source] = default_submission_data_from_buffer(buffers[0]);
-    arbiter->submit_buffer(buffer, size, source);
+    arbiter->submit_buffer(buffer, size, source, std::nullopt);
     auto b1 = arbiter->compositor_acquire(&comp_id1)->claim_buffer();
     auto id1 = b1->id();
     std::tie(buffer, size, source) = default_submission_data_from_buffer(buffers[1]);
-    arbiter->submit_buffer(buffer, size, source);
+    arbiter->submit_buffer(buffer, size, source, std::nullopt);
     auto b2 = arbiter->compositor_acquire(&comp_id1)->claim_buffer();
     auto id2 = b2->id();
 
     b1.reset();
 
     std::tie(buffer, size, source) = default_submission_data_from_buffer(buffers[0]);
-    arbiter->submit_buffer(buffer, size, source);
+    arbiter->submit_buffer(buffer, size, source, std::nullopt);
     auto b3 = arbiter->compositor_acquire(&comp_id2)->claim_buffer();
     auto id3 = b3->id();
     auto b4 = arbiter->compositor_acquire(&comp_id2)->claim_buffer();
@@ -459,14 +459,94 @@ TEST_F(MultiMonitorArbiter, second_compositor_advances_schedule_after_both_aquir
     int comp_id2{1};
 
     auto [buffer, size, source] = default_submission_data_from_buffer(buffers[0]);
-    arbiter->submit_buffer(buffer, size, source);
+    arbiter->submit_buffer(buffer, size, source, std::nullopt);
     auto cbuffer1 = arbiter->compositor_acquire(&comp_id1)->claim_buffer();
     auto cbuffer2 = arbiter->compositor_acquire(&comp_id2)->claim_buffer();
     auto cbuffer3 = arbiter->compositor_acquire(&comp_id1)->claim_buffer();
     EXPECT_THAT(cbuffer1, IsSameBufferAs(cbuffer2));
     EXPECT_THAT(cbuffer1, IsSameBufferAs(cbuffer3));
     std::tie(buffer, size, source) = default_submission_data_from_buffer(buffers[1]);
-    arbiter->submit_buffer(buffer, size, source);
+    arbiter->submit_buffer(buffer, size, source, std::nullopt);
     auto cbuffer4 = arbiter->compositor_acquire(&comp_id2)->claim_buffer();
     EXPECT_THAT(cbuffer1, Not(IsSameBufferAs(cbuffer4)));
 }
+
+TEST_F(MultiMonitorArbiter, first_acquisition_by_a_compositor_is_fully_damaged)
+{
+    auto [buffer, size, source] = default_submission_data_from_buffer(buffers[0]);
+    arbiter->submit_buffer(buffer, size, source, geom::Rectangles{{{1, 1}, {2, 2}}});
+
+    EXPECT_THAT(arbiter->compositor_acquire(this)->damage(), Eq(std::nullopt));
+}
+
+TEST_F(MultiMonitorArbiter, reacquiring_the_same_submission_has_empty_damage)
+{
+    auto [buffer, size, source] = default_submission_data_from_buffer(buffers[0]);
+    arbiter->submit_buffer(buffer, size, source, std::nullopt);
+    arbiter->compositor_acquire(this)->claim_buffer();
+
+    EXPECT_THAT(arbiter->compositor_acquire(this)->damage(), Optional(Eq(geom::Rectangles{})));
+}
+
+TEST_F(MultiMonitorArbiter, next_submission_carries_its_damage)
+{
+    geom::Rectangles const damage{{{1, 1}, {2, 2}}};
+
+    auto [buffer, size, source] = default_submission_data_from_buffer(buffers[0]);
+    arbiter->submit_buffer(buffer, size, source, std::nullopt);
+    arbiter->compositor_acquire(this)->claim_buffer();
+    std::tie(buffer, size, source) = default_submission_data_from_buffer(buffers[1]);
+    arbiter->submit_buffer(buffer, size, source, damage);
+
+    EXPECT_THAT(arbiter->compositor_acquire(this)->damage(), Optional(Eq(damage)));
+}
+
+TEST_F(MultiMonitorArbiter, damage_of_replaced_submissions_is_accumulated)
+{
+    geom::Rectangle const first_damage{{1, 1}, {2, 2}};
+    geom::Rectangle const second_damage{{5, 5}, {1, 1}};
+
+    auto [buffer, size, source] = default_submission_data_from_buffer(buffers[0]);
+    arbiter->submit_buffer(buffer, size, source, std::nullopt);
+    arbiter->compositor_acquire(this)->claim_buffer();
+    std::tie(buffer, size, source) = default_submission_data_from_buffer(buffers[1]);
+    arbiter->submit_buffer(buffer, size, source, geom::Rectangles{first_damage});
+    std::tie(buffer, size, source) = default_submission_data_from_buffer(buffers[2]);
+    arbiter->submit_buffer(buffer, size, source, geom::Rectangles{second_damage});
+
+    EXPECT_THAT(
+        arbiter->compositor_acquire(this)->damage(),
+        Optional(Eq(geom::Rectangles{first_damage, second_damage})));
+}
+
+TEST_F(MultiMonitorArbiter, compositor_that_missed_a_submission_is_fully_damaged)
+{
+    int comp_id1{0};
+    int comp_id2{1};
+
+    auto [buffer, size, source] = default_submission_data_from_buffer(buffers[0]);
+    arbiter->submit_buffer(buffer, size, source, std::nullopt);
+    arbiter->compositor_acquire(&comp_id1)->claim_buffer();
+    arbiter->compositor_acquire(&comp_id2)->claim_buffer();
+
+    std::tie(buffer, size, source) = default_submission_data_from_buffer(buffers[1]);
+    arbiter->submit_buffer(buffer, size, source, geom::Rectangles{{{1, 1}, {2, 2}}});
+    arbiter->compositor_acquire(&comp_id1)->claim_buffer();
+    std::tie(buffer, size, source) = default_submission_data_from_buffer(buffers[2]);
+    arbiter->submit_buffer(buffer, size, source, geom::Rectangles{{{3, 3}, {2, 2}}});
+    arbiter->compositor_acquire(&comp_id1)->claim_buffer();
+
+    EXPECT_THAT(arbiter->compositor_acquire(&comp_id2)->damage(), Eq(std::nullopt));
+}
+
+TEST_F(MultiMonitorArbiter, change_of_size_is_fully_damaged)
+{
+    auto [buffer, size, source] = default_submission_data_from_buffer(buffers[0]);
+    arbiter->submit_buffer(buffer, size, source, std::nullopt);
+    arbiter->compositor_acquire(this)->claim_buffer();
+    std::tie(buffer, size, source) = default_submission_data_from_buffer(buffers[1]);
+    geom::Size const new_size{size.width.as_int() + 1, size.height.as_int() + 1};
+    arbiter->submit_buffer(buffer, new_size, source, geom::Rectangles{{{1, 1}, {2, 2}}});
+
+    EXPECT_THAT(arbiter->compositor_acquire(this)->damage(), Eq(std::nullopt));
+}
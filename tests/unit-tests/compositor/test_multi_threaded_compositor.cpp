@@ -15,6 +15,7 @@
  */
 
 #include "src/server/compositor/multi_threaded_compositor.h"
+#include "src/server/compositor/render_time_predictor.h"
 #include "src/server/report/null_report_factory.h"
 
 #include "mir/compositor/display_listener.h"
@@ -25,6 +26,7 @@
 #include "mir/raii.h"
 
 #include "mir/test/current_thread_name.h"
+#include "mir/test/signal.h"
 #include "mir/test/doubles/null_display.h"
 #include "mir/test/doubles/null_display_sink.h"
 #include "mir/test/doubles/mock_display_sink.h"
@@ -84,12 +86,63 @@ private:
         {
             return std::chrono::milliseconds::zero();
         }
+        auto when_presented(std::function<void(mg::Presentation const&)> const& handler) -> bool override
+        {
+            handler(mg::Presentation{{++msc, mg::Frame::Timestamp::now(CLOCK_MONOTONIC)}, 16ms, true});
+            return true;
+        }
         testing::NiceMock<mtd::MockDisplaySink> buffer;
+        int64_t msc{0};
     };
 
     std::vector<StubDisplaySyncGroup> buffers;
 };
 
+/// A display that refreshes every \a refresh_interval, starting now
+class StubDisplayWithVBlanks : public mtd::NullDisplay
+{
+public:
+    StubDisplayWithVBlanks(std::chrono::nanoseconds refresh_interval)
+        : group{refresh_interval}
+    {
+    }
+
+    void for_each_display_sync_group(std::function<void(mg::DisplaySyncGroup&)> const& f) override
+    {
+        f(group);
+    }
+
+private:
+    struct StubDisplaySyncGroup : mg::DisplaySyncGroup
+    {
+        StubDisplaySyncGroup(std::chrono::nanoseconds refresh_interval)
+            : refresh_interval{refresh_interval}
+        {
+        }
+
+        void for_each_display_sink(std::function<void(mg::DisplaySink&)> const& f) override
+        {
+            f(sink);
+        }
+        void post() override {}
+        std::chrono::milliseconds recommended_sleep() const override
+        {
+            return std::chrono::milliseconds::zero();
+        }
+        auto next_vblank() const -> std::optional<mg::Frame::Timestamp> override
+        {
+            auto const now = mg::Frame::Timestamp::now(CLOCK_MONOTONIC);
+            return now + (refresh_interval - (now - first_vblank) % refresh_interval);
+        }
+
+        std::chrono::nanoseconds const refresh_interval;
+        mg::Frame::Timestamp const first_vblank{mg::Frame::Timestamp::now(CLOCK_MONOTONIC)};
+        testing::NiceMock<mtd::MockDisplaySink> sink;
+    };
+
+    StubDisplaySyncGroup group;
+};
+
 class StubScene : public mtd::StubScene
 {
 public:
@@ -455,6 +508,46 @@ TEST(MultiThreadedCompositor, reports_in_the_right_places)
     compositor.stop();
 }
 
+TEST(MultiThreadedCompositor, reports_composited_frames_as_presented_when_the_display_shows_them)
+{
+    using namespace testing;
+
+    unsigned int const nbuffers{3};
+    auto display = std::make_shared<StubDisplayWithMockBuffers>(nbuffers);
+    auto scene = std::make_shared<StubScene>();
+    auto db_compositor_factory =
+        std::make_shared<RecordingDisplayBufferCompositorFactory>();
+    auto mock_report = std::make_shared<NiceMock<mtd::MockCompositorReport>>();
+    mc::MultiThreadedCompositor compositor{display, scene,
+                                           db_compositor_factory,
+                                           null_display_listener,
+                                           mock_report,
+                                           default_delay,
+                                           true};
+
+    std::mutex presented_mutex;
+    std::unordered_set<mc::CompositorReport::SubCompositorId> presented;
+    ON_CALL(*mock_report, presented_frame(_, _))
+        .WillByDefault(Invoke([&](mc::CompositorReport::SubCompositorId id, mg::Presentation const& presentation)
+            {
+                // What the display reported, not a guess made after posting
+                EXPECT_TRUE(presentation.from_hardware);
+                EXPECT_THAT(presentation.frame.msc, Gt(0));
+
+                std::lock_guard lock{presented_mutex};
+                presented.insert(id);
+            }));
+
+    compositor.start();
+    scene->emit_change_event();
+    while (!db_compositor_factory->check_record_count_for_each_buffer(nbuffers, composites_per_update))
+        std::this_thread::yield();
+    compositor.stop();
+
+    std::lock_guard lock{presented_mutex};
+    EXPECT_THAT(presented.size(), Eq(nbuffers));
+}
+
 /*
  * It's difficult to test that a render won't happen, without some further
  * introspective capabilities that would complicate the code. This test will
@@ -576,6 +669,48 @@ TEST(MultiThreadedCompositor, recommended_sleep_throttles_compositor_loop)
     compositor.stop();
 }
 
+TEST(MultiThreadedCompositor, starts_compositing_the_predicted_render_time_before_the_next_vblank)
+{
+    using namespace testing;
+
+    auto const refresh_interval = 20ms;
+    auto display = std::make_shared<StubDisplayWithVBlanks>(refresh_interval);
+    auto scene = std::make_shared<StubScene>();
+    auto factory = std::make_shared<RecordingDisplayBufferCompositorFactory>();
+    auto mock_report = std::make_shared<NiceMock<mtd::MockCompositorReport>>();
+    mc::MultiThreadedCompositor compositor{display, scene, factory,
+                                           null_display_listener, mock_report,
+                                           default_delay, false};
+
+    mt::Signal scheduled;
+    std::chrono::nanoseconds predicted_render_time, delay;
+    ON_CALL(*mock_report, scheduled_next_frame(_, _, _))
+        .WillByDefault(Invoke([&](auto, auto predicted, auto scheduled_delay)
+            {
+                if (!scheduled.raised())
+                {
+                    predicted_render_time = predicted;
+                    delay = scheduled_delay;
+                    scheduled.raise();
+                }
+            }));
+
+    compositor.start();
+
+    // Compositing isn't delayed until enough frames have been measured to predict from
+    for (auto frame = 0; frame != 100 && !scheduled.raised(); ++frame)
+    {
+        scene->emit_change_event();
+        scheduled.wait_for(refresh_interval);
+    }
+
+    compositor.stop();
+
+    ASSERT_TRUE(scheduled.raised());
+    EXPECT_THAT(predicted_render_time, Ge(mc::RenderTimePredictor::margin));
+    EXPECT_THAT(delay, Le(refresh_interval - predicted_render_time));
+}
+
 TEST(MultiThreadedCompositor, when_no_initial_composite_is_needed_there_is_none)
 {
     using namespace testing;
@@ -695,7 +830,7 @@ TEST(MultiThreadedCompositor, double_start_or_stop_ignored)
         .Times(1);
     EXPECT_CALL(*mock_scene, remove_observer(_))
         .Times(1);
-    EXPECT_CALL(*mock_scene, scene_elements_for(_))
+    EXPECT_CALL(*mock_scene, scene_elements_for(_, _))
         .Times(AtLeast(0))
         .WillRepeatedly(Return(mc::SceneElementSequence{}));
 
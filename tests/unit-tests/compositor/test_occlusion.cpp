@@ -15,6 +15,7 @@
  */
 
 #include "mir/geometry/rectangle.h"
+#include "mir/geometry/rectangles.h"
 #include "src/server/compositor/occlusion.h"
 #include "mir/test/doubles/fake_renderable.h"
 #include "mir/test/doubles/stub_scene_element.h"
@@ -123,6 +124,52 @@ TEST_F(OcclusionFilterTest, shaped_window_occludes_nothing)
     EXPECT_THAT(renderables_from(elements), ElementsAre(bottom, top));
 }
 
+TEST_F(OcclusionFilterTest, opaque_region_of_shaped_window_occludes)
+{
+    Rectangles opaque;
+    opaque.add({{12, 10}, {6, 10}});
+    auto top = std::make_shared<mtd::FakeRenderable>(Rectangle{{10, 10}, {10, 10}}, 1.0f, false, opaque);
+    auto bottom = std::make_shared<mtd::FakeRenderable>(13, 12, 4, 5);
+    auto elements = scene_elements_from({bottom, top});
+
+    auto const& occlusions = filter_occlusions_from(elements, monitor_rect);
+
+    EXPECT_THAT(renderables_from(occlusions), ElementsAre(bottom));
+    EXPECT_THAT(renderables_from(elements), ElementsAre(top));
+}
+
+TEST_F(OcclusionFilterTest, window_outside_opaque_region_of_shaped_window_not_occluded)
+{
+    Rectangles opaque;
+    opaque.add({{12, 10}, {6, 10}});
+    auto top = std::make_shared<mtd::FakeRenderable>(Rectangle{{10, 10}, {10, 10}}, 1.0f, false, opaque);
+    auto bottom = std::make_shared<mtd::FakeRenderable>(10, 12, 4, 5);
+    auto elements = scene_elements_from({bottom, top});
+
+    auto const& occlusions = filter_occlusions_from(elements, monitor_rect);
+
+    EXPECT_THAT(renderables_from(occlusions), IsEmpty());
+    auto const renderables = renderables_from(elements);
+    ASSERT_THAT(renderables.size(), Eq(2u));
+    EXPECT_THAT(renderables[0]->id(), Eq(bottom->id()));
+    EXPECT_THAT(renderables[0]->clip_area(), Eq(std::make_optional(Rectangle{{10, 12}, {2, 5}})));
+    EXPECT_THAT(renderables[1], Eq(top));
+}
+
+TEST_F(OcclusionFilterTest, opaque_region_of_translucent_window_occludes_nothing)
+{
+    Rectangles opaque;
+    opaque.add({{10, 10}, {10, 10}});
+    auto top = std::make_shared<mtd::FakeRenderable>(Rectangle{{10, 10}, {10, 10}}, 0.5f, false, opaque);
+    auto bottom = std::make_shared<mtd::FakeRenderable>(12, 12, 5, 5);
+    auto elements = scene_elements_from({bottom, top});
+
+    auto const& occlusions = filter_occlusions_from(elements, monitor_rect);
+
+    EXPECT_THAT(renderables_from(occlusions), IsEmpty());
+    EXPECT_THAT(renderables_from(elements), ElementsAre(bottom, top));
+}
+
 TEST_F(OcclusionFilterTest, identical_window_occluded)
 {
     auto top = std::make_shared<mtd::FakeRenderable>(10, 10, 10, 10);
@@ -200,3 +247,59 @@ TEST_F(OcclusionFilterTest,
     EXPECT_THAT(renderables_from(occlusions), ElementsAre(partially_onscreen));
     EXPECT_THAT(renderables_from(elements), ElementsAre(covering));
 }
+
+TEST_F(OcclusionFilterTest, window_covered_by_tiled_windows_together_is_occluded)
+{
+    auto const left = std::make_shared<mtd::FakeRenderable>(0, 0, 960, 1200);
+    auto const right = std::make_shared<mtd::FakeRenderable>(960, 0, 960, 1200);
+    auto const beneath = std::make_shared<mtd::FakeRenderable>(800, 100, 400, 300);
+    auto elements = scene_elements_from({beneath, left, right});
+
+    auto const& occlusions = filter_occlusions_from(elements, monitor_rect);
+
+    EXPECT_THAT(renderables_from(occlusions), ElementsAre(beneath));
+    EXPECT_THAT(renderables_from(elements), ElementsAre(left, right));
+}
+
+TEST_F(OcclusionFilterTest, window_covered_by_panel_and_maximised_window_is_occluded)
+{
+    auto const panel = std::make_shared<mtd::FakeRenderable>(0, 0, 1920, 32);
+    auto const maximised = std::make_shared<mtd::FakeRenderable>(0, 32, 1920, 1168);
+    auto const beneath = std::make_shared<mtd::FakeRenderable>(100, 0, 640, 480);
+    auto elements = scene_elements_from({beneath, maximised, panel});
+
+    auto const& occlusions = filter_occlusions_from(elements, monitor_rect);
+
+    EXPECT_THAT(renderables_from(occlusions), ElementsAre(beneath));
+    EXPECT_THAT(renderables_from(elements), ElementsAre(maximised, panel));
+}
+
+TEST_F(OcclusionFilterTest, partially_occluded_window_is_clipped_to_its_visible_part)
+{
+    auto const top = std::make_shared<mtd::FakeRenderable>(0, 0, 100, 60);
+    auto const bottom = std::make_shared<mtd::FakeRenderable>(0, 0, 100, 100);
+    auto elements = scene_elements_from({bottom, top});
+
+    auto const& occlusions = filter_occlusions_from(elements, monitor_rect);
+
+    EXPECT_THAT(renderables_from(occlusions), IsEmpty());
+    auto const renderables = renderables_from(elements);
+    ASSERT_THAT(renderables.size(), Eq(2u));
+    EXPECT_THAT(renderables[0]->id(), Eq(bottom->id()));
+    EXPECT_THAT(renderables[0]->buffer(), Eq(bottom->buffer()));
+    EXPECT_THAT(renderables[0]->screen_position(), Eq(bottom->screen_position()));
+    EXPECT_THAT(renderables[0]->clip_area(), Eq(std::make_optional(Rectangle{{0, 60}, {100, 40}})));
+    EXPECT_THAT(renderables[1], Eq(top));
+}
+
+TEST_F(OcclusionFilterTest, window_with_visible_parts_on_both_sides_is_not_clipped)
+{
+    auto const top = std::make_shared<mtd::FakeRenderable>(10, 10, 80, 80);
+    auto const bottom = std::make_shared<mtd::FakeRenderable>(0, 0, 100, 100);
+    auto elements = scene_elements_from({bottom, top});
+
+    auto const& occlusions = filter_occlusions_from(elements, monitor_rect);
+
+    EXPECT_THAT(renderables_from(occlusions), IsEmpty());
+    EXPECT_THAT(renderables_from(elements), ElementsAre(bottom, top));
+}
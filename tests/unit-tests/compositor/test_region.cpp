@@ -0,0 +1,129 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/compositor/region.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+using namespace testing;
+using namespace mir::geometry;
+using mir::compositor::Region;
+
+TEST(Region, default_region_is_empty)
+{
+    Region const region;
+
+    EXPECT_TRUE(region.is_empty());
+    EXPECT_THAT(region.rectangles(), Eq(Rectangles{}));
+    EXPECT_THAT(region.bounding_rectangle(), Eq(Rectangle{}));
+}
+
+TEST(Region, region_of_empty_rectangle_is_empty)
+{
+    EXPECT_TRUE(Region{Rectangle({10, 10}, {0, 10})}.is_empty());
+    EXPECT_TRUE(Region{Rectangle({10, 10}, {10, 0})}.is_empty());
+}
+
+TEST(Region, region_of_rectangle_contains_it)
+{
+    Rectangle const rect{{10, 20}, {30, 40}};
+    Region const region{rect};
+
+    EXPECT_TRUE(region.contains(rect));
+    EXPECT_TRUE(region.contains({{15, 25}, {5, 5}}));
+    EXPECT_FALSE(region.contains({{9, 20}, {30, 40}}));
+    EXPECT_THAT(region.rectangles(), Eq(Rectangles{rect}));
+    EXPECT_THAT(region.bounding_rectangle(), Eq(rect));
+}
+
+TEST(Region, union_of_adjacent_rectangles_contains_both_together)
+{
+    Region region{Rectangle{{0, 0}, {50, 100}}};
+    region.add(Rectangle{{50, 0}, {50, 100}});
+
+    EXPECT_TRUE(region.contains({{25, 25}, {50, 50}}));
+    EXPECT_THAT(region.rectangles(), Eq(Rectangles{{{0, 0}, {100, 100}}}));
+}
+
+TEST(Region, union_of_stacked_rectangles_is_coalesced)
+{
+    Region region{Rectangle{{0, 0}, {100, 30}}};
+    region.add(Rectangle{{0, 30}, {100, 70}});
+
+    EXPECT_THAT(region.rectangles(), Eq(Rectangles{{{0, 0}, {100, 100}}}));
+}
+
+TEST(Region, union_of_overlapping_rectangles_is_split_into_bands)
+{
+    Region region{Rectangle{{0, 0}, {20, 20}}};
+    region.add(Rectangle{{10, 10}, {20, 20}});
+
+    EXPECT_THAT(region.rectangles(), Eq(Rectangles{
+        {{0, 0}, {20, 10}},
+        {{0, 10}, {30, 10}},
+        {{10, 20}, {20, 10}}}));
+    EXPECT_THAT(region.bounding_rectangle(), Eq(Rectangle{{0, 0}, {30, 30}}));
+    EXPECT_FALSE(region.contains({{0, 0}, {30, 30}}));
+}
+
+TEST(Region, subtracting_middle_leaves_a_frame)
+{
+    Region region{Rectangle{{0, 0}, {30, 30}}};
+    region.subtract(Rectangle{{10, 10}, {10, 10}});
+
+    EXPECT_THAT(region.rectangles(), Eq(Rectangles{
+        {{0, 0}, {30, 10}},
+        {{0, 10}, {10, 10}},
+        {{20, 10}, {10, 10}},
+        {{0, 20}, {30, 10}}}));
+    EXPECT_THAT(region.bounding_rectangle(), Eq(Rectangle{{0, 0}, {30, 30}}));
+}
+
+TEST(Region, subtracting_everything_leaves_nothing)
+{
+    Region region{Rectangle{{10, 10}, {30, 30}}};
+    region.subtract(Rectangle{{0, 0}, {50, 50}});
+
+    EXPECT_TRUE(region.is_empty());
+}
+
+TEST(Region, intersection_is_the_common_part)
+{
+    Region region{Rectangle{{0, 0}, {20, 20}}};
+    region.add(Rectangle{{40, 0}, {20, 20}});
+    region.intersect(Rectangle{{10, 5}, {40, 10}});
+
+    EXPECT_THAT(region.rectangles(), Eq(Rectangles{
+        {{10, 5}, {10, 10}},
+        {{40, 5}, {10, 10}}}));
+}
+
+TEST(Region, intersection_of_disjoint_regions_is_empty)
+{
+    Region region{Rectangle{{0, 0}, {20, 20}}};
+    region.intersect(Rectangle{{20, 0}, {20, 20}});
+
+    EXPECT_TRUE(region.is_empty());
+}
+
+TEST(Region, representation_does_not_depend_on_construction_order)
+{
+    Region a{Rectangles{{{0, 0}, {10, 30}}, {{10, 0}, {10, 10}}, {{10, 20}, {10, 10}}}};
+    Region b{Rectangles{{{0, 0}, {20, 10}}, {{0, 10}, {10, 10}}, {{0, 20}, {20, 10}}}};
+
+    EXPECT_THAT(a, Eq(b));
+}
@@ -0,0 +1,147 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/compositor/render_time_predictor.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+using namespace testing;
+using namespace std::chrono_literals;
+namespace mc = mir::compositor;
+
+namespace
+{
+struct RenderTimePredictor : Test
+{
+    mc::RenderTimePredictor predictor;
+};
+}
+
+TEST_F(RenderTimePredictor, predicts_nothing_from_too_few_frames)
+{
+    for (auto i = 1u; i < mc::RenderTimePredictor::min_samples; ++i)
+    {
+        predictor.record(3ms);
+    }
+
+    EXPECT_THAT(predictor.predicted(), Eq(std::nullopt));
+}
+
+TEST_F(RenderTimePredictor, predicts_steady_render_time_plus_margin)
+{
+    for (auto i = 0u; i < mc::RenderTimePredictor::min_samples; ++i)
+    {
+        predictor.record(3ms);
+    }
+
+    EXPECT_THAT(predictor.predicted(), Optional(3ms + mc::RenderTimePredictor::margin));
+}
+
+TEST_F(RenderTimePredictor, allows_for_the_slow_frames_but_not_outliers)
+{
+    for (auto i = 0u; i < mc::RenderTimePredictor::window; ++i)
+    {
+        if (i % 32 == 0)
+        {
+            predictor.record(40ms);     // 2 frames
+        }
+        else if (i % 16 == 1)
+        {
+            predictor.record(6ms);      // 4 frames
+        }
+        else
+        {
+            predictor.record(2ms);
+        }
+    }
+
+    EXPECT_THAT(predictor.predicted(), Optional(6ms + mc::RenderTimePredictor::margin));
+}
+
+TEST_F(RenderTimePredictor, forgets_frames_outside_the_window)
+{
+    for (auto i = 0u; i < mc::RenderTimePredictor::window; ++i)
+    {
+        predictor.record(10ms);
+    }
+    for (auto i = 0u; i < mc::RenderTimePredictor::window; ++i)
+    {
+        predictor.record(1ms);
+    }
+
+    EXPECT_THAT(predictor.predicted(), Optional(1ms + mc::RenderTimePredictor::margin));
+}
+
+TEST_F(RenderTimePredictor, predicts_nothing_after_being_cleared)
+{
+    for (auto i = 0u; i < mc::RenderTimePredictor::window; ++i)
+    {
+        predictor.record(3ms);
+    }
+
+    predictor.clear();
+
+    EXPECT_THAT(predictor.predicted(), Eq(std::nullopt));
+}
+
+TEST_F(RenderTimePredictor, allows_longer_after_missed_vblanks)
+{
+    for (auto i = 0u; i < mc::RenderTimePredictor::window; ++i)
+    {
+        predictor.record(3ms);
+    }
+
+    predictor.missed_vblank();
+    predictor.missed_vblank();
+
+    EXPECT_THAT(
+        predictor.predicted(),
+        Optional(3ms + mc::RenderTimePredictor::margin + 2 * mc::RenderTimePredictor::miss_penalty));
+}
+
+TEST_F(RenderTimePredictor, allows_no_more_than_the_max_penalty_for_missed_vblanks)
+{
+    for (auto i = 0u; i < mc::RenderTimePredictor::window; ++i)
+    {
+        predictor.record(3ms);
+    }
+
+    for (auto i = 0; i != 100; ++i)
+    {
+        predictor.missed_vblank();
+    }
+
+    EXPECT_THAT(
+        predictor.predicted(),
+        Optional(3ms + mc::RenderTimePredictor::margin + mc::RenderTimePredictor::max_penalty));
+}
+
+TEST_F(RenderTimePredictor, eases_back_as_frames_make_their_vblanks)
+{
+    for (auto i = 0u; i < mc::RenderTimePredictor::window; ++i)
+    {
+        predictor.record(3ms);
+    }
+
+    predictor.missed_vblank();
+    for (auto i = 0u; i < mc::RenderTimePredictor::window; ++i)
+    {
+        predictor.record(3ms);
+    }
+
+    EXPECT_THAT(predictor.predicted(), Optional(3ms + mc::RenderTimePredictor::margin));
+}
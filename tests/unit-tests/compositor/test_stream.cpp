@@ -16,6 +16,7 @@
 
 #include "mir/test/doubles/stub_buffer.h"
 #include "mir/compositor/stream.h"
+#include "mir/graphics/frame.h"
 
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
@@ -53,10 +54,30 @@ TEST_F(Stream, tracks_has_buffer)
     stream.submit_buffer(
             buffers[0],
             buffers[0]->size(),
-            {{0, 0}, geom::SizeD{buffers[0]->size()}} );
+            {{0, 0}, geom::SizeD{buffers[0]->size()}},
+            std::nullopt);
     EXPECT_TRUE(stream.has_submitted_buffer());
 }
 
+TEST_F(Stream, tracks_logical_size_of_latest_submission)
+{
+    geom::Size const logical_size{22, 1};
+
+    stream.submit_buffer(
+            buffers[0],
+            buffers[0]->size(),
+            {{0, 0}, geom::SizeD{buffers[0]->size()}},
+            std::nullopt);
+    EXPECT_THAT(stream.stream_size(), Eq(initial_size));
+
+    stream.submit_buffer(
+            buffers[1],
+            logical_size,
+            {{0, 0}, geom::SizeD{buffers[1]->size()}},
+            std::nullopt);
+    EXPECT_THAT(stream.stream_size(), Eq(logical_size));
+}
+
 TEST_F(Stream, calls_frame_callback_after_scheduling_on_submissions)
 {
     int frame_count{0};
@@ -64,12 +85,14 @@ TEST_F(Stream, calls_frame_callback_after_scheduling_on_submissions)
     stream.submit_buffer(
             buffers[0],
             buffers[0]->size(),
-            {{0, 0}, geom::SizeD{buffers[0]->size()}} );
+            {{0, 0}, geom::SizeD{buffers[0]->size()}},
+            std::nullopt);
     stream.set_frame_posted_callback([](auto) {});
     stream.submit_buffer(
             buffers[0],
             buffers[0]->size(),
-            {{0, 0}, geom::SizeD{buffers[0]->size()}} );
+            {{0, 0}, geom::SizeD{buffers[0]->size()}},
+            std::nullopt);
     EXPECT_THAT(frame_count, Eq(1));
 }
 
@@ -83,7 +106,8 @@ TEST_F(Stream, frame_callback_is_called_without_scheduling_lock)
     stream.submit_buffer(
             buffers[0],
             buffers[0]->size(),
-            {{0, 0}, geom::SizeD{buffers[0]->size()}} );
+            {{0, 0}, geom::SizeD{buffers[0]->size()}},
+            std::nullopt);
 }
 
 TEST_F(Stream, throws_on_nullptr_submissions)
@@ -93,7 +117,133 @@ TEST_F(Stream, throws_on_nullptr_submissions)
         stream.submit_buffer(
                 nullptr,
                 buffers[0]->size(),
-                {{0, 0}, geom::SizeD{buffers[0]->size()}} );
+                {{0, 0}, geom::SizeD{buffers[0]->size()}},
+            std::nullopt);
     }, std::invalid_argument);
     EXPECT_FALSE(stream.has_submitted_buffer());
 }
+
+TEST_F(Stream, frame_callback_receives_whole_surface_when_damage_is_unknown)
+{
+    geom::Size const dest_size{22, 1};
+    std::optional<geom::Rectangle> posted;
+    stream.set_frame_posted_callback([&posted](auto const& damage) { posted = damage; });
+    stream.submit_buffer(
+            buffers[0],
+            dest_size,
+            {{0, 0}, geom::SizeD{buffers[0]->size()}},
+            std::nullopt);
+    EXPECT_THAT(posted, Optional(Eq(geom::Rectangle{{0, 0}, dest_size})));
+}
+
+TEST_F(Stream, frame_callback_receives_buffer_damage_scaled_to_logical_coordinates)
+{
+    std::optional<geom::Rectangle> posted;
+    stream.set_frame_posted_callback([&posted](auto const& damage) { posted = damage; });
+    stream.submit_buffer(
+            buffers[0],
+            geom::Size{22, 1},
+            {{0, 0}, geom::SizeD{buffers[0]->size()}},
+            geom::Rectangles{{{4, 0}, {4, 2}}});
+    EXPECT_THAT(posted, Optional(Eq(geom::Rectangle{{2, 0}, {2, 1}})));
+}
+
+TEST_F(Stream, frame_callback_receives_whole_surface_when_damage_clips_to_nothing)
+{
+    geom::Size const dest_size{22, 1};
+    std::optional<geom::Rectangle> posted;
+    stream.set_frame_posted_callback([&posted](auto const& damage) { posted = damage; });
+    stream.submit_buffer(
+            buffers[0],
+            dest_size,
+            {{0, 0}, geom::SizeD{buffers[0]->size()}},
+            geom::Rectangles{{{1000, 1000}, {4, 2}}});
+    EXPECT_THAT(posted, Optional(Eq(geom::Rectangle{{0, 0}, dest_size})));
+}
+
+TEST_F(Stream, submission_damage_is_in_logical_coordinates)
+{
+    int const compositor_id{0};
+    stream.submit_buffer(
+            buffers[0],
+            geom::Size{22, 1},
+            {{0, 0}, geom::SizeD{buffers[0]->size()}},
+            std::nullopt);
+    stream.next_submission_for_compositor(&compositor_id)->claim_buffer();
+    stream.submit_buffer(
+            buffers[1],
+            geom::Size{22, 1},
+            {{0, 0}, geom::SizeD{buffers[1]->size()}},
+            geom::Rectangles{{{4, 0}, {4, 2}}});
+    EXPECT_THAT(
+        stream.next_submission_for_compositor(&compositor_id)->damage(),
+        Optional(Eq(geom::Rectangles{{{2, 0}, {2, 1}}})));
+}
+
+TEST_F(Stream, reports_each_buffer_presented_once)
+{
+    int const first_compositor{0};
+    int const second_compositor{1};
+    mg::Presentation const presentation{{42, mg::Frame::Timestamp::now(CLOCK_MONOTONIC)}, {}, true};
+
+    std::vector<mg::BufferID> presented;
+    stream.set_frame_presented_callback(
+        [&presented](mg::BufferID id, mg::Presentation const&) { presented.push_back(id); });
+
+    stream.submit_buffer(
+            buffers[0],
+            buffers[0]->size(),
+            {{0, 0}, geom::SizeD{buffers[0]->size()}},
+            std::nullopt);
+    // Nothing has been claimed, so nothing has been shown
+    stream.presenter(&first_compositor)(presentation);
+    EXPECT_THAT(presented, IsEmpty());
+
+    stream.next_submission_for_compositor(&first_compositor)->claim_buffer();
+    stream.next_submission_for_compositor(&second_compositor)->claim_buffer();
+    stream.presenter(&first_compositor)(presentation);
+    stream.presenter(&second_compositor)(presentation);
+    stream.presenter(&first_compositor)(presentation);
+    EXPECT_THAT(presented, ElementsAre(buffers[0]->id()));
+
+    stream.submit_buffer(
+            buffers[1],
+            buffers[1]->size(),
+            {{0, 0}, geom::SizeD{buffers[1]->size()}},
+            std::nullopt);
+    stream.next_submission_for_compositor(&second_compositor)->claim_buffer();
+    stream.presenter(&second_compositor)(presentation);
+    EXPECT_THAT(presented, ElementsAre(buffers[0]->id(), buffers[1]->id()));
+}
+
+TEST_F(Stream, reports_the_buffer_claimed_for_the_frame_even_if_a_newer_one_is_claimed_before_it_is_shown)
+{
+    int const compositor{0};
+    mg::Presentation const presentation{{42, mg::Frame::Timestamp::now(CLOCK_MONOTONIC)}, {}, true};
+
+    std::vector<mg::BufferID> presented;
+    stream.set_frame_presented_callback(
+        [&presented](mg::BufferID id, mg::Presentation const&) { presented.push_back(id); });
+
+    stream.submit_buffer(
+            buffers[0],
+            buffers[0]->size(),
+            {{0, 0}, geom::SizeD{buffers[0]->size()}},
+            std::nullopt);
+    stream.next_submission_for_compositor(&compositor)->claim_buffer();
+    auto const first_frame_presenter = stream.presenter(&compositor);
+
+    // As in clone mode, the next frame is composited before the first one's flip completes
+    stream.submit_buffer(
+            buffers[1],
+            buffers[1]->size(),
+            {{0, 0}, geom::SizeD{buffers[1]->size()}},
+            std::nullopt);
+    stream.next_submission_for_compositor(&compositor)->claim_buffer();
+    auto const second_frame_presenter = stream.presenter(&compositor);
+
+    first_frame_presenter(presentation);
+    EXPECT_THAT(presented, ElementsAre(buffers[0]->id()));
+    second_frame_presenter(presentation);
+    EXPECT_THAT(presented, ElementsAre(buffers[0]->id(), buffers[1]->id()));
+}
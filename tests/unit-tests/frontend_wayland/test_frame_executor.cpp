@@ -0,0 +1,165 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "src/server/frontend_wayland/frame_executor.h"
+#include "mir/graphics/frame.h"
+#include "mir/test/doubles/advanceable_clock.h"
+#include "mir/test/doubles/fake_alarm_factory.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+namespace mf = mir::frontend;
+namespace mg = mir::graphics;
+namespace mtd = mir::test::doubles;
+
+using namespace testing;
+using namespace std::chrono_literals;
+
+namespace
+{
+struct FrameExecutor : Test
+{
+    auto presented_at(mir::time::Timestamp when, std::chrono::nanoseconds refresh) -> mg::Presentation
+    {
+        return {{0, {CLOCK_MONOTONIC, when.time_since_epoch()}}, refresh, true};
+    }
+
+    std::shared_ptr<mtd::AdvanceableClock> const clock{std::make_shared<mtd::AdvanceableClock>()};
+    mtd::FakeAlarmFactory alarm_factory{clock};
+    mf::FrameExecutor executor{alarm_factory, clock};
+    int runs{0};
+};
+}
+
+TEST_F(FrameExecutor, runs_work_of_unknown_output_after_a_60hz_frame)
+{
+    executor.spawn([this]{ ++runs; });
+
+    alarm_factory.advance_by(15ms);
+    EXPECT_THAT(runs, Eq(0));
+
+    alarm_factory.advance_by(2ms);
+    EXPECT_THAT(runs, Eq(1));
+}
+
+TEST_F(FrameExecutor, runs_work_at_the_next_refresh_of_the_output)
+{
+    auto const refresh = std::chrono::nanoseconds{1s} / 144;
+    // Presented two refreshes (and a little) ago
+    executor.spawn_at_next_refresh(presented_at(clock->now() - 2 * refresh - 1ms, refresh), [this]{ ++runs; });
+
+    alarm_factory.advance_by(refresh - 2ms);
+    EXPECT_THAT(runs, Eq(0));
+
+    alarm_factory.advance_by(2ms);
+    EXPECT_THAT(runs, Eq(1));
+}
+
+TEST_F(FrameExecutor, falls_back_to_60hz_when_the_refresh_rate_is_unknown)
+{
+    executor.spawn_at_next_refresh(presented_at(clock->now(), 0ns), [this]{ ++runs; });
+
+    alarm_factory.advance_by(15ms);
+    EXPECT_THAT(runs, Eq(0));
+
+    alarm_factory.advance_by(2ms);
+    EXPECT_THAT(runs, Eq(1));
+}
+
+TEST_F(FrameExecutor, unknown_refresh_rates_keep_to_60hz_from_the_presentation)
+{
+    // With VRR, say, the output was showing frames as they came, the last 10ms ago
+    executor.spawn_at_next_refresh(presented_at(clock->now() - 10ms, 0ns), [this]{ ++runs; });
+
+    alarm_factory.advance_by(5ms);
+    EXPECT_THAT(runs, Eq(0));
+
+    alarm_factory.advance_by(2ms);
+    EXPECT_THAT(runs, Eq(1));
+}
+
+TEST_F(FrameExecutor, work_spawned_behind_earlier_work_does_not_delay_it)
+{
+    int later_runs{0};
+    executor.spawn([this]{ ++runs; });
+    executor.spawn_throttled(this, [&]{ ++later_runs; });
+
+    alarm_factory.advance_smoothly_by(20ms);
+    EXPECT_THAT(runs, Eq(1));
+    EXPECT_THAT(later_runs, Eq(0));
+
+    alarm_factory.advance_smoothly_by(1s);
+    EXPECT_THAT(later_runs, Eq(1));
+}
+
+TEST_F(FrameExecutor, throttles_work_for_hidden_surfaces)
+{
+    executor.spawn_throttled(this, [this]{ ++runs; });
+
+    alarm_factory.advance_smoothly_by(500ms);
+    EXPECT_THAT(runs, Eq(0));
+
+    alarm_factory.advance_smoothly_by(501ms);
+    EXPECT_THAT(runs, Eq(1));
+}
+
+TEST_F(FrameExecutor, throttled_work_does_not_delay_work_due_sooner)
+{
+    int throttled_runs{0};
+    executor.spawn_throttled(this, [&]{ ++throttled_runs; });
+    executor.spawn([this]{ ++runs; });
+
+    alarm_factory.advance_smoothly_by(20ms);
+    EXPECT_THAT(runs, Eq(1));
+    EXPECT_THAT(throttled_runs, Eq(0));
+
+    alarm_factory.advance_smoothly_by(1s);
+    EXPECT_THAT(throttled_runs, Eq(1));
+}
+
+TEST_F(FrameExecutor, hurried_throttled_work_runs_at_the_next_refresh_of_the_output)
+{
+    auto const refresh = std::chrono::nanoseconds{1s} / 144;
+    executor.spawn_throttled(this, [this]{ ++runs; });
+
+    alarm_factory.advance_smoothly_by(100ms);
+    executor.hurry_throttled(this, presented_at(clock->now() - 1ms, refresh));
+
+    alarm_factory.advance_by(refresh - 2ms);
+    EXPECT_THAT(runs, Eq(0));
+
+    alarm_factory.advance_by(2ms);
+    EXPECT_THAT(runs, Eq(1));
+}
+
+TEST_F(FrameExecutor, hurrying_throttled_work_leaves_that_of_other_surfaces)
+{
+    int other_runs{0};
+    int const other_surface{0};
+    executor.spawn_throttled(this, [this]{ ++runs; });
+    executor.spawn_throttled(&other_surface, [&]{ ++other_runs; });
+
+    executor.hurry_throttled(this, std::nullopt);
+
+    alarm_factory.advance_smoothly_by(20ms);
+    EXPECT_THAT(runs, Eq(1));
+    EXPECT_THAT(other_runs, Eq(0));
+
+    alarm_factory.advance_smoothly_by(1s);
+    EXPECT_THAT(other_runs, Eq(1));
+}
@@ -0,0 +1,211 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/frontend_wayland/input_batch.h"
+#include "mir/events/event_builders.h"
+#include "mir/events/input_event.h"
+#include "mir/events/pointer_event.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+namespace mf = mir::frontend;
+namespace mev = mir::events;
+namespace geom = mir::geometry;
+
+using namespace testing;
+
+namespace
+{
+auto input_event(mir::EventUPtr event) -> std::shared_ptr<MirInputEvent const>
+{
+    return std::dynamic_pointer_cast<MirInputEvent const>(std::shared_ptr<MirEvent const>{std::move(event)});
+}
+
+auto motion(float x, float y, float dx = 0, float dy = 0) -> std::shared_ptr<MirInputEvent const>
+{
+    return input_event(mev::make_pointer_event(
+        0, std::chrono::nanoseconds{0}, 0, mir_pointer_action_motion, 0, x, y, 0, 0, dx, dy));
+}
+
+auto scroll(float x, float y) -> std::shared_ptr<MirInputEvent const>
+{
+    return input_event(mev::make_pointer_event(
+        0, std::chrono::nanoseconds{0}, 0, mir_pointer_action_motion, 0, x, y, 0, 1, 0, 0));
+}
+
+auto button_down(float x, float y) -> std::shared_ptr<MirInputEvent const>
+{
+    return input_event(mev::make_pointer_event(
+        0, std::chrono::nanoseconds{0}, 0, mir_pointer_action_button_down, mir_pointer_button_primary,
+        x, y, 0, 0, 0, 0));
+}
+
+auto key_down() -> std::shared_ptr<MirInputEvent const>
+{
+    return input_event(mev::make_key_event(
+        0, std::chrono::nanoseconds{0}, mir_keyboard_action_down, 0, 0, mir_input_event_modifier_none));
+}
+
+struct InputBatcher : Test
+{
+    mf::InputBatcher batcher;
+};
+
+struct MotionRuns : Test
+{
+    using Events = std::vector<std::shared_ptr<MirInputEvent const>>;
+    /// What was sent, in order: each other event on its own, each run of motion as one entry
+    std::vector<Events> sent;
+
+    void split(Events const& events)
+    {
+        mf::for_each_motion_run(
+            events,
+            [this](auto const& event)
+            {
+                sent.push_back({event});
+            },
+            [this](auto const& run)
+            {
+                Events motion(run.begin(), run.end());
+                EXPECT_THAT(motion, Not(IsEmpty()));
+                sent.push_back(motion);
+            });
+    }
+};
+}
+
+TEST_F(InputBatcher, the_first_input_starts_a_batch)
+{
+    auto const event = key_down();
+
+    auto const batch = batcher.add(event);
+
+    ASSERT_THAT(batch, NotNull());
+    EXPECT_THAT(*batch, ElementsAre(event));
+}
+
+TEST_F(InputBatcher, later_input_joins_the_open_batch_in_order)
+{
+    auto const first = motion(1, 1);
+    auto const second = button_down(1, 1);
+    auto const third = key_down();
+
+    auto const batch = batcher.add(first);
+    EXPECT_THAT(batcher.add(second), IsNull());
+    EXPECT_THAT(batcher.add(third), IsNull());
+
+    ASSERT_THAT(batch, NotNull());
+    EXPECT_THAT(*batch, ElementsAre(first, second, third));
+}
+
+TEST_F(InputBatcher, input_after_the_batch_is_being_handled_starts_a_new_batch)
+{
+    auto const first = motion(1, 1);
+    auto const second = motion(2, 2);
+
+    auto const batch = batcher.add(first);
+    batcher.handling(batch);
+
+    auto const next_batch = batcher.add(second);
+    ASSERT_THAT(next_batch, NotNull());
+    EXPECT_THAT(*next_batch, ElementsAre(second));
+    EXPECT_THAT(*batch, ElementsAre(first));
+}
+
+TEST_F(InputBatcher, input_after_other_work_starts_a_new_batch)
+{
+    auto const first = motion(1, 1);
+    auto const second = motion(2, 2);
+
+    auto const batch = batcher.add(first);
+    batcher.close();
+
+    auto const next_batch = batcher.add(second);
+    ASSERT_THAT(next_batch, NotNull());
+    EXPECT_THAT(*next_batch, ElementsAre(second));
+    EXPECT_THAT(*batch, ElementsAre(first));
+}
+
+TEST_F(InputBatcher, handling_a_closed_batch_leaves_the_next_one_open)
+{
+    auto const batch = batcher.add(motion(1, 1));
+    batcher.close();
+    auto const next_batch = batcher.add(motion(2, 2));
+
+    batcher.handling(batch);
+
+    auto const third = motion(3, 3);
+    EXPECT_THAT(batcher.add(third), IsNull());
+    EXPECT_THAT(next_batch->back(), Eq(third));
+}
+
+TEST_F(MotionRuns, consecutive_motion_is_sent_as_one_run)
+{
+    Events const events{motion(1, 1), motion(2, 2), motion(3, 3)};
+
+    split(events);
+
+    EXPECT_THAT(sent, ElementsAre(events));
+}
+
+TEST_F(MotionRuns, every_coalesced_motion_is_kept_for_its_relative_motion)
+{
+    Events const events{motion(1, 1, 1, 1), motion(3, 2, 2, 1), motion(3, 5, 0, 3)};
+
+    split(events);
+
+    ASSERT_THAT(sent, SizeIs(1));
+    ASSERT_THAT(sent.front(), SizeIs(3));
+    geom::DisplacementF total;
+    for (auto const& event : sent.front())
+    {
+        total = total + mir_input_event_get_pointer_event(event.get())->motion();
+    }
+    EXPECT_THAT(total, Eq(geom::DisplacementF{3.0f, 5.0f}));
+}
+
+TEST_F(MotionRuns, runs_are_split_at_other_events_in_order)
+{
+    auto const first = motion(1, 1);
+    auto const second = motion(2, 2);
+    auto const press = button_down(2, 2);
+    auto const third = motion(3, 3);
+    auto const key = key_down();
+    auto const fourth = motion(4, 4);
+    auto const fifth = motion(5, 5);
+
+    split({first, second, press, third, key, fourth, fifth});
+
+    EXPECT_THAT(sent, ElementsAre(
+        Events{first, second},
+        Events{press},
+        Events{third},
+        Events{key},
+        Events{fourth, fifth}));
+}
+
+TEST_F(MotionRuns, scrolling_is_not_coalesced_with_motion)
+{
+    auto const first = motion(1, 1);
+    auto const scrolled = scroll(1, 1);
+    auto const second = motion(2, 2);
+
+    split({first, scrolled, second});
+
+    EXPECT_THAT(sent, ElementsAre(Events{first}, Events{scrolled}, Events{second}));
+}
@@ -0,0 +1,162 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/frontend_wayland/keyboard_helper.h"
+#include "mir/input/parameter_keymap.h"
+#include "mir/events/event_builders.h"
+#include "mir/events/keyboard_event.h"
+
+#include "mir/test/doubles/mock_input_seat.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <unistd.h>
+
+namespace mf = mir::frontend;
+namespace mi = mir::input;
+namespace mev = mir::events;
+namespace mtd = mir::test::doubles;
+
+using namespace testing;
+
+namespace
+{
+struct SentKeymap
+{
+    mir::Fd fd;
+    size_t size;
+};
+
+struct MockKeyboardCallbacks : mf::KeyboardCallbacks
+{
+    MockKeyboardCallbacks()
+    {
+        ON_CALL(*this, send_keymap_xkb_v1(_, _))
+            .WillByDefault([this](mir::Fd const& fd, size_t size) { sent_keymaps.push_back({fd, size}); });
+    }
+
+    MOCK_METHOD(void, send_repeat_info, (int32_t rate, int32_t delay), (override));
+    MOCK_METHOD(void, send_keymap_xkb_v1, (mir::Fd const& fd, size_t length), (override));
+    MOCK_METHOD(void, send_key, (std::shared_ptr<MirKeyboardEvent const> const& event), (override));
+    MOCK_METHOD(void, send_modifiers, (MirXkbModifiers const& modifiers), (override));
+
+    std::vector<SentKeymap> sent_keymaps;
+};
+
+struct KeyboardHelper : Test
+{
+    auto helper_for(MockKeyboardCallbacks& callbacks, std::shared_ptr<mi::Keymap> const& keymap)
+        -> std::unique_ptr<mf::KeyboardHelper>
+    {
+        return std::make_unique<mf::KeyboardHelper>(&callbacks, keymap, seat, true);
+    }
+
+    static auto keymap_with_layout(std::string const& layout) -> std::shared_ptr<mi::Keymap>
+    {
+        return std::make_shared<mi::ParameterKeymap>(mi::ParameterKeymap::default_model, layout, "", "");
+    }
+
+    static auto key_with_keymap(std::shared_ptr<mi::Keymap> const& keymap) -> std::shared_ptr<MirEvent const>
+    {
+        auto event = mev::make_key_event(
+            0, std::chrono::nanoseconds{0}, mir_keyboard_action_down, 0, 30, mir_input_event_modifier_none);
+        event->to_input()->to_keyboard()->set_keymap(keymap);
+        return std::shared_ptr<MirEvent const>{std::move(event)};
+    }
+
+    /// The whole of a keymap file, however far a client has read it
+    static auto contents_of(SentKeymap const& keymap) -> std::string
+    {
+        std::string contents(keymap.size, '\0');
+        EXPECT_THAT(pread(keymap.fd, contents.data(), keymap.size, 0), Eq(static_cast<ssize_t>(keymap.size)));
+        return contents;
+    }
+
+    std::shared_ptr<mtd::MockInputSeat> const seat{std::make_shared<NiceMock<mtd::MockInputSeat>>()};
+};
+}
+
+TEST_F(KeyboardHelper, keymap_file_can_be_read_from_the_start)
+{
+    NiceMock<MockKeyboardCallbacks> callbacks;
+    auto const helper = helper_for(callbacks, keymap_with_layout("us"));
+
+    ASSERT_THAT(callbacks.sent_keymaps, SizeIs(1));
+    auto const& sent = callbacks.sent_keymaps.front();
+
+    std::string text(sent.size, 'x');
+    EXPECT_THAT(read(sent.fd, text.data(), sent.size), Eq(static_cast<ssize_t>(sent.size)));
+    EXPECT_THAT(text, StartsWith("xkb_keymap"));
+    EXPECT_THAT(text.back(), Eq('\0'));
+}
+
+TEST_F(KeyboardHelper, keymap_file_cannot_be_changed_by_clients)
+{
+    NiceMock<MockKeyboardCallbacks> callbacks;
+    auto const helper = helper_for(callbacks, keymap_with_layout("us"));
+
+    ASSERT_THAT(callbacks.sent_keymaps, SizeIs(1));
+    auto const& sent = callbacks.sent_keymaps.front();
+
+    EXPECT_THAT(pwrite(sent.fd, "x", 1, 0), Lt(0));
+    EXPECT_THAT(ftruncate(sent.fd, 0), Lt(0));
+}
+
+TEST_F(KeyboardHelper, keyboards_with_the_same_keymap_share_one_file)
+{
+    NiceMock<MockKeyboardCallbacks> first_callbacks;
+    NiceMock<MockKeyboardCallbacks> second_callbacks;
+
+    // Separate, but matching, keymaps, as separate devices would have
+    auto const first = helper_for(first_callbacks, keymap_with_layout("us"));
+    auto const second = helper_for(second_callbacks, keymap_with_layout("us"));
+
+    ASSERT_THAT(first_callbacks.sent_keymaps, SizeIs(1));
+    ASSERT_THAT(second_callbacks.sent_keymaps, SizeIs(1));
+    EXPECT_THAT(int{second_callbacks.sent_keymaps.front().fd}, Eq(int{first_callbacks.sent_keymaps.front().fd}));
+    EXPECT_THAT(second_callbacks.sent_keymaps.front().size, Eq(first_callbacks.sent_keymaps.front().size));
+}
+
+TEST_F(KeyboardHelper, a_layout_switch_swaps_the_file)
+{
+    NiceMock<MockKeyboardCallbacks> switching_callbacks;
+    NiceMock<MockKeyboardCallbacks> other_callbacks;
+    auto const switching = helper_for(switching_callbacks, keymap_with_layout("us"));
+    auto const other = helper_for(other_callbacks, keymap_with_layout("de"));
+
+    switching->handle_event(key_with_keymap(keymap_with_layout("de")));
+
+    ASSERT_THAT(switching_callbacks.sent_keymaps, SizeIs(2));
+    ASSERT_THAT(other_callbacks.sent_keymaps, SizeIs(1));
+    auto const& before = switching_callbacks.sent_keymaps[0];
+    auto const& after = switching_callbacks.sent_keymaps[1];
+
+    EXPECT_THAT(int{after.fd}, Ne(int{before.fd}));
+    EXPECT_THAT(contents_of(after), Ne(contents_of(before)));
+    // ...to the file every keyboard with the new layout already shares
+    EXPECT_THAT(int{after.fd}, Eq(int{other_callbacks.sent_keymaps.front().fd}));
+}
+
+TEST_F(KeyboardHelper, a_matching_keymap_does_not_resend_the_file)
+{
+    NiceMock<MockKeyboardCallbacks> callbacks;
+    auto const helper = helper_for(callbacks, keymap_with_layout("us"));
+
+    helper->handle_event(key_with_keymap(keymap_with_layout("us")));
+
+    EXPECT_THAT(callbacks.sent_keymaps, SizeIs(1));
+}
@@ -0,0 +1,197 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/frontend_wayland/linux_drm_syncobj_v1.h"
+#include "mir/test/doubles/mock_drm.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <wayland-server-core.h>
+#include <sys/eventfd.h>
+
+namespace mf = mir::frontend;
+namespace mg = mir::graphics;
+namespace mw = mir::wayland;
+namespace mtd = mir::test::doubles;
+
+using namespace testing;
+
+namespace
+{
+using Error = mw::LinuxDrmSyncobjSurfaceV1::Error;
+
+MATCHER_P(HasCode, code, "")
+{
+    return arg && arg->code == code;
+}
+
+struct LinuxDrmSyncobjSurfaceV1 : Test
+{
+    auto timeline() -> std::shared_ptr<mg::DRMTimeline>
+    {
+        return std::make_shared<mg::DRMTimeline>(mir::Fd{mir::IntOwnedFd{42}}, mir::Fd{mir::IntOwnedFd{43}});
+    }
+
+    static auto points_error(
+        bool buffer_attached,
+        std::optional<mg::DRMTimelinePoint> const& acquire,
+        std::optional<mg::DRMTimelinePoint> const& release)
+    {
+        return mf::LinuxDrmSyncobjSurfaceV1::points_error(buffer_attached, acquire, release);
+    }
+
+    NiceMock<mtd::MockDRM> mock_drm;
+    std::shared_ptr<mg::DRMTimeline> const first_timeline{timeline()};
+    std::shared_ptr<mg::DRMTimeline> const second_timeline{timeline()};
+};
+}
+
+TEST_F(LinuxDrmSyncobjSurfaceV1, a_buffer_with_both_points_is_accepted)
+{
+    EXPECT_FALSE(
+        points_error(true, mg::DRMTimelinePoint{first_timeline, 1}, mg::DRMTimelinePoint{first_timeline, 2}));
+}
+
+TEST_F(LinuxDrmSyncobjSurfaceV1, a_commit_without_a_buffer_or_points_is_accepted)
+{
+    EXPECT_FALSE(points_error(false, std::nullopt, std::nullopt));
+}
+
+TEST_F(LinuxDrmSyncobjSurfaceV1, a_buffer_without_an_acquire_point_is_an_error)
+{
+    EXPECT_THAT(
+        points_error(true, std::nullopt, mg::DRMTimelinePoint{first_timeline, 2}),
+        HasCode(Error::no_acquire_point));
+}
+
+TEST_F(LinuxDrmSyncobjSurfaceV1, a_buffer_without_a_release_point_is_an_error)
+{
+    EXPECT_THAT(
+        points_error(true, mg::DRMTimelinePoint{first_timeline, 1}, std::nullopt),
+        HasCode(Error::no_release_point));
+}
+
+TEST_F(LinuxDrmSyncobjSurfaceV1, points_without_a_buffer_are_an_error)
+{
+    EXPECT_THAT(
+        points_error(false, mg::DRMTimelinePoint{first_timeline, 1}, std::nullopt),
+        HasCode(Error::no_buffer));
+    EXPECT_THAT(
+        points_error(false, std::nullopt, mg::DRMTimelinePoint{first_timeline, 2}),
+        HasCode(Error::no_buffer));
+}
+
+TEST_F(LinuxDrmSyncobjSurfaceV1, an_acquire_point_not_before_the_release_point_on_its_timeline_is_an_error)
+{
+    EXPECT_THAT(
+        points_error(true, mg::DRMTimelinePoint{first_timeline, 2}, mg::DRMTimelinePoint{first_timeline, 2}),
+        HasCode(Error::conflicting_points));
+    EXPECT_THAT(
+        points_error(true, mg::DRMTimelinePoint{first_timeline, 3}, mg::DRMTimelinePoint{first_timeline, 2}),
+        HasCode(Error::conflicting_points));
+}
+
+TEST_F(LinuxDrmSyncobjSurfaceV1, points_on_different_timelines_are_not_ordered)
+{
+    EXPECT_FALSE(
+        points_error(true, mg::DRMTimelinePoint{first_timeline, 3}, mg::DRMTimelinePoint{second_timeline, 2}));
+}
+
+namespace
+{
+struct DRMTimelinePointWatch : Test
+{
+    DRMTimelinePointWatch()
+    {
+        ON_CALL(mock_drm, drmSyncobjEventfd(_, _, point, _, _))
+            .WillByDefault(DoAll(SaveArg<3>(&notify_fd), Return(0)));
+    }
+
+    ~DRMTimelinePointWatch()
+    {
+        wl_event_loop_destroy(loop);
+    }
+
+    void fence_submitted()
+    {
+        eventfd_write(notify_fd, 1);
+    }
+
+    NiceMock<mtd::MockDRM> mock_drm;
+    wl_event_loop* const loop{wl_event_loop_create()};
+    std::shared_ptr<mg::DRMTimeline> const timeline{
+        std::make_shared<mg::DRMTimeline>(mir::Fd{mir::IntOwnedFd{42}}, mir::Fd{mir::IntOwnedFd{43}})};
+    uint64_t const point{3};
+    int notify_fd{-1};
+};
+}
+
+TEST_F(DRMTimelinePointWatch, calls_back_once_the_point_has_a_fence)
+{
+    MockFunction<void()> on_fence;
+    mf::DRMTimelinePointWatch const watch{loop, {timeline, point}, on_fence.AsStdFunction()};
+
+    EXPECT_CALL(on_fence, Call()).Times(0);
+    wl_event_loop_dispatch(loop, 0);
+    Mock::VerifyAndClearExpectations(&on_fence);
+
+    EXPECT_CALL(on_fence, Call());
+    fence_submitted();
+    wl_event_loop_dispatch(loop, 0);
+}
+
+TEST_F(DRMTimelinePointWatch, does_not_call_back_once_destroyed)
+{
+    MockFunction<void()> on_fence;
+    EXPECT_CALL(on_fence, Call()).Times(0);
+
+    {
+        mf::DRMTimelinePointWatch const watch{loop, {timeline, point}, on_fence.AsStdFunction()};
+        fence_submitted();
+    }
+    wl_event_loop_dispatch(loop, 0);
+}
+
+TEST_F(DRMTimelinePointWatch, can_be_destroyed_by_its_callback)
+{
+    std::unique_ptr<mf::DRMTimelinePointWatch> watch;
+    bool called{false};
+    watch = std::make_unique<mf::DRMTimelinePointWatch>(
+        loop,
+        mg::DRMTimelinePoint{timeline, point},
+        [&]()
+        {
+            watch.reset();
+            called = true;
+        });
+
+    fence_submitted();
+    wl_event_loop_dispatch(loop, 0);
+
+    EXPECT_TRUE(called);
+    EXPECT_FALSE(watch);
+}
+
+TEST_F(DRMTimelinePointWatch, throws_if_the_point_cannot_be_watched)
+{
+    ON_CALL(mock_drm, drmSyncobjEventfd(_, _, _, _, _))
+        .WillByDefault(SetErrnoAndReturn(EINVAL, -1));
+
+    EXPECT_THROW(
+        (mf::DRMTimelinePointWatch{loop, {timeline, point}, []{}}),
+        std::system_error);
+}
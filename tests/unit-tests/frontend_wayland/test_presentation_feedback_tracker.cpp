@@ -0,0 +1,144 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/frontend_wayland/wp_presentation.h"
+#include "mir/graphics/frame.h"
+#include "mir/wayland/lifetime_tracker.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+namespace mf = mir::frontend;
+namespace mg = mir::graphics;
+namespace mw = mir::wayland;
+
+using namespace testing;
+
+namespace
+{
+struct MockFeedback : mf::PresentationFeedbackTracker::Feedback, mw::LifetimeTracker
+{
+    auto destroyed_flag() const -> std::shared_ptr<bool const> override
+    {
+        return LifetimeTracker::destroyed_flag();
+    }
+
+    MOCK_METHOD(void, presented, (mg::Presentation const&), (override));
+    MOCK_METHOD(void, discarded, (), (override));
+};
+
+MATCHER_P(PresentedAt, msc, "")
+{
+    return arg.frame.msc == msc;
+}
+
+struct PresentationFeedbackTracker : Test
+{
+    auto feedbacks(std::initializer_list<MockFeedback*> list) -> mf::PresentationFeedbackTracker::Feedbacks
+    {
+        mf::PresentationFeedbackTracker::Feedbacks result;
+        for (auto const feedback : list)
+        {
+            result.push_back(mw::make_weak<mf::PresentationFeedbackTracker::Feedback>(feedback));
+        }
+        return result;
+    }
+
+    static auto presentation(int64_t msc) -> mg::Presentation
+    {
+        return {{msc, mg::Frame::Timestamp::now(CLOCK_MONOTONIC)}, {}, true};
+    }
+
+    mg::BufferID const first_buffer{1};
+    mg::BufferID const second_buffer{2};
+    StrictMock<MockFeedback> first_feedback;
+    StrictMock<MockFeedback> second_feedback;
+    mf::PresentationFeedbackTracker tracker;
+};
+}
+
+TEST_F(PresentationFeedbackTracker, feedback_is_presented_when_its_buffer_is_shown)
+{
+    tracker.submitted(first_buffer, feedbacks({&first_feedback}));
+
+    EXPECT_CALL(first_feedback, presented(PresentedAt(42)));
+    tracker.presented(first_buffer, presentation(42));
+}
+
+TEST_F(PresentationFeedbackTracker, feedback_is_only_presented_once)
+{
+    tracker.submitted(first_buffer, feedbacks({&first_feedback}));
+
+    EXPECT_CALL(first_feedback, presented(_));
+    tracker.presented(first_buffer, presentation(42));
+    tracker.presented(first_buffer, presentation(43));
+}
+
+TEST_F(PresentationFeedbackTracker, feedback_is_discarded_when_its_content_is_superseded)
+{
+    tracker.submitted(first_buffer, feedbacks({&first_feedback}));
+
+    EXPECT_CALL(first_feedback, discarded());
+    tracker.submitted(second_buffer, feedbacks({&second_feedback}));
+
+    // A late report of the superseded buffer says nothing about the new content
+    tracker.presented(first_buffer, presentation(42));
+
+    EXPECT_CALL(second_feedback, presented(PresentedAt(43)));
+    tracker.presented(second_buffer, presentation(43));
+}
+
+TEST_F(PresentationFeedbackTracker, commits_without_new_content_are_presented_with_the_content_still_waiting)
+{
+    tracker.submitted(first_buffer, feedbacks({&first_feedback}));
+    tracker.unchanged(feedbacks({&second_feedback}));
+
+    EXPECT_CALL(first_feedback, presented(PresentedAt(42)));
+    EXPECT_CALL(second_feedback, presented(PresentedAt(42)));
+    tracker.presented(first_buffer, presentation(42));
+}
+
+TEST_F(PresentationFeedbackTracker, commits_without_new_content_are_discarded_once_the_content_has_been_shown)
+{
+    tracker.submitted(first_buffer, feedbacks({&first_feedback}));
+    EXPECT_CALL(first_feedback, presented(_));
+    tracker.presented(first_buffer, presentation(42));
+
+    EXPECT_CALL(second_feedback, discarded());
+    tracker.unchanged(feedbacks({&second_feedback}));
+}
+
+TEST_F(PresentationFeedbackTracker, feedback_is_discarded_when_the_surface_is_unmapped)
+{
+    tracker.submitted(first_buffer, feedbacks({&first_feedback}));
+    tracker.unchanged(feedbacks({&second_feedback}));
+
+    EXPECT_CALL(first_feedback, discarded());
+    EXPECT_CALL(second_feedback, discarded());
+    tracker.unmapped();
+
+    tracker.presented(first_buffer, presentation(42));
+}
+
+TEST_F(PresentationFeedbackTracker, feedback_the_client_has_destroyed_is_skipped)
+{
+    auto destroyed_feedback = std::make_unique<StrictMock<MockFeedback>>();
+    tracker.submitted(first_buffer, feedbacks({destroyed_feedback.get(), &first_feedback}));
+    destroyed_feedback.reset();
+
+    EXPECT_CALL(first_feedback, presented(_));
+    tracker.presented(first_buffer, presentation(42));
+}
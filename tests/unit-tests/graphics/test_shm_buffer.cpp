@@ -351,3 +351,130 @@ TEST_F(ShmBufferTest, texture_is_destroyed_on_thread_with_current_context)
         eglMakeCurrent(dummy_dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
     }
 }
+
+namespace
+{
+struct ShmBufferStreamTest : public ShmBufferTest
+{
+    auto make_pixels(geom::Size size) -> std::shared_ptr<PlatformlessShmBuffer>
+    {
+        return std::make_shared<PlatformlessShmBuffer>(size, mir_pixel_format_argb_8888, egl_delegate);
+    }
+
+    auto make_frame(
+        std::shared_ptr<PlatformlessShmBuffer> const& pixels,
+        std::shared_ptr<mg::Buffer> const& previous,
+        std::optional<geom::Rectangles> const& damage) -> std::shared_ptr<mgc::MappableBackedShmBuffer>
+    {
+        return std::make_shared<mgc::MappableBackedShmBuffer>(pixels, egl_delegate, previous, damage);
+    }
+
+    static auto offset_of(PlatformlessShmBuffer& pixels, geom::Point point) -> unsigned char const*
+    {
+        auto const stride = pixels.stride().as_int();
+        return pixels.pixel_buffer() +
+            point.y.as_int() * stride +
+            point.x.as_int() * MIR_BYTES_PER_PIXEL(mir_pixel_format_argb_8888);
+    }
+
+    geom::Size const stream_size{640, 480};
+};
+}
+
+TEST_F(ShmBufferStreamTest, next_frame_reuses_texture_and_uploads_only_damage)
+{
+    auto const first_pixels = make_pixels(stream_size);
+    auto const second_pixels = make_pixels(stream_size);
+    geom::Rectangle const damage{{10, 20}, {30, 40}};
+
+    EXPECT_CALL(mock_gl, glGenTextures(1, _)).WillOnce(SetArgPointee<1>(GLuint{0x5eed}));
+    EXPECT_CALL(mock_gl, glTexImage2D(_, _, _, _, _, _, _, _, first_pixels->pixel_buffer()));
+    EXPECT_CALL(mock_gl, glTexSubImage2D(
+        GL_TEXTURE_2D, 0,
+        10, 20, 30, 40,
+        _, GL_UNSIGNED_BYTE,
+        offset_of(*second_pixels, damage.top_left)));
+
+    auto const first = make_frame(first_pixels, nullptr, std::nullopt);
+    first->bind();
+
+    auto const second = make_frame(second_pixels, first, geom::Rectangles{damage});
+    second->bind();
+}
+
+TEST_F(ShmBufferStreamTest, frame_with_unknown_damage_is_fully_uploaded)
+{
+    auto const first_pixels = make_pixels(stream_size);
+    auto const second_pixels = make_pixels(stream_size);
+
+    EXPECT_CALL(mock_gl, glTexImage2D(_, _, _, _, _, _, _, _, first_pixels->pixel_buffer()));
+    EXPECT_CALL(mock_gl, glTexImage2D(_, _, _, _, _, _, _, _, second_pixels->pixel_buffer()));
+    EXPECT_CALL(mock_gl, glTexSubImage2D(_, _, _, _, _, _, _, _, _)).Times(0);
+
+    auto const first = make_frame(first_pixels, nullptr, std::nullopt);
+    first->bind();
+
+    auto const second = make_frame(second_pixels, first, std::nullopt);
+    second->bind();
+}
+
+TEST_F(ShmBufferStreamTest, frame_of_different_size_gets_its_own_texture)
+{
+    auto const first_pixels = make_pixels(stream_size);
+    auto const second_pixels = make_pixels(stream_size * 2);
+
+    EXPECT_CALL(mock_gl, glGenTextures(1, _)).Times(2);
+    EXPECT_CALL(mock_gl, glTexSubImage2D(_, _, _, _, _, _, _, _, _)).Times(0);
+
+    auto const first = make_frame(first_pixels, nullptr, std::nullopt);
+    first->bind();
+
+    auto const second = make_frame(second_pixels, first, geom::Rectangles{{{0, 0}, {1, 1}}});
+    second->bind();
+}
+
+TEST_F(ShmBufferStreamTest, damage_of_frames_never_bound_is_uploaded_with_the_next)
+{
+    auto const first_pixels = make_pixels(stream_size);
+    auto const second_pixels = make_pixels(stream_size);
+    auto const third_pixels = make_pixels(stream_size);
+    geom::Rectangle const second_damage{{10, 20}, {30, 40}};
+    geom::Rectangle const third_damage{{100, 200}, {5, 6}};
+
+    EXPECT_CALL(mock_gl, glTexSubImage2D(
+        _, _, 10, 20, 30, 40, _, _, offset_of(*third_pixels, second_damage.top_left)));
+    EXPECT_CALL(mock_gl, glTexSubImage2D(
+        _, _, 100, 200, 5, 6, _, _, offset_of(*third_pixels, third_damage.top_left)));
+
+    auto const first = make_frame(first_pixels, nullptr, std::nullopt);
+    first->bind();
+
+    auto const second = make_frame(second_pixels, first, geom::Rectangles{second_damage});
+    auto const third = make_frame(third_pixels, second, geom::Rectangles{third_damage});
+    third->bind();
+}
+
+TEST_F(ShmBufferStreamTest, rebinding_an_uploaded_frame_uploads_nothing)
+{
+    auto const first = make_frame(make_pixels(stream_size), nullptr, std::nullopt);
+    first->bind();
+
+    EXPECT_CALL(mock_gl, glTexImage2D(_, _, _, _, _, _, _, _, _)).Times(0);
+    EXPECT_CALL(mock_gl, glTexSubImage2D(_, _, _, _, _, _, _, _, _)).Times(0);
+
+    first->bind();
+}
+
+TEST_F(ShmBufferStreamTest, fences_upload_rather_than_blocking_when_supported)
+{
+    EGLSyncKHR const fence{reinterpret_cast<EGLSyncKHR>(0xfe9ce)};
+    ON_CALL(mock_egl, eglQueryString(_, EGL_EXTENSIONS))
+        .WillByDefault(Return("EGL_KHR_fence_sync"));
+
+    EXPECT_CALL(mock_egl, eglCreateSyncKHR(_, EGL_SYNC_FENCE_KHR, _)).WillOnce(Return(fence));
+    EXPECT_CALL(mock_gl, glFlush());
+    EXPECT_CALL(mock_gl, glFinish()).Times(0);
+
+    auto const first = make_frame(make_pixels(stream_size), nullptr, std::nullopt);
+    first->bind();
+}
@@ -31,6 +31,7 @@
 #include "mir/test/event_matchers.h"
 #include "mir/test/doubles/mock_input_dispatcher.h"
 #include "mir/test/doubles/mock_input_device_hub.h"
+#include "mir/test/doubles/advanceable_clock.h"
 
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
@@ -103,7 +104,7 @@ struct StubDevice : public mi::Device
 struct KeyRepeatDispatcher : public testing::Test
 {
     KeyRepeatDispatcher(bool on_arale = false)
-        : dispatcher(mock_next_dispatcher, mock_alarm_factory, true, repeat_time, repeat_delay, on_arale)
+        : dispatcher(mock_next_dispatcher, mock_alarm_factory, clock, true, repeat_time, repeat_delay, on_arale)
     {
         ON_CALL(hub,add_observer(_)).WillByDefault(SaveArg<0>(&observer));
         dispatcher.set_input_device_hub(mt::fake_shared(hub));
@@ -118,6 +119,7 @@ struct KeyRepeatDispatcher : public testing::Test
     const MirInputDeviceId test_device = 123;
     std::shared_ptr<mtd::MockInputDispatcher> mock_next_dispatcher = std::make_shared<mtd::MockInputDispatcher>();
     std::shared_ptr<MockAlarmFactory> mock_alarm_factory = std::make_shared<MockAlarmFactory>();
+    std::shared_ptr<mtd::AdvanceableClock> clock = std::make_shared<mtd::AdvanceableClock>();
     std::chrono::milliseconds const repeat_time{2};
     std::chrono::milliseconds const repeat_delay{1};
     std::shared_ptr<mi::InputDeviceObserver> observer;
@@ -144,6 +146,13 @@ struct KeyRepeatDispatcher : public testing::Test
             test_device, std::chrono::nanoseconds(0), mir_keyboard_action_up, 0, 0,
             mir_input_event_modifier_alt);
     }
+
+    mir::EventUPtr a_key_down_event_from(MirInputDeviceId device)
+    {
+        return mev::make_key_event(
+            device, std::chrono::nanoseconds(0), mir_keyboard_action_down, 0, 0,
+            mir_input_event_modifier_none);
+    }
 };
 
 struct KeyRepeatDispatcherOnArale : KeyRepeatDispatcher
@@ -225,6 +234,81 @@ TEST_F(KeyRepeatDispatcher, stops_repeat_on_device_removal)
     EXPECT_THAT(alarm_canceled, Eq(true));
 }
 
+TEST_F(KeyRepeatDispatcher, repeats_keys_held_on_several_devices_from_one_alarm)
+{
+    MockAlarm *mock_alarm = new MockAlarm; // deleted by AlarmFactory
+    std::function<void()> alarm_function;
+    MirInputDeviceId const other_device = 124;
+
+    EXPECT_CALL(*mock_alarm_factory, create_alarm_adapter(_)).Times(1).
+        WillOnce(DoAll(SaveArg<0>(&alarm_function), Return(mock_alarm)));
+    ON_CALL(*mock_alarm, reschedule_in(_)).WillByDefault(Return(true));
+    EXPECT_CALL(*mock_next_dispatcher, dispatch(mt::KeyDownEvent())).Times(2);
+    EXPECT_CALL(*mock_next_dispatcher, dispatch(AllOf(mt::KeyRepeatEvent(), mt::InputDeviceIdMatches(test_device))))
+        .Times(1);
+    EXPECT_CALL(*mock_next_dispatcher, dispatch(AllOf(mt::KeyRepeatEvent(), mt::InputDeviceIdMatches(other_device))))
+        .Times(1);
+
+    dispatcher.dispatch(a_key_down_event_from(test_device));
+    dispatcher.dispatch(a_key_down_event_from(other_device));
+    // The first key is held long enough for the second to be due by the time the alarm fires
+    clock->advance_by(repeat_time);
+    alarm_function();
+}
+
+TEST_F(KeyRepeatDispatcher, repeats_are_only_sent_once_due)
+{
+    MockAlarm *mock_alarm = new MockAlarm; // deleted by AlarmFactory
+    std::function<void()> alarm_function;
+    MirInputDeviceId const other_device = 124;
+
+    EXPECT_CALL(*mock_alarm_factory, create_alarm_adapter(_)).Times(1).
+        WillOnce(DoAll(SaveArg<0>(&alarm_function), Return(mock_alarm)));
+    ON_CALL(*mock_alarm, reschedule_in(_)).WillByDefault(Return(true));
+    EXPECT_CALL(*mock_next_dispatcher, dispatch(mt::KeyDownEvent())).Times(2);
+
+    dispatcher.dispatch(a_key_down_event_from(test_device));
+    clock->advance_by(repeat_time / 2);
+    dispatcher.dispatch(a_key_down_event_from(other_device));
+    clock->advance_by(repeat_time / 2);
+
+    // Only the first key has been held for repeat_time
+    EXPECT_CALL(*mock_next_dispatcher, dispatch(AllOf(mt::KeyRepeatEvent(), mt::InputDeviceIdMatches(test_device))))
+        .Times(1);
+    EXPECT_CALL(*mock_next_dispatcher, dispatch(AllOf(mt::KeyRepeatEvent(), mt::InputDeviceIdMatches(other_device))))
+        .Times(0);
+    alarm_function();
+    Mock::VerifyAndClearExpectations(mock_next_dispatcher.get());
+
+    clock->advance_by(repeat_time / 2);
+
+    EXPECT_CALL(*mock_next_dispatcher, dispatch(AllOf(mt::KeyRepeatEvent(), mt::InputDeviceIdMatches(test_device))))
+        .Times(1);
+    EXPECT_CALL(*mock_next_dispatcher, dispatch(AllOf(mt::KeyRepeatEvent(), mt::InputDeviceIdMatches(other_device))))
+        .Times(1);
+    alarm_function();
+}
+
+TEST_F(KeyRepeatDispatcher, repeats_are_sent_without_holding_the_repeat_state)
+{
+    MockAlarm *mock_alarm = new MockAlarm; // deleted by AlarmFactory
+    std::function<void()> alarm_function;
+
+    EXPECT_CALL(*mock_alarm_factory, create_alarm_adapter(_)).Times(1).
+        WillOnce(DoAll(SaveArg<0>(&alarm_function), Return(mock_alarm)));
+    ON_CALL(*mock_alarm, reschedule_in(_)).WillByDefault(Return(true));
+    ON_CALL(*mock_alarm, cancel()).WillByDefault(Return(true));
+    EXPECT_CALL(*mock_next_dispatcher, dispatch(mt::KeyDownEvent())).Times(1);
+
+    dispatcher.dispatch(a_key_down_event());
+    clock->advance_by(repeat_time);
+
+    // Something downstream reacting to the repeat by releasing the key (here, removing the device)
+    EXPECT_CALL(*mock_next_dispatcher, dispatch(mt::KeyRepeatEvent()))
+        .WillOnce(InvokeWithoutArgs([this]() { simulate_device_removal(); return true; }));
+    alarm_function();
+}
+
 TEST_F(KeyRepeatDispatcherOnArale, no_repeat_alarm_on_mtk_tpd)
 {
     EXPECT_CALL(*mock_alarm_factory, create_alarm_adapter(_)).Times(0);
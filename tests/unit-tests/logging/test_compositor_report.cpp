@@ -16,10 +16,12 @@
 
 #include "src/server/report/logging/compositor_report.h"
 #include "mir/logging/logger.h"
+#include "mir/graphics/frame.h"
 #include "mir/test/doubles/advanceable_clock.h"
 
 #include <gtest/gtest.h>
 #include <string>
+#include <vector>
 #include <cstdio>
 
 using namespace std;
@@ -27,6 +29,7 @@ using namespace std;
 namespace mtd = mir::test::doubles;
 namespace mrl = mir::report::logging;
 namespace ml = mir::logging;
+namespace mg = mir::graphics;
 
 namespace
 {
@@ -37,6 +40,11 @@ public:
     void log(ml::Severity, string const& message, string const&)
     {
         last = message;
+        all.push_back(message);
+    }
+    vector<string> const& all_messages() const
+    {
+        return all;
     }
     string const& last_message() const
     {
@@ -53,6 +61,7 @@ public:
     }
 private:
     string last;
+    vector<string> all;
 };
 
 struct LoggingCompositorReport : ::testing::Test
@@ -62,6 +71,12 @@ struct LoggingCompositorReport : ::testing::Test
     std::shared_ptr<Recorder> const recorder =
         make_shared<Recorder>();
     mrl::CompositorReport report{recorder, clock};
+
+    /// The display flipping to vblank \a msc just now
+    static auto shown_at(int64_t msc) -> mg::Presentation
+    {
+        return {{msc, mg::Frame::Timestamp::now(CLOCK_MONOTONIC)}, chrono::milliseconds(16), true};
+    }
 };
 
 } // namespace
@@ -187,3 +202,113 @@ TEST_F(LoggingCompositorReport, bypass_has_no_render_time)
 
     report.stopped();
 }
+
+TEST_F(LoggingCompositorReport, logs_latency_percentiles)
+{
+    const void* const id = "My Screen";
+
+    report.started();
+
+    // Each frame is scheduled while the last waits for its flip; the two slow ones flip three vblanks late
+    int64_t msc = 0;
+    report.scheduled();
+    for (int f = 0; f < 100; ++f)
+    {
+        report.began_frame(id);
+        clock->advance_by(chrono::microseconds(f >= 98 ? 50000 : 2000));
+        report.rendered_frame(id);
+        report.finished_frame(id);
+        report.scheduled();
+        clock->advance_by(chrono::microseconds(14000));
+        msc += f >= 98 ? 4 : 1;
+        report.presented_frame(id, shown_at(msc));
+    }
+    clock->advance_by(chrono::seconds(1));
+
+    report.began_frame(id);
+    report.finished_frame(id);
+    float render_p50, render_p90, render_p99, render_max;
+    unsigned long long missed;
+    bool found = false;
+    for (auto const& message : recorder->all_messages())
+    {
+        if (sscanf(message.c_str(),
+                   "Display %*s latency p50/p90/p99/max: render %f/%f/%f/%f ms, %*[^,], %*[^,], %llu missed vblanks",
+                   &render_p50, &render_p90, &render_p99, &render_max, &missed) == 5)
+        {
+            found = true;
+        }
+    }
+
+    ASSERT_TRUE(found) << recorder->last_message();
+    EXPECT_NEAR(2.0f, render_p50, 0.1f);
+    EXPECT_NEAR(2.0f, render_p90, 0.1f);
+    EXPECT_NEAR(50.0f, render_p99, 2.0f);
+    EXPECT_FLOAT_EQ(50.0f, render_max);
+    EXPECT_EQ(6u, missed);
+
+    report.stopped();
+}
+
+TEST_F(LoggingCompositorReport, frame_timings_can_be_queried)
+{
+    const void* const id = "My Screen";
+
+    report.started();
+
+    for (int f = 0; f < 10; ++f)
+    {
+        report.scheduled();
+        clock->advance_by(chrono::microseconds(500));
+        report.began_frame(id);
+        clock->advance_by(chrono::microseconds(3000));
+        report.rendered_frame(id);
+        report.finished_frame(id);
+        clock->advance_by(chrono::microseconds(13000));
+        report.presented_frame(id, shown_at(f + 1));
+    }
+
+    auto const stats = report.frame_timings().stats_for(id);
+    ASSERT_TRUE(stats.has_value());
+    EXPECT_EQ(10u, stats->frames);
+    EXPECT_EQ(chrono::microseconds(3000), stats->render_time.max);
+    EXPECT_EQ(chrono::microseconds(500), stats->schedule_latency.p99);
+    // From the start of the frame; allowing for the real time between taking the flip and reporting it
+    EXPECT_NEAR(16000, stats->present_latency.p50.count(), 600);
+    EXPECT_EQ(0u, stats->missed_vblanks);
+
+    report.stopped();
+}
+
+TEST_F(LoggingCompositorReport, logs_predicted_render_time)
+{
+    const void* const id = "My Screen";
+
+    report.started();
+
+    report.began_frame(id);
+    report.rendered_frame(id);
+    report.finished_frame(id);
+    report.scheduled_next_frame(id, chrono::microseconds(4500), chrono::microseconds(11250));
+    clock->advance_by(chrono::seconds(1));
+
+    report.began_frame(id);
+    report.finished_frame(id);
+    float predicted, delay;
+    bool found = false;
+    for (auto const& message : recorder->all_messages())
+    {
+        if (sscanf(message.c_str(),
+                   "Display %*s predicted render time %f ms, composite delay %f ms",
+                   &predicted, &delay) == 2)
+        {
+            found = true;
+        }
+    }
+
+    ASSERT_TRUE(found) << recorder->last_message();
+    EXPECT_FLOAT_EQ(4.5f, predicted);
+    EXPECT_FLOAT_EQ(11.25f, delay);
+
+    report.stopped();
+}
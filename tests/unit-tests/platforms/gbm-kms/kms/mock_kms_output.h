@@ -33,6 +33,8 @@ struct MockKMSOutput : public graphics::gbm::KMSOutput
     MOCK_METHOD2(configure, void(geometry::Displacement, size_t));
     MOCK_CONST_METHOD0(size, geometry::Size());
     MOCK_CONST_METHOD0(max_refresh_rate, int());
+    MOCK_CONST_METHOD0(vrr_capable, bool());
+    MOCK_METHOD1(set_vrr_enabled, bool(bool));
 
     bool set_crtc(graphics::FBHandle const& fb) override
     {
@@ -48,7 +50,25 @@ struct MockKMSOutput : public graphics::gbm::KMSOutput
         return schedule_page_flip_thunk(&fb);
     }
     MOCK_METHOD1(schedule_page_flip_thunk, bool(graphics::FBHandle const*));
-    MOCK_METHOD0(wait_for_page_flip, void());
+    MOCK_METHOD0(wait_for_page_flip, std::optional<graphics::Frame>());
+
+    size_t fit_layers(graphics::FBHandle const& fb, std::vector<graphics::gbm::PlaneLayer> const& layers) override
+    {
+        return fit_layers_thunk(&fb, layers);
+    }
+    MOCK_METHOD2(fit_layers_thunk, size_t(graphics::FBHandle const*, std::vector<graphics::gbm::PlaneLayer> const&));
+
+    bool schedule_page_flip(
+        graphics::FBHandle const& fb,
+        std::vector<graphics::gbm::PlaneLayer> const& layers) override
+    {
+        return schedule_layered_page_flip_thunk(&fb, layers);
+    }
+    MOCK_METHOD2(
+        schedule_layered_page_flip_thunk,
+        bool(graphics::FBHandle const*, std::vector<graphics::gbm::PlaneLayer> const&));
+
+    MOCK_METHOD0(scanout_formats, std::vector<std::pair<uint32_t, uint64_t>>());
 
     MOCK_CONST_METHOD0(last_frame, graphics::Frame());
 
@@ -233,6 +233,16 @@ struct StubKMSDisplayConfiguration : public mgg::KMSDisplayConfiguration
             });
     }
 
+    void set_scale_of_output(mg::DisplayConfigurationOutputId id, float scale)
+    {
+        stub_config.for_each_output(
+            [id, scale] (mg::UserDisplayConfigurationOutput const& output)
+            {
+                if (output.id == id)
+                    output.scale = scale;
+            });
+    }
+
     StubKMSOutputContainer& container;
     mtd::StubDisplayConfig stub_config;
     std::vector<std::shared_ptr<mgg::KMSOutput>> outputs;
@@ -777,3 +787,111 @@ TEST_F(MesaCursorTest, show_cursor_sets_cursor_with_hotspot)
     cursor.move_to(cursor_location_2);
 }
 
+
+TEST_F(MesaCursorTest, moving_cursor_does_not_rewrite_image)
+{
+    using namespace testing;
+
+    cursor.show(stub_image);
+
+    EXPECT_CALL(mock_gbm, gbm_bo_write(_, _, _)).Times(0);
+
+    cursor.move_to({10, 10});
+    cursor.move_to({20, 15});
+    cursor.move_to({150, 75});
+}
+
+// The image is scaled as the output scales everything else
+MATCHER_P2(ContainsWhiteSquare, side, stride_pixels, "")
+{
+    auto pixels = static_cast<uint32_t const*>(arg);
+    for (auto y = decltype(side){0}; y < side + 1; y++)
+    {
+        for (auto x = decltype(side){0}; x < side + 1; x++)
+        {
+            auto const expected = (x < side && y < side) ? 0xffffffff : 0x0;
+            if (pixels[y * stride_pixels + x] != expected)
+                return false;
+        }
+    }
+    return true;
+}
+
+TEST_F(MesaCursorTest, scales_image_for_hidpi_outputs)
+{
+    using namespace testing;
+
+    size_t const stride = cursor_side * 4;
+    ON_CALL(mock_gbm, gbm_bo_get_stride(_))
+        .WillByDefault(Return(stride));
+
+    current_configuration.conf.set_scale_of_output(mg::DisplayConfigurationOutputId{0}, 2.0f);
+
+    EXPECT_CALL(mock_gbm, gbm_bo_write(_, ContainsWhiteSquare(2u, cursor_side), _));
+
+    cursor.show(SinglePixelCursorImage());
+}
+
+TEST_F(MesaCursorTest, scales_hotspot_for_hidpi_outputs)
+{
+    using namespace testing;
+
+    struct SmallHotspotCursor : public StubCursorImage
+    {
+        geom::Size size() const override
+        {
+            return {16, 16};
+        }
+        geom::Displacement hotspot() const override
+        {
+            return {5, 5};
+        }
+    };
+
+    current_configuration.conf.set_scale_of_output(mg::DisplayConfigurationOutputId{0}, 2.0f);
+
+    // (20, 20) in the logical space of the output is (40, 40) on the output, and the hotspot (5, 5) is (10, 10)
+    EXPECT_CALL(*output_container.outputs[0], move_cursor(geom::Point{30, 30}));
+
+    cursor.move_to({20, 20});
+    cursor.show(SmallHotspotCursor());
+}
+
+TEST_F(MesaCursorTest, shrinks_images_too_large_for_buffer)
+{
+    using namespace testing;
+
+    struct LargeCursorImage : public StubCursorImage
+    {
+        geom::Size size() const override
+        {
+            return {128, 128};
+        }
+        geom::Displacement hotspot() const override
+        {
+            return {64, 64};
+        }
+    };
+
+    // The 128x128 image is shown at 64x64, so its hotspot is at (32, 32)
+    EXPECT_CALL(*output_container.outputs[0], move_cursor(geom::Point{68, 68}));
+
+    cursor.move_to({100, 100});
+    cursor.show(LargeCursorImage());
+}
+
+TEST_F(MesaCursorTest, does_not_write_to_buffer_on_screen)
+{
+    using namespace testing;
+
+    int second_bo_storage{0};
+    auto const second_bo = reinterpret_cast<gbm_bo*>(&second_bo_storage);
+    cursor.show(stub_image);
+
+    EXPECT_CALL(mock_gbm, gbm_bo_create(_, _, _, _, _))
+        .WillOnce(Return(second_bo));
+    EXPECT_CALL(mock_gbm, gbm_bo_write(second_bo, _, _));
+    EXPECT_CALL(*output_container.outputs[0], set_cursor(second_bo));
+
+    cursor.show(SinglePixelCursorImage());
+}
@@ -316,6 +316,18 @@ TEST_F(MesaDisplayMultiMonitorTest, create_display_sets_all_connected_crtcs)
     auto display = create_display_cloned(create_platform());
 }
 
+TEST_F(MesaDisplayMultiMonitorTest, create_display_enables_atomic_modesetting_once_for_all_outputs)
+{
+    using namespace testing;
+
+    setup_outputs(3, 0);
+
+    EXPECT_CALL(mock_drm, drmSetClientCap(mtd::IsFdOfDevice(drm_device), DRM_CLIENT_CAP_ATOMIC, 1))
+        .Times(1);
+
+    auto display = create_display_cloned(create_platform());
+}
+
 namespace
 {
 
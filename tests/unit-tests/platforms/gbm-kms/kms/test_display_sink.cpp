@@ -219,6 +219,233 @@ TEST_F(MesaDisplaySinkTest, frames_requiring_gl_are_not_throttled)
     }
 }
 
+TEST_F(MesaDisplaySinkTest, next_vblank_is_a_whole_number_of_frames_after_the_last_page_flip)
+{
+    using namespace std::chrono_literals;
+    auto const flipped = mir::graphics::Frame::Timestamp::now(CLOCK_MONOTONIC) - 2ms;
+    ON_CALL(*mock_kms_output, wait_for_page_flip())
+        .WillByDefault(Return(mir::graphics::Frame{1, flipped}));
+
+    graphics::gbm::DisplaySink sink(
+        drm_fd,
+        gbm,
+        graphics::gbm::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output},
+        display_area,
+        identity);
+
+    EXPECT_FALSE(sink.next_vblank());
+
+    ASSERT_TRUE(sink.overlay(bypassable_list));
+    sink.post();
+
+    auto const vblank = sink.next_vblank();
+    ASSERT_TRUE(vblank);
+    EXPECT_EQ(flipped + std::chrono::nanoseconds{1s} / mock_refresh_rate, *vblank);
+}
+
+TEST_F(MesaDisplaySinkTest, bypassed_frames_drive_a_vrr_capable_output_at_their_own_rate)
+{
+    using namespace std::chrono_literals;
+    ON_CALL(*mock_kms_output, vrr_capable())
+        .WillByDefault(Return(true));
+    ON_CALL(*mock_kms_output, wait_for_page_flip())
+        .WillByDefault(Return(mir::graphics::Frame{1, mir::graphics::Frame::Timestamp::now(CLOCK_MONOTONIC)}));
+
+    graphics::gbm::DisplaySink sink(
+        drm_fd,
+        gbm,
+        graphics::gbm::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output},
+        display_area,
+        identity);
+
+    InSequence seq;
+    EXPECT_CALL(*mock_kms_output, set_vrr_enabled(true))
+        .WillOnce(Return(true));
+    EXPECT_CALL(*mock_kms_output, schedule_page_flip_thunk(_))
+        .Times(2)
+        .WillRepeatedly(Return(true));
+    EXPECT_CALL(*mock_kms_output, set_vrr_enabled(false))
+        .WillOnce(Return(true));
+    EXPECT_CALL(*mock_kms_output, schedule_page_flip_thunk(_))
+        .WillOnce(Return(true));
+
+    for (int frame = 0; frame < 2; ++frame)
+    {
+        ASSERT_TRUE(sink.overlay(bypassable_list));
+        sink.post();
+
+        EXPECT_EQ(0, sink.recommended_sleep().count());
+        EXPECT_FALSE(sink.next_vblank());
+        std::optional<Presentation> presentation;
+        EXPECT_TRUE(sink.when_presented([&](auto const& shown) { presentation = shown; }));
+        ASSERT_TRUE(presentation);
+        EXPECT_EQ(0ns, presentation->refresh_interval);
+    }
+
+    sink.set_next_image(std::make_unique<NiceMock<MockKMSFramebuffer>>());
+    sink.post();
+
+    EXPECT_TRUE(sink.next_vblank());
+}
+
+TEST_F(MesaDisplaySinkTest, output_that_fails_to_enable_vrr_keeps_its_fixed_rate)
+{
+    using namespace std::chrono_literals;
+    ON_CALL(*mock_kms_output, vrr_capable())
+        .WillByDefault(Return(true));
+    ON_CALL(*mock_kms_output, wait_for_page_flip())
+        .WillByDefault(Return(mir::graphics::Frame{1, mir::graphics::Frame::Timestamp::now(CLOCK_MONOTONIC)}));
+
+    graphics::gbm::DisplaySink sink(
+        drm_fd,
+        gbm,
+        graphics::gbm::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output},
+        display_area,
+        identity);
+
+    // ...and isn't asked again each frame
+    EXPECT_CALL(*mock_kms_output, set_vrr_enabled(true))
+        .WillOnce(Return(false));
+
+    for (int frame = 0; frame < 2; ++frame)
+    {
+        ASSERT_TRUE(sink.overlay(bypassable_list));
+        sink.post();
+
+        EXPECT_TRUE(sink.next_vblank());
+        std::optional<Presentation> presentation;
+        EXPECT_TRUE(sink.when_presented([&](auto const& shown) { presentation = shown; }));
+        ASSERT_TRUE(presentation);
+        EXPECT_EQ(std::chrono::nanoseconds{1s} / mock_refresh_rate, presentation->refresh_interval);
+    }
+}
+
+TEST_F(MesaDisplaySinkTest, bypassed_frames_leave_a_fixed_rate_output_alone)
+{
+    ON_CALL(*mock_kms_output, vrr_capable())
+        .WillByDefault(Return(false));
+    ON_CALL(*mock_kms_output, wait_for_page_flip())
+        .WillByDefault(Return(mir::graphics::Frame{1, mir::graphics::Frame::Timestamp::now(CLOCK_MONOTONIC)}));
+
+    graphics::gbm::DisplaySink sink(
+        drm_fd,
+        gbm,
+        graphics::gbm::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output},
+        display_area,
+        identity);
+
+    EXPECT_CALL(*mock_kms_output, set_vrr_enabled(_))
+        .Times(0);
+
+    ASSERT_TRUE(sink.overlay(bypassable_list));
+    sink.post();
+
+    EXPECT_TRUE(sink.next_vblank());
+}
+
+TEST_F(MesaDisplaySinkTest, frames_are_presented_at_their_page_flip)
+{
+    using namespace std::chrono_literals;
+    mir::graphics::Frame const flip{7, mir::graphics::Frame::Timestamp::now(CLOCK_MONOTONIC) - 1ms};
+    ON_CALL(*mock_kms_output, wait_for_page_flip())
+        .WillByDefault(Return(flip));
+
+    graphics::gbm::DisplaySink sink(
+        drm_fd,
+        gbm,
+        graphics::gbm::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output},
+        display_area,
+        identity);
+
+    sink.set_next_image(std::make_unique<NiceMock<MockKMSFramebuffer>>());
+    sink.post();
+
+    // With a single output, post() waits for the flip
+    std::optional<Presentation> presentation;
+    EXPECT_TRUE(sink.when_presented([&](auto const& shown) { presentation = shown; }));
+    ASSERT_TRUE(presentation);
+    EXPECT_EQ(flip.msc, presentation->frame.msc);
+    EXPECT_EQ(flip.ust, presentation->frame.ust);
+    EXPECT_EQ(std::chrono::nanoseconds{1s} / mock_refresh_rate, presentation->refresh_interval);
+    EXPECT_TRUE(presentation->from_hardware);
+}
+
+TEST_F(MesaDisplaySinkTest, cloned_frames_are_presented_once_the_last_output_flips)
+{
+    using namespace std::chrono_literals;
+    auto const now = mir::graphics::Frame::Timestamp::now(CLOCK_MONOTONIC);
+    mir::graphics::Frame const first_flip{7, now - 3ms};
+    mir::graphics::Frame const last_flip{12, now - 1ms};
+
+    int const other_refresh_rate = 75;
+    auto const other_output = std::make_shared<NiceMock<MockKMSOutput>>();
+    ON_CALL(*other_output, schedule_page_flip_thunk(_))
+        .WillByDefault(Return(true));
+    ON_CALL(*other_output, max_refresh_rate())
+        .WillByDefault(Return(other_refresh_rate));
+    ON_CALL(*mock_kms_output, wait_for_page_flip())
+        .WillByDefault(Return(last_flip));
+    ON_CALL(*other_output, wait_for_page_flip())
+        .WillByDefault(Return(first_flip));
+
+    graphics::gbm::DisplaySink sink(
+        drm_fd,
+        gbm,
+        graphics::gbm::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output, other_output},
+        display_area,
+        identity);
+
+    sink.set_next_image(std::make_unique<NiceMock<MockKMSFramebuffer>>());
+    sink.post();
+
+    // In clone mode the flips are only waited for before the next frame is posted
+    std::optional<Presentation> presentation;
+    EXPECT_TRUE(sink.when_presented([&](auto const& shown) { presentation = shown; }));
+    EXPECT_FALSE(presentation);
+
+    sink.set_next_image(std::make_unique<NiceMock<MockKMSFramebuffer>>());
+    sink.post();
+
+    ASSERT_TRUE(presentation);
+    EXPECT_EQ(last_flip.msc, presentation->frame.msc);
+    EXPECT_EQ(last_flip.ust, presentation->frame.ust);
+    // The refreshes that follow on from that timestamp are those of the output that flipped last
+    EXPECT_EQ(std::chrono::nanoseconds{1s} / mock_refresh_rate, presentation->refresh_interval);
+    EXPECT_TRUE(presentation->from_hardware);
+}
+
+TEST_F(MesaDisplaySinkTest, frames_shown_without_a_page_flip_have_no_presentation)
+{
+    ON_CALL(*mock_kms_output, schedule_page_flip_thunk(_))
+        .WillByDefault(Return(false));
+
+    graphics::gbm::DisplaySink sink(
+        drm_fd,
+        gbm,
+        graphics::gbm::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output},
+        display_area,
+        identity);
+
+    sink.set_next_image(std::make_unique<NiceMock<MockKMSFramebuffer>>());
+    sink.post();
+
+    EXPECT_FALSE(sink.when_presented([](auto const&) { FAIL() << "No flip to say when this was shown"; }));
+}
+
 TEST_F(MesaDisplaySinkTest, untransformed_with_bypassable_list_can_bypass)
 {
     graphics::gbm::DisplaySink sink(
@@ -233,6 +460,45 @@ TEST_F(MesaDisplaySinkTest, untransformed_with_bypassable_list_can_bypass)
     EXPECT_TRUE(sink.overlay(bypassable_list));
 }
 
+TEST_F(MesaDisplaySinkTest, bypass_can_be_prohibited)
+{
+    graphics::gbm::DisplaySink sink(
+        drm_fd,
+        gbm,
+        graphics::gbm::BypassOption::prohibited,
+        null_display_report(),
+        {mock_kms_output},
+        display_area,
+        identity);
+
+    EXPECT_FALSE(sink.overlay(bypassable_list));
+}
+
+TEST_F(MesaDisplaySinkTest, prohibiting_bypass_also_prohibits_overlay_planes)
+{
+    graphics::gbm::DisplaySink sink(
+        drm_fd,
+        gbm,
+        graphics::gbm::BypassOption::prohibited,
+        null_display_report(),
+        {mock_kms_output},
+        display_area,
+        identity);
+
+    // Get a frame on screen that layers could otherwise go above
+    sink.set_next_image(std::make_unique<NiceMock<MockKMSFramebuffer>>());
+    sink.post();
+
+    EXPECT_CALL(*mock_kms_output, fit_layers_thunk(_, _))
+        .Times(0);
+
+    std::vector<mir::graphics::DisplayElement> const topmost{
+        {{{20, 40}, {10, 10}}, {{0, 0}, {10, 10}}, std::make_shared<NiceMock<MockKMSFramebuffer>>()}};
+
+    EXPECT_FALSE(sink.can_overlay());
+    EXPECT_THAT(sink.overlay_topmost(topmost), Eq(0u));
+}
+
 namespace
 {
 template<typename T>
@@ -258,3 +524,170 @@ TEST_F(MesaDisplaySinkTest, transformation_not_implemented_internally)
     EXPECT_EQ(rotate_left, sink.transformation());
 }
 
+
+TEST_F(MesaDisplaySinkTest, elements_above_a_bypassable_element_are_shown_on_overlay_planes)
+{
+    auto const window_framebuffer = std::make_shared<NiceMock<MockKMSFramebuffer>>();
+    auto list = bypassable_list;
+    list.push_back({{{20, 40}, {10, 10}}, {{0, 0}, {10, 10}}, window_framebuffer});
+
+    graphics::gbm::DisplaySink sink(
+        drm_fd,
+        gbm,
+        graphics::gbm::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output},
+        display_area,
+        identity);
+
+    auto const bypass_fb = dynamic_cast<FBHandle const*>(bypass_framebuffer.get());
+    auto const on_output = ElementsAre(
+        Field(&PlaneLayer::destination, Eq(geometry::Rectangle{{8, 6}, {10, 10}})));
+
+    EXPECT_CALL(*mock_kms_output, fit_layers_thunk(bypass_fb, on_output))
+        .WillOnce(Return(1));
+    EXPECT_CALL(*mock_kms_output, schedule_layered_page_flip_thunk(bypass_fb, on_output))
+        .WillOnce(Return(true));
+
+    EXPECT_TRUE(sink.overlay(list));
+    sink.post();
+}
+
+TEST_F(MesaDisplaySinkTest, elements_that_do_not_all_fit_on_overlay_planes_are_not_overlaid)
+{
+    auto list = bypassable_list;
+    list.push_back({{{20, 40}, {10, 10}}, {{0, 0}, {10, 10}}, std::make_shared<NiceMock<MockKMSFramebuffer>>()});
+    list.push_back({{{30, 50}, {10, 10}}, {{0, 0}, {10, 10}}, std::make_shared<NiceMock<MockKMSFramebuffer>>()});
+
+    graphics::gbm::DisplaySink sink(
+        drm_fd,
+        gbm,
+        graphics::gbm::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output},
+        display_area,
+        identity);
+
+    EXPECT_CALL(*mock_kms_output, fit_layers_thunk(_, SizeIs(2)))
+        .WillOnce(Return(1));
+
+    EXPECT_FALSE(sink.overlay(list));
+}
+
+TEST_F(MesaDisplaySinkTest, topmost_elements_are_shown_above_the_composited_frame)
+{
+    auto const lower_framebuffer = std::make_shared<NiceMock<MockKMSFramebuffer>>();
+    auto const upper_framebuffer = std::make_shared<NiceMock<MockKMSFramebuffer>>();
+    std::vector<mir::graphics::DisplayElement> const topmost{
+        {{{20, 40}, {10, 10}}, {{0, 0}, {10, 10}}, lower_framebuffer},
+        {{{30, 50}, {10, 10}}, {{0, 0}, {10, 10}}, upper_framebuffer}};
+
+    graphics::gbm::DisplaySink sink(
+        drm_fd,
+        gbm,
+        graphics::gbm::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output},
+        display_area,
+        identity);
+
+    auto const bypass_fb = dynamic_cast<FBHandle const*>(bypass_framebuffer.get());
+
+    // Get a frame on screen to check the layers against
+    ASSERT_TRUE(sink.overlay(bypassable_list));
+    sink.post();
+
+    EXPECT_CALL(*mock_kms_output, fit_layers_thunk(bypass_fb, SizeIs(2)))
+        .WillOnce(Return(1));
+    EXPECT_CALL(
+        *mock_kms_output,
+        schedule_layered_page_flip_thunk(_, ElementsAre(Field(&PlaneLayer::fb, Eq(upper_framebuffer)))))
+        .WillOnce(Return(true));
+
+    EXPECT_THAT(sink.overlay_topmost(topmost), Eq(1u));
+    sink.set_next_image(std::make_unique<NiceMock<MockKMSFramebuffer>>());
+    sink.post();
+}
+
+TEST_F(MesaDisplaySinkTest, transformed_sink_does_not_use_overlay_planes)
+{
+    auto list = bypassable_list;
+    list.push_back({{{20, 40}, {10, 10}}, {{0, 0}, {10, 10}}, std::make_shared<NiceMock<MockKMSFramebuffer>>()});
+
+    graphics::gbm::DisplaySink sink(
+        drm_fd,
+        gbm,
+        graphics::gbm::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output},
+        display_area,
+        transformation(mir_orientation_left));
+
+    EXPECT_CALL(*mock_kms_output, fit_layers_thunk(_, _))
+        .Times(0);
+
+    EXPECT_FALSE(sink.overlay(list));
+    EXPECT_THAT(sink.overlay_topmost(list), Eq(0u));
+}
+
+TEST_F(MesaDisplaySinkTest, translucent_elements_are_not_shown_on_overlay_planes)
+{
+    auto list = bypassable_list;
+    list.push_back({{{20, 40}, {10, 10}}, {{0, 0}, {10, 10}}, std::make_shared<NiceMock<MockKMSFramebuffer>>(), 0.5f});
+
+    graphics::gbm::DisplaySink sink(
+        drm_fd,
+        gbm,
+        graphics::gbm::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output},
+        display_area,
+        identity);
+
+    // Get a frame on screen to check the layers against
+    ASSERT_TRUE(sink.overlay(bypassable_list));
+    sink.post();
+
+    EXPECT_CALL(*mock_kms_output, fit_layers_thunk(_, IsEmpty()))
+        .Times(AnyNumber())
+        .WillRepeatedly(Return(0));
+    EXPECT_CALL(*mock_kms_output, fit_layers_thunk(_, Not(IsEmpty())))
+        .Times(0);
+
+    EXPECT_FALSE(sink.overlay(list));
+    EXPECT_THAT(sink.overlay_topmost(list), Eq(0u));
+}
+
+TEST_F(MesaDisplaySinkTest, transformed_elements_are_not_bypassed)
+{
+    auto list = bypassable_list;
+    list.front().transformation = glm::mat4{transformation(mir_orientation_inverted)};
+
+    graphics::gbm::DisplaySink sink(
+        drm_fd,
+        gbm,
+        graphics::gbm::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output},
+        display_area,
+        identity);
+
+    EXPECT_FALSE(sink.overlay(list));
+}
+
+TEST_F(MesaDisplaySinkTest, client_buffers_are_not_bypassed_onto_a_transformed_sink)
+{
+    graphics::gbm::DisplaySink sink(
+        drm_fd,
+        gbm,
+        graphics::gbm::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output},
+        display_area,
+        transformation(mir_orientation_left));
+
+    EXPECT_FALSE(sink.overlay(bypassable_list));
+
+    // ...but frames we render for it are still shown
+    EXPECT_NO_THROW(sink.set_next_image(std::make_unique<NiceMock<MockKMSFramebuffer>>()));
+}
@@ -0,0 +1,201 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/platforms/gbm-kms/server/dmabuf_display_allocator.h"
+#include "src/platforms/common/server/kms_framebuffer.h"
+#include "mir/graphics/dmabuf_buffer.h"
+#include "mir/graphics/drm_formats.h"
+
+#include "mir/test/doubles/mock_buffer.h"
+#include "mir/test/doubles/mock_drm.h"
+#include "mir/test/doubles/mock_gbm.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <drm_fourcc.h>
+#include <fcntl.h>
+#include <gbm.h>
+
+namespace mg = mir::graphics;
+namespace mgg = mir::graphics::gbm;
+namespace geom = mir::geometry;
+namespace mtd = mir::test::doubles;
+
+using namespace testing;
+
+namespace
+{
+class MockClientBuffer : public mg::DMABufBuffer, public mg::DirectScanoutBuffer
+{
+public:
+    MOCK_METHOD(mg::DRMFormat, format, (), (const override));
+    MOCK_METHOD(std::optional<uint64_t>, modifier, (), (const override));
+    MOCK_METHOD(std::vector<PlaneDescriptor> const&, planes, (), (const override));
+    MOCK_METHOD(mg::gl::Texture::Layout, layout, (), (const override));
+    MOCK_METHOD(geom::Size, size, (), (const override));
+    MOCK_METHOD(bool, ready_for_scanout, (), (const override));
+    MOCK_METHOD(void, claim_for_scanout, (), (override));
+};
+
+class DmaBufDisplayAllocator : public Test
+{
+public:
+    DmaBufDisplayAllocator()
+    {
+        planes.push_back({mir::Fd{open("/dev/null", O_RDONLY | O_CLOEXEC)}, 256, 0});
+
+        ON_CALL(client_buffer, format()).WillByDefault(Return(mg::DRMFormat{DRM_FORMAT_ARGB8888}));
+        ON_CALL(client_buffer, modifier()).WillByDefault(Return(DRM_FORMAT_MOD_LINEAR));
+        ON_CALL(client_buffer, planes()).WillByDefault(ReturnRef(planes));
+        ON_CALL(client_buffer, size()).WillByDefault(Return(size));
+        ON_CALL(client_buffer, ready_for_scanout()).WillByDefault(Return(true));
+        ON_CALL(*buffer, native_buffer_base()).WillByDefault(Return(&client_buffer));
+
+        ON_CALL(mock_gbm, gbm_bo_import(_, GBM_BO_IMPORT_FD_MODIFIER, _, _))
+            .WillByDefault(Return(mock_gbm.fake_gbm.bo));
+        ON_CALL(mock_drm, drmModeAddFB2WithModifiers(_, _, _, _, _, _, _, _, _, _))
+            .WillByDefault(DoAll(SetArgPointee<8>(fb_id), Return(0)));
+    }
+
+    NiceMock<mtd::MockDRM> mock_drm;
+    NiceMock<mtd::MockGBM> mock_gbm;
+    mir::Fd const drm_fd{open("/dev/dri/card0", 0, 0)};
+    geom::Size const size{64, 48};
+    uint32_t const fb_id{77};
+    std::vector<mg::DMABufBuffer::PlaneDescriptor> planes;
+    NiceMock<MockClientBuffer> client_buffer;
+    std::shared_ptr<mtd::MockBuffer> buffer{std::make_shared<NiceMock<mtd::MockBuffer>>()};
+    mgg::DmaBufDisplayAllocator allocator{drm_fd, std::shared_ptr<gbm_device>{mock_gbm.fake_gbm.device, [](auto){}}};
+};
+}
+
+TEST_F(DmaBufDisplayAllocator, imports_a_client_buffer_as_a_kms_framebuffer)
+{
+    EXPECT_CALL(mock_drm, drmModeAddFB2WithModifiers(_, size.width.as_uint32_t(), size.height.as_uint32_t(),
+                                                     DRM_FORMAT_ARGB8888, _, _, _, _, _, DRM_MODE_FB_MODIFIERS));
+
+    auto const fb = allocator.framebuffer_for(buffer);
+
+    ASSERT_THAT(fb, NotNull());
+    auto const handle = dynamic_cast<mg::FBHandle*>(fb.get());
+    ASSERT_THAT(handle, NotNull());
+    EXPECT_THAT(static_cast<uint32_t>(*handle), Eq(fb_id));
+}
+
+TEST_F(DmaBufDisplayAllocator, imports_each_client_buffer_only_once)
+{
+    EXPECT_CALL(mock_gbm, gbm_bo_import(_, _, _, _))
+        .Times(1);
+    EXPECT_CALL(mock_drm, drmModeAddFB2WithModifiers(_, _, _, _, _, _, _, _, _, _))
+        .Times(1);
+
+    EXPECT_THAT(allocator.framebuffer_for(buffer), NotNull());
+    EXPECT_THAT(allocator.framebuffer_for(buffer), NotNull());
+}
+
+TEST_F(DmaBufDisplayAllocator, buffers_of_the_same_dmabuf_share_an_import)
+{
+    // Clients get a new Buffer each time they commit the same wl_buffer
+    auto const next_buffer = std::make_shared<NiceMock<mtd::MockBuffer>>();
+    ON_CALL(*next_buffer, native_buffer_base()).WillByDefault(Return(&client_buffer));
+
+    EXPECT_CALL(mock_gbm, gbm_bo_import(_, _, _, _))
+        .Times(1);
+
+    EXPECT_THAT(allocator.framebuffer_for(buffer), NotNull());
+    EXPECT_THAT(allocator.framebuffer_for(next_buffer), NotNull());
+}
+
+TEST_F(DmaBufDisplayAllocator, import_is_released_once_its_buffer_and_framebuffers_are_gone)
+{
+    auto fb = allocator.framebuffer_for(buffer);
+    ASSERT_THAT(fb, NotNull());
+
+    std::vector<mg::DMABufBuffer::PlaneDescriptor> other_planes;
+    other_planes.push_back({mir::Fd{open("/dev/zero", O_RDONLY | O_CLOEXEC)}, 256, 0});
+    NiceMock<MockClientBuffer> other_client_buffer;
+    ON_CALL(other_client_buffer, format()).WillByDefault(Return(mg::DRMFormat{DRM_FORMAT_ARGB8888}));
+    ON_CALL(other_client_buffer, modifier()).WillByDefault(Return(DRM_FORMAT_MOD_LINEAR));
+    ON_CALL(other_client_buffer, planes()).WillByDefault(ReturnRef(other_planes));
+    ON_CALL(other_client_buffer, size()).WillByDefault(Return(size));
+    auto const other_buffer = std::make_shared<NiceMock<mtd::MockBuffer>>();
+    ON_CALL(*other_buffer, native_buffer_base()).WillByDefault(Return(&other_client_buffer));
+    ON_CALL(mock_drm, drmModeAddFB2WithModifiers(_, _, _, _, _, _, _, _, _, _))
+        .WillByDefault(DoAll(SetArgPointee<8>(fb_id + 1), Return(0)));
+
+    // The allocator notices the buffer has gone when next it imports something...
+    EXPECT_CALL(mock_drm, drmModeRmFB(_, fb_id))
+        .Times(0);
+    buffer.reset();
+    auto const other_fb = allocator.framebuffer_for(other_buffer);
+    Mock::VerifyAndClearExpectations(&mock_drm);
+
+    // ...but the framebuffer still on the display keeps the import alive
+    EXPECT_CALL(mock_drm, drmModeRmFB(_, fb_id));
+    EXPECT_CALL(mock_gbm, gbm_bo_destroy(mock_gbm.fake_gbm.bo));
+    fb.reset();
+    Mock::VerifyAndClearExpectations(&mock_drm);
+    Mock::VerifyAndClearExpectations(&mock_gbm);
+}
+
+TEST_F(DmaBufDisplayAllocator, buffers_that_are_not_dmabufs_are_not_imported)
+{
+    ON_CALL(*buffer, native_buffer_base()).WillByDefault(Return(nullptr));
+
+    EXPECT_CALL(mock_gbm, gbm_bo_import(_, _, _, _))
+        .Times(0);
+
+    EXPECT_THAT(allocator.framebuffer_for(buffer), IsNull());
+}
+
+TEST_F(DmaBufDisplayAllocator, buffers_kms_rejects_are_not_shown)
+{
+    ON_CALL(mock_drm, drmModeAddFB2WithModifiers(_, _, _, _, _, _, _, _, _, _))
+        .WillByDefault(Return(-EINVAL));
+
+    EXPECT_CALL(mock_gbm, gbm_bo_destroy(mock_gbm.fake_gbm.bo));
+
+    EXPECT_THAT(allocator.framebuffer_for(buffer), IsNull());
+}
+
+TEST_F(DmaBufDisplayAllocator, buffers_kms_rejects_are_not_imported_again)
+{
+    ON_CALL(mock_drm, drmModeAddFB2WithModifiers(_, _, _, _, _, _, _, _, _, _))
+        .WillByDefault(Return(-EINVAL));
+
+    EXPECT_CALL(mock_gbm, gbm_bo_import(_, _, _, _))
+        .Times(1);
+
+    EXPECT_THAT(allocator.framebuffer_for(buffer), IsNull());
+    EXPECT_THAT(allocator.framebuffer_for(buffer), IsNull());
+}
+
+TEST_F(DmaBufDisplayAllocator, buffers_whose_content_is_not_ready_are_not_shown)
+{
+    ON_CALL(client_buffer, ready_for_scanout()).WillByDefault(Return(false));
+
+    EXPECT_THAT(allocator.framebuffer_for(buffer), IsNull());
+}
+
+TEST_F(DmaBufDisplayAllocator, buffers_are_not_claimed_just_for_being_imported)
+{
+    // Only the compositor knows whether the display will actually show the buffer
+    EXPECT_CALL(client_buffer, claim_for_scanout())
+        .Times(0);
+
+    EXPECT_THAT(allocator.framebuffer_for(buffer), NotNull());
+}
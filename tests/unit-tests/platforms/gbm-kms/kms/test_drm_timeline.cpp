@@ -0,0 +1,204 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/graphics/drm_syncobj.h"
+
+#include "mir/test/doubles/mock_drm.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <xf86drm.h>
+#include <sys/eventfd.h>
+#include <system_error>
+
+namespace mg = mir::graphics;
+namespace mtd = mir::test::doubles;
+
+using namespace testing;
+
+namespace
+{
+struct DRMTimeline : Test
+{
+    DRMTimeline()
+    {
+        ON_CALL(mock_drm, drmSyncobjFDToHandle(drm_fd, syncobj_fd, _))
+            .WillByDefault(DoAll(SetArgPointee<2>(timeline_handle), Return(0)));
+        ON_CALL(mock_drm, drmSyncobjCreate(drm_fd, _, _))
+            .WillByDefault(DoAll(SetArgPointee<2>(binary_handle), Return(0)));
+    }
+
+    auto timeline() -> mg::DRMTimeline
+    {
+        return {mir::Fd{mir::IntOwnedFd{drm_fd}}, mir::Fd{mir::IntOwnedFd{syncobj_fd}}};
+    }
+
+    static auto fence() -> mir::Fd
+    {
+        return mir::Fd{eventfd(0, EFD_CLOEXEC)};
+    }
+
+    int const drm_fd{42};
+    int const syncobj_fd{43};
+    uint32_t const timeline_handle{7};
+    uint32_t const binary_handle{9};
+    uint64_t const point{5};
+    NiceMock<mtd::MockDRM> mock_drm;
+};
+}
+
+TEST_F(DRMTimeline, importing_something_other_than_a_syncobj_throws)
+{
+    ON_CALL(mock_drm, drmSyncobjFDToHandle(drm_fd, syncobj_fd, _))
+        .WillByDefault(SetErrnoAndReturn(EINVAL, -1));
+
+    EXPECT_THROW(timeline(), std::system_error);
+}
+
+TEST_F(DRMTimeline, destroys_its_handle)
+{
+    {
+        auto const timeline = this->timeline();
+        EXPECT_CALL(mock_drm, drmSyncobjDestroy(drm_fd, timeline_handle));
+    }
+}
+
+TEST_F(DRMTimeline, has_fence_for_checks_the_point_without_waiting)
+{
+    auto const timeline = this->timeline();
+
+    EXPECT_CALL(
+        mock_drm,
+        drmSyncobjTimelineWait(
+            drm_fd, Pointee(timeline_handle), Pointee(point), 1, 0, DRM_SYNCOBJ_WAIT_FLAGS_WAIT_AVAILABLE, _))
+        .WillOnce(Return(0))
+        .WillOnce(SetErrnoAndReturn(ETIME, -1));
+
+    EXPECT_TRUE(timeline.has_fence_for(point));
+    EXPECT_FALSE(timeline.has_fence_for(point));
+}
+
+TEST_F(DRMTimeline, eventfd_for_fence_asks_for_the_eventfd_to_be_signalled_once_the_point_has_a_fence)
+{
+    auto const timeline = this->timeline();
+
+    EXPECT_CALL(mock_drm, drmSyncobjEventfd(drm_fd, timeline_handle, point, _, DRM_SYNCOBJ_WAIT_FLAGS_WAIT_AVAILABLE));
+
+    EXPECT_THAT(timeline.eventfd_for_fence(point), Ne(mir::Fd::invalid));
+}
+
+TEST_F(DRMTimeline, eventfd_for_fence_throws_if_the_point_cannot_be_watched)
+{
+    auto const timeline = this->timeline();
+
+    ON_CALL(mock_drm, drmSyncobjEventfd(_, _, _, _, _))
+        .WillByDefault(SetErrnoAndReturn(EINVAL, -1));
+
+    EXPECT_THROW(timeline.eventfd_for_fence(point), std::system_error);
+}
+
+TEST_F(DRMTimeline, sync_file_for_exports_the_fence_of_the_point)
+{
+    auto const timeline = this->timeline();
+    auto const exported = eventfd(0, EFD_CLOEXEC);
+
+    InSequence seq;
+    EXPECT_CALL(
+        mock_drm,
+        drmSyncobjTimelineWait(
+            drm_fd, Pointee(timeline_handle), Pointee(point), 1, 0, DRM_SYNCOBJ_WAIT_FLAGS_WAIT_AVAILABLE, _));
+    EXPECT_CALL(mock_drm, drmSyncobjTransfer(drm_fd, binary_handle, 0, timeline_handle, point, 0));
+    EXPECT_CALL(mock_drm, drmSyncobjExportSyncFile(drm_fd, binary_handle, _))
+        .WillOnce(DoAll(SetArgPointee<2>(exported), Return(0)));
+
+    EXPECT_THAT(timeline.sync_file_for(point), Eq(exported));
+}
+
+TEST_F(DRMTimeline, sync_file_for_throws_if_the_point_has_no_fence_yet)
+{
+    auto const timeline = this->timeline();
+
+    ON_CALL(mock_drm, drmSyncobjTimelineWait(_, _, _, _, _, _, _))
+        .WillByDefault(SetErrnoAndReturn(ETIME, -1));
+    EXPECT_CALL(mock_drm, drmSyncobjExportSyncFile(_, _, _)).Times(0);
+
+    EXPECT_THROW(timeline.sync_file_for(point), std::system_error);
+}
+
+TEST_F(DRMTimeline, signal_after_attaches_the_fence_to_the_point)
+{
+    auto timeline = this->timeline();
+    auto const sync_file = fence();
+
+    InSequence seq;
+    EXPECT_CALL(mock_drm, drmSyncobjImportSyncFile(drm_fd, binary_handle, int{sync_file}));
+    EXPECT_CALL(mock_drm, drmSyncobjTransfer(drm_fd, timeline_handle, point, binary_handle, 0, 0));
+
+    timeline.signal_after(point, sync_file);
+}
+
+TEST_F(DRMTimeline, signal_signals_the_point)
+{
+    auto timeline = this->timeline();
+
+    EXPECT_CALL(mock_drm, drmSyncobjTimelineSignal(drm_fd, Pointee(timeline_handle), Pointee(point), 1));
+
+    timeline.signal(point);
+}
+
+TEST_F(DRMTimeline, release_with_a_fence_signals_the_point_once_the_fence_has)
+{
+    auto timeline = this->timeline();
+    auto const sync_file = fence();
+
+    EXPECT_CALL(mock_drm, drmSyncobjImportSyncFile(drm_fd, binary_handle, int{sync_file}));
+    EXPECT_CALL(mock_drm, drmSyncobjTransfer(drm_fd, timeline_handle, point, binary_handle, 0, 0));
+    EXPECT_CALL(mock_drm, drmSyncobjTimelineSignal(_, _, _, _)).Times(0);
+
+    timeline.release(point, sync_file);
+}
+
+TEST_F(DRMTimeline, release_without_a_fence_signals_the_point_now)
+{
+    auto timeline = this->timeline();
+
+    EXPECT_CALL(mock_drm, drmSyncobjTransfer(_, _, _, _, _, _)).Times(0);
+    EXPECT_CALL(mock_drm, drmSyncobjTimelineSignal(drm_fd, Pointee(timeline_handle), Pointee(point), 1));
+
+    timeline.release(point, std::nullopt);
+}
+
+TEST_F(DRMTimeline, release_signals_the_point_now_if_the_fence_cannot_be_attached)
+{
+    auto timeline = this->timeline();
+
+    ON_CALL(mock_drm, drmSyncobjImportSyncFile(_, _, _))
+        .WillByDefault(SetErrnoAndReturn(EINVAL, -1));
+    EXPECT_CALL(mock_drm, drmSyncobjTimelineSignal(drm_fd, Pointee(timeline_handle), Pointee(point), 1));
+
+    timeline.release(point, fence());
+}
+
+TEST_F(DRMTimeline, release_does_not_throw_if_the_point_cannot_be_signalled)
+{
+    auto timeline = this->timeline();
+
+    ON_CALL(mock_drm, drmSyncobjTimelineSignal(_, _, _, _))
+        .WillByDefault(SetErrnoAndReturn(EINVAL, -1));
+
+    EXPECT_NO_THROW(timeline.release(point, std::nullopt));
+}
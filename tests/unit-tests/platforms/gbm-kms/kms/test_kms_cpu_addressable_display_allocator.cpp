@@ -0,0 +1,177 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/platforms/common/server/kms_cpu_addressable_display_provider.h"
+#include "src/platforms/common/server/kms_framebuffer.h"
+
+#include "mir/test/doubles/mock_drm.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <drm_fourcc.h>
+#include <fcntl.h>
+
+namespace mg = mir::graphics;
+namespace geom = mir::geometry;
+namespace mtd = mir::test::doubles;
+
+using namespace testing;
+
+namespace
+{
+class KMSCPUAddressableDisplayAllocator : public Test
+{
+public:
+    KMSCPUAddressableDisplayAllocator()
+    {
+        ON_CALL(mock_drm, drmIoctl(_, DRM_IOCTL_MODE_CREATE_DUMB, _))
+            .WillByDefault(
+                [this](auto, auto, void* arg)
+                {
+                    auto const params = static_cast<drm_mode_create_dumb*>(arg);
+                    params->handle = ++next_handle;
+                    params->pitch = params->width * 4;
+                    params->size = params->pitch * params->height;
+                    return 0;
+                });
+        // Tests set expectations on specific ioctls; let the rest through
+        EXPECT_CALL(mock_drm, drmIoctl(_, _, _)).Times(AnyNumber());
+        ON_CALL(mock_drm, drmGetCap(_, DRM_CAP_ADDFB2_MODIFIERS, _))
+            .WillByDefault(
+                [](auto, auto, uint64_t* value)
+                {
+                    *value = 0;
+                    return 0;
+                });
+        ON_CALL(mock_drm, drmModeAddFB2(_, _, _, _, _, _, _, _, _))
+            .WillByDefault(
+                [](auto, auto, auto, auto, uint32_t const handles[4], auto, auto, uint32_t* fb_id, auto)
+                {
+                    *fb_id = handles[0] + 100;
+                    return 0;
+                });
+    }
+
+    auto create_allocator(size_t buffer_count) -> std::shared_ptr<mg::kms::CPUAddressableDisplayAllocator>
+    {
+        return mg::kms::CPUAddressableDisplayAllocator::create_if_supported(drm_fd, size, buffer_count);
+    }
+
+    NiceMock<mtd::MockDRM> mock_drm;
+    mir::Fd const drm_fd{open("/dev/dri/card0", 0, 0)};
+    geom::Size const size{64, 48};
+    mg::DRMFormat const format{DRM_FORMAT_XRGB8888};
+    uint32_t next_handle{0};
+};
+}
+
+TEST_F(KMSCPUAddressableDisplayAllocator, reuses_buffer_once_released)
+{
+    EXPECT_CALL(mock_drm, drmIoctl(_, DRM_IOCTL_MODE_CREATE_DUMB, _)).Times(1);
+    EXPECT_CALL(mock_drm, mmap(_, _, _, _, _, _)).Times(1);
+
+    auto const allocator = create_allocator(2);
+
+    for (auto frame = 0; frame != 5; ++frame)
+    {
+        auto const fb = allocator->alloc_fb(format);
+        auto const mapping = fb->map_writeable();
+        ASSERT_THAT(mapping->data(), NotNull());
+        EXPECT_THAT(mapping->len(), Eq(64u * 4 * 48));
+    }
+}
+
+TEST_F(KMSCPUAddressableDisplayAllocator, buffers_in_flight_are_not_handed_out_again)
+{
+    auto const allocator = create_allocator(3);
+
+    auto const first = allocator->alloc_fb(format);
+    auto const second = allocator->alloc_fb(format);
+    auto const third = allocator->alloc_fb(format);
+
+    auto const fb_id = [](auto const& fb) { return uint32_t(dynamic_cast<mg::FBHandle const&>(*fb)); };
+
+    EXPECT_THAT(first->map_writeable()->data(), Ne(second->map_writeable()->data()));
+    EXPECT_THAT(second->map_writeable()->data(), Ne(third->map_writeable()->data()));
+    EXPECT_THAT(first->map_writeable()->data(), Ne(third->map_writeable()->data()));
+    EXPECT_THAT(first->map_writeable()->data(), Eq(first->map_writeable()->data()));
+    EXPECT_THAT(fb_id(first), Ne(0u));
+}
+
+TEST_F(KMSCPUAddressableDisplayAllocator, falls_back_to_one_off_buffer_when_ring_is_exhausted)
+{
+    auto const allocator = create_allocator(2);
+
+    auto const first = allocator->alloc_fb(format);
+    auto second = allocator->alloc_fb(format);
+
+    EXPECT_CALL(mock_drm, drmIoctl(_, DRM_IOCTL_MODE_CREATE_DUMB, _));
+    EXPECT_CALL(mock_drm, drmIoctl(_, DRM_IOCTL_MODE_DESTROY_DUMB, _));
+    allocator->alloc_fb(format);
+    Mock::VerifyAndClearExpectations(&mock_drm);
+
+    EXPECT_CALL(mock_drm, drmIoctl(_, DRM_IOCTL_MODE_CREATE_DUMB, _)).Times(0);
+    EXPECT_CALL(mock_drm, drmIoctl(_, DRM_IOCTL_MODE_DESTROY_DUMB, _)).Times(0);
+    second.reset();
+    allocator->alloc_fb(format);
+    Mock::VerifyAndClearExpectations(&mock_drm);
+}
+
+TEST_F(KMSCPUAddressableDisplayAllocator, replaces_idle_buffers_of_another_format)
+{
+    auto const allocator = create_allocator(1);
+
+    allocator->alloc_fb(format);
+
+    EXPECT_CALL(mock_drm, drmIoctl(_, DRM_IOCTL_MODE_DESTROY_DUMB, _));
+    EXPECT_CALL(mock_drm, drmIoctl(_, DRM_IOCTL_MODE_CREATE_DUMB, _));
+    auto const argb = allocator->alloc_fb(mg::DRMFormat{DRM_FORMAT_ARGB8888});
+    Mock::VerifyAndClearExpectations(&mock_drm);
+
+    EXPECT_THAT(argb->format(), Eq(mir_pixel_format_argb_8888));
+}
+
+TEST_F(KMSCPUAddressableDisplayAllocator, buffers_can_outlive_allocator)
+{
+    auto allocator = create_allocator(2);
+    auto const fb = allocator->alloc_fb(format);
+
+    EXPECT_CALL(mock_drm, drmIoctl(_, DRM_IOCTL_MODE_DESTROY_DUMB, _)).Times(0);
+    allocator.reset();
+    Mock::VerifyAndClearExpectations(&mock_drm);
+
+    EXPECT_CALL(mock_drm, drmIoctl(_, DRM_IOCTL_MODE_DESTROY_DUMB, _));
+    fb->map_writeable()->data()[0] = 0xff;
+}
+
+TEST_F(KMSCPUAddressableDisplayAllocator, recycled_buffers_report_age_of_content)
+{
+    auto const allocator = create_allocator(3);
+
+    auto first = allocator->alloc_fb(format);
+    auto second = allocator->alloc_fb(format);
+    EXPECT_THAT(first->buffer_age(), Eq(0u));
+    EXPECT_THAT(second->buffer_age(), Eq(0u));
+
+    first.reset();
+    auto const third = allocator->alloc_fb(format);
+    EXPECT_THAT(third->buffer_age(), Eq(2u));
+
+    second.reset();
+    auto const fourth = allocator->alloc_fb(format);
+    EXPECT_THAT(fourth->buffer_age(), Eq(2u));
+}
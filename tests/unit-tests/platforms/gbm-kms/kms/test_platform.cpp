@@ -280,6 +280,18 @@ TEST_F(MesaGraphicsPlatform, display_probe_returns_supported_when_KMS_probe_is_o
         Each(SupportLevelIs(mg::probe::supported)));
 }
 
+TEST_F(MesaGraphicsPlatform, bypass_is_only_used_when_turned_on)
+{
+    mir::SharedLibrary platform_lib{mtf::server_platform("graphics-gbm-kms")};
+    boost::program_options::options_description po;
+
+    auto add_options = platform_lib.load_function<mg::AddPlatformOptions>(add_platform_options_symbol);
+    add_options(po);
+
+    EXPECT_FALSE(parsed_options_from_args({}, po)->get<bool>("bypass"));
+    EXPECT_TRUE(parsed_options_from_args({"--bypass=true"}, po)->get<bool>("bypass"));
+}
+
 TEST_F(MesaGraphicsPlatform, display_probe_does_not_touch_quirked_device)
 {
     using namespace testing;
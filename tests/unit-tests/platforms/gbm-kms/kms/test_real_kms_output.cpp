@@ -45,6 +45,7 @@ class NullPageFlipper : public mgg::PageFlipper
 {
 public:
     bool schedule_flip(uint32_t,uint32_t,uint32_t) override { return true; }
+    bool schedule_atomic_flip(uint32_t,drmModeAtomicReq*,uint32_t) override { return true; }
     mg::Frame wait_for_flip(uint32_t) override { return {}; }
 };
 
@@ -52,6 +53,7 @@ class MockPageFlipper : public mgg::PageFlipper
 {
 public:
     MOCK_METHOD3(schedule_flip, bool(uint32_t,uint32_t,uint32_t));
+    MOCK_METHOD3(schedule_atomic_flip, bool(uint32_t,drmModeAtomicReq*,uint32_t));
     MOCK_METHOD1(wait_for_flip, mg::Frame(uint32_t));
 };
 
@@ -168,6 +170,56 @@ public:
         mock_drm.prepare(drm_device);
     }
 
+    void setup_outputs_with_planes(std::optional<uint64_t> second_overlay_zpos = 0)
+    {
+        uint32_t const possible_crtcs_mask{0x1};
+
+        mock_drm.reset(drm_device);
+
+        mock_drm.add_crtc(
+            drm_device,
+            crtc_ids[0],
+            modes[0]);
+        mock_drm.add_encoder(
+            drm_device,
+            encoder_ids[0],
+            crtc_ids[0],
+            possible_crtcs_mask);
+        mock_drm.add_connector(
+            drm_device,
+            connector_ids[0],
+            DRM_MODE_CONNECTOR_DVID,
+            DRM_MODE_CONNECTED,
+            encoder_ids[0],
+            modes,
+            possible_encoder_ids1,
+            geom::Size());
+        mock_drm.add_plane(drm_device, primary_plane_id, possible_crtcs_mask, DRM_PLANE_TYPE_PRIMARY);
+        mock_drm.add_plane(drm_device, overlay_plane_ids[0], possible_crtcs_mask, DRM_PLANE_TYPE_OVERLAY);
+        mock_drm.add_plane(
+            drm_device,
+            overlay_plane_ids[1],
+            possible_crtcs_mask,
+            DRM_PLANE_TYPE_OVERLAY,
+            second_overlay_zpos);
+        mock_drm.add_plane(drm_device, cursor_plane_id, possible_crtcs_mask, DRM_PLANE_TYPE_CURSOR);
+
+        mock_drm.prepare(drm_device);
+    }
+
+    auto layers(int count) -> std::vector<mgg::PlaneLayer>
+    {
+        std::vector<mgg::PlaneLayer> result;
+        for (int i = 0; i != count; ++i)
+        {
+            result.push_back({
+                std::make_shared<MockKMSFramebuffer>(100 + i),
+                {{0, 0}, {64, 64}},
+                {{10 * i, 10 * i}, {64, 64}}});
+        }
+        return result;
+    }
+
     void append_fb_id(uint32_t fb_id)
     {
         EXPECT_CALL(mock_drm, drmModeAddFB2(_,_,_,_,_,_,_,_,_))
@@ -182,6 +234,11 @@ public:
     MockPageFlipper mock_page_flipper;
     NullPageFlipper null_page_flipper;
     std::vector<drmModeModeInfo> modes_empty;
+    std::vector<drmModeModeInfo> modes{
+        mtd::FakeDRMResources::create_mode(1920, 1080, 138500, 2080, 1111, mtd::FakeDRMResources::PreferredMode)};
+    uint32_t const primary_plane_id{40};
+    std::vector<uint32_t> const overlay_plane_ids{41, 42};
+    uint32_t const cursor_plane_id{43};
 
     char const* const drm_device = "/dev/dri/card0";
     int const drm_fd;
@@ -228,7 +285,8 @@ TEST_F(RealKMSOutputTest, operations_use_existing_crtc)
     mgg::RealKMSOutput output{
         drm_fd,
         mg::kms::get_connector(drm_fd, connector_ids[0]),
-        mt::fake_shared(mock_page_flipper)};
+        mt::fake_shared(mock_page_flipper),
+        true};
 
     EXPECT_TRUE(output.set_crtc(*fb));
     EXPECT_TRUE(output.schedule_page_flip(*fb));
@@ -267,7 +325,8 @@ TEST_F(RealKMSOutputTest, operations_use_possible_crtc)
     mgg::RealKMSOutput output{
         drm_fd,
         mg::kms::get_connector(drm_fd, connector_ids[0]),
-        mt::fake_shared(mock_page_flipper)};
+        mt::fake_shared(mock_page_flipper),
+        true};
 
     EXPECT_TRUE(output.set_crtc(*fb));
     EXPECT_TRUE(output.schedule_page_flip(*fb));
@@ -304,7 +363,8 @@ TEST_F(RealKMSOutputTest, set_crtc_failure_is_handled_gracefully)
     mgg::RealKMSOutput output{
         drm_fd,
         mg::kms::get_connector(drm_fd, connector_ids[0]),
-        mt::fake_shared(mock_page_flipper)};
+        mt::fake_shared(mock_page_flipper),
+        true};
 
     EXPECT_FALSE(output.set_crtc(*fb));
 
@@ -325,7 +385,8 @@ TEST_F(RealKMSOutputTest, clear_crtc_gets_crtc_if_none_is_current)
     mgg::RealKMSOutput output{
         drm_fd,
         mg::kms::get_connector(drm_fd, connector_ids[0]),
-        mt::fake_shared(mock_page_flipper)};
+        mt::fake_shared(mock_page_flipper),
+        true};
 
     EXPECT_CALL(mock_drm, drmModeSetCrtc(_, crtc_ids[0], 0, 0, 0, nullptr, 0, nullptr))
         .Times(1)
@@ -362,7 +423,8 @@ TEST_F(RealKMSOutputTest, clear_crtc_does_not_throw_if_no_crtc_is_found)
     mgg::RealKMSOutput output{
         drm_fd,
         mg::kms::get_connector(drm_fd, connector_ids[0]),
-        mt::fake_shared(mock_page_flipper)};
+        mt::fake_shared(mock_page_flipper),
+        true};
 
     EXPECT_CALL(mock_drm, drmModeSetCrtc(_, _, 0, 0, 0, nullptr, 0, nullptr))
         .Times(0);
@@ -383,7 +445,8 @@ TEST_F(RealKMSOutputTest, cursor_move_permission_failure_is_non_fatal)
     mgg::RealKMSOutput output{
         drm_fd,
         mg::kms::get_connector(drm_fd, connector_ids[0]),
-        mt::fake_shared(mock_page_flipper)};
+        mt::fake_shared(mock_page_flipper),
+        true};
 
     auto const fb = std::make_shared<MockKMSFramebuffer>(4);
 
@@ -411,7 +474,8 @@ TEST_F(RealKMSOutputTest, cursor_set_permission_failure_is_non_fatal)
     mgg::RealKMSOutput output{
         drm_fd,
         mg::kms::get_connector(drm_fd, connector_ids[0]),
-        mt::fake_shared(mock_page_flipper)};
+        mt::fake_shared(mock_page_flipper),
+        true};
 
     auto const fb = std::make_shared<MockKMSFramebuffer>(0x42);
 
@@ -440,7 +504,8 @@ TEST_F(RealKMSOutputTest, has_no_cursor_if_no_hardware_support)
     mgg::RealKMSOutput output{
         drm_fd,
         mg::kms::get_connector(drm_fd, connector_ids[0]),
-        mt::fake_shared(mock_page_flipper)};
+        mt::fake_shared(mock_page_flipper),
+        true};
 
     auto const fb = std::make_shared<MockKMSFramebuffer>(42);
 
@@ -461,7 +526,8 @@ TEST_F(RealKMSOutputTest, clear_crtc_is_non_fatal_on_permission_error)
     mgg::RealKMSOutput output{
         drm_fd,
         mg::kms::get_connector(drm_fd, connector_ids[0]),
-        mt::fake_shared(mock_page_flipper)};
+        mt::fake_shared(mock_page_flipper),
+        true};
 
     EXPECT_CALL(mock_drm, drmModeSetCrtc(_, crtc_ids[0], 0, 0, 0, nullptr, 0, nullptr))
         .Times(2)
@@ -487,7 +553,8 @@ TEST_F(RealKMSOutputTest, clear_crtc_throws_if_drm_call_fails_for_non_permission
     mgg::RealKMSOutput output{
         drm_fd,
         mg::kms::get_connector(drm_fd, connector_ids[0]),
-        mt::fake_shared(mock_page_flipper)};
+        mt::fake_shared(mock_page_flipper),
+        true};
 
     EXPECT_CALL(mock_drm, drmModeSetCrtc(_, crtc_ids[0], 0, 0, 0, nullptr, 0, nullptr))
         .Times(1)
@@ -509,7 +576,8 @@ TEST_F(RealKMSOutputTest, drm_set_gamma)
     mgg::RealKMSOutput output{
         drm_fd,
         mg::kms::get_connector(drm_fd, connector_ids[0]),
-        mt::fake_shared(mock_page_flipper)};
+        mt::fake_shared(mock_page_flipper),
+        true};
 
     mg::GammaCurves gamma{{1}, {2}, {3}};
 
@@ -538,7 +606,8 @@ TEST_F(RealKMSOutputTest, drm_set_gamma_failure_does_not_throw)
     mgg::RealKMSOutput output{
         drm_fd,
         mg::kms::get_connector(drm_fd, connector_ids[0]),
-        mt::fake_shared(mock_page_flipper)};
+        mt::fake_shared(mock_page_flipper),
+        true};
 
     mg::GammaCurves gamma{{1}, {2}, {3}};
 
@@ -555,3 +624,111 @@ TEST_F(RealKMSOutputTest, drm_set_gamma_failure_does_not_throw)
 
     EXPECT_NO_THROW(output.set_gamma(gamma););
 }
+
+TEST_F(RealKMSOutputTest, fits_as_many_layers_as_there_are_overlay_planes)
+{
+    setup_outputs_with_planes();
+
+    EXPECT_CALL(mock_drm, drmModeAtomicCommit(_, NotNull(), DRM_MODE_ATOMIC_TEST_ONLY, _))
+        .WillOnce(Return(0));
+
+    mgg::RealKMSOutput output{
+        drm_fd,
+        mg::kms::get_connector(drm_fd, connector_ids[0]),
+        mt::fake_shared(null_page_flipper),
+        true};
+
+    MockKMSFramebuffer const fb{42};
+    ASSERT_TRUE(output.set_crtc(fb));
+
+    EXPECT_THAT(output.fit_layers(fb, layers(3)), Eq(overlay_plane_ids.size()));
+}
+
+TEST_F(RealKMSOutputTest, layers_the_driver_rejects_are_not_fitted)
+{
+    setup_outputs_with_planes();
+
+    EXPECT_CALL(mock_drm, drmModeAtomicCommit(_, _, DRM_MODE_ATOMIC_TEST_ONLY, _))
+        .WillOnce(Return(-EINVAL))
+        .WillOnce(Return(0));
+
+    mgg::RealKMSOutput output{
+        drm_fd,
+        mg::kms::get_connector(drm_fd, connector_ids[0]),
+        mt::fake_shared(null_page_flipper),
+        true};
+
+    MockKMSFramebuffer const fb{42};
+    ASSERT_TRUE(output.set_crtc(fb));
+
+    EXPECT_THAT(output.fit_layers(fb, layers(2)), Eq(1u));
+}
+
+TEST_F(RealKMSOutputTest, fits_no_layers_without_atomic_modesetting)
+{
+    setup_outputs_with_planes();
+
+    EXPECT_CALL(mock_drm, drmModeAtomicCommit(_, _, _, _))
+        .Times(0);
+
+    mgg::RealKMSOutput output{
+        drm_fd,
+        mg::kms::get_connector(drm_fd, connector_ids[0]),
+        mt::fake_shared(null_page_flipper),
+        false};
+
+    MockKMSFramebuffer const fb{42};
+    ASSERT_TRUE(output.set_crtc(fb));
+
+    EXPECT_THAT(output.fit_layers(fb, layers(2)), Eq(0u));
+}
+
+TEST_F(RealKMSOutputTest, overlay_planes_that_do_not_say_where_they_stack_are_not_used)
+{
+    setup_outputs_with_planes(std::nullopt);
+
+    mgg::RealKMSOutput output{
+        drm_fd,
+        mg::kms::get_connector(drm_fd, connector_ids[0]),
+        mt::fake_shared(null_page_flipper),
+        true};
+
+    MockKMSFramebuffer const fb{42};
+    ASSERT_TRUE(output.set_crtc(fb));
+
+    EXPECT_THAT(output.fit_layers(fb, layers(2)), Eq(1u));
+}
+
+TEST_F(RealKMSOutputTest, page_flips_clear_overlay_planes_after_showing_layers)
+{
+    setup_outputs_with_planes();
+
+    {
+        InSequence s;
+
+        EXPECT_CALL(mock_page_flipper, schedule_atomic_flip(crtc_ids[0], NotNull(), connector_ids[0]))
+            .WillOnce(Return(true));
+        EXPECT_CALL(mock_page_flipper, schedule_atomic_flip(crtc_ids[0], NotNull(), connector_ids[0]))
+            .WillOnce(Return(true));
+        EXPECT_CALL(mock_page_flipper, schedule_flip(crtc_ids[0], _, connector_ids[0]))
+            .WillOnce(Return(true));
+    }
+
+    mgg::RealKMSOutput output{
+        drm_fd,
+        mg::kms::get_connector(drm_fd, connector_ids[0]),
+        mt::fake_shared(mock_page_flipper),
+        true};
+
+    MockKMSFramebuffer const fb{42};
+    ASSERT_TRUE(output.set_crtc(fb));
+
+    auto const shown = layers(2);
+    ASSERT_THAT(output.fit_layers(fb, shown), Eq(2u));
+
+    EXPECT_TRUE(output.schedule_page_flip(fb, shown));
+    // The overlay planes still show the layers, so need switching off...
+    EXPECT_TRUE(output.schedule_page_flip(fb));
+    // ...after which a plain page flip will do
+    EXPECT_TRUE(output.schedule_page_flip(fb));
+}
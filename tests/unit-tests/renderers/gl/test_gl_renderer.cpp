@@ -230,6 +230,39 @@ TEST_F(GLRenderer, avoids_src_alpha_for_rgbx_blending)  // LP: #1423462
     renderer.render(renderable_list);
 }
 
+TEST_F(GLRenderer, draws_opaque_region_of_rgba_surfaces_without_blending)
+{
+    mir::geometry::Rectangles opaque_region;
+    opaque_region.add({{1, 2}, {3, 2}});
+    EXPECT_CALL(*renderable, shaped()).WillOnce(Return(true));
+    EXPECT_CALL(*renderable, opaque_region()).WillRepeatedly(Return(opaque_region));
+
+    InSequence seq;
+    EXPECT_CALL(mock_gl, glDisable(GL_BLEND));
+    EXPECT_CALL(mock_gl, glDrawArrays(_, _, _));
+    EXPECT_CALL(mock_gl, glEnable(GL_BLEND));
+    EXPECT_CALL(mock_gl, glBlendFuncSeparate(GL_ONE, GL_ONE_MINUS_SRC_ALPHA,
+                                             GL_ONE, GL_ONE_MINUS_SRC_ALPHA));
+    EXPECT_CALL(mock_gl, glDrawArrays(_, _, _));
+
+    mrg::Renderer renderer(gl_platform, make_output_surface());
+    renderer.render(renderable_list);
+}
+
+TEST_F(GLRenderer, blends_all_of_translucent_rgba_surfaces_despite_opaque_region)
+{
+    mir::geometry::Rectangles opaque_region;
+    opaque_region.add({{1, 2}, {3, 4}});
+    EXPECT_CALL(*renderable, alpha()).WillRepeatedly(Return(0.5f));
+    EXPECT_CALL(*renderable, shaped()).WillOnce(Return(true));
+    EXPECT_CALL(*renderable, opaque_region()).WillRepeatedly(Return(opaque_region));
+    EXPECT_CALL(mock_gl, glDisable(GL_BLEND)).Times(0);
+    EXPECT_CALL(mock_gl, glEnable(GL_BLEND));
+
+    mrg::Renderer renderer(gl_platform, make_output_surface());
+    renderer.render(renderable_list);
+}
+
 TEST_F(GLRenderer, clears_to_opaque_black)
 {
     InSequence seq;
@@ -436,3 +469,119 @@ TEST_F(GLRenderer, sets_viewport_downscaled_wide)
     mrg::Renderer renderer(gl_platform, std::move(output_surface));
     renderer.set_viewport(view_area);
 }
+
+namespace
+{
+auto make_output_surface_with_buffer_age(
+    mir::geometry::Size size,
+    std::optional<unsigned> age) -> std::unique_ptr<mtd::MockOutputSurface>
+{
+    auto output_surface = make_output_surface();
+    ON_CALL(*output_surface, size()).WillByDefault(Return(size));
+    ON_CALL(*output_surface, layout()).WillByDefault(Return(mg::gl::OutputSurface::Layout::GL));
+    ON_CALL(*output_surface, buffer_age()).WillByDefault(Return(age));
+    return output_surface;
+}
+}
+
+TEST_F(GLRenderer, repaints_only_damaged_area_when_buffer_age_is_known)
+{
+    mir::geometry::Rectangle const view_area{{0, 0}, {1920, 1080}};
+    EXPECT_CALL(*renderable, transformation()).WillRepeatedly(Return(glm::mat4{1}));
+    EXPECT_CALL(*renderable, screen_position())
+        .WillRepeatedly(Return(mir::geometry::Rectangle{{100, 200}, {300, 400}}));
+    ON_CALL(*renderable, damage())
+        .WillByDefault(Return(mir::geometry::Rectangles{{{110, 210}, {10, 20}}}));
+
+    mrg::Renderer renderer(gl_platform, make_output_surface_with_buffer_age(view_area.size, 1));
+    renderer.set_viewport(view_area);
+    renderer.render(renderable_list);
+
+    EXPECT_CALL(mock_gl, glScissor(110, 1080 - 210 - 20, 10, 20));
+    EXPECT_CALL(mock_gl, glClear(_)).Times(1);
+    renderer.render(renderable_list);
+}
+
+TEST_F(GLRenderer, hints_output_surface_with_repainted_area)
+{
+    mir::geometry::Rectangle const view_area{{0, 0}, {1920, 1080}};
+    EXPECT_CALL(*renderable, transformation()).WillRepeatedly(Return(glm::mat4{1}));
+    EXPECT_CALL(*renderable, screen_position())
+        .WillRepeatedly(Return(mir::geometry::Rectangle{{100, 200}, {300, 400}}));
+    ON_CALL(*renderable, damage())
+        .WillByDefault(Return(mir::geometry::Rectangles{{{110, 210}, {10, 20}}}));
+
+    auto output_surface = make_output_surface_with_buffer_age(view_area.size, 1);
+    // Only the second frame is repainted partially
+    EXPECT_CALL(*output_surface, set_damage_hint(mir::geometry::Rectangles{{{110, 1080 - 210 - 20}, {10, 20}}}));
+
+    mrg::Renderer renderer(gl_platform, std::move(output_surface));
+    renderer.set_viewport(view_area);
+    renderer.render(renderable_list);
+    renderer.render(renderable_list);
+}
+
+TEST_F(GLRenderer, draws_nothing_when_nothing_is_damaged)
+{
+    mir::geometry::Rectangle const view_area{{0, 0}, {1920, 1080}};
+    EXPECT_CALL(*renderable, transformation()).WillRepeatedly(Return(glm::mat4{1}));
+    ON_CALL(*renderable, damage()).WillByDefault(Return(mir::geometry::Rectangles{}));
+
+    mrg::Renderer renderer(gl_platform, make_output_surface_with_buffer_age(view_area.size, 1));
+    renderer.set_viewport(view_area);
+    renderer.render(renderable_list);
+
+    EXPECT_CALL(mock_gl, glClear(_)).Times(0);
+    EXPECT_CALL(mock_gl, glDrawArrays(_, _, _)).Times(0);
+    renderer.render(renderable_list);
+}
+
+TEST_F(GLRenderer, moved_renderable_repaints_old_and_new_positions)
+{
+    mir::geometry::Rectangle const view_area{{0, 0}, {1920, 1080}};
+    mir::geometry::Rectangle position{{100, 200}, {300, 400}};
+    EXPECT_CALL(*renderable, transformation()).WillRepeatedly(Return(glm::mat4{1}));
+    EXPECT_CALL(*renderable, screen_position()).WillRepeatedly(testing::ReturnPointee(&position));
+    ON_CALL(*renderable, damage()).WillByDefault(Return(mir::geometry::Rectangles{}));
+
+    mrg::Renderer renderer(gl_platform, make_output_surface_with_buffer_age(view_area.size, 1));
+    renderer.set_viewport(view_area);
+    renderer.render(renderable_list);
+
+    position.top_left = {500, 200};
+
+    EXPECT_CALL(mock_gl, glScissor(100, 1080 - 200 - 400, 300, 400));
+    EXPECT_CALL(mock_gl, glScissor(500, 1080 - 200 - 400, 300, 400));
+    EXPECT_CALL(mock_gl, glClear(_)).Times(2);
+    renderer.render(renderable_list);
+}
+
+TEST_F(GLRenderer, repaints_everything_when_buffer_age_is_unknown)
+{
+    mir::geometry::Rectangle const view_area{{0, 0}, {1920, 1080}};
+    EXPECT_CALL(*renderable, transformation()).WillRepeatedly(Return(glm::mat4{1}));
+    ON_CALL(*renderable, damage())
+        .WillByDefault(Return(mir::geometry::Rectangles{{{1, 2}, {1, 1}}}));
+
+    mrg::Renderer renderer(gl_platform, make_output_surface_with_buffer_age(view_area.size, std::nullopt));
+    renderer.set_viewport(view_area);
+    renderer.render(renderable_list);
+
+    EXPECT_CALL(mock_gl, glScissor(_, _, _, _)).Times(0);
+    EXPECT_CALL(mock_gl, glClear(_)).Times(1);
+    renderer.render(renderable_list);
+}
+
+TEST_F(GLRenderer, repaints_everything_on_first_frame_even_with_buffer_age)
+{
+    mir::geometry::Rectangle const view_area{{0, 0}, {1920, 1080}};
+    EXPECT_CALL(*renderable, transformation()).WillRepeatedly(Return(glm::mat4{1}));
+    ON_CALL(*renderable, damage()).WillByDefault(Return(mir::geometry::Rectangles{}));
+
+    mrg::Renderer renderer(gl_platform, make_output_surface_with_buffer_age(view_area.size, 1));
+    renderer.set_viewport(view_area);
+
+    EXPECT_CALL(mock_gl, glScissor(_, _, _, _)).Times(0);
+    EXPECT_CALL(mock_gl, glClear(_)).Times(1);
+    renderer.render(renderable_list);
+}
@@ -76,6 +76,7 @@ public:
     MOCK_METHOD(void, cursor_image_set_to, (ms::Surface const*, std::weak_ptr<mir::graphics::CursorImage> const&), (override));
     MOCK_METHOD(void, cursor_image_removed, (ms::Surface const*), (override));
     MOCK_METHOD(void, application_id_set_to, (ms::Surface const*, std::string const&), (override));
+    MOCK_METHOD(void, input_region_set_to, (ms::Surface const*, std::vector<geom::Rectangle> const&), (override));
     MOCK_METHOD(void, entered_output, (ms::Surface const*, mg::DisplayConfigurationOutputId const&), (override));
     MOCK_METHOD(void, left_output, (ms::Surface const*, mg::DisplayConfigurationOutputId const&), (override));
 };
@@ -1013,7 +1014,21 @@ TEST_F(BasicSurfaceTest, when_frame_is_posted_an_observer_is_notified_of_frame_w
     surface.set_streams({ms::StreamInfo{buffer_stream, {}}});
 
     EXPECT_CALL(*mock_surface_observer, frame_posted(_, mt::RectSizeEq(rect.size)));
-    buffer_stream->frame_posted_callback(rect.size);
+    buffer_stream->frame_posted_callback({{}, rect.size});
+}
+
+TEST_F(BasicSurfaceTest, when_partial_frame_is_posted_an_observer_is_notified_of_only_the_damaged_area)
+{
+    using namespace testing;
+    geom::Displacement const stream_info_offset{7, 10};
+    geom::Rectangle const damage{{3, 4}, {5, 6}};
+
+    auto buffer_stream = std::make_shared<NiceMock<mtd::MockBufferStream>>();
+    surface.register_interest(mock_surface_observer, executor);
+    surface.set_streams({ms::StreamInfo{buffer_stream, stream_info_offset}});
+
+    EXPECT_CALL(*mock_surface_observer, frame_posted(_, Eq(geom::Rectangle{damage.top_left + stream_info_offset, damage.size})));
+    buffer_stream->frame_posted_callback(damage);
 }
 
 TEST_F(BasicSurfaceTest, when_frame_is_posted_an_observer_is_notified_of_frame_at_origin)
@@ -1025,7 +1040,7 @@ TEST_F(BasicSurfaceTest, when_frame_is_posted_an_observer_is_notified_of_frame_a
     surface.set_streams({ms::StreamInfo{buffer_stream, {}}});
 
     EXPECT_CALL(*mock_surface_observer, frame_posted(_, mt::RectTopLeftEq(geom::Point{})));
-    buffer_stream->frame_posted_callback(rect.size);
+    buffer_stream->frame_posted_callback({{}, rect.size});
 }
 
 TEST_F(BasicSurfaceTest, when_stream_info_has_offset_an_observer_is_notified_of_frame_with_correct_offset)
@@ -1034,13 +1049,12 @@ TEST_F(BasicSurfaceTest, when_stream_info_has_offset_an_observer_is_notified_of_
     geom::Displacement const stream_info_offset{7, 10};
 
     auto buffer_stream = std::make_shared<NiceMock<mtd::MockBufferStream>>();
-    std::function<void(geom::Size const&)> frame_posted_callback;
 
     surface.register_interest(mock_surface_observer, executor);
     surface.set_streams({ms::StreamInfo{buffer_stream, stream_info_offset}});
 
     EXPECT_CALL(*mock_surface_observer, frame_posted(_, mt::RectTopLeftEq(geom::Point{} + stream_info_offset)));
-    buffer_stream->frame_posted_callback(rect.size);
+    buffer_stream->frame_posted_callback({{}, rect.size});
 }
 
 TEST_F(BasicSurfaceTest, when_surface_has_margins_an_observer_is_notified_of_frame_with_correct_offset)
@@ -1050,14 +1064,13 @@ TEST_F(BasicSurfaceTest, when_surface_has_margins_an_observer_is_notified_of_fra
     geom::DeltaX const margin_left{3}, margin_right{5};
 
     auto buffer_stream = std::make_shared<NiceMock<mtd::MockBufferStream>>();
-    std::function<void(geom::Size const&)> frame_posted_callback;
 
     surface.register_interest(mock_surface_observer, executor);
     surface.set_streams({ms::StreamInfo{buffer_stream, {}}});
 
     EXPECT_CALL(*mock_surface_observer, frame_posted(_, mt::RectTopLeftEq(geom::Point{} + margin_top + margin_left)));
     surface.set_window_margins(margin_top, margin_left, margin_bottom, margin_right);
-    buffer_stream->frame_posted_callback({20, 30});
+    buffer_stream->frame_posted_callback({{}, {20, 30}});
 }
 
 TEST_F(BasicSurfaceTest, default_application_id)
@@ -1072,6 +1085,20 @@ TEST_F(BasicSurfaceTest, application_id_can_be_set)
     EXPECT_EQ(id, surface.application_id());
 }
 
+TEST_F(BasicSurfaceTest, notifies_about_input_region_changes)
+{
+    using namespace testing;
+
+    std::vector<geom::Rectangle> const region{{{0, 0}, {10, 10}}, {{20, 0}, {10, 10}}};
+
+    EXPECT_CALL(*mock_surface_observer, input_region_set_to(_, region))
+        .Times(1);
+
+    surface.register_interest(mock_surface_observer, executor);
+
+    surface.set_input_region(region);
+}
+
 TEST_F(BasicSurfaceTest, notifies_about_application_id_changes)
 {
     using namespace testing;
@@ -1288,6 +1315,56 @@ TEST_F(BasicSurfaceTest, moving_surface_repositions_all_associated_streams)
     EXPECT_THAT(renderables[1], IsRenderableOfPosition(pt + d));
 }
 
+TEST_F(BasicSurfaceTest, generates_renderables_only_for_streams_in_view_area)
+{
+    using namespace testing;
+    geom::Displacement d{100, 0};
+    auto buffer_stream = std::make_shared<NiceMock<mtd::MockBufferStream>>();
+    ON_CALL(*mock_buffer_stream, stream_size()).WillByDefault(Return(rect.size));
+    ON_CALL(*buffer_stream, stream_size()).WillByDefault(Return(geom::Size{10, 10}));
+
+    std::list<ms::StreamInfo> streams = {
+        { mock_buffer_stream, {0,0}},
+        { buffer_stream, d}
+    };
+    surface.set_streams(streams);
+
+    EXPECT_CALL(*buffer_stream, next_submission_for_compositor(_)).Times(0);
+
+    auto renderables = surface.generate_renderables(this, {{0, 0}, {100, 100}});
+    ASSERT_THAT(renderables.size(), Eq(1));
+    EXPECT_THAT(renderables[0], IsRenderableOfPosition(rect.top_left));
+}
+
+TEST_F(BasicSurfaceTest, does_not_cull_streams_of_transformed_surface)
+{
+    using namespace testing;
+    ON_CALL(*mock_buffer_stream, stream_size()).WillByDefault(Return(rect.size));
+
+    surface.set_transformation(glm::mat4{2});
+
+    auto renderables = surface.generate_renderables(this, {{100, 100}, {100, 100}});
+    EXPECT_THAT(renderables.size(), Eq(1));
+}
+
+TEST_F(BasicSurfaceTest, renderable_opaque_region_is_on_screen_and_clipped_to_content)
+{
+    using namespace testing;
+    geom::Displacement const d{3, 5};
+    auto buffer_stream = std::make_shared<NiceMock<mtd::MockBufferStream>>();
+    ON_CALL(*buffer_stream->submission, size()).WillByDefault(Return(geom::Size{10, 10}));
+
+    surface.set_streams({ms::StreamInfo{buffer_stream, d, {{{2, 2}, {4, 4}}, {{8, 0}, {4, 4}}}}});
+
+    auto renderables = surface.generate_renderables(this);
+    ASSERT_THAT(renderables.size(), Eq(1));
+
+    geom::Rectangles expected;
+    expected.add({rect.top_left + d + geom::Displacement{2, 2}, {4, 4}});
+    expected.add({rect.top_left + d + geom::Displacement{8, 0}, {2, 4}});
+    EXPECT_THAT(renderables[0]->opaque_region(), Eq(expected));
+}
+
 TEST_F(BasicSurfaceTest, can_remove_all_streams)
 {
     using namespace testing;
@@ -1545,7 +1622,7 @@ TEST_F(BasicSurfaceTest, buffer_can_be_submitted_to_original_stream_after_surfac
 
     auto local_stream = std::make_shared<NiceMock<mtd::MockBufferStream>>();
     std::list<ms::StreamInfo> local_stream_list = { { local_stream, {}} };
-    std::function<void(geom::Size const&)> callback = [](auto){};
+    std::function<void(geom::Rectangle const&)> callback = [](auto){};
 
     EXPECT_CALL(*local_stream, set_frame_posted_callback(_))
         .Times(AtLeast(1))
@@ -1563,7 +1640,7 @@ TEST_F(BasicSurfaceTest, buffer_can_be_submitted_to_original_stream_after_surfac
         display_config_registrar);
 
     surface.reset();
-    callback({10, 10});
+    callback({{}, {10, 10}});
 }
 
 TEST_F(BasicSurfaceTest, buffer_can_be_submitted_to_set_stream_after_surface_destroyed)
@@ -1572,7 +1649,7 @@ TEST_F(BasicSurfaceTest, buffer_can_be_submitted_to_set_stream_after_surface_des
 
     auto local_stream = std::make_shared<NiceMock<mtd::MockBufferStream>>();
     std::list<ms::StreamInfo> local_stream_list = { { local_stream, {}} };
-    std::function<void(geom::Size const&)> callback = [](auto){};
+    std::function<void(geom::Rectangle const&)> callback = [](auto){};
 
     EXPECT_CALL(*local_stream, set_frame_posted_callback(_))
         .Times(AtLeast(1))
@@ -1592,5 +1669,5 @@ TEST_F(BasicSurfaceTest, buffer_can_be_submitted_to_set_stream_after_surface_des
     surface->set_streams(local_stream_list);
 
     surface.reset();
-    callback({10, 10});
+    callback({{}, {10, 10}});
 }
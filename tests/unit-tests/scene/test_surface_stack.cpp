@@ -17,6 +17,7 @@
 #include "mir/test/doubles/stub_buffer.h"
 #include "src/server/scene/surface_stack.h"
 #include "mir/graphics/buffer_properties.h"
+#include "mir/graphics/frame.h"
 #include "mir/geometry/rectangle.h"
 #include "mir/scene/observer.h"
 #include "mir/compositor/scene_element.h"
@@ -152,6 +153,7 @@ struct SurfaceStack : public ::testing::Test
     std::shared_ptr<ms::SurfaceStack> shared_stack = std::make_shared<ms::SurfaceStack>(report);
     ms::SurfaceStack& stack = *shared_stack;
     void const* compositor_id{&stack};
+    geom::Rectangle const view_area{{-1000, -1000}, {2000, 2000}};
     mtd::ExplicitExecutor executor;
     std::shared_ptr<mtd::FakeDisplayConfigurationObserverRegistrar> const display_config_registrar =
         std::make_shared<mtd::FakeDisplayConfigurationObserverRegistrar>();
@@ -183,7 +185,7 @@ TEST_F(SurfaceStack, stacking_order)
     stack.add_surface(stub_surface3, mi::InputReceptionMode::normal);
 
     EXPECT_THAT(
-        stack.scene_elements_for(compositor_id),
+        stack.scene_elements_for(compositor_id, view_area),
         ElementsAre(
             SceneElementForStream(stub_buffer_stream1),
             SceneElementForStream(stub_buffer_stream2),
@@ -214,7 +216,7 @@ TEST_F(SurfaceStack, stacking_order_with_multiple_buffer_streams)
     stack.add_surface(stub_surface3, mi::InputReceptionMode::normal);
 
     EXPECT_THAT(
-        stack.scene_elements_for(compositor_id),
+        stack.scene_elements_for(compositor_id, view_area),
         ElementsAre(
             SceneElementForStream(stub_buffer_stream1),
             SceneElementForStream(stub_stream0),
@@ -234,7 +236,7 @@ TEST_F(SurfaceStack, scene_snapshot_omits_invisible_surfaces)
     stack.add_surface(stub_surface2, mi::InputReceptionMode::normal);
 
     EXPECT_THAT(
-        stack.scene_elements_for(compositor_id),
+        stack.scene_elements_for(compositor_id, view_area),
         ElementsAre(
             SceneElementForStream(stub_buffer_stream1),
             SceneElementForStream(stub_buffer_stream2)));
@@ -249,7 +251,7 @@ TEST_F(SurfaceStack, surfaces_are_emitted_by_layer)
     stack.add_surface(stub_surface2, mi::InputReceptionMode::normal);
 
     EXPECT_THAT(
-        stack.scene_elements_for(compositor_id),
+        stack.scene_elements_for(compositor_id, view_area),
         ElementsAre(
             SceneElementForStream(stub_buffer_stream1),
             SceneElementForStream(stub_buffer_stream3),
@@ -284,7 +286,7 @@ TEST_F(SurfaceStack, raise_to_top_alters_render_ordering)
     stack.add_surface(stub_surface3, mi::InputReceptionMode::normal);
 
     EXPECT_THAT(
-        stack.scene_elements_for(compositor_id),
+        stack.scene_elements_for(compositor_id, view_area),
         ElementsAre(
             SceneElementForStream(stub_buffer_stream1),
             SceneElementForStream(stub_buffer_stream2),
@@ -293,13 +295,116 @@ TEST_F(SurfaceStack, raise_to_top_alters_render_ordering)
     stack.raise(stub_surface1);
 
     EXPECT_THAT(
-        stack.scene_elements_for(compositor_id),
+        stack.scene_elements_for(compositor_id, view_area),
         ElementsAre(
             SceneElementForStream(stub_buffer_stream2),
             SceneElementForStream(stub_buffer_stream3),
             SceneElementForStream(stub_buffer_stream1)));
 }
 
+TEST_F(SurfaceStack, scene_elements_include_surfaces_added_since_last_composited)
+{
+    using namespace ::testing;
+
+    stack.add_surface(stub_surface1, mi::InputReceptionMode::normal);
+
+    EXPECT_THAT(
+        stack.scene_elements_for(compositor_id, view_area),
+        ElementsAre(SceneElementForStream(stub_buffer_stream1)));
+
+    stack.add_surface(stub_surface2, mi::InputReceptionMode::normal);
+
+    EXPECT_THAT(
+        stack.scene_elements_for(compositor_id, view_area),
+        ElementsAre(
+            SceneElementForStream(stub_buffer_stream1),
+            SceneElementForStream(stub_buffer_stream2)));
+}
+
+TEST_F(SurfaceStack, does_not_own_surface_composited_before_removal)
+{
+    using namespace testing;
+
+    auto const use_count = stub_surface1.use_count();
+
+    stack.add_surface(stub_surface1, mi::InputReceptionMode::normal);
+    stack.scene_elements_for(compositor_id, view_area);
+    stack.remove_surface(stub_surface1);
+
+    EXPECT_THAT(stub_surface1.use_count(), Eq(use_count));
+    EXPECT_THAT(stack.scene_elements_for(compositor_id, view_area), IsEmpty());
+}
+
+TEST_F(SurfaceStack, releases_renderables_with_the_scene_elements_of_each_frame)
+{
+    using namespace testing;
+
+    stack.add_surface(stub_surface1, mi::InputReceptionMode::normal);
+
+    for (auto frame = 0; frame != 3; ++frame)
+    {
+        std::weak_ptr<mg::Renderable> renderable;
+        {
+            auto const elements = stack.scene_elements_for(compositor_id, view_area);
+            ASSERT_THAT(elements, SizeIs(1));
+            renderable = elements.front()->renderable();
+        }
+
+        EXPECT_TRUE(renderable.expired());
+    }
+}
+
+TEST_F(SurfaceStack, only_asks_streams_that_went_into_the_frame_to_present_it)
+{
+    using namespace testing;
+
+    auto const shown_stream = std::make_shared<NiceMock<mtd::MockBufferStream>>();
+    auto const hidden_stream = std::make_shared<NiceMock<mtd::MockBufferStream>>();
+    auto const shown = std::make_shared<StubSurface>(shown_stream, executor);
+    auto const hidden = std::make_shared<StubSurface>(hidden_stream, executor);
+    hidden->hide();
+    stack.add_surface(shown, mi::InputReceptionMode::normal);
+    stack.add_surface(hidden, mi::InputReceptionMode::normal);
+
+    EXPECT_CALL(*shown_stream, presenter(compositor_id));
+    EXPECT_CALL(*hidden_stream, presenter(_)).Times(0);
+
+    stack.scene_elements_for(compositor_id, view_area);
+    stack.frame_presenter(compositor_id)(mg::Presentation{});
+}
+
+TEST_F(SurfaceStack, does_not_own_surface_found_under_cursor)
+{
+    using namespace testing;
+
+    auto const use_count = stub_surface1.use_count();
+
+    stack.add_surface(stub_surface1, mi::InputReceptionMode::normal);
+    EXPECT_THAT(stack.surface_at({}), Eq(stub_surface1));
+
+    stack.remove_surface(stub_surface1);
+
+    EXPECT_THAT(stub_surface1.use_count(), Eq(use_count));
+    EXPECT_THAT(stack.surface_at({}), IsNull());
+}
+
+TEST_F(SurfaceStack, scene_elements_remain_usable_after_their_surface_is_removed)
+{
+    using namespace testing;
+
+    stack.register_compositor(compositor_id);
+    stack.add_surface(stub_surface1, mi::InputReceptionMode::normal);
+    stack.add_surface(stub_surface2, mi::InputReceptionMode::normal);
+
+    auto const elements = stack.scene_elements_for(compositor_id, view_area);
+    stack.remove_surface(stub_surface1);
+
+    ASSERT_THAT(elements.size(), Eq(2u));
+    EXPECT_THAT(elements.front(), SceneElementForStream(stub_buffer_stream1));
+    elements.front()->rendered();
+    elements.back()->occluded();
+}
+
 TEST_F(SurfaceStack, raise_throw_behavior)
 {
     using namespace ::testing;
@@ -334,7 +439,7 @@ TEST_F(SurfaceStack, generate_elementelements)
         stack.add_surface(surface, mi::InputReceptionMode::normal);
     }
 
-    auto const elements = stack.scene_elements_for(compositor_id);
+    auto const elements = stack.scene_elements_for(compositor_id, view_area);
 
     ASSERT_THAT(elements.size(), Eq(num_surfaces));
 
@@ -533,7 +638,7 @@ TEST_F(SurfaceStack, scene_elements_hold_snapshot_of_positioning_info)
         stack.add_surface(surface, mi::InputReceptionMode::normal);
     }
 
-    auto const elements = stack.scene_elements_for(compositor_id);
+    auto const elements = stack.scene_elements_for(compositor_id, view_area);
 
     auto const changed_position = geom::Point{43,44};
     for(auto const& surface : surfaces)
@@ -562,7 +667,7 @@ TEST_F(SurfaceStack, generates_scene_elements_that_delay_buffer_acquisition)
         display_config_registrar);
         stack.add_surface(surface, mi::InputReceptionMode::normal);
 
-    auto const elements = stack.scene_elements_for(compositor_id);
+    auto const elements = stack.scene_elements_for(compositor_id, view_area);
 
     Mock::VerifyAndClearExpectations(mock_stream.get());
     ASSERT_THAT(elements.size(), Eq(1u));
@@ -587,7 +692,7 @@ TEST_F(SurfaceStack, generates_scene_elements_that_allow_only_one_buffer_acquisi
         display_config_registrar);
         stack.add_surface(surface, mi::InputReceptionMode::normal);
 
-    auto const elements = stack.scene_elements_for(compositor_id);
+    auto const elements = stack.scene_elements_for(compositor_id, view_area);
     ASSERT_THAT(elements.size(), Eq(1u));
     elements.front()->renderable()->buffer();
     elements.front()->renderable()->buffer();
@@ -621,9 +726,9 @@ TEST_F(SurfaceStack, occludes_not_rendered_surface)
 
     stack.add_surface(mock_surface, mi::InputReceptionMode::normal);
 
-    auto const elements = stack.scene_elements_for(compositor_id);
+    auto const elements = stack.scene_elements_for(compositor_id, view_area);
     ASSERT_THAT(elements.size(), Eq(1u));
-    auto const elements2 = stack.scene_elements_for(compositor_id2);
+    auto const elements2 = stack.scene_elements_for(compositor_id2, view_area);
     ASSERT_THAT(elements2.size(), Eq(1u));
 
     EXPECT_CALL(*mock_surface, configure(mir_window_attrib_visibility, mir_window_visibility_occluded));
@@ -644,9 +749,9 @@ TEST_F(SurfaceStack, exposes_rendered_surface)
     auto const mock_surface = std::make_shared<MockConfigureSurface>(executor);
     stack.add_surface(mock_surface, mi::InputReceptionMode::normal);
 
-    auto const elements = stack.scene_elements_for(compositor_id);
+    auto const elements = stack.scene_elements_for(compositor_id, view_area);
     ASSERT_THAT(elements.size(), Eq(1u));
-    auto const elements2 = stack.scene_elements_for(compositor_id2);
+    auto const elements2 = stack.scene_elements_for(compositor_id2, view_area);
     ASSERT_THAT(elements2.size(), Eq(1u));
 
     EXPECT_CALL(*mock_surface, configure(mir_window_attrib_visibility, mir_window_visibility_exposed));
@@ -669,11 +774,11 @@ TEST_F(SurfaceStack, occludes_surface_when_unregistering_all_compositors_that_re
     auto const mock_surface = std::make_shared<MockConfigureSurface>(executor);
     stack.add_surface(mock_surface, mi::InputReceptionMode::normal);
 
-    auto const elements = stack.scene_elements_for(compositor_id);
+    auto const elements = stack.scene_elements_for(compositor_id, view_area);
     ASSERT_THAT(elements.size(), Eq(1u));
-    auto const elements2 = stack.scene_elements_for(compositor_id2);
+    auto const elements2 = stack.scene_elements_for(compositor_id2, view_area);
     ASSERT_THAT(elements2.size(), Eq(1u));
-    auto const elements3 = stack.scene_elements_for(compositor_id3);
+    auto const elements3 = stack.scene_elements_for(compositor_id3, view_area);
     ASSERT_THAT(elements3.size(), Eq(1u));
 
     EXPECT_CALL(*mock_surface, configure(mir_window_attrib_visibility, mir_window_visibility_exposed))
@@ -692,6 +797,59 @@ TEST_F(SurfaceStack, occludes_surface_when_unregistering_all_compositors_that_re
     stack.unregister_compositor(compositor_id3);
 }
 
+TEST_F(SurfaceStack, occludes_surface_outside_view_area)
+{
+    using namespace testing;
+
+    mc::CompositorID const compositor_id2{&compositor_id};
+    geom::Rectangle const other_view_area{{1000, 0}, {640, 480}};
+
+    stack.register_compositor(compositor_id);
+    stack.register_compositor(compositor_id2);
+
+    auto const mock_surface = std::make_shared<MockConfigureSurface>(executor);
+    stack.add_surface(mock_surface, mi::InputReceptionMode::normal);
+
+    auto const elements = stack.scene_elements_for(compositor_id, view_area);
+    ASSERT_THAT(elements.size(), Eq(1u));
+    elements.back()->occluded();
+
+    EXPECT_CALL(*mock_surface, configure(mir_window_attrib_visibility, mir_window_visibility_occluded));
+
+    EXPECT_THAT(stack.scene_elements_for(compositor_id2, other_view_area), IsEmpty());
+}
+
+TEST_F(SurfaceStack, omits_surfaces_outside_view_area)
+{
+    using namespace testing;
+
+    stub_surface2->move_to({500, 500});
+
+    stack.add_surface(stub_surface1, mi::InputReceptionMode::normal);
+    stack.add_surface(stub_surface2, mi::InputReceptionMode::normal);
+    stack.add_surface(stub_surface3, mi::InputReceptionMode::normal);
+
+    EXPECT_THAT(
+        stack.scene_elements_for(compositor_id, {{-10, -10}, {100, 100}}),
+        ElementsAre(
+            SceneElementForStream(stub_buffer_stream1),
+            SceneElementForStream(stub_buffer_stream3)));
+}
+
+TEST_F(SurfaceStack, does_not_take_submissions_for_surfaces_outside_view_area)
+{
+    using namespace testing;
+
+    auto const stream = std::make_shared<NiceMock<mtd::MockBufferStream>>();
+    auto const surface = std::make_shared<StubSurface>(stream, executor);
+    surface->move_to({500, 500});
+    stack.add_surface(surface, mi::InputReceptionMode::normal);
+
+    EXPECT_CALL(*stream, next_submission_for_compositor(_)).Times(0);
+
+    EXPECT_THAT(stack.scene_elements_for(compositor_id, {{-10, -10}, {100, 100}}), IsEmpty());
+}
+
 TEST_F(SurfaceStack, observer_can_trigger_state_change_within_notification)
 {
     using namespace ::testing;
@@ -805,7 +963,7 @@ TEST_F(SurfaceStack, overlays_appear_at_top_of_renderlist)
     stack.add_surface(stub_surface2, mi::InputReceptionMode::normal);
 
     EXPECT_THAT(
-        stack.scene_elements_for(compositor_id),
+        stack.scene_elements_for(compositor_id, view_area),
         ElementsAre(
             SceneElementForStream(stub_buffer_stream1),
             SceneElementForStream(stub_buffer_stream2),
@@ -823,7 +981,7 @@ TEST_F(SurfaceStack, removed_overlays_are_removed)
     stack.add_surface(stub_surface2, mi::InputReceptionMode::normal);
 
     EXPECT_THAT(
-        stack.scene_elements_for(compositor_id),
+        stack.scene_elements_for(compositor_id, view_area),
         ElementsAre(
             SceneElementForStream(stub_buffer_stream1),
             SceneElementForStream(stub_buffer_stream2),
@@ -832,7 +990,7 @@ TEST_F(SurfaceStack, removed_overlays_are_removed)
     stack.remove_input_visualization(mt::fake_shared(r));
 
     EXPECT_THAT(
-        stack.scene_elements_for(compositor_id),
+        stack.scene_elements_for(compositor_id, view_area),
         ElementsAre(
             SceneElementForStream(stub_buffer_stream1),
             SceneElementForStream(stub_buffer_stream2)));
@@ -929,6 +1087,78 @@ TEST_F(SurfaceStack, surface_at_returns_top_visible_surface_under_cursor)
     EXPECT_THAT(stack.surface_at(cursor_over_none).get(), IsNull());
 }
 
+TEST_F(SurfaceStack, surface_at_follows_surfaces_moved_after_lookup)
+{
+    stack.add_surface(stub_surface1, mi::InputReceptionMode::normal);
+    stack.add_surface(stub_surface2, mi::InputReceptionMode::normal);
+
+    stub_surface1->resize({100, 100});
+    stub_surface2->resize({100, 100});
+    executor.execute();
+
+    EXPECT_THAT(stack.surface_at({50, 50}), Eq(stub_surface2));
+
+    stub_surface2->move_to({1000, 1000});
+    executor.execute();
+
+    EXPECT_THAT(stack.surface_at({50, 50}), Eq(stub_surface1));
+    EXPECT_THAT(stack.surface_at({1050, 1050}), Eq(stub_surface2));
+}
+
+TEST_F(SurfaceStack, surface_at_follows_input_region_set_after_lookup)
+{
+    geom::Point const cursor_outside_window{700, 700};
+
+    stack.add_surface(stub_surface1, mi::InputReceptionMode::normal);
+    stub_surface1->resize({100, 100});
+    executor.execute();
+
+    EXPECT_THAT(stack.surface_at(cursor_outside_window).get(), IsNull());
+
+    stub_surface1->set_input_region({{{0, 0}, {10, 10}}, {{600, 600}, {200, 200}}});
+    executor.execute();
+
+    EXPECT_THAT(stack.surface_at(cursor_outside_window), Eq(stub_surface1));
+    EXPECT_THAT(stack.surface_at({50, 50}).get(), IsNull());
+}
+
+TEST_F(SurfaceStack, surface_at_follows_restacking_after_lookup)
+{
+    stack.add_surface(stub_surface1, mi::InputReceptionMode::normal);
+    stack.add_surface(stub_surface2, mi::InputReceptionMode::normal);
+
+    stub_surface1->resize({100, 100});
+    stub_surface2->resize({100, 100});
+    executor.execute();
+
+    EXPECT_THAT(stack.surface_at({50, 50}), Eq(stub_surface2));
+
+    stack.raise(stub_surface1);
+    EXPECT_THAT(stack.surface_at({50, 50}), Eq(stub_surface1));
+
+    stack.remove_surface(stub_surface1);
+    EXPECT_THAT(stack.surface_at({50, 50}), Eq(stub_surface2));
+}
+
+TEST_F(SurfaceStack, surface_at_finds_surfaces_of_any_size)
+{
+    stack.add_surface(stub_surface1, mi::InputReceptionMode::normal);
+    stack.add_surface(stub_surface2, mi::InputReceptionMode::normal);
+    stack.add_surface(stub_surface3, mi::InputReceptionMode::normal);
+
+    stub_surface1->resize({20000, 20000});
+    stub_surface2->move_to({-5000, -5000});
+    stub_surface2->resize({1000, 1000});
+    stub_surface3->move_to({12000, 9000});
+    stub_surface3->resize({1, 1});
+    executor.execute();
+
+    EXPECT_THAT(stack.surface_at({15000, 15000}), Eq(stub_surface1));
+    EXPECT_THAT(stack.surface_at({-4500, -4500}), Eq(stub_surface2));
+    EXPECT_THAT(stack.surface_at({12000, 9000}), Eq(stub_surface3));
+    EXPECT_THAT(stack.surface_at({12001, 9000}), Eq(stub_surface1));
+}
+
 TEST_F(SurfaceStack, input_surface_at_returns_top_visible_surface_under_cursor)
 {
     geom::Point const cursor_over_all {100, 100};
@@ -968,7 +1198,7 @@ TEST_F(SurfaceStack, raise_surfaces_to_top)
 
     stack.raise({stub_surface1, stub_surface3});
     EXPECT_THAT(
-        stack.scene_elements_for(compositor_id),
+        stack.scene_elements_for(compositor_id, view_area),
         ElementsAre(
             SceneElementForStream(stub_buffer_stream2),
             SceneElementForStream(stub_buffer_stream1),
@@ -982,7 +1212,7 @@ TEST_F(SurfaceStack, raise_surfaces_to_top)
 
     stack.raise({stub_surface2, stub_surface3});
     EXPECT_THAT(
-        stack.scene_elements_for(compositor_id),
+        stack.scene_elements_for(compositor_id, view_area),
         ElementsAre(
             SceneElementForStream(stub_buffer_stream1),
             SceneElementForStream(stub_buffer_stream2),
@@ -993,7 +1223,7 @@ TEST_F(SurfaceStack, raise_surfaces_to_top)
 
     stack.raise({stub_surface2, stub_surface1, stub_surface3});
     EXPECT_THAT(
-        stack.scene_elements_for(compositor_id),
+        stack.scene_elements_for(compositor_id, view_area),
         ElementsAre(
             SceneElementForStream(stub_buffer_stream1),
             SceneElementForStream(stub_buffer_stream2),
@@ -1009,7 +1239,7 @@ TEST_F(SurfaceStack, new_surface_is_placed_under_old_according_to_depth_layer)
     stack.add_surface(stub_surface2, mi::InputReceptionMode::normal);
 
     EXPECT_THAT(
-        stack.scene_elements_for(compositor_id),
+        stack.scene_elements_for(compositor_id, view_area),
         ElementsAre(
             SceneElementForStream(stub_buffer_stream2),
             SceneElementForStream(stub_buffer_stream1)));
@@ -1032,7 +1262,7 @@ TEST_F(SurfaceStack, raise_does_not_reorder_surfaces_when_depth_layers_are_diffe
 
     stack.raise({stub_surface1, stub_surface3});
     EXPECT_THAT(
-        stack.scene_elements_for(compositor_id),
+        stack.scene_elements_for(compositor_id, view_area),
         ElementsAre(
             SceneElementForStream(stub_buffer_stream1),
             SceneElementForStream(stub_buffer_stream2),
@@ -1051,7 +1281,7 @@ TEST_F(SurfaceStack, changing_depth_layer_causes_reorder)
     executor.execute();
 
     EXPECT_THAT(
-        stack.scene_elements_for(compositor_id),
+        stack.scene_elements_for(compositor_id, view_area),
         ElementsAre(
             SceneElementForStream(stub_buffer_stream1),
             SceneElementForStream(stub_buffer_stream2)));
@@ -1066,7 +1296,7 @@ TEST_F(SurfaceStack, changing_depth_layer_causes_reorder)
     executor.execute();
 
     EXPECT_THAT(
-        stack.scene_elements_for(compositor_id),
+        stack.scene_elements_for(compositor_id, view_area),
         ElementsAre(
             SceneElementForStream(stub_buffer_stream2),
             SceneElementForStream(stub_buffer_stream1)));
@@ -1078,7 +1308,7 @@ TEST_F(SurfaceStack, changing_depth_layer_does_not_cause_reorder_when_it_shouldn
     stack.add_surface(stub_surface2, mi::InputReceptionMode::normal);
 
     EXPECT_THAT(
-        stack.scene_elements_for(compositor_id),
+        stack.scene_elements_for(compositor_id, view_area),
         ElementsAre(
             SceneElementForStream(stub_buffer_stream1),
             SceneElementForStream(stub_buffer_stream2)));
@@ -1086,7 +1316,7 @@ TEST_F(SurfaceStack, changing_depth_layer_does_not_cause_reorder_when_it_shouldn
     stub_surface1->set_depth_layer(mir_depth_layer_below);
 
     EXPECT_THAT(
-        stack.scene_elements_for(compositor_id),
+        stack.scene_elements_for(compositor_id, view_area),
         ElementsAre(
             SceneElementForStream(stub_buffer_stream1),
             SceneElementForStream(stub_buffer_stream2)));
@@ -1103,7 +1333,7 @@ TEST_F(SurfaceStack, raising_surface_set_respects_depth_layers)
     stack.add_surface(stub_surface3, mi::InputReceptionMode::normal);
 
     EXPECT_THAT(
-        stack.scene_elements_for(compositor_id),
+        stack.scene_elements_for(compositor_id, view_area),
         ElementsAre(
             SceneElementForStream(stub_buffer_stream1),
             SceneElementForStream(stub_buffer_stream2),
@@ -1120,7 +1350,7 @@ TEST_F(SurfaceStack, raising_surface_set_respects_depth_layers)
     stack.raise({stub_surface1, stub_surface2});
 
     EXPECT_THAT(
-        stack.scene_elements_for(compositor_id),
+        stack.scene_elements_for(compositor_id, view_area),
         ElementsAre(
             SceneElementForStream(stub_buffer_stream1),
             SceneElementForStream(stub_buffer_stream3),
@@ -1182,7 +1412,7 @@ TEST_F(SurfaceStack, all_depth_layers_are_handled)
         stack.raise(stub_surface2);
 
         EXPECT_THAT(
-            stack.scene_elements_for(compositor_id),
+            stack.scene_elements_for(compositor_id, view_area),
             ElementsAre(
                 SceneElementForStream(stub_buffer_stream2),
                 SceneElementForStream(stub_buffer_stream1)))
@@ -1192,7 +1422,7 @@ TEST_F(SurfaceStack, all_depth_layers_are_handled)
         executor.execute();
 
         EXPECT_THAT(
-            stack.scene_elements_for(compositor_id),
+            stack.scene_elements_for(compositor_id, view_area),
             ElementsAre(
                 SceneElementForStream(stub_buffer_stream1),
                 SceneElementForStream(stub_buffer_stream2)))
@@ -1255,7 +1485,7 @@ TEST_F(SurfaceStack, surfaces_that_are_sent_to_back_appear_at_the_front_of_the_l
 
     stack.send_to_back({stub_surface2, stub_surface3});
     EXPECT_THAT(
-        stack.scene_elements_for(compositor_id),
+        stack.scene_elements_for(compositor_id, view_area),
         ElementsAre(
             SceneElementForStream(stub_buffer_stream2),
             SceneElementForStream(stub_buffer_stream3),
@@ -1285,7 +1515,7 @@ TEST_F(SurfaceStack, single_surfaces_can_be_swapped)
 
     stack.swap_z_order({stub_surface1}, {stub_surface2});
     EXPECT_THAT(
-        stack.scene_elements_for(compositor_id),
+        stack.scene_elements_for(compositor_id, view_area),
         ElementsAre(
             SceneElementForStream(stub_buffer_stream2),
             SceneElementForStream(stub_buffer_stream1),
@@ -1315,7 +1545,7 @@ TEST_F(SurfaceStack, multiple_surfaces_can_be_swapped)
 
     stack.swap_z_order({stub_surface1, stub_surface2}, {stub_surface3});
     EXPECT_THAT(
-        stack.scene_elements_for(compositor_id),
+        stack.scene_elements_for(compositor_id, view_area),
         ElementsAre(
             SceneElementForStream(stub_buffer_stream3),
             SceneElementForStream(stub_buffer_stream1),
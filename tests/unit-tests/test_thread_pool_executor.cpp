@@ -18,9 +18,12 @@
 #include <gmock/gmock.h>
 
 #include <boost/throw_exception.hpp>
+#include <algorithm>
 #include <chrono>
 #include <thread>
 #include <future>
+#include <mutex>
+#include <set>
 
 #include "mir/executor.h"
 #include "mir/test/signal.h"
@@ -215,3 +218,84 @@ TEST(ThreadPoolExecutor, quiesce_waits_until_work_completes)
     mir::ThreadPoolExecutor::quiesce();
     EXPECT_THAT(std::chrono::steady_clock::now(), Gt(expected_end));
 }
+
+TEST(ThreadPoolExecutor, executes_work_on_dedicated_thread)
+{
+    auto thread_name_provider = std::make_shared<std::promise<std::string>>();
+    auto thread_name = thread_name_provider->get_future();
+
+    mir::ThreadPoolExecutor::spawn_on_dedicated_thread(
+        [thread_name_provider]()
+        {
+            thread_name_provider->set_value(mt::current_thread_name());
+        });
+
+    ASSERT_THAT(thread_name.wait_for(std::chrono::seconds{60}), Eq(std::future_status::ready));
+    EXPECT_THAT(thread_name.get(), MatchesRegex("Mir/Workqueue.*"));
+}
+
+TEST(ThreadPoolExecutor, work_is_not_blocked_by_work_on_dedicated_threads)
+{
+    auto const release = std::make_shared<mt::Signal>();
+    auto const done = std::make_shared<mt::Signal>();
+
+    for (auto i = 0u; i < 2 * std::max(std::thread::hardware_concurrency(), 4u); ++i)
+    {
+        mir::ThreadPoolExecutor::spawn_on_dedicated_thread([release]() { release->wait_for(60s); });
+    }
+    mir::thread_pool_executor.spawn([done]() { done->raise(); });
+
+    EXPECT_TRUE(done->wait_for(60s));
+    release->raise();
+}
+
+TEST(ThreadPoolExecutor, cpu_bound_work_does_not_grow_the_pool)
+{
+    auto const pool_size = std::max(std::thread::hardware_concurrency(), 4u);
+    auto const work_count = 4 * pool_size;
+
+    std::mutex mutex;
+    std::set<std::thread::id> threads_used;
+    std::atomic<unsigned> remaining{work_count};
+    auto const done = std::make_shared<mt::Signal>();
+
+    for (auto i = 0u; i < work_count; ++i)
+    {
+        mir::thread_pool_executor.spawn(
+            [&]()
+            {
+                auto const until = std::chrono::steady_clock::now() + 20ms;
+                while (std::chrono::steady_clock::now() < until)
+                {
+                }
+                {
+                    std::lock_guard lock{mutex};
+                    threads_used.insert(std::this_thread::get_id());
+                }
+                if (--remaining == 0)
+                {
+                    done->raise();
+                }
+            });
+    }
+
+    ASSERT_TRUE(done->wait_for(60s));
+    // Allow for the odd thread being descheduled long enough to look blocked on a busy machine
+    EXPECT_THAT(threads_used.size(), Le(2 * pool_size));
+}
+
+TEST(ThreadPoolExecutor, quiesce_waits_until_work_on_dedicated_thread_completes)
+{
+    constexpr auto const delay = 500ms;
+
+    auto const expected_end = std::chrono::steady_clock::now() + delay;
+
+    mir::ThreadPoolExecutor::spawn_on_dedicated_thread(
+        [delay]()
+        {
+            std::this_thread::sleep_for(delay);
+        });
+
+    mir::ThreadPoolExecutor::quiesce();
+    EXPECT_THAT(std::chrono::steady_clock::now(), Gt(expected_end));
+}